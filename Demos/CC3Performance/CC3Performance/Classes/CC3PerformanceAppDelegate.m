@@ -32,6 +32,7 @@
 #import "CC3PerformanceAppDelegate.h"
 #import "CC3PerformanceLayer.h"
 #import "CC3PerformanceScene.h"
+#import "CC3PerformanceBenchmarks.h"
 
 @implementation CC3PerformanceAppDelegate {
 	UIWindow *window;
@@ -106,6 +107,11 @@
 
 	// Run the layer on the controller.
 	[viewController runSceneOnNode: mainLayer];		// attach the layer to the controller and run a scene with it
+
+	// To time specific cocos3d operations in isolation, uncomment the following line. The
+	// benchmarks run once the scene has been displayed for a moment, and their results are
+	// logged. See the notes of the CC3PerformanceBenchmarks class for more information.
+//	[CC3PerformanceBenchmarks performSelector: @selector(runAllOnScene:) withObject: cc3Layer.cc3Scene afterDelay: 1.0];
 }
 
 -(void) applicationWillResignActive:(UIApplication *)application {
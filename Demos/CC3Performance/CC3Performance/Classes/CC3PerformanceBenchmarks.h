@@ -0,0 +1,90 @@
+/*
+ * CC3PerformanceBenchmarks.h
+ *
+ * cocos3d 2.0.0
+ * Author: Bill Hollings
+ * Copyright (c) 2013 The Brenwill Workshop Ltd. All rights reserved.
+ * http://www.brenwill.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * http://en.wikipedia.org/wiki/MIT_License
+ */
+
+#import "CC3Scene.h"
+
+
+/**
+ * CC3PerformanceBenchmarks runs a set of CPU benchmarks against specific operations
+ * within the cocos3d framework, and logs the results.
+ *
+ * Whereas the interactive scene of this application measures the overall update and
+ * drawing rate of a scene, each of these benchmarks times a single operation, repeated
+ * many times in a tight loop, so that changes to that operation can be compared in
+ * isolation. The benchmarks do not require that anything be displayed.
+ *
+ * Results are logged using LogInfo, and so will only appear in builds with logging enabled.
+ * Benchmark timings are most meaningful when run in a Release build on a device.
+ *
+ * To run the benchmarks when this application starts, uncomment the line that invokes
+ * the runAllOnScene: method, within the applicationDidFinishLaunching: method of the
+ * CC3PerformanceAppDelegate class.
+ */
+@interface CC3PerformanceBenchmarks : NSObject
+
+/**
+ * Runs all of the benchmarks, one after the other. Benchmarks that draw do so using the
+ * specified scene, which must already be displayed by a CC3Layer.
+ */
++(void) runAllOnScene: (CC3Scene*) aScene;
+
+/**
+ * Times the sampling of long node animations that have variable frame timing, such as
+ * the animations in long cinematic clips loaded from POD files.
+ *
+ * For animations of several thousand frames, this benchmark compares the time taken to
+ * sample the animation during normal forward playback, during random seeking, and during
+ * forward playback when each frame is found by scanning the frame times backwards from
+ * the last frame, which is how frames were found before animation states kept a frame cursor.
+ */
++(void) runAnimationKeyframeBenchmark;
+
+/**
+ * Times the CPU cost of drawing the specified scene, including the population of GLSL
+ * uniforms by the drawing visitor, with the shouldSubmitToGL property of the
+ * CC3OpenGLESEngine set to NO, so that nothing is submitted to the GL engine.
+ *
+ * The scene is drawn repeatedly, first with the camera held still, and then with the camera
+ * turning a little before each frame. Uniforms whose values are derived only from the view
+ * and projection matrices need not be recalculated when the camera is still. The average
+ * drawing time per frame is logged for each pass, together with the number of state changes,
+ * uniform changes, and draw calls per frame, as counted by a CC3OpenGLESNullDriver replaying
+ * the commands recorded while drawing.
+ *
+ * The specified scene must already be displayed by a CC3Layer, so that its viewport has
+ * been established, and this method must be invoked on the rendering thread.
+ *
+ * While the GL engine is not being submitted to, the GL state trackers and GLSL uniforms
+ * continue to track the state changes as if they had been made. When this benchmark sets the
+ * shouldSubmitToGL property back to YES on completion, the CC3OpenGLESEngine marks the values
+ * of those trackers and uniforms as unknown, so that the next frame submits them to GL again.
+ */
++(void) runDrawingBenchmarkOnScene: (CC3Scene*) aScene;
+
+@end
@@ -0,0 +1,280 @@
+/*
+ * CC3PerformanceBenchmarks.m
+ *
+ * cocos3d 2.0.0
+ * Author: Bill Hollings
+ * Copyright (c) 2013 The Brenwill Workshop Ltd. All rights reserved.
+ * http://www.brenwill.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * http://en.wikipedia.org/wiki/MIT_License
+ * 
+ * See header file CC3PerformanceBenchmarks.h for full API documentation.
+ */
+
+#import "CC3PerformanceBenchmarks.h"
+#import "CC3NodeAnimation.h"
+#import "CC3Node.h"
+#import "CC3Camera.h"
+#import "CC3OpenGLESEngine.h"
+#import "CC3OpenGLESCommandBuffer.h"
+
+
+/** The frame counts of the animations sampled by the animation keyframe benchmark. */
+static const GLuint kAnimBenchFrameCounts[] = { 1000, 4000, 16000 };
+
+/** The number of times each animation is sampled during each pass of the benchmark. */
+#define kAnimBenchSampleCount		3600		// One minute of animation at 60 fps
+
+/** The number of times each pass of the animation keyframe benchmark is repeated. */
+#define kAnimBenchRepeatCount		20
+
+/** The number of frames drawn during each pass of the drawing benchmark. */
+#define kDrawBenchFrameCount		300
+
+/** The angle, in degrees, that the camera is turned before each frame in the moving camera pass. */
+#define kDrawBenchCameraStep		0.1f
+
+/** Returns a pseudo-random number between zero and one, generated from the specified seed. */
+static GLfloat CC3BenchRandom(GLuint* seed) {
+	*seed = (*seed * 1664525) + 1013904223;
+	return (GLfloat)(*seed >> 8) / (GLfloat)(1 << 24);
+}
+
+
+#pragma mark -
+#pragma mark CC3LinearScanNodeAnimation
+
+@interface CC3NodeAnimation (TemplateMethods)
+-(GLuint) frameIndexAt: (ccTime) t fromFrame: (GLuint) frameCursor;
+@end
+
+/**
+ * A CC3ArrayNodeAnimation that finds the frame at a particular time by scanning the frame
+ * times backwards from the last frame, ignoring the frame cursor of the animation state.
+ * This is used as the baseline for the animation keyframe benchmark.
+ */
+@interface CC3LinearScanNodeAnimation : CC3ArrayNodeAnimation
+@end
+
+@implementation CC3LinearScanNodeAnimation
+
+-(GLuint) frameIndexAt: (ccTime) t fromFrame: (GLuint) frameCursor {
+	for (GLint fIdx = _frameCount - 1; fIdx >= 0; fIdx--)
+		if (_frameTimes[fIdx] <= t) return fIdx;
+	return 0;
+}
+
+@end
+
+
+#pragma mark -
+#pragma mark CC3PerformanceBenchmarks
+
+@implementation CC3PerformanceBenchmarks
+
++(void) runAllOnScene: (CC3Scene*) aScene {
+	LogInfo(@"Starting cocos3d benchmarks");
+	[self runAnimationKeyframeBenchmark];
+	[self runDrawingBenchmarkOnScene: aScene];
+	LogInfo(@"Finished cocos3d benchmarks");
+}
+
+
+#pragma mark Animation keyframe benchmark
+
+/**
+ * Populates the specified animation with variable frame timing and animated locations and
+ * rotations. The time between frames varies pseudo-randomly, as it does in cinematic clips
+ * whose keyframes have been reduced by an exporter.
+ */
++(void) populateBenchmarkAnimation: (CC3ArrayNodeAnimation*) anim {
+	GLuint fCnt = anim.frameCount;
+	ccTime* frameTimes = [anim allocateFrameTimes];
+	CC3Vector* locations = [anim allocateLocations];
+	CC3Quaternion* quaternions = [anim allocateQuaternions];
+	GLuint seed = fCnt;
+
+	ccTime totalTime = 0.0f;
+	for (GLuint fIdx = 0; fIdx < fCnt; fIdx++) {
+		frameTimes[fIdx] = totalTime;
+		totalTime += 0.25f + CC3BenchRandom(&seed);
+		locations[fIdx] = cc3v(fIdx, CC3BenchRandom(&seed), 0.0f);
+		quaternions[fIdx] = CC3QuaternionFromAxisAngle(CC3Vector4Make(0.0f, 1.0f, 0.0f, fIdx));
+	}
+
+	// Normalize the frame times to the range 0 to 1, with the last frame at 1.
+	ccTime lastTime = frameTimes[fCnt - 1];
+	for (GLuint fIdx = 0; fIdx < fCnt; fIdx++) frameTimes[fIdx] /= lastTime;
+}
+
+/**
+ * Samples the specified animation state at each of the specified times, repeating the
+ * samples the specified number of times, and returns the average time per sample, in
+ * microseconds.
+ */
++(NSTimeInterval) timeSampling: (CC3NodeAnimationState*) animState
+					   atTimes: (ccTime*) sampleTimes
+						 count: (GLuint) sampleCount
+					   repeats: (GLuint) repeatCount {
+	NSDate* startTime = [NSDate date];
+	for (GLuint rIdx = 0; rIdx < repeatCount; rIdx++)
+		for (GLuint sIdx = 0; sIdx < sampleCount; sIdx++)
+			[animState establishFrameAt: sampleTimes[sIdx]];
+	return [[NSDate date] timeIntervalSinceDate: startTime] * 1.0e6 / (sampleCount * repeatCount);
+}
+
++(void) runAnimationKeyframeBenchmark {
+	GLuint sampleCount = kAnimBenchSampleCount;
+	ccTime* playTimes = malloc(sampleCount * sizeof(ccTime));
+	ccTime* seekTimes = malloc(sampleCount * sizeof(ccTime));
+	GLuint seed = 1;
+	for (GLuint sIdx = 0; sIdx < sampleCount; sIdx++) {
+		playTimes[sIdx] = (ccTime)sIdx / (ccTime)(sampleCount - 1);
+		seekTimes[sIdx] = CC3BenchRandom(&seed);
+	}
+
+	CC3Node* node = [CC3Node node];
+	GLuint benchCount = sizeof(kAnimBenchFrameCounts) / sizeof(GLuint);
+	for (GLuint bIdx = 0; bIdx < benchCount; bIdx++) {
+		GLuint fCnt = kAnimBenchFrameCounts[bIdx];
+
+		CC3ArrayNodeAnimation* anim = [CC3ArrayNodeAnimation animationWithFrameCount: fCnt];
+		[self populateBenchmarkAnimation: anim];
+		CC3NodeAnimationState* animState = [CC3NodeAnimationState animationStateWithAnimation: anim
+																					  onTrack: 0
+																					  forNode: node];
+
+		CC3ArrayNodeAnimation* scanAnim = [CC3LinearScanNodeAnimation animationWithFrameCount: fCnt];
+		[self populateBenchmarkAnimation: scanAnim];
+		CC3NodeAnimationState* scanState = [CC3NodeAnimationState animationStateWithAnimation: scanAnim
+																					  onTrack: 0
+																					  forNode: node];
+
+		NSTimeInterval playTime = [self timeSampling: animState
+											 atTimes: playTimes
+											   count: sampleCount
+											 repeats: kAnimBenchRepeatCount];
+		NSTimeInterval seekTime = [self timeSampling: animState
+											 atTimes: seekTimes
+											   count: sampleCount
+											 repeats: kAnimBenchRepeatCount];
+		NSTimeInterval scanTime = [self timeSampling: scanState
+											 atTimes: playTimes
+											   count: sampleCount
+											 repeats: kAnimBenchRepeatCount];
+
+		LogInfo(@"Animation keyframe benchmark with %u variable-timed frames: playback %.3f us,"
+				@" random seek %.3f us, playback by backwards scan %.3f us, per sample",
+				fCnt, playTime, seekTime, scanTime);
+	}
+
+	free(playTimes);
+	free(seekTimes);
+}
+
+
+#pragma mark Drawing benchmark
+
+/**
+ * Updates and draws the specified scene the specified number of times, turning the camera
+ * by the specified angle before each update, and returns the average time taken to draw
+ * each frame, in microseconds. The update time is not included.
+ *
+ * The commands recorded while drawing each frame are replayed through the specified null
+ * driver, and the command buffer is then cleared for the next frame.
+ */
++(NSTimeInterval) timeDrawing: (CC3Scene*) aScene
+					forFrames: (GLuint) frameCount
+			  turningCameraBy: (GLfloat) cameraStep
+				usingCommands: (CC3OpenGLESCommandBuffer*) cmdBuffer
+				andNullDriver: (CC3OpenGLESNullDriver*) nullDriver {
+	CC3Camera* cam = aScene.activeCamera;
+	NSTimeInterval drawTime = 0.0;
+	for (GLuint fIdx = 0; fIdx < frameCount; fIdx++) {
+		cam.rotation = CC3VectorAdd(cam.rotation, cc3v(0.0f, cameraStep, 0.0f));
+		[aScene updateScene];
+
+		NSDate* startTime = [NSDate date];
+		[aScene drawScene];
+		drawTime += [[NSDate date] timeIntervalSinceDate: startTime];
+
+		[nullDriver replay: cmdBuffer];
+		[cmdBuffer clear];
+	}
+	return drawTime * 1.0e6 / frameCount;
+}
+
+/** Logs the average drawing time per frame, and the average commands per frame counted by the null driver. */
++(void) logDrawingPass: (NSString*) passName
+			  drawTime: (NSTimeInterval) drawTime
+		 forFrameCount: (GLuint) frameCount
+		withNullDriver: (CC3OpenGLESNullDriver*) nullDriver {
+	LogInfo(@"Drawing benchmark with %@: %.1f us per frame, with %.1f state changes,"
+			@" %.1f uniform changes, and %.1f draw calls per frame", passName, drawTime,
+			((GLfloat)nullDriver.stateChangeCount / frameCount),
+			((GLfloat)nullDriver.uniformChangeCount / frameCount),
+			((GLfloat)nullDriver.drawCount / frameCount));
+}
+
++(void) runDrawingBenchmarkOnScene: (CC3Scene*) aScene {
+	if ( !aScene.activeCamera ) {
+		LogInfo(@"Drawing benchmark skipped because %@ has no active camera", aScene);
+		return;
+	}
+
+	CC3OpenGLESEngine* glesEngine = [CC3OpenGLESEngine engine];
+	CC3OpenGLESCommandBuffer* cmdBuffer = [CC3OpenGLESCommandBuffer commandBuffer];
+	CC3OpenGLESNullDriver* nullDriver = [CC3OpenGLESNullDriver nullDriver];
+	CC3Vector camRotation = aScene.activeCamera.rotation;
+	GLuint frameCount = kDrawBenchFrameCount;
+
+	glesEngine.commandBuffer = cmdBuffer;
+	glesEngine.shouldSubmitToGL = NO;
+
+	// Draw once before timing, to settle any state that is only established on the first frame
+	[self timeDrawing: aScene forFrames: 1 turningCameraBy: 0.0f usingCommands: cmdBuffer andNullDriver: nullDriver];
+	[nullDriver reset];
+
+	NSTimeInterval drawTime = [self timeDrawing: aScene
+									  forFrames: frameCount
+								turningCameraBy: 0.0f
+								  usingCommands: cmdBuffer
+								  andNullDriver: nullDriver];
+	[self logDrawingPass: @"still camera" drawTime: drawTime forFrameCount: frameCount withNullDriver: nullDriver];
+	[nullDriver reset];
+
+	drawTime = [self timeDrawing: aScene
+					   forFrames: frameCount
+				 turningCameraBy: kDrawBenchCameraStep
+				   usingCommands: cmdBuffer
+				   andNullDriver: nullDriver];
+	[self logDrawingPass: @"moving camera" drawTime: drawTime forFrameCount: frameCount withNullDriver: nullDriver];
+
+	if (nullDriver.invalidCommandCount > 0)
+		LogInfo(@"Drawing benchmark recorded %u invalid commands", nullDriver.invalidCommandCount);
+
+	glesEngine.shouldSubmitToGL = YES;
+	glesEngine.commandBuffer = nil;
+	aScene.activeCamera.rotation = camRotation;
+	[aScene updateScene];
+}
+
+@end
@@ -45,7 +45,11 @@
 	ccTime _animationDuration;
 	NSInteger _fileVersion;
 	NSInteger _flags;
+	GLfloat _animationCompressionTolerance;
+	GLuint _animationByteCount;
+	GLuint _uncompressedAnimationByteCount;
 	BOOL _isCompressed : 1;
+	BOOL _shouldCompressAnimation : 1;
 	BOOL _wasCSFResourceAttached : 1;
 	BOOL _shouldSwapYZ : 1;
 }
@@ -93,6 +97,82 @@
  */
 +(void) setDefaultShouldSwapYZ: (BOOL) shouldSwap;
 
+/**
+ * Indicates whether the animation content loaded by this resource should be held in compressed
+ * form, by loading it into instances of CC3CompressedNodeAnimation.
+ *
+ * If this property is set to YES, keyframes that can be reproduced from the keyframes on either
+ * side of them, to within the value of the animationCompressionTolerance property, are removed,
+ * and the remaining content is quantized. See the notes for CC3CompressedNodeAnimation for more
+ * information about how animation content is compressed.
+ *
+ * Animation content that is compressed within the file, as indicated by the isCompressed property,
+ * is always held in compressed form. If this property is set to NO, keyframes are only removed
+ * from that content if they can be reproduced exactly.
+ *
+ * This property must be set before the file is loaded. The initial value of this property
+ * is set from the value of the class-side defaultShouldCompressAnimation property.
+ */
+@property(nonatomic, assign) BOOL shouldCompressAnimation;
+
+/**
+ * Indicates the value that the shouldCompressAnimation property should be initially set to
+ * when any new instance of this class is created.
+ *
+ * The initial value of this property is NO.
+ */
++(BOOL) defaultShouldCompressAnimation;
+
+/**
+ * Indicates the value that the shouldCompressAnimation property should be initially set to
+ * when any new instance of this class is created.
+ *
+ * The initial value of this property is NO.
+ */
++(void) setDefaultShouldCompressAnimation: (BOOL) shouldCompress;
+
+/**
+ * When the shouldCompressAnimation property is set to YES, indicates the tolerance within which
+ * each component of the animated locations and rotation quaternions of a keyframe must be able
+ * to be reproduced from the keyframes on either side of it, in order for that keyframe to be
+ * removed from the animation.
+ *
+ * This property must be set before the file is loaded. The initial value of this property
+ * is set from the value of the class-side defaultAnimationCompressionTolerance property.
+ */
+@property(nonatomic, assign) GLfloat animationCompressionTolerance;
+
+/**
+ * Indicates the value that the animationCompressionTolerance property should be initially set to
+ * when any new instance of this class is created.
+ *
+ * The initial value of this property is 0.001.
+ */
++(GLfloat) defaultAnimationCompressionTolerance;
+
+/**
+ * Indicates the value that the animationCompressionTolerance property should be initially set to
+ * when any new instance of this class is created.
+ *
+ * The initial value of this property is 0.001.
+ */
++(void) setDefaultAnimationCompressionTolerance: (GLfloat) tolerance;
+
+/**
+ * Returns the number of bytes of memory used to hold the animation content loaded by this resource.
+ *
+ * If the animation content is held in compressed form, this will be less than the value of the
+ * uncompressedAnimationByteCount property, and the difference between the two values is the
+ * amount of memory saved by compressing the animation.
+ */
+@property(nonatomic, readonly) GLuint animationByteCount;
+
+/**
+ * Returns the number of bytes of memory that would be used to hold the animation content loaded
+ * by this resource, if that animation content was held in uncompressed form.
+ */
+@property(nonatomic, readonly) GLuint uncompressedAnimationByteCount;
+
 
 #pragma mark Allocation and initialization
 
@@ -35,13 +35,37 @@
 
 #define kCC3MaxCAFFileVersion		1300
 
+/** The number of frames per second of keyframe times in compressed CAF content. */
+#define kCC3CAFCompressedFrameRate						30.0f
+
+/** The scale applied to low-range translation components in compressed CAF content. */
+#define kCC3CAFCompressedTranslationScale				256.0f
+
+/** The scale applied to rotation quaternion components in compressed CAF content. */
+#define kCC3CAFCompressedQuaternionScale				32767.0f
+
+/** Bits of the compressed CAF track header containing the bone ID. */
+#define kCC3CAFCompressedBoneIDMask						0x1FFF
+
+/** Bit of the compressed CAF track header indicating that the translation varies between keyframes. */
+#define kCC3CAFCompressedTranslationIsDynamicBit		0x2000
+
+/** Bit of the compressed CAF track header indicating that translations are held as floats. */
+#define kCC3CAFCompressedTranslationIsHighRangeBit		0x4000
+
+/** Bit of the compressed CAF track header indicating that the track contains translation content. */
+#define kCC3CAFCompressedTranslationIsRequiredBit		0x8000
+
 
 @implementation CC3CAFResource
 
 @synthesize fileVersion=_fileVersion, animationDuration=_animationDuration;
 @synthesize isCompressed=_isCompressed, flags=_flags;
 @synthesize wasCSFResourceAttached=_wasCSFResourceAttached;
-@synthesize shouldSwapYZ=_shouldSwapYZ;
+@synthesize shouldSwapYZ=_shouldSwapYZ, shouldCompressAnimation=_shouldCompressAnimation;
+@synthesize animationCompressionTolerance=_animationCompressionTolerance;
+@synthesize animationByteCount=_animationByteCount;
+@synthesize uncompressedAnimationByteCount=_uncompressedAnimationByteCount;
 
 static BOOL _defaultShouldSwapYZ = YES;
 
@@ -49,6 +73,20 @@ static BOOL _defaultShouldSwapYZ = YES;
 
 +(void) setDefaultShouldSwapYZ: (BOOL) shouldSwap { _defaultShouldSwapYZ = shouldSwap; }
 
+static BOOL _defaultShouldCompressAnimation = NO;
+
++(BOOL) defaultShouldCompressAnimation { return _defaultShouldCompressAnimation; }
+
++(void) setDefaultShouldCompressAnimation: (BOOL) shouldCompress { _defaultShouldCompressAnimation = shouldCompress; }
+
+static GLfloat _defaultAnimationCompressionTolerance = 0.001f;
+
++(GLfloat) defaultAnimationCompressionTolerance { return _defaultAnimationCompressionTolerance; }
+
++(void) setDefaultAnimationCompressionTolerance: (GLfloat) tolerance {
+	_defaultAnimationCompressionTolerance = tolerance;
+}
+
 -(CC3Node*) getNodeMatching: (CC3Node*) node {
 	CC3CALNode* matchedNode = (CC3CALNode*)[super getNodeMatching:node];
 	if ( !matchedNode.isAnimationCorrectedForScale )
@@ -66,6 +104,10 @@ static BOOL _defaultShouldSwapYZ = YES;
 		_animationDuration = 0;
 		_wasCSFResourceAttached = NO;
 		_shouldSwapYZ = self.class.defaultShouldSwapYZ;
+		_shouldCompressAnimation = self.class.defaultShouldCompressAnimation;
+		_animationCompressionTolerance = self.class.defaultAnimationCompressionTolerance;
+		_animationByteCount = 0;
+		_uncompressedAnimationByteCount = 0;
 		_isCompressed = NO;
 		_flags = 0;
 	}
@@ -97,11 +139,15 @@ static BOOL _defaultShouldSwapYZ = YES;
 #pragma mark File reading
 
 -(BOOL) processFile: (NSString*) anAbsoluteFilePath {
+	return self.wasPreprocessed || [self preprocessFile: anAbsoluteFilePath];
+}
+
+/** Reading CAF content does not involve the GL engine, so the entire file is read here. */
+-(BOOL) preprocessFile: (NSString*) anAbsoluteFilePath {
 	
-	// Load the contents of the file and create a reader to parse those contents.
-	NSData* cafData = [NSData dataWithContentsOfFile: anAbsoluteFilePath];
-	if (cafData) {
-		CC3DataReader* reader = [CC3DataReader readerOnData: cafData];
+	// Map the contents of the file and create a reader to parse those contents.
+	CC3DataReader* reader = [CC3DataReader readerOnContentsOfFile: anAbsoluteFilePath];
+	if (reader) {
 		reader.isBigEndian = self.isBigEndian;
 		return [self readFrom: reader];
 	} else {
@@ -120,7 +166,10 @@ static BOOL _defaultShouldSwapYZ = YES;
 	if (_animationDuration > 0.0f)
 		for (NSInteger nIdx = 0; nIdx < _nodeCount; nIdx++)
 			wasRead = wasRead && [self readNodeFrom: reader];
-	
+
+	LogRez(@"%@ holds animation content in %u bytes, saving %i bytes by compression",
+		   self, _animationByteCount, (GLint)_uncompressedAnimationByteCount - (GLint)_animationByteCount);
+
 	return wasRead;
 }
 
@@ -146,8 +195,6 @@ static BOOL _defaultShouldSwapYZ = YES;
 			  self, _fileVersion, kCC3MaxCAFFileVersion);
 	
 	if (_fileVersion >= 1300) _isCompressed = reader.readInteger;
-	CC3Assert( !_isCompressed, @"%@ cannot read compressed animation content."
-			  @" Re-export the CAF file with uncompressed animation content.", self);
 
 	_animationDuration = reader.readFloat;	// Animation duration
 
@@ -168,10 +215,23 @@ static BOOL _defaultShouldSwapYZ = YES;
 	//	[tracks]
 	//		bone id                  4       integer   index to bone
 	//		number of keyframes      4       integer
+	//
+	//	[compressed tracks]
+	//		bone id and flags        2       short     bone id in low 13 bits, plus translation flags
+	//		number of keyframes      2       short
 
 	// Node index and keyframe count
-	NSInteger calNodeIdx = reader.readInteger;
-	NSInteger frameCount = reader.readInteger;
+	NSInteger calNodeIdx;
+	NSInteger frameCount;
+	NSUInteger trackFlags = 0;
+	if (_isCompressed) {
+		trackFlags = reader.readUnsignedShort;
+		calNodeIdx = trackFlags & kCC3CAFCompressedBoneIDMask;
+		frameCount = reader.readUnsignedShort;
+	} else {
+		calNodeIdx = reader.readInteger;
+		frameCount = reader.readInteger;
+	}
 	if (reader.wasReadBeyondEOF) return NO;
 
 	LogRez(@"Loading node with CAL index %i with %i keyframes of animation", calNodeIdx, frameCount);
@@ -180,18 +240,44 @@ static BOOL _defaultShouldSwapYZ = YES;
 	if (frameCount <= 0) return YES;
 
 	// Create and populate the animation instance
-	CC3ArrayNodeAnimation* anim = [CC3ArrayNodeAnimation animationWithFrameCount: frameCount];
-	if ( ![self populateAnimation: anim from: reader] ) return NO;
+	CC3ArrayNodeAnimation* arrayAnim = [CC3ArrayNodeAnimation animationWithFrameCount: frameCount];
+	if (_isCompressed) {
+		if ( ![self populateAnimation: arrayAnim fromCompressed: reader withTrackFlags: trackFlags] ) return NO;
+	} else {
+		if ( ![self populateAnimation: arrayAnim from: reader] ) return NO;
+	}
 
 	// Create the node, add the animation to it, and add it to the nodes array
 	CC3CALNode* calNode = [CC3CALNode node];
 	calNode.calIndex = calNodeIdx;
-	calNode.animation = anim;
+	calNode.animation = [self retainedAnimationFrom: arrayAnim];
 	[self.nodes addObject: calNode];
 
 	return YES;
 }
 
+/**
+ * Returns the animation to be held by this resource, given the specified loaded animation.
+ *
+ * If the file contained compressed content, or this resource should compress the animation, the
+ * content is compressed into a CC3CompressedNodeAnimation. Otherwise the loaded animation is returned.
+ */
+-(CC3NodeAnimation*) retainedAnimationFrom: (CC3ArrayNodeAnimation*) arrayAnim {
+	if ( !(_isCompressed || _shouldCompressAnimation) ) {
+		GLuint byteCount = arrayAnim.frameCount * (sizeof(ccTime) + sizeof(CC3Vector) + sizeof(CC3Quaternion));
+		_animationByteCount += byteCount;
+		_uncompressedAnimationByteCount += byteCount;
+		return arrayAnim;
+	}
+
+	GLfloat tolerance = _shouldCompressAnimation ? _animationCompressionTolerance : 0.0f;
+	CC3CompressedNodeAnimation* anim = [CC3CompressedNodeAnimation animationByCompressing: arrayAnim
+																			withTolerance: tolerance];
+	_animationByteCount += anim.compressedByteCount;
+	_uncompressedAnimationByteCount += anim.uncompressedByteCount;
+	return anim;
+}
+
 /** Populates the specified animation from the content in the specified reader. */
 -(BOOL)	populateAnimation: (CC3ArrayNodeAnimation*) anim from: (CC3DataReader*) reader {
 	//	[keyframes]
@@ -209,34 +295,34 @@ static BOOL _defaultShouldSwapYZ = YES;
 	CC3Vector* locations = anim.allocateLocations;
 	CC3Quaternion* quaternions = anim.allocateQuaternions;
 
+	// Read the content of all keyframes in one pass, then distribute it to the content arrays.
 	NSInteger frameCount = anim.frameCount;
-	for (NSInteger fIdx = 0; fIdx < frameCount; fIdx++) {
+	GLuint floatsPerFrame = 8;
+	GLfloat* frameContent = malloc(frameCount * floatsPerFrame * sizeof(GLfloat));
+	[reader read: (frameCount * floatsPerFrame) floats: frameContent];
+
+	GLfloat* fc = frameContent;
+	for (NSInteger fIdx = 0; fIdx < frameCount; fIdx++, fc += floatsPerFrame) {
 		
 		// Frame time, normalized to range between 0 and 1.
-		frameTimes[fIdx] = CLAMP(reader.readFloat / _animationDuration, 0.0f, 1.0f);
+		frameTimes[fIdx] = CLAMP(fc[0] / _animationDuration, 0.0f, 1.0f);
 
 		// Location and rotation at frame
 		if (_shouldSwapYZ) {
 			
-			locations[fIdx].x = reader.readFloat;
-			locations[fIdx].z = -reader.readFloat;		// Swap for negated Y
-			locations[fIdx].y = reader.readFloat;		// Swap for Z
+			locations[fIdx].x = fc[1];
+			locations[fIdx].z = -fc[2];		// Swap for negated Y
+			locations[fIdx].y = fc[3];		// Swap for Z
 
-			quaternions[fIdx].x = reader.readFloat;
-			quaternions[fIdx].z = -reader.readFloat;	// Swap for negated Y
-			quaternions[fIdx].y = reader.readFloat;		// Swap for Z
-			quaternions[fIdx].w = reader.readFloat;
+			quaternions[fIdx].x = fc[4];
+			quaternions[fIdx].z = -fc[5];	// Swap for negated Y
+			quaternions[fIdx].y = fc[6];	// Swap for Z
+			quaternions[fIdx].w = fc[7];
 
 		} else {
 
-			locations[fIdx].x = reader.readFloat;
-			locations[fIdx].y = reader.readFloat;
-			locations[fIdx].z = reader.readFloat;
-
-			quaternions[fIdx].x = reader.readFloat;
-			quaternions[fIdx].y = reader.readFloat;
-			quaternions[fIdx].z = reader.readFloat;
-			quaternions[fIdx].w = reader.readFloat;
+			locations[fIdx] = cc3v(fc[1], fc[2], fc[3]);
+			quaternions[fIdx] = CC3QuaternionMake(fc[4], fc[5], fc[6], fc[7]);
 
 		}
 
@@ -244,10 +330,78 @@ static BOOL _defaultShouldSwapYZ = YES;
 				 frameTimes[fIdx], NSStringFromCC3Vector(locations[fIdx]),
 				 NSStringFromCC3Quaternion(quaternions[fIdx]), fIdx);
 	}
+	free(frameContent);
 	
 	return !reader.wasReadBeyondEOF;
 }
 
+/**
+ * Populates the specified animation from the compressed content in the specified reader,
+ * using the flags read from the header of the compressed track.
+ */
+-(BOOL)	populateAnimation: (CC3ArrayNodeAnimation*) anim
+		   fromCompressed: (CC3DataReader*) reader
+		   withTrackFlags: (NSUInteger) trackFlags {
+	//	[compressed keyframes]
+	//		time                   2       short     time of keyframe in frames, at 30 frames per second
+	//		translation            12/6    float     (high range) or short (low range), only present if
+	//		                                         translation is required, and is either dynamic or
+	//		                                         this is the first keyframe
+	//		rotation x             2       short     relative rotation to parent bone
+	//		rotation y             2       short     stored as the X, Y & Z components of a unit
+	//		rotation z             2       short     quaternion with a non-negative W component
+
+	BOOL isTranslationRequired = (trackFlags & kCC3CAFCompressedTranslationIsRequiredBit) != 0;
+	BOOL isTranslationHighRange = (trackFlags & kCC3CAFCompressedTranslationIsHighRangeBit) != 0;
+	BOOL isTranslationDynamic = (trackFlags & kCC3CAFCompressedTranslationIsDynamicBit) != 0;
+
+	// Allocate the animation content arrays. Locations are only animated if translation is required.
+	ccTime* frameTimes = anim.allocateFrameTimes;
+	CC3Vector* locations = isTranslationRequired ? anim.allocateLocations : NULL;
+	CC3Quaternion* quaternions = anim.allocateQuaternions;
+
+	CC3Vector loc = kCC3VectorZero;
+	short qComps[3];
+	NSInteger frameCount = anim.frameCount;
+	for (NSInteger fIdx = 0; fIdx < frameCount; fIdx++) {
+
+		// Frame time, normalized to range between 0 and 1.
+		ccTime frameTime = reader.readUnsignedShort / kCC3CAFCompressedFrameRate;
+		frameTimes[fIdx] = CLAMP(frameTime / _animationDuration, 0.0f, 1.0f);
+
+		// Location at frame. If not dynamic, the location of the first frame is used throughout.
+		if (locations) {
+			if (fIdx == 0 || isTranslationDynamic) {
+				if (isTranslationHighRange) {
+					loc = reader.readVector;
+				} else {
+					[reader read: 3 shorts: qComps];
+					loc = cc3v(qComps[0], qComps[1], qComps[2]);
+					loc = CC3VectorScaleUniform(loc, 1.0f / kCC3CAFCompressedTranslationScale);
+				}
+				if (_shouldSwapYZ) loc = cc3v(loc.x, loc.z, -loc.y);
+			}
+			locations[fIdx] = loc;
+		}
+
+		// Rotation at frame, with the W component reconstructed from the others
+		[reader read: 3 shorts: qComps];
+		CC3Quaternion quat;
+		quat.x = qComps[0] / kCC3CAFCompressedQuaternionScale;
+		quat.y = qComps[1] / kCC3CAFCompressedQuaternionScale;
+		quat.z = qComps[2] / kCC3CAFCompressedQuaternionScale;
+		quat.w = sqrtf(MAX(1.0f - (quat.x * quat.x) - (quat.y * quat.y) - (quat.z * quat.z), 0.0f));
+		if (_shouldSwapYZ) quat = CC3QuaternionMake(quat.x, quat.z, -quat.y, quat.w);
+		quaternions[fIdx] = quat;
+
+		LogTrace(@"Time: %.4f Loc: %@ Quat: %@ in frame %i",
+				 frameTimes[fIdx], NSStringFromCC3Vector(loc),
+				 NSStringFromCC3Quaternion(quaternions[fIdx]), fIdx);
+	}
+
+	return !reader.wasReadBeyondEOF;
+}
+
 
 #pragma mark Linking to other CAL files
 
@@ -38,7 +38,7 @@
  *
  * During extraction from the file, nodes of this type are related to each other through index values.
  *
- * Only CC3ArrayNodeAnimation should be used for animating this type of node.
+ * Only CC3ArrayNodeAnimation or CC3CompressedNodeAnimation should be used for animating this type of node.
  *
  * CAF bones do not contain scale content. When a skeleton model whose bones do contain scale
  * content is exported to a CAF file, the animation location content is incorrectly scaled.
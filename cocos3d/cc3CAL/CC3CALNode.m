@@ -63,15 +63,8 @@
 	if ( CC3VectorsAreEqual(aScale, kCC3VectorUnitCube) ) return;
 	
 	CC3Vector invScale = CC3VectorInvert(aScale);
-	for (CC3NodeAnimationState* animState in _animationStates) {
-		CC3ArrayNodeAnimation* anim = (CC3ArrayNodeAnimation*)animState.animation;
-		CC3Vector* locations = anim.animatedLocations;
-		if (locations) {
-			GLuint fCnt = anim.frameCount;
-			for (GLuint fIdx = 0; fIdx < fCnt; fIdx++)
-				locations[fIdx] = CC3VectorScale(locations[fIdx], invScale);
-		}
-	}
+	for (CC3NodeAnimationState* animState in _animationStates)
+		[animState.animation scaleAnimatedLocationsBy: invScale];
 	_isAnimationCorrectedForScale = YES;
 }
 
@@ -63,16 +63,20 @@
 }
 
 -(BOOL) processFile: (NSString*) anAbsoluteFilePath {
+	BOOL wasLoaded = self.wasPreprocessed || [self preprocessFile: anAbsoluteFilePath];
+	if (wasLoaded) [self build];
+	return wasLoaded;
+}
+
+/** Reads the CSF file content. The nodes are built from that content by processFile:. */
+-(BOOL) preprocessFile: (NSString*) anAbsoluteFilePath {
 	
-	// Load the contents of the file and create a reader to parse those contents.
-	NSData* csfData = [NSData dataWithContentsOfFile: anAbsoluteFilePath];
-	CC3DataReader* reader = [CC3DataReader readerOnData: csfData];
+	// Map the contents of the file and create a reader to parse those contents.
+	CC3DataReader* reader = [CC3DataReader readerOnContentsOfFile: anAbsoluteFilePath];
 	reader.isBigEndian = self.isBigEndian;
 
-	if (csfData) {
-		BOOL wasLoaded = [self readFrom: reader];
-		if (wasLoaded) [self build];
-		return wasLoaded;
+	if (reader) {
+		return [self readFrom: reader];
 	} else {
 		LogError(@"Could not load %@", anAbsoluteFilePath.lastPathComponent);
 		return NO;
@@ -168,30 +172,16 @@
 	}
 
 	// Node location
-	CC3Vector location;
-	location.x = reader.readFloat;
-	location.y = reader.readFloat;
-	location.z = reader.readFloat;
+	CC3Vector location = reader.readVector;
 	
 	// Node rotation quaternion
-	CC3Quaternion quaternion;
-	quaternion.x = reader.readFloat;
-	quaternion.y = reader.readFloat;
-	quaternion.z = reader.readFloat;
-	quaternion.w = reader.readFloat;
+	CC3Quaternion quaternion = reader.readQuaternion;
 	
 	// Node vertex translation - ignored
-	CC3Vector vtxTranslation;
-	vtxTranslation.x = reader.readFloat;
-	vtxTranslation.y = reader.readFloat;
-	vtxTranslation.z = reader.readFloat;
+	CC3Vector vtxTranslation = reader.readVector;
 	
 	// Node vertex rotation quaternion - ignored
-	CC3Quaternion vtxQuaternion;
-	vtxQuaternion.x = reader.readFloat;
-	vtxQuaternion.y = reader.readFloat;
-	vtxQuaternion.z = reader.readFloat;
-	vtxQuaternion.w = reader.readFloat;
+	CC3Quaternion vtxQuaternion = reader.readQuaternion;
 	
 	NSInteger parentIndex = reader.readInteger;
 	
@@ -45,6 +45,7 @@
 	NSMutableDictionary* _texturesByName;
 	NSMutableDictionary* _effectsByName;
 	Class _semanticDelegateClass;
+	PODClassPtr _pfxParser;
 }
 
 /** Populates the specfied material from the PFX effect with the specified name. */
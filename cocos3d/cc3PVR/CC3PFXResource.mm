@@ -47,6 +47,7 @@ extern "C" {
 	[_effectsByName release];
 	[_texturesByName release];
 	_semanticDelegateClass = nil;		// not retained
+	[self deletePFXParser];
 	[super dealloc];
 }
 
@@ -101,28 +102,47 @@ extern "C" {
 
 /** Load the file, and if successful build this resource from the contents. */
 -(BOOL) processFile: (NSString*) anAbsoluteFilePath {
+	BOOL wasLoaded = self.wasPreprocessed || [self preprocessFile: anAbsoluteFilePath];
+	if (wasLoaded) [self buildFromPFXParser: (CPVRTPFXParser*)_pfxParser];
+	[self deletePFXParser];
+	return wasLoaded;
+}
+
+/**
+ * Parses the file, and holds the parser until processFile: builds this resource from it.
+ * Building the content compiles shaders, which requires the GL engine.
+ */
+-(BOOL) preprocessFile: (NSString*) anAbsoluteFilePath {
 
 	// Split the path into directory and file names and set the PVR read path to the directory and
 	// pass the unqualified file name to the parser. This allows the parser to locate any additional
 	// files that might be read as part of the parsing. For PFX, this will include any shader files
-	// referenced by the PFX file.
+	// referenced by the PFX file. The PVR read path is global, so parsing is serialized with other
+	// PVR files being read on other threads.
 	NSString* fileName = anAbsoluteFilePath.lastPathComponent;
 	NSString* dirName = anAbsoluteFilePath.stringByDeletingLastPathComponent;
 
-	CPVRTResourceFile::SetReadPath([dirName stringByAppendingString: @"/"].UTF8String);
-
+	[self deletePFXParser];
 	CPVRTString	error;
 	CPVRTPFXParser* pfxParser = new CPVRTPFXParser();
-	BOOL wasLoaded = (pfxParser->ParseFromFile(fileName.UTF8String, &error) == PVR_SUCCESS);
-	if (wasLoaded)
-		[self buildFromPFXParser: pfxParser];
-	else
+	BOOL wasParsed;
+	@synchronized([CC3PODResource class]) {
+		CPVRTResourceFile::SetReadPath([dirName stringByAppendingString: @"/"].UTF8String);
+		wasParsed = (pfxParser->ParseFromFile(fileName.UTF8String, &error) == PVR_SUCCESS);
+	}
+	if (wasParsed) {
+		_pfxParser = pfxParser;
+	} else {
 		LogError(@"Could not load %@ because %@", anAbsoluteFilePath.lastPathComponent,
 				 [NSString stringWithUTF8String: error.c_str()]);
+		delete pfxParser;
+	}
+	return wasParsed;
+}
 
-	delete pfxParser;
-
-	return wasLoaded;
+-(void) deletePFXParser {
+	if (_pfxParser) delete (CPVRTPFXParser*)_pfxParser;
+	_pfxParser = NULL;
 }
 
 /** Build this instance from the contents of the resource. */
@@ -607,6 +607,9 @@
 /**
  * Builds the textureIndex'th texture.
  * Note that textureIndex is an ordinal number indicating the rank of the texture.
+ *
+ * If the shouldLoadResourceTextures property of the CC3TextureManager is set to YES, the
+ * texture is loaded through that manager, and is streamed to the resolution required on screen.
  * 
  * This is automatically invoked from the buildTextures method.
  * The application should not invoke this method directly.
@@ -42,6 +42,7 @@ extern "C" {
 #import "CC3PODMaterial.h"
 #import "CC3PODVertexSkinning.h"
 #import "CC3PFXResource.h"
+#import "CC3TextureManager.h"
 #import "CC3CC2Extensions.h"
 
 
@@ -103,20 +104,27 @@ static Class _defaultPFXResourceClass = nil;
 }
 
 -(BOOL) processFile: (NSString*) anAbsoluteFilePath {
+	BOOL wasLoaded = self.wasPreprocessed || [self preprocessFile: anAbsoluteFilePath];
+	
+	if (wasLoaded && _shouldAutoBuild) [self build];
+	
+	return wasLoaded;
+}
+
+/** Reads the POD file content. Building the content requires the GL engine, and is left to processFile:. */
+-(BOOL) preprocessFile: (NSString*) anAbsoluteFilePath {
 
 	// Split the path into directory and file names and set the PVR read path to the directory and
 	// pass the unqualified file name to the parser. This allows the parser to locate any additional
-	// files that might be read as part of the parsing.
+	// files that might be read as part of the parsing. The PVR read path is global, so reading is
+	// serialized with other PVR files being read on other threads.
 	NSString* fileName = anAbsoluteFilePath.lastPathComponent;
 	NSString* dirName = anAbsoluteFilePath.stringByDeletingLastPathComponent;
 
-	CPVRTResourceFile::SetReadPath([dirName stringByAppendingString: @"/"].UTF8String);
-	
-	BOOL wasLoaded = (self.pvrtModelImpl->ReadFromFile(fileName.UTF8String) == PVR_SUCCESS);
-	
-	if (wasLoaded && _shouldAutoBuild) [self build];
-	
-	return wasLoaded;
+	@synchronized([CC3PODResource class]) {
+		CPVRTResourceFile::SetReadPath([dirName stringByAppendingString: @"/"].UTF8String);
+		return (self.pvrtModelImpl->ReadFromFile(fileName.UTF8String) == PVR_SUCCESS);
+	}
 }
 
 -(void) build {
@@ -507,12 +515,18 @@ static Class _defaultPFXResourceClass = nil;
 	}
 }
 
-/** Loads the texture file from the directory indicated by the directory property. */
+/**
+ * Loads the texture file from the directory indicated by the directory property, through
+ * the CC3TextureManager if its shouldLoadResourceTextures property is set to YES.
+ */
 -(CC3Texture*) buildTextureAtIndex: (uint) textureIndex {
 	SPODTexture* pst = (SPODTexture*)[self texturePODStructAtIndex: textureIndex];
 	NSString* texFile = [NSString stringWithUTF8String: pst->pszName];
 	NSString* texPath = [self.directory stringByAppendingPathComponent: texFile];
-	CC3Texture* tex = [CC3Texture textureFromFile: texPath];
+	CC3TextureManager* texMgr = CC3TextureManager.sharedTextureManager;
+	CC3Texture* tex = texMgr.shouldLoadResourceTextures
+						? [texMgr textureFromFile: texPath]
+						: [CC3Texture textureFromFile: texPath];
 	tex.textureParameters = _textureParameters;
 	LogRez(@"Creating %@ at POD index %u from: '%@'", tex, textureIndex, texPath);
 	return tex;
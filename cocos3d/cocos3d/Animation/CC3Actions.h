@@ -33,6 +33,8 @@
 #import "CC3Node.h"
 #import "CCActionEase.h"
 
+@class CC3NodeAnimationClip;
+
 
 /**
  * Constants for use as action tags to identify an action of a particular type on a node.
@@ -636,8 +638,10 @@ typedef enum {							// Don't start at zero to avoid possible confusion with def
  * those two values here will result in an animation containing only the punch.
  */
 @interface CC3Animate : CCActionInterval <NSCopying> {
+	CC3NodeAnimationClip* _animationClip;
 	NSUInteger _trackID;
 	BOOL _isReversed : 1;
+	BOOL _shouldUseAnimationClip : 1;
 }
 
 /** The animation track on which the animation runs. */
@@ -653,6 +657,24 @@ typedef enum {							// Don't start at zero to avoid possible confusion with def
  */
 @property(nonatomic, assign) BOOL isReversed;
 
+/**
+ * Indicates whether this action should sample the animation of the target node and its
+ * descendants as a single CC3NodeAnimationClip, instead of sampling the animation of each
+ * node individually.
+ *
+ * Setting this property to YES can significantly reduce the cost of animating characters
+ * with many bones, particularly when many such characters are animated at the same time.
+ *
+ * The clip is created from the animation content on the track when this action is first
+ * started on a target node, and is reused each time this action is restarted on that same
+ * target node, such as when this action is repeated. Changes to the animation content on the
+ * track after the clip has been created are not reflected in the clip. See the notes for the
+ * CC3NodeAnimationClip class for more information.
+ *
+ * The initial value of this property is NO.
+ */
+@property(nonatomic, assign) BOOL shouldUseAnimationClip;
+
 /**
  * Initializes this instance to animate animation track zero on the target node,
  * over the specified time duration.
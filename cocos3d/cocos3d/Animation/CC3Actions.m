@@ -31,6 +31,7 @@
 
 #import "CC3Actions.h"
 #import "CC3Node.h"
+#import "CC3NodeAnimation.h"
 
 
 #pragma mark -
@@ -639,7 +640,12 @@
 
 @implementation CC3Animate
 
-@synthesize trackID = _trackID, isReversed=_isReversed;
+@synthesize trackID = _trackID, isReversed=_isReversed, shouldUseAnimationClip=_shouldUseAnimationClip;
+
+-(void) dealloc {
+	[_animationClip release];
+	[super dealloc];
+}
 
 -(id) initWithDuration: (ccTime) t { return [self initWithDuration: t onTrack: 0]; }
 
@@ -649,6 +655,8 @@
 	if ( (self = [super initWithDuration: t]) ) {
 		_trackID = trackID;
 		_isReversed = NO;
+		_shouldUseAnimationClip = NO;
+		_animationClip = nil;
 	}
 	return self;
 }
@@ -669,19 +677,34 @@
 	return [CC3ActionRangeLimit actionWithAction: self limitFrom: startOfRange to: endOfRange];
 }
 
+/** If using an animation clip, reuse the existing clip if it was created for the same target node. */
+-(void) startWithTarget: (CC3Node*) aTarget {
+	[super startWithTarget: aTarget];
+	if (_shouldUseAnimationClip && _animationClip.rootNode != aTarget) {
+		[_animationClip release];
+		_animationClip = [[CC3NodeAnimationClip alloc] initFromNode: aTarget onTrack: _trackID];	// retained
+	}
+}
+
 -(void) update: (ccTime) t {
-	[self.targetCC3Node establishAnimationFrameAt: (_isReversed ? (1.0 - t) : t) onTrack: _trackID];
+	ccTime animTime = (_isReversed ? (1.0 - t) : t);
+	if (_shouldUseAnimationClip && _animationClip)
+		[_animationClip establishFrameAt: animTime];
+	else
+		[self.targetCC3Node establishAnimationFrameAt: animTime onTrack: _trackID];
 }
 
 -(CCActionInterval*) reverse {
 	CC3Animate* newAnim = [[self class] actionWithDuration: self.duration];
 	newAnim.isReversed = !self.isReversed;
+	newAnim.shouldUseAnimationClip = self.shouldUseAnimationClip;
 	return newAnim;
 }
 
 -(id) copyWithZone: (NSZone*) zone {
 	CC3Animate* newAnim = [[[self class] allocWithZone:zone] initWithDuration: self.duration];
 	newAnim.isReversed = self.isReversed;
+	newAnim.shouldUseAnimationClip = self.shouldUseAnimationClip;
 	return newAnim;
 }
 
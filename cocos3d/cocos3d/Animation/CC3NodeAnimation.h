@@ -187,6 +187,16 @@
  */
 -(ccTime) timeAtFrame: (GLuint) frameIndex;
 
+/**
+ * Scales the animated locations in this animation by the specified scale.
+ *
+ * This can be used to correct animated locations to match the scale of a skeleton.
+ *
+ * This base implementation does nothing. Subclasses that contain animated location content
+ * will override.
+ */
+-(void) scaleAnimatedLocationsBy: (CC3Vector) aScale;
+
 @end
 
 
@@ -379,6 +389,84 @@
 @end
 
 
+#pragma mark -
+#pragma mark CC3CompressedNodeAnimation
+
+/**
+ * CC3CompressedNodeAnimation is a concrete CC3NodeAnimation that holds its animation content
+ * in a compact, quantized form, and decompresses the content of each frame as it is sampled.
+ *
+ * An instance is created from another animation, typically a CC3ArrayNodeAnimation that has
+ * been loaded from a file, using the animationByCompressing:withTolerance: method. The content
+ * is compressed as follows:
+ *   - Keyframes whose content can be reproduced, to within the specified tolerance, by
+ *     interpolating between the keyframes retained on either side of them, are removed.
+ *     Since this results in uneven spacing between the remaining keyframes, the time of
+ *     each retained frame is held, quantized to 16 bits.
+ *   - Each component of the animated locations and scales is quantized to 16 bits, across
+ *     the range of values that the component takes on during the animation.
+ *   - Each rotation quaternion is quantized using the "smallest three" technique. The component
+ *     with the largest magnitude is dropped, and is reconstructed from the other three when the
+ *     frame is sampled. Since each of the three remaining components must lie within the range
+ *     +/-sqrt(1/2), each is quantized to 15 bits across that range, and the index of the dropped
+ *     component is held in the spare bits, for a total of six bytes per quaternion.
+ *
+ * A typical animation occupies a small fraction of the memory required by the equivalent
+ * CC3ArrayNodeAnimation. You can use the compressedByteCount and uncompressedByteCount
+ * properties to determine how much memory has been saved by compressing the animation.
+ */
+@interface CC3CompressedNodeAnimation : CC3NodeAnimation {
+	GLushort* _frameTimes;
+	GLushort* _animatedLocations;
+	GLushort* _animatedQuaternions;
+	GLushort* _animatedScales;
+	CC3Vector _locationMinimum;
+	CC3Vector _locationStep;
+	CC3Vector _scaleMinimum;
+	CC3Vector _scaleStep;
+	GLuint _uncompressedByteCount;
+}
+
+/** Returns the number of bytes of memory used to hold the compressed animation content. */
+@property(nonatomic, readonly) GLuint compressedByteCount;
+
+/**
+ * Returns the number of bytes of memory that would be used to hold the animation content,
+ * if it was held in an uncompressed CC3ArrayNodeAnimation.
+ */
+@property(nonatomic, readonly) GLuint uncompressedByteCount;
+
+
+#pragma mark Allocation and initialization
+
+/**
+ * Initializes this instance by compressing the content of the specified animation.
+ *
+ * Keyframes are removed from the animation if the content of the keyframe can be reproduced by
+ * interpolating between the keyframes retained on either side of it, such that each component
+ * of the animated location, rotation quaternion, and scale of the removed keyframe lies within
+ * the specified tolerance of the content of the original keyframe. If the specified animation
+ * does not interpolate between frames, keyframes are only removed if their content lies within
+ * the specified tolerance of the keyframe retained before them.
+ *
+ * Setting the tolerance to zero removes only those keyframes whose content can be reproduced
+ * exactly. The tolerance does not include the small error introduced by quantizing the content.
+ *
+ * The frameCount property of this instance will be set to the number of keyframes retained.
+ */
+-(id) initByCompressing: (CC3NodeAnimation*) animation withTolerance: (GLfloat) tolerance;
+
+/**
+ * Allocates and initializes an autoreleased instance by compressing the content of the
+ * specified animation.
+ *
+ * See the notes for the initByCompressing:withTolerance: method for more information.
+ */
++(id) animationByCompressing: (CC3NodeAnimation*) animation withTolerance: (GLfloat) tolerance;
+
+@end
+
+
 #pragma mark -
 #pragma mark CC3NodeAnimationState
 
@@ -395,6 +483,7 @@
 	CC3Node* _node;
 	CC3NodeAnimation* _animation;
 	ccTime _animationTime;
+	GLuint _frameCursor;
 	CC3Vector _location;
 	CC3Quaternion _quaternion;
 	CC3Vector _scale;
@@ -482,6 +571,18 @@
  */
 @property(nonatomic, readonly) ccTime animationTime;
 
+/**
+ * The index of the animation frame that was found for the most recent animation time.
+ *
+ * For animations with variable frame timing, this is used as the starting point when searching
+ * for the frame at the next animation time. During normal forward playback, the next frame is
+ * then found in constant time, instead of in time proportional to the number of frames.
+ *
+ * The value of this property is updated by the animation when the establishFrameAt: is invoked.
+ * The application should not normally need to set this property.
+ */
+@property(nonatomic, assign) GLuint frameCursor;
+
 /**
  * The current animated location.
  *
@@ -558,6 +659,22 @@
  */
 -(void) establishFrameAt: (ccTime) t;
 
+/**
+ * Updates the animationTime, location, quaternion, and scale of this instance to the specified
+ * values, which have already been sampled from the contained animation at the specified time.
+ *
+ * Only those properties that are being animated are changed, and they are only changed if this
+ * instance is enabled. The node is marked as needing its animation applied once, regardless of
+ * how many of the properties are changed.
+ *
+ * This method is invoked automatically by a CC3NodeAnimationClip, which samples the animations
+ * of many nodes together. Usually, the application never needs to invoke this method directly.
+ */
+-(void) establishFrameAt: (ccTime) t
+			withLocation: (CC3Vector) location
+			  quaternion: (CC3Quaternion) quaternion
+				   scale: (CC3Vector) scale;
+
 
 #pragma mark Allocation and initialization
 
@@ -608,3 +725,285 @@
 @end
 
 
+#pragma mark -
+#pragma mark CC3NodeAnimationClip
+
+/** Indexes of the channels of animated content packed by a CC3NodeAnimationClip. */
+typedef enum {
+	kCC3AnimationClipChannelLocationX,		/**< The X component of the animated location. */
+	kCC3AnimationClipChannelLocationY,		/**< The Y component of the animated location. */
+	kCC3AnimationClipChannelLocationZ,		/**< The Z component of the animated location. */
+	kCC3AnimationClipChannelQuaternionX,	/**< The X component of the animated quaternion. */
+	kCC3AnimationClipChannelQuaternionY,	/**< The Y component of the animated quaternion. */
+	kCC3AnimationClipChannelQuaternionZ,	/**< The Z component of the animated quaternion. */
+	kCC3AnimationClipChannelQuaternionW,	/**< The W component of the animated quaternion. */
+	kCC3AnimationClipChannelScaleX,			/**< The X component of the animated scale. */
+	kCC3AnimationClipChannelScaleY,			/**< The Y component of the animated scale. */
+	kCC3AnimationClipChannelScaleZ,			/**< The Z component of the animated scale. */
+	kCC3AnimationClipChannelCount			/**< The number of channels. */
+} CC3AnimationClipChannel;
+
+/** Bit flags indicating which animated content a joint in a CC3NodeAnimationClip contains. */
+typedef enum {
+	kCC3AnimationClipContentLocation = 1 << 0,		/**< The joint contains location animation. */
+	kCC3AnimationClipContentQuaternion = 1 << 1,	/**< The joint contains quaternion animation. */
+	kCC3AnimationClipContentScale = 1 << 2,			/**< The joint contains scale animation. */
+} CC3AnimationClipContentBits;
+
+/** A combination of CC3AnimationClipContentBits flags. */
+typedef GLubyte CC3AnimationClipContent;
+
+/**
+ * CC3NodeAnimationClip packs the animation content of all of the nodes in a node assembly
+ * that are animated on a single track, such as the bones of a skinned character, into a
+ * single clip, and samples the animation of all of those nodes together.
+ *
+ * Each component of the animated locations, quaternions and scales is held in its own channel
+ * array, with the values for all of the nodes at each frame held contiguously. Establishing
+ * the animation frame at a particular time therefore determines the frame and interpolation
+ * fraction only once for the whole clip, and then interpolates each channel for all of the
+ * nodes in a single tight loop. Quaternions are interpolated linearly and then normalized.
+ * To support this, each quaternion is stored in the same hemisphere as the quaternion in the
+ * previous frame.
+ *
+ * The sampled values are written to the CC3NodeAnimationState of each node, so animation
+ * blending across tracks continues to work as it does when each node is animated individually.
+ *
+ * Only CC3ArrayNodeAnimation instances that have the same number of frames, the same frame
+ * timing, and the same interpolation setting as the first such animation found can be packed.
+ * Any other animations found on the track are sampled individually, in the normal way, when
+ * the establishFrameAt: method is invoked.
+ *
+ * The animation content is copied when the clip is created. If the animations on the track are
+ * subsequently changed, or nodes are added to or removed from the node assembly, a new clip should
+ * be created. The clip retains the nodes that it animates.
+ *
+ * Sampling as a clip is most effective when many instances of a multi-node character are being
+ * animated at the same time. You can have a CC3Animate action use a clip by setting its
+ * shouldUseAnimationClip property to YES.
+ */
+@interface CC3NodeAnimationClip : NSObject {
+	CC3Node* _rootNode;
+	CCArray* _nodes;
+	CCArray* _animationStates;
+	CCArray* _unpackedAnimationStates;
+	GLfloat* _channels[kCC3AnimationClipChannelCount];
+	GLfloat* _pose[kCC3AnimationClipChannelCount];
+	ccTime* _frameTimes;
+	CC3AnimationClipContent* _jointContent;
+	NSUInteger _trackID;
+	GLuint _frameCount;
+	GLuint _frameCursor;
+	GLuint _jointCount;
+	BOOL _shouldInterpolate : 1;
+}
+
+/** The root node of the node assembly animated by this clip. */
+@property(nonatomic, retain, readonly) CC3Node* rootNode;
+
+/** The animation track that is animated by this clip. */
+@property(nonatomic, readonly) NSUInteger trackID;
+
+/** The number of frames of animated content in this clip. */
+@property(nonatomic, readonly) GLuint frameCount;
+
+/** The number of nodes whose animation content has been packed into this clip. */
+@property(nonatomic, readonly) GLuint jointCount;
+
+/**
+ * The number of nodes whose animation could not be packed into this clip,
+ * and which are sampled individually.
+ */
+@property(nonatomic, readonly) GLuint unpackedCount;
+
+
+#pragma mark Updating
+
+/**
+ * Updates the animation state of all of the nodes animated by this clip, based on the animation
+ * frame located at the specified time, which should be a value between zero and one, with zero
+ * indicating the first animation frame, and one indicating the last animation frame.
+ *
+ * This is equivalent to invoking the establishAnimationFrameAt:onTrack: method on the rootNode.
+ */
+-(void) establishFrameAt: (ccTime) t;
+
+/**
+ * Samples the animation content of all of the packed nodes at the specified time, which should
+ * be a value between zero and one, into the pose arrays of this clip, without changing the
+ * animation state of any node. The sampled values can be retrieved using the poseChannel: method.
+ *
+ * Nodes whose animations could not be packed into this clip, as indicated by the unpackedCount
+ * property, are not sampled by this method. The establishFrameAt: method samples those nodes
+ * individually, but a CC3NodeAnimationBlendTree will not accept a clip that contains them.
+ *
+ * This method is invoked automatically by the establishFrameAt: method, and by a
+ * CC3NodeAnimationBlendTree that contains this clip.
+ */
+-(void) samplePoseAt: (ccTime) t;
+
+/**
+ * Returns the array of values of the specified channel sampled by the most recent invocation of
+ * the samplePoseAt: method. The array contains one value for each packed node, in joint order.
+ */
+-(const GLfloat*) poseChannel: (CC3AnimationClipChannel) channel;
+
+/**
+ * Returns the array of values of the specified channel at the specified frame.
+ * The array contains one value for each packed node, in joint order.
+ */
+-(const GLfloat*) channel: (CC3AnimationClipChannel) channel atFrame: (GLuint) frameIndex;
+
+/** Returns the node whose animation is packed at the specified joint index. */
+-(CC3Node*) nodeForJointAt: (GLuint) jointIndex;
+
+/**
+ * Returns an array indicating, for each packed node, in joint order,
+ * which animated content that node contains.
+ */
+@property(nonatomic, readonly) const CC3AnimationClipContent* jointContent;
+
+
+#pragma mark Allocation and initialization
+
+/**
+ * Initializes this instance to animate the specified node, and all of its descendants,
+ * that contain animation on the specified track.
+ */
+-(id) initFromNode: (CC3Node*) aNode onTrack: (NSUInteger) trackID;
+
+/**
+ * Allocates and initializes an autoreleased instance to animate the specified node,
+ * and all of its descendants, that contain animation on the specified track.
+ */
++(id) clipFromNode: (CC3Node*) aNode onTrack: (NSUInteger) trackID;
+
+@end
+
+
+#pragma mark -
+#pragma mark CC3NodeAnimationBlendTree
+
+/** The blending state of a single layer within a CC3NodeAnimationBlendTree. */
+typedef struct {
+	GLfloat weight;			/**< The blending weight of the layer. */
+	ccTime time;			/**< The animation time at which the layer is sampled, between zero and one. */
+	GLuint* jointMap;		/**< Maps each joint of the layer clip to a joint of the blend tree. */
+	BOOL isAdditive;		/**< Whether the layer is added to the blend of the other layers. */
+} CC3NodeAnimationBlendLayer;
+
+/**
+ * CC3NodeAnimationBlendTree blends several CC3NodeAnimationClips, each running at its own time,
+ * and with its own blending weight, and applies the result directly to the location, quaternion,
+ * and scale of the animated nodes.
+ *
+ * Each clip is added to the blend tree as a layer. Normal layers are blended together using a
+ * weighted average, normalized by the total weight of the layers that animate each node and
+ * content type. This allows layers for locomotion, for example, to be crossfaded by adjusting
+ * their weights, using the setWeight:onLayer: or crossFadeFromLayer:toLayer:by: methods.
+ * Additive layers, such as for aiming or facial expressions, are then applied on top of that
+ * blend, scaled by their weights. An additive layer contributes the difference between its
+ * content at the layer time and its content at its first frame.
+ *
+ * When a node is first added to a blend tree, by a layer whose clip animates it, the location,
+ * quaternion, and scale of that node are captured as its rest pose. If no normal layer with a
+ * non-zero weight animates a particular content type of a node, an additive layer adds its
+ * difference to the rest pose of the node, rather than to the current state of the node, so
+ * that the difference does not accumulate from one evaluation to the next.
+ *
+ * When the evaluate method is invoked, all layers are sampled and blended for all nodes in a
+ * single pass into the pose buffer of the blend tree, and then each node is updated once.
+ * Layers with a weight of zero are skipped entirely and are not sampled.
+ *
+ * A blend tree takes the place of the CC3NodeAnimationStates of the nodes that it animates.
+ * Those nodes should not also be animated on the same tracks by CC3Animate actions. Typically,
+ * the application will set the times and weights of the layers, and then invoke the evaluate
+ * method, from the updateBeforeTransform: method of the root node of the character, or from
+ * a custom action.
+ */
+@interface CC3NodeAnimationBlendTree : NSObject {
+	CCArray* _joints;
+	CCArray* _clips;
+	CC3NodeAnimationBlendLayer* _layers;
+	GLfloat* _pose[kCC3AnimationClipChannelCount];
+	GLfloat* _locationWeights;
+	GLfloat* _quaternionWeights;
+	GLfloat* _scaleWeights;
+	CC3Vector* _restLocations;
+	CC3Quaternion* _restQuaternions;
+	CC3Vector* _restScales;
+	GLuint _layerCount;
+	GLuint _layerCapacity;
+	GLuint _jointCapacity;
+}
+
+/** The number of layers in this blend tree. */
+@property(nonatomic, readonly) GLuint layerCount;
+
+/** The number of distinct nodes animated by the layers of this blend tree. */
+@property(nonatomic, readonly) GLuint jointCount;
+
+/**
+ * Adds the specified clip as a normal layer, which is blended with the other normal layers
+ * using a weighted average. The new layer has a weight of zero, and a time of zero.
+ *
+ * The clip must not contain any nodes whose animations could not be packed into the clip,
+ * as indicated by its unpackedCount property, because those nodes are not sampled by the
+ * samplePoseAt: method of the clip, and so cannot be blended.
+ *
+ * Returns the index of the new layer.
+ */
+-(GLuint) addLayerWithClip: (CC3NodeAnimationClip*) clip;
+
+/**
+ * Adds the specified clip as an additive layer, which is added to the blend of the normal layers.
+ * The new layer has a weight of zero, and a time of zero.
+ *
+ * As with the addLayerWithClip: method, the clip must not contain any unpacked nodes.
+ *
+ * Returns the index of the new layer.
+ */
+-(GLuint) addAdditiveLayerWithClip: (CC3NodeAnimationClip*) clip;
+
+/** Returns the clip of the layer at the specified index. */
+-(CC3NodeAnimationClip*) clipOnLayer: (GLuint) layerIndex;
+
+/** Returns the blending weight of the layer at the specified index. */
+-(GLfloat) weightOnLayer: (GLuint) layerIndex;
+
+/**
+ * Sets the blending weight of the layer at the specified index. The weight is clamped
+ * to be at least zero. A layer whose weight is zero is not sampled by the evaluate method.
+ */
+-(void) setWeight: (GLfloat) weight onLayer: (GLuint) layerIndex;
+
+/** Returns the animation time of the layer at the specified index. */
+-(ccTime) timeOnLayer: (GLuint) layerIndex;
+
+/**
+ * Sets the animation time, between zero and one, at which the layer
+ * at the specified index will be sampled by the evaluate method.
+ */
+-(void) setTime: (ccTime) t onLayer: (GLuint) layerIndex;
+
+/**
+ * Crossfades between the two specified layers, by setting the weight of the first layer to
+ * (1 - fraction), and the weight of the second layer to the fraction, which is clamped to
+ * the range between zero and one.
+ */
+-(void) crossFadeFromLayer: (GLuint) fromLayerIndex toLayer: (GLuint) toLayerIndex by: (GLfloat) fraction;
+
+/**
+ * Samples each layer whose weight is not zero, at the time of that layer, blends the results
+ * for all of the nodes into the pose buffer of this blend tree, and then applies the blended
+ * location, quaternion, and scale to each node animated by at least one of those layers.
+ */
+-(void) evaluate;
+
+
+#pragma mark Allocation and initialization
+
+/** Allocates and initializes an autoreleased instance. */
++(id) blendTree;
+
+@end
@@ -31,6 +31,35 @@
 
 #import "CC3NodeAnimation.h"
 
+/** The number of frames a frame cursor will step forward before resorting to a binary search. */
+#define kCC3FrameCursorMaxSteps		4
+
+/**
+ * Returns the index of the last frame, within the specified array of ascending frame times,
+ * whose time is at or before the specified time, or zero if the time is before the first frame.
+ *
+ * The search starts at the specified cursor frame, which is typically the frame found by the
+ * previous search. During forward playback, the required frame is the cursor frame, or only
+ * a few frames after it, so it is found by stepping forward in constant time. Otherwise, such
+ * as when seeking backwards or jumping far ahead, a binary search is performed.
+ */
+static GLuint CC3FrameIndexAtTime(const ccTime* frameTimes, GLuint frameCount, ccTime t, GLuint cursor) {
+	if (cursor < frameCount && frameTimes[cursor] <= t) {
+		for (GLuint step = 0; step < kCC3FrameCursorMaxSteps; step++) {
+			if (cursor + 1 >= frameCount || frameTimes[cursor + 1] > t) return cursor;
+			cursor++;
+		}
+	}
+
+	GLuint lo = 0, hi = frameCount;
+	while (hi - lo > 1) {
+		GLuint mid = (lo + hi) >> 1;
+		if (frameTimes[mid] <= t) lo = mid;
+		else hi = mid;
+	}
+	return lo;
+}
+
 
 #pragma mark -
 #pragma mark CC3NodeAnimation
@@ -91,9 +120,10 @@ static ccTime _interpolationEpsilon = 0.1f;
 	LogTrace(@"%@ animating frame at %.4f", self, t);
 	CC3Assert(t >= 0.0 && t <= 1.0, @"%@ animation frame time %f must be between 0.0 and 1.0", self, t);
 	
-	// Get the index of the frame within which the given time appears,
-	// and declare a possible fractional interpolation within that frame.
-	GLuint frameIndex = [self frameIndexAt: t];
+	// Get the index of the frame within which the given time appears, starting the search from
+	// the frame found last time, and declare a possible fractional interpolation within that frame.
+	GLuint frameIndex = [self frameIndexAt: t fromFrame: animState.frameCursor];
+	animState.frameCursor = frameIndex;
 	GLfloat frameInterpolation = 0.0;
 	
 	// If we should interpolate, and we're not at the last frame, calc the interpolation amount.
@@ -189,6 +219,16 @@ static ccTime _interpolationEpsilon = 0.1f;
  */
 -(GLuint) frameIndexAt: (ccTime) t { return (_frameCount - 1) * t; }
 
+/**
+ * Template method that returns the index of the frame within which the specified time occurs,
+ * using the specified frame, usually the frame returned by the previous invocation, as a
+ * starting point for the search.
+ *
+ * This implementation ignores the specified frame, and invokes the frameIndexAt: method.
+ * Subclasses that must search for the frame will override.
+ */
+-(GLuint) frameIndexAt: (ccTime) t fromFrame: (GLuint) frameCursor { return [self frameIndexAt: t]; }
+
 /**
  * Template method that returns the location at the specified animation frame.
  * Frame index numbering starts at zero.
@@ -219,6 +259,8 @@ static ccTime _interpolationEpsilon = 0.1f;
  */
 -(CC3Vector) scaleAtFrame: (GLuint) frameIndex { return kCC3VectorUnitCube; }
 
+-(void) scaleAnimatedLocationsBy: (CC3Vector) aScale {}
+
 @end
 
 
@@ -269,14 +311,17 @@ static ccTime _interpolationEpsilon = 0.1f;
 	return _frameTimes[MIN(frameIndex, _frameCount - 1)];
 }
 
-// Iterate backwards through the frames looking for the first frame whose time is at or before
-// the specified frame time, and return that frame. If the specified frame is before the first
-// frame, return the first frame.
+// Binary search for the last frame whose time is at or before the specified frame time,
+// and return that frame. If the specified time is before the first frame, return the first frame.
 -(GLuint) frameIndexAt: (ccTime) t {
 	if (!_frameTimes) return [super frameIndexAt: t];
-	for (GLint fIdx = _frameCount - 1; fIdx >= 0; fIdx--)	// start at last frame
-		if (_frameTimes[fIdx] <= t) return fIdx;			// return frame
-	return 0;
+	return CC3FrameIndexAtTime(_frameTimes, _frameCount, t, _frameCount);
+}
+
+// Step forward from the cursor frame during normal playback, otherwise binary search.
+-(GLuint) frameIndexAt: (ccTime) t fromFrame: (GLuint) frameCursor {
+	if (!_frameTimes) return [super frameIndexAt: t];
+	return CC3FrameIndexAtTime(_frameTimes, _frameCount, t, frameCursor);
 }
 
 -(CC3Vector) locationAtFrame: (GLuint) frameIndex {
@@ -294,6 +339,12 @@ static ccTime _interpolationEpsilon = 0.1f;
 	return _animatedScales[MIN(frameIndex, _frameCount - 1)];
 }
 
+-(void) scaleAnimatedLocationsBy: (CC3Vector) aScale {
+	if ( !_animatedLocations ) return;
+	for (GLuint fIdx = 0; fIdx < _frameCount; fIdx++)
+		_animatedLocations[fIdx] = CC3VectorScale(_animatedLocations[fIdx], aScale);
+}
+
 -(void) setFrameTimes: (ccTime*) frameTimes {
 	[self deallocateFrameTimes];			// get rid of any existing array
 	_frameTimes = frameTimes;
@@ -394,6 +445,344 @@ static ccTime _interpolationEpsilon = 0.1f;
 @end
 
 
+#pragma mark -
+#pragma mark CC3CompressedNodeAnimation
+
+/** The largest value of a 16-bit quantized value. */
+#define kCC3QuantizedMax				65535.0f
+
+/** The largest value of a 15-bit quantized quaternion component. */
+#define kCC3QuantizedQuaternionMax		32767.0f
+
+/** The mask covering the 15 bits of a quantized quaternion component. */
+#define kCC3QuantizedQuaternionMask		0x7FFF
+
+/**
+ * Returns the index of the last frame, within the specified array of ascending 16-bit
+ * quantized frame times, whose time is at or before the specified time.
+ *
+ * This is the same search as performed by CC3FrameIndexAtTime, on quantized frame times.
+ */
+static GLuint CC3FrameIndexAtQuantizedTime(const GLushort* frameTimes, GLuint frameCount, ccTime t, GLuint cursor) {
+	GLfloat qt = t * kCC3QuantizedMax;
+	if (cursor < frameCount && frameTimes[cursor] <= qt) {
+		for (GLuint step = 0; step < kCC3FrameCursorMaxSteps; step++) {
+			if (cursor + 1 >= frameCount || frameTimes[cursor + 1] > qt) return cursor;
+			cursor++;
+		}
+	}
+	
+	GLuint lo = 0, hi = frameCount;
+	while (hi - lo > 1) {
+		GLuint mid = (lo + hi) >> 1;
+		if (frameTimes[mid] <= qt) lo = mid;
+		else hi = mid;
+	}
+	return lo;
+}
+
+/** Returns the specified value quantized to 16 bits, as a number of steps above the specified minimum. */
+static inline GLushort CC3QuantizeFloat(GLfloat value, GLfloat minimum, GLfloat step) {
+	if (step <= 0.0f) return 0;
+	return (GLushort)CLAMP(((value - minimum) / step) + 0.5f, 0.0f, kCC3QuantizedMax);
+}
+
+/** Quantizes the specified vector to 16 bits per component, into the specified array of three values. */
+static inline void CC3QuantizeVector(CC3Vector v, CC3Vector minimum, CC3Vector step, GLushort* qv) {
+	qv[0] = CC3QuantizeFloat(v.x, minimum.x, step.x);
+	qv[1] = CC3QuantizeFloat(v.y, minimum.y, step.y);
+	qv[2] = CC3QuantizeFloat(v.z, minimum.z, step.z);
+}
+
+/** Returns the vector held quantized in the specified array of three values. */
+static inline CC3Vector CC3DequantizeVector(const GLushort* qv, CC3Vector minimum, CC3Vector step) {
+	return cc3v(minimum.x + (qv[0] * step.x),
+				minimum.y + (qv[1] * step.y),
+				minimum.z + (qv[2] * step.z));
+}
+
+/**
+ * Quantizes the specified quaternion, using the "smallest three" technique, into the specified
+ * array of three values.
+ *
+ * The component with the largest magnitude is dropped. Since q and -q represent the same rotation,
+ * the quaternion is negated if required, so that the dropped component is positive. The remaining
+ * three components, which must lie within +/-sqrt(1/2), are quantized to 15 bits each. The two bits
+ * of the index of the dropped component are held in the top bits of the first two values.
+ */
+static void CC3QuantizeQuaternion(CC3Quaternion q, GLushort* qq) {
+	q = CC3QuaternionNormalize(q);
+	GLfloat comps[4] = { q.x, q.y, q.z, q.w };
+
+	GLuint maxIdx = 0;
+	for (GLuint cIdx = 1; cIdx < 4; cIdx++)
+		if (fabsf(comps[cIdx]) > fabsf(comps[maxIdx])) maxIdx = cIdx;
+	GLfloat sign = (comps[maxIdx] < 0.0f) ? -1.0f : 1.0f;
+
+	GLuint qIdx = 0;
+	for (GLuint cIdx = 0; cIdx < 4; cIdx++) {
+		if (cIdx == maxIdx) continue;
+		GLfloat unitComp = ((comps[cIdx] * sign * (GLfloat)M_SQRT1_2) + 0.5f);	// Map +/-sqrt(1/2) to 0-1
+		qq[qIdx++] = (GLushort)CLAMP((unitComp * kCC3QuantizedQuaternionMax) + 0.5f, 0.0f, kCC3QuantizedQuaternionMax);
+	}
+	qq[0] |= (maxIdx & 2) << 14;
+	qq[1] |= (maxIdx & 1) << 15;
+}
+
+/** Returns the quaternion held quantized in the specified array of three values. */
+static CC3Quaternion CC3DequantizeQuaternion(const GLushort* qq) {
+	GLuint maxIdx = ((qq[0] >> 14) & 2) | (qq[1] >> 15);
+	GLfloat comps[4];
+	GLfloat sumSq = 0.0f;
+	GLuint qIdx = 0;
+	for (GLuint cIdx = 0; cIdx < 4; cIdx++) {
+		if (cIdx == maxIdx) continue;
+		GLfloat unitComp = (qq[qIdx++] & kCC3QuantizedQuaternionMask) / kCC3QuantizedQuaternionMax;
+		GLfloat comp = (unitComp - 0.5f) * (GLfloat)M_SQRT2;		// Map 0-1 to +/-sqrt(1/2)
+		comps[cIdx] = comp;
+		sumSq += comp * comp;
+	}
+	comps[maxIdx] = sqrtf(MAX(1.0f - sumSq, 0.0f));
+	return CC3QuaternionMake(comps[0], comps[1], comps[2], comps[3]);
+}
+
+/** Returns whether each component of the two vectors lies within the specified tolerance of each other. */
+static inline BOOL CC3VectorsAreWithinTolerance(CC3Vector v1, CC3Vector v2, GLfloat tolerance) {
+	return (fabsf(v1.x - v2.x) <= tolerance &&
+			fabsf(v1.y - v2.y) <= tolerance &&
+			fabsf(v1.z - v2.z) <= tolerance);
+}
+
+/**
+ * Returns whether each component of the two quaternions lies within the specified tolerance
+ * of each other, once the quaternions have been aligned to the same hemisphere.
+ */
+static inline BOOL CC3QuaternionsAreWithinTolerance(CC3Quaternion q1, CC3Quaternion q2, GLfloat tolerance) {
+	if (CC3QuaternionDot(q1, q2) < 0.0f) q2 = CC3QuaternionNegate(q2);
+	return (fabsf(q1.x - q2.x) <= tolerance &&
+			fabsf(q1.y - q2.y) <= tolerance &&
+			fabsf(q1.z - q2.z) <= tolerance &&
+			fabsf(q1.w - q2.w) <= tolerance);
+}
+
+@implementation CC3CompressedNodeAnimation
+
+@synthesize uncompressedByteCount=_uncompressedByteCount;
+
+-(void) dealloc {
+	free(_frameTimes);		// All content arrays are held in a single memory block
+	[super dealloc];
+}
+
+-(BOOL) isAnimatingLocation { return _animatedLocations != NULL; }
+
+-(BOOL) isAnimatingQuaternion { return _animatedQuaternions != NULL; }
+
+-(BOOL) isAnimatingScale { return _animatedScales != NULL; }
+
+-(BOOL) hasVariableFrameTiming { return YES; }
+
+-(GLuint) compressedByteCount {
+	GLuint elemsPerFrame = 1;
+	if (_animatedLocations) elemsPerFrame += 3;
+	if (_animatedQuaternions) elemsPerFrame += 3;
+	if (_animatedScales) elemsPerFrame += 3;
+	return _frameCount * elemsPerFrame * sizeof(GLushort);
+}
+
+
+#pragma mark Accessing frame data
+
+-(ccTime) timeAtFrame: (GLuint) frameIndex {
+	return _frameTimes[MIN(frameIndex, _frameCount - 1)] / kCC3QuantizedMax;
+}
+
+-(GLuint) frameIndexAt: (ccTime) t {
+	return CC3FrameIndexAtQuantizedTime(_frameTimes, _frameCount, t, _frameCount);
+}
+
+-(GLuint) frameIndexAt: (ccTime) t fromFrame: (GLuint) frameCursor {
+	return CC3FrameIndexAtQuantizedTime(_frameTimes, _frameCount, t, frameCursor);
+}
+
+-(CC3Vector) locationAtFrame: (GLuint) frameIndex {
+	if (!_animatedLocations) return [super locationAtFrame: frameIndex];
+	return CC3DequantizeVector(&_animatedLocations[MIN(frameIndex, _frameCount - 1) * 3],
+							   _locationMinimum, _locationStep);
+}
+
+-(CC3Quaternion) quaternionAtFrame: (GLuint) frameIndex {
+	if (!_animatedQuaternions) return [super quaternionAtFrame: frameIndex];
+	return CC3DequantizeQuaternion(&_animatedQuaternions[MIN(frameIndex, _frameCount - 1) * 3]);
+}
+
+-(CC3Vector) scaleAtFrame: (GLuint) frameIndex {
+	if (!_animatedScales) return [super scaleAtFrame: frameIndex];
+	return CC3DequantizeVector(&_animatedScales[MIN(frameIndex, _frameCount - 1) * 3],
+							   _scaleMinimum, _scaleStep);
+}
+
+// Quantized locations are offsets from the minimum, so scaling the minimum and step is sufficient.
+-(void) scaleAnimatedLocationsBy: (CC3Vector) aScale {
+	_locationMinimum = CC3VectorScale(_locationMinimum, aScale);
+	_locationStep = CC3VectorScale(_locationStep, aScale);
+}
+
+
+#pragma mark Allocation and initialization
+
+-(id) initWithFrameCount: (GLuint) numFrames {
+	CC3Assert(NO, @"%@ must be initialized by compressing another animation", self);
+	[self release];
+	return nil;
+}
+
+-(id) initByCompressing: (CC3NodeAnimation*) animation withTolerance: (GLfloat) tolerance {
+	GLuint srcFrameCount = animation.frameCount;
+	if ( (self = [super initWithFrameCount: srcFrameCount]) ) {
+		_shouldInterpolate = animation.shouldInterpolate;
+
+		GLuint* keyFrames = malloc(MAX(srcFrameCount, 1) * sizeof(GLuint));
+		_frameCount = [self selectKeyFrames: keyFrames from: animation withTolerance: tolerance];
+		[self populateFrom: animation atKeyFrames: keyFrames];
+		free(keyFrames);
+
+		_uncompressedByteCount = srcFrameCount * ((animation.hasVariableFrameTiming ? sizeof(ccTime) : 0) +
+												  (animation.isAnimatingLocation ? sizeof(CC3Vector) : 0) +
+												  (animation.isAnimatingQuaternion ? sizeof(CC3Quaternion) : 0) +
+												  (animation.isAnimatingScale ? sizeof(CC3Vector) : 0));
+		LogRez(@"%@ compressed from %u frames and %u bytes", self, srcFrameCount, _uncompressedByteCount);
+	}
+	return self;
+}
+
++(id) animationByCompressing: (CC3NodeAnimation*) animation withTolerance: (GLfloat) tolerance {
+	return [[[self alloc] initByCompressing: animation withTolerance: tolerance] autorelease];
+}
+
+/**
+ * Populates the specified array with the indexes of the frames of the specified animation that must
+ * be retained in order to reproduce the animation to within the specified tolerance, and returns the
+ * number of frames retained. The first and last frames are always retained.
+ *
+ * Working forward from the last retained frame, each frame is dropped if all of the frames between
+ * the last retained frame and the frame following the candidate frame can be reproduced without it.
+ */
+-(GLuint) selectKeyFrames: (GLuint*) keyFrames from: (CC3NodeAnimation*) animation withTolerance: (GLfloat) tolerance {
+	GLuint srcFrameCount = animation.frameCount;
+	if (srcFrameCount == 0) return 0;
+
+	GLuint keyCount = 0;
+	GLuint anchorIdx = 0;
+	keyFrames[keyCount++] = anchorIdx;
+	for (GLuint fIdx = 1; fIdx < srcFrameCount - 1; fIdx++) {
+		if ( ![self canReproduceFramesOf: animation between: anchorIdx and: fIdx + 1 withTolerance: tolerance] ) {
+			keyFrames[keyCount++] = fIdx;
+			anchorIdx = fIdx;
+		}
+	}
+	if (srcFrameCount > 1) keyFrames[keyCount++] = srcFrameCount - 1;
+	return keyCount;
+}
+
+/**
+ * Returns whether all of the frames of the specified animation that lie between the specified start
+ * and end frames can be reproduced, to within the specified tolerance, from the content of the start
+ * and end frames. If the animation does not interpolate, the intervening frames must lie within the
+ * specified tolerance of the start frame.
+ */
+-(BOOL) canReproduceFramesOf: (CC3NodeAnimation*) animation
+					 between: (GLuint) startIdx
+						 and: (GLuint) endIdx
+			   withTolerance: (GLfloat) tolerance {
+	BOOL shouldInterpolate = animation.shouldInterpolate;
+	ccTime startTime = [animation timeAtFrame: startIdx];
+	ccTime frameDur = [animation timeAtFrame: endIdx] - startTime;
+
+	for (GLuint fIdx = startIdx + 1; fIdx < endIdx; fIdx++) {
+		GLfloat fraction = 0.0f;
+		if (shouldInterpolate && frameDur > 0.0f)
+			fraction = ([animation timeAtFrame: fIdx] - startTime) / frameDur;
+
+		if (animation.isAnimatingLocation &&
+			!CC3VectorsAreWithinTolerance(CC3VectorLerp([animation locationAtFrame: startIdx],
+														[animation locationAtFrame: endIdx], fraction),
+										  [animation locationAtFrame: fIdx], tolerance)) return NO;
+
+		if (animation.isAnimatingQuaternion &&
+			!CC3QuaternionsAreWithinTolerance(CC3QuaternionSlerp([animation quaternionAtFrame: startIdx],
+																 [animation quaternionAtFrame: endIdx], fraction),
+											  [animation quaternionAtFrame: fIdx], tolerance)) return NO;
+
+		if (animation.isAnimatingScale &&
+			!CC3VectorsAreWithinTolerance(CC3VectorLerp([animation scaleAtFrame: startIdx],
+														[animation scaleAtFrame: endIdx], fraction),
+										  [animation scaleAtFrame: fIdx], tolerance)) return NO;
+	}
+	return YES;
+}
+
+/**
+ * Allocates the content arrays, as a single memory block, and populates them with the quantized
+ * content of the specified key frames of the specified animation.
+ */
+-(void) populateFrom: (CC3NodeAnimation*) animation atKeyFrames: (GLuint*) keyFrames {
+	BOOL hasLocs = animation.isAnimatingLocation;
+	BOOL hasQuats = animation.isAnimatingQuaternion;
+	BOOL hasScales = animation.isAnimatingScale;
+
+	GLuint elemsPerFrame = 1 + (hasLocs ? 3 : 0) + (hasQuats ? 3 : 0) + (hasScales ? 3 : 0);
+	GLushort* block = calloc(MAX(_frameCount, 1) * elemsPerFrame, sizeof(GLushort));
+	_frameTimes = block;
+	block += _frameCount;
+	_animatedLocations = NULL;
+	if (hasLocs) { _animatedLocations = block; block += _frameCount * 3; }
+	_animatedQuaternions = NULL;
+	if (hasQuats) { _animatedQuaternions = block; block += _frameCount * 3; }
+	_animatedScales = NULL;
+	if (hasScales) { _animatedScales = block; block += _frameCount * 3; }
+
+	// Determine the range covered by each component of the locations and scales
+	CC3Vector locMin = kCC3VectorZero, locMax = kCC3VectorZero;
+	CC3Vector scaleMin = kCC3VectorUnitCube, scaleMax = kCC3VectorUnitCube;
+	for (GLuint kIdx = 0; kIdx < _frameCount; kIdx++) {
+		GLuint fIdx = keyFrames[kIdx];
+		if (hasLocs) {
+			CC3Vector loc = [animation locationAtFrame: fIdx];
+			locMin = (kIdx == 0) ? loc : CC3VectorMinimize(locMin, loc);
+			locMax = (kIdx == 0) ? loc : CC3VectorMaximize(locMax, loc);
+		}
+		if (hasScales) {
+			CC3Vector scale = [animation scaleAtFrame: fIdx];
+			scaleMin = (kIdx == 0) ? scale : CC3VectorMinimize(scaleMin, scale);
+			scaleMax = (kIdx == 0) ? scale : CC3VectorMaximize(scaleMax, scale);
+		}
+	}
+	_locationMinimum = locMin;
+	_locationStep = CC3VectorScaleUniform(CC3VectorDifference(locMax, locMin), 1.0f / kCC3QuantizedMax);
+	_scaleMinimum = scaleMin;
+	_scaleStep = CC3VectorScaleUniform(CC3VectorDifference(scaleMax, scaleMin), 1.0f / kCC3QuantizedMax);
+
+	// Quantize the content of each key frame
+	for (GLuint kIdx = 0; kIdx < _frameCount; kIdx++) {
+		GLuint fIdx = keyFrames[kIdx];
+		_frameTimes[kIdx] = CC3QuantizeFloat([animation timeAtFrame: fIdx], 0.0f, 1.0f / kCC3QuantizedMax);
+		if (hasLocs) CC3QuantizeVector([animation locationAtFrame: fIdx], _locationMinimum, _locationStep,
+									   &_animatedLocations[kIdx * 3]);
+		if (hasQuats) CC3QuantizeQuaternion([animation quaternionAtFrame: fIdx], &_animatedQuaternions[kIdx * 3]);
+		if (hasScales) CC3QuantizeVector([animation scaleAtFrame: fIdx], _scaleMinimum, _scaleStep,
+										 &_animatedScales[kIdx * 3]);
+	}
+}
+
+-(NSString*) description {
+	return [NSString stringWithFormat: @"%@ with %u frames in %u bytes", [self class],
+			_frameCount, self.compressedByteCount];
+}
+
+@end
+
+
 #pragma mark -
 #pragma mark CC3NodeAnimationState
 
@@ -403,6 +792,7 @@ static ccTime _interpolationEpsilon = 0.1f;
 @synthesize isLocationAnimationEnabled=_isLocationAnimationEnabled;
 @synthesize isQuaternionAnimationEnabled=_isQuaternionAnimationEnabled;
 @synthesize isScaleAnimationEnabled=_isScaleAnimationEnabled;
+@synthesize frameCursor=_frameCursor;
 
 -(void) dealloc {
 	_node = nil;			// not retained
@@ -473,6 +863,19 @@ static ccTime _interpolationEpsilon = 0.1f;
 	if (self.isEnabled) [_animation establishFrameAt: t inNodeAnimationState: self];
 }
 
+-(void) establishFrameAt: (ccTime) t
+			withLocation: (CC3Vector) location
+			  quaternion: (CC3Quaternion) quaternion
+				   scale: (CC3Vector) scale {
+	_animationTime = t;
+	if ( !_isEnabled ) return;
+
+	if (self.isAnimatingLocation) _location = location;
+	if (self.isAnimatingQuaternion) _quaternion = quaternion;
+	if (self.isAnimatingScale) _scale = scale;
+	[self markDirty];
+}
+
 
 #pragma mark Allocation and initialization
 
@@ -490,6 +893,7 @@ static ccTime _interpolationEpsilon = 0.1f;
 		_trackID = trackID;
 		_blendingWeight = 1.0f;
 		_animationTime = 0.0f;
+		_frameCursor = 0;
 		_location = kCC3VectorZero;
 		_quaternion = kCC3QuaternionIdentity;
 		_scale = kCC3VectorUnitCube;
@@ -564,3 +968,666 @@ static NSUInteger _lastTrackID = 0;
 }
 
 @end
+
+
+#pragma mark -
+#pragma mark CC3NodeAnimationClip
+
+/**
+ * Linearly interpolates count values between the two specified source arrays by the
+ * specified fraction, into the destination array. Written without branches so that
+ * the compiler can vectorize the loop.
+ */
+static void CC3AnimationClipLerp(GLfloat* restrict dst,
+								 const GLfloat* restrict src0,
+								 const GLfloat* restrict src1,
+								 GLfloat fraction, GLuint count) {
+	for (GLuint i = 0; i < count; i++) dst[i] = src0[i] + ((src1[i] - src0[i]) * fraction);
+}
+
+/** Normalizes count quaternions whose components are held in the specified separate arrays. */
+static void CC3AnimationClipNormalizeQuaternions(GLfloat* restrict qx, GLfloat* restrict qy,
+												 GLfloat* restrict qz, GLfloat* restrict qw,
+												 GLuint count) {
+	for (GLuint i = 0; i < count; i++) {
+		GLfloat lenSq = (qx[i] * qx[i]) + (qy[i] * qy[i]) + (qz[i] * qz[i]) + (qw[i] * qw[i]);
+		GLfloat invLen = (lenSq > 0.0f) ? (1.0f / sqrtf(lenSq)) : 1.0f;
+		qx[i] *= invLen;
+		qy[i] *= invLen;
+		qz[i] *= invLen;
+		qw[i] *= invLen;
+	}
+}
+
+@interface CC3NodeAnimationClip (TemplateMethods)
+-(BOOL) canPackAnimation: (CC3NodeAnimation*) anim like: (CC3ArrayNodeAnimation*) refAnim;
+-(void) packAnimationStates;
+-(GLuint) frameIndexAt: (ccTime) t;
+-(ccTime) timeAtFrame: (GLuint) frameIndex;
+@end
+
+@implementation CC3NodeAnimationClip
+
+@synthesize rootNode=_rootNode, trackID=_trackID, frameCount=_frameCount, jointCount=_jointCount;
+
+-(void) dealloc {
+	[_rootNode release];
+	[_nodes release];
+	[_animationStates release];
+	[_unpackedAnimationStates release];
+	free(_channels[0]);			// All channels and pose arrays share one allocation
+	free(_jointContent);
+	free(_frameTimes);
+	[super dealloc];
+}
+
+-(GLuint) unpackedCount { return _unpackedAnimationStates.count; }
+
+
+#pragma mark Updating
+
+-(void) establishFrameAt: (ccTime) t {
+	LogTrace(@"%@ animating frame at %.4f", self, t);
+
+	[self samplePoseAt: t];
+
+	// Hand the sampled pose to the animation state of each joint
+	GLuint jCnt = _jointCount;
+	for (GLuint jIdx = 0; jIdx < jCnt; jIdx++) {
+		CC3NodeAnimationState* animState = [_animationStates objectAtIndex: jIdx];
+		[animState establishFrameAt: t
+					   withLocation: cc3v(_pose[kCC3AnimationClipChannelLocationX][jIdx],
+										  _pose[kCC3AnimationClipChannelLocationY][jIdx],
+										  _pose[kCC3AnimationClipChannelLocationZ][jIdx])
+						 quaternion: CC3QuaternionMake(_pose[kCC3AnimationClipChannelQuaternionX][jIdx],
+													   _pose[kCC3AnimationClipChannelQuaternionY][jIdx],
+													   _pose[kCC3AnimationClipChannelQuaternionZ][jIdx],
+													   _pose[kCC3AnimationClipChannelQuaternionW][jIdx])
+							  scale: cc3v(_pose[kCC3AnimationClipChannelScaleX][jIdx],
+										  _pose[kCC3AnimationClipChannelScaleY][jIdx],
+										  _pose[kCC3AnimationClipChannelScaleZ][jIdx])];
+	}
+
+	// Animations that could not be packed are sampled individually
+	for (CC3NodeAnimationState* animState in _unpackedAnimationStates) [animState establishFrameAt: t];
+}
+
+-(void) samplePoseAt: (ccTime) t {
+	CC3Assert(t >= 0.0 && t <= 1.0, @"%@ animation frame time %f must be between 0.0 and 1.0", self, t);
+
+	if (_jointCount > 0) {
+		// Determine the frame and interpolation once for all joints, as CC3NodeAnimation does per node
+		GLuint frameIndex = [self frameIndexAt: t];
+		_frameCursor = frameIndex;
+		GLfloat frameInterpolation = 0.0f;
+		ccTime interpEpsilon = [CC3NodeAnimation interpolationEpsilon];
+		if (_shouldInterpolate && (frameIndex < _frameCount - 1)) {
+			ccTime frameTime = [self timeAtFrame: frameIndex];
+			ccTime frameDur = [self timeAtFrame: frameIndex + 1] - frameTime;
+			if (frameDur != 0.0f) frameInterpolation = (t - frameTime) / frameDur;
+			if (frameInterpolation < interpEpsilon) {
+				frameInterpolation = 0.0f;		// use this frame
+			} else if ((1.0f - frameInterpolation) < interpEpsilon) {
+				frameInterpolation = 0.0f;
+				frameIndex++;					// use next frame
+			}
+		}
+
+		// Sample all joints, one channel at a time
+		GLuint jCnt = _jointCount;
+		GLuint nextFrameIndex = MIN(frameIndex + 1, _frameCount - 1);
+		for (GLuint chIdx = 0; chIdx < kCC3AnimationClipChannelCount; chIdx++) {
+			const GLfloat* frame = _channels[chIdx] + (frameIndex * jCnt);
+			if (frameInterpolation > 0.0f) {
+				const GLfloat* nextFrame = _channels[chIdx] + (nextFrameIndex * jCnt);
+				CC3AnimationClipLerp(_pose[chIdx], frame, nextFrame, frameInterpolation, jCnt);
+			} else {
+				memcpy(_pose[chIdx], frame, (jCnt * sizeof(GLfloat)));
+			}
+		}
+		if (frameInterpolation > 0.0f)
+			CC3AnimationClipNormalizeQuaternions(_pose[kCC3AnimationClipChannelQuaternionX],
+												 _pose[kCC3AnimationClipChannelQuaternionY],
+												 _pose[kCC3AnimationClipChannelQuaternionZ],
+												 _pose[kCC3AnimationClipChannelQuaternionW],
+												 jCnt);
+	}
+}
+
+-(const GLfloat*) poseChannel: (CC3AnimationClipChannel) channel { return _pose[channel]; }
+
+-(const GLfloat*) channel: (CC3AnimationClipChannel) channel atFrame: (GLuint) frameIndex {
+	return _channels[channel] + (MIN(frameIndex, _frameCount - 1) * _jointCount);
+}
+
+-(CC3Node*) nodeForJointAt: (GLuint) jointIndex {
+	return ((CC3NodeAnimationState*)[_animationStates objectAtIndex: jointIndex]).node;
+}
+
+-(const CC3AnimationClipContent*) jointContent { return _jointContent; }
+
+/** Returns the time of the specified frame, using the shared frame timing of the packed animations. */
+-(ccTime) timeAtFrame: (GLuint) frameIndex {
+	frameIndex = MIN(frameIndex, _frameCount - 1);
+	if (_frameTimes) return _frameTimes[frameIndex];
+	GLfloat lastIdx = _frameCount - 1;
+	return (lastIdx > 0.0f) ? CLAMP(frameIndex / lastIdx, 0.0f, 1.0f) : 0.0f;
+}
+
+/**
+ * Returns the index of the frame within which the specified time occurs. For variable frame
+ * timing, the shared frame times are searched starting from the frame found last time.
+ * If the specified time is before the first frame, the first frame is returned.
+ */
+-(GLuint) frameIndexAt: (ccTime) t {
+	if ( !_frameTimes ) return (_frameCount - 1) * t;
+	return CC3FrameIndexAtTime(_frameTimes, _frameCount, t, _frameCursor);
+}
+
+
+#pragma mark Allocation and initialization
+
+-(id) init {
+	CC3Assert(NO, @"%@ cannot be initialized without a node and track", self);
+	return nil;
+}
+
+-(id) initFromNode: (CC3Node*) aNode onTrack: (NSUInteger) trackID {
+	CC3Assert(aNode, @"%@ must be created with a valid node.", [self class]);
+	if ( (self = [super init]) ) {
+		_rootNode = [aNode retain];
+		_trackID = trackID;
+		_nodes = [CCArray new];							// retained
+		_animationStates = [CCArray new];				// retained
+		_unpackedAnimationStates = [CCArray new];		// retained
+		_frameTimes = NULL;
+		_jointContent = NULL;
+		_frameCount = 0;
+		_frameCursor = 0;
+		_jointCount = 0;
+		_shouldInterpolate = YES;
+
+		// Collect the animation states on the track, packing those that share the timing of the first one.
+		CC3ArrayNodeAnimation* refAnim = nil;
+		for (CC3Node* node in [aNode flatten]) {
+			CC3NodeAnimationState* animState = [node getAnimationStateOnTrack: trackID];
+			if ( !animState ) continue;
+
+			[_nodes addObject: node];
+			CC3NodeAnimation* anim = animState.animation;
+			if ( !refAnim && anim.frameCount > 0 && [anim isKindOfClass: [CC3ArrayNodeAnimation class]] )
+				refAnim = (CC3ArrayNodeAnimation*)anim;
+
+			if ([self canPackAnimation: anim like: refAnim])
+				[_animationStates addObject: animState];
+			else
+				[_unpackedAnimationStates addObject: animState];
+		}
+
+		_frameCount = refAnim.frameCount;
+		_shouldInterpolate = refAnim ? refAnim.shouldInterpolate : YES;
+		if (refAnim.frameTimes) {
+			_frameTimes = malloc(_frameCount * sizeof(ccTime));
+			memcpy(_frameTimes, refAnim.frameTimes, (_frameCount * sizeof(ccTime)));
+		}
+		[self packAnimationStates];
+		LogTrace(@"Created %@", self);
+	}
+	return self;
+}
+
++(id) clipFromNode: (CC3Node*) aNode onTrack: (NSUInteger) trackID {
+	return [[[self alloc] initFromNode: aNode onTrack: trackID] autorelease];
+}
+
+/**
+ * Returns whether the specified animation can be packed into a clip whose frame structure
+ * is defined by the specified reference animation.
+ */
+-(BOOL) canPackAnimation: (CC3NodeAnimation*) anim like: (CC3ArrayNodeAnimation*) refAnim {
+	if ( !refAnim || ![anim isKindOfClass: [CC3ArrayNodeAnimation class]] ) return NO;
+
+	CC3ArrayNodeAnimation* arrayAnim = (CC3ArrayNodeAnimation*)anim;
+	if (arrayAnim.frameCount != refAnim.frameCount) return NO;
+	if (arrayAnim.shouldInterpolate != refAnim.shouldInterpolate) return NO;
+
+	ccTime* frameTimes = arrayAnim.frameTimes;
+	ccTime* refFrameTimes = refAnim.frameTimes;
+	if (frameTimes == refFrameTimes) return YES;
+	if ( !(frameTimes && refFrameTimes) ) return NO;
+	return memcmp(frameTimes, refFrameTimes, (refAnim.frameCount * sizeof(ccTime))) == 0;
+}
+
+/**
+ * Copies the animation content of each packed animation state into the channel arrays, which,
+ * together with the pose arrays, are allocated as a single block. Channels that an animation
+ * does not animate are filled with the identity value for that channel.
+ */
+-(void) packAnimationStates {
+	_jointCount = _animationStates.count;
+	if (_jointCount == 0) return;
+
+	GLuint jCnt = _jointCount;
+	size_t channelLen = _frameCount * jCnt;
+	GLfloat* block = calloc((channelLen + jCnt) * kCC3AnimationClipChannelCount, sizeof(GLfloat));
+	for (GLuint chIdx = 0; chIdx < kCC3AnimationClipChannelCount; chIdx++) {
+		_channels[chIdx] = block + (chIdx * channelLen);
+		_pose[chIdx] = block + (kCC3AnimationClipChannelCount * channelLen) + (chIdx * jCnt);
+	}
+	_jointContent = calloc(jCnt, sizeof(CC3AnimationClipContent));
+
+	for (GLuint jIdx = 0; jIdx < jCnt; jIdx++) {
+		CC3ArrayNodeAnimation* anim = (CC3ArrayNodeAnimation*)((CC3NodeAnimationState*)[_animationStates objectAtIndex: jIdx]).animation;
+		CC3Vector* locs = anim.animatedLocations;
+		CC3Quaternion* quats = anim.animatedQuaternions;
+		CC3Vector* scales = anim.animatedScales;
+		CC3Quaternion prevQuat = kCC3QuaternionIdentity;
+
+		CC3AnimationClipContent content = 0;
+		if (locs) content |= kCC3AnimationClipContentLocation;
+		if (quats) content |= kCC3AnimationClipContentQuaternion;
+		if (scales) content |= kCC3AnimationClipContentScale;
+		_jointContent[jIdx] = content;
+
+		for (GLuint fIdx = 0; fIdx < _frameCount; fIdx++) {
+			size_t elemIdx = (fIdx * jCnt) + jIdx;
+
+			CC3Vector loc = locs ? locs[fIdx] : kCC3VectorZero;
+			_channels[kCC3AnimationClipChannelLocationX][elemIdx] = loc.x;
+			_channels[kCC3AnimationClipChannelLocationY][elemIdx] = loc.y;
+			_channels[kCC3AnimationClipChannelLocationZ][elemIdx] = loc.z;
+
+			// Keep each quaternion in the same hemisphere as the previous frame, so linear
+			// interpolation between frames takes the shortest path.
+			CC3Quaternion quat = quats ? quats[fIdx] : kCC3QuaternionIdentity;
+			if (fIdx > 0 && CC3QuaternionDot(quat, prevQuat) < 0.0f) quat = CC3QuaternionNegate(quat);
+			prevQuat = quat;
+			_channels[kCC3AnimationClipChannelQuaternionX][elemIdx] = quat.x;
+			_channels[kCC3AnimationClipChannelQuaternionY][elemIdx] = quat.y;
+			_channels[kCC3AnimationClipChannelQuaternionZ][elemIdx] = quat.z;
+			_channels[kCC3AnimationClipChannelQuaternionW][elemIdx] = quat.w;
+
+			CC3Vector scale = scales ? scales[fIdx] : kCC3VectorUnitCube;
+			_channels[kCC3AnimationClipChannelScaleX][elemIdx] = scale.x;
+			_channels[kCC3AnimationClipChannelScaleY][elemIdx] = scale.y;
+			_channels[kCC3AnimationClipChannelScaleZ][elemIdx] = scale.z;
+		}
+	}
+}
+
+-(NSString*) description {
+	return [NSString stringWithFormat: @"%@ on track %u of %@ packing %u nodes over %u frames (%u unpacked)",
+			[self class], _trackID, _rootNode, _jointCount, _frameCount, self.unpackedCount];
+}
+
+@end
+
+
+#pragma mark -
+#pragma mark CC3NodeAnimationBlendTree
+
+@interface CC3NodeAnimationBlendTree (TemplateMethods)
+-(GLuint) addLayerWithClip: (CC3NodeAnimationClip*) clip isAdditive: (BOOL) isAdditive;
+-(void) ensureJointCapacity: (GLuint) jointCount;
+-(void) captureRestPoseOfJoint: (GLuint) jointIndex;
+-(void) accumulateClip: (CC3NodeAnimationClip*) clip withWeight: (GLfloat) weight jointMap: (const GLuint*) jointMap;
+-(void) normalizePose;
+-(void) addClip: (CC3NodeAnimationClip*) clip withWeight: (GLfloat) weight jointMap: (const GLuint*) jointMap;
+-(void) applyPose;
+@end
+
+@implementation CC3NodeAnimationBlendTree
+
+@synthesize layerCount=_layerCount;
+
+-(void) dealloc {
+	for (GLuint lIdx = 0; lIdx < _layerCount; lIdx++) free(_layers[lIdx].jointMap);
+	free(_layers);
+	free(_pose[0]);				// All pose and weight arrays share one allocation
+	free(_restLocations);
+	free(_restQuaternions);
+	free(_restScales);
+	[_joints release];
+	[_clips release];
+	[super dealloc];
+}
+
+-(GLuint) jointCount { return _joints.count; }
+
+
+#pragma mark Layers
+
+-(GLuint) addLayerWithClip: (CC3NodeAnimationClip*) clip { return [self addLayerWithClip: clip isAdditive: NO]; }
+
+-(GLuint) addAdditiveLayerWithClip: (CC3NodeAnimationClip*) clip { return [self addLayerWithClip: clip isAdditive: YES]; }
+
+/** Adds a layer for the clip, mapping each joint of the clip to a joint of this blend tree. */
+-(GLuint) addLayerWithClip: (CC3NodeAnimationClip*) clip isAdditive: (BOOL) isAdditive {
+	CC3Assert(clip, @"%@ cannot add a nil clip", self);
+	CC3Assert(clip.unpackedCount == 0, @"%@ cannot blend %@ because the animations of %u of its nodes"
+			  @" could not be packed into the clip", self, clip, clip.unpackedCount);
+
+	if (_layerCount == _layerCapacity) {
+		_layerCapacity = MAX(_layerCapacity * 2, 4);
+		_layers = realloc(_layers, _layerCapacity * sizeof(CC3NodeAnimationBlendLayer));
+	}
+
+	GLuint clipJointCnt = clip.jointCount;
+	GLuint* jointMap = calloc(MAX(clipJointCnt, 1), sizeof(GLuint));
+	for (GLuint cjIdx = 0; cjIdx < clipJointCnt; cjIdx++) {
+		CC3Node* node = [clip nodeForJointAt: cjIdx];
+		NSUInteger tjIdx = [_joints indexOfObject: node];
+		if (tjIdx == NSNotFound) {
+			tjIdx = _joints.count;
+			[_joints addObject: node];
+			[self ensureJointCapacity: self.jointCount];
+			[self captureRestPoseOfJoint: tjIdx];
+		}
+		jointMap[cjIdx] = tjIdx;
+	}
+
+	CC3NodeAnimationBlendLayer* layer = &_layers[_layerCount];
+	layer->weight = 0.0f;
+	layer->time = 0.0f;
+	layer->jointMap = jointMap;
+	layer->isAdditive = isAdditive;
+	[_clips addObject: clip];
+
+	LogTrace(@"%@ added %@layer %u with %@", self, (isAdditive ? @"additive " : @""), _layerCount, clip);
+	return _layerCount++;
+}
+
+/**
+ * Ensures the pose, weight, and rest pose arrays can hold the specified number of joints.
+ * The pose and weight arrays are scratch space for the evaluate method, so their contents
+ * are not preserved. The contents of the rest pose arrays are preserved.
+ */
+-(void) ensureJointCapacity: (GLuint) jointCount {
+	if (jointCount <= _jointCapacity) return;
+
+	_jointCapacity = MAX(jointCount, _jointCapacity * 2);
+	_restLocations = realloc(_restLocations, _jointCapacity * sizeof(CC3Vector));
+	_restQuaternions = realloc(_restQuaternions, _jointCapacity * sizeof(CC3Quaternion));
+	_restScales = realloc(_restScales, _jointCapacity * sizeof(CC3Vector));
+	free(_pose[0]);
+	GLfloat* block = calloc(_jointCapacity * (kCC3AnimationClipChannelCount + 3), sizeof(GLfloat));
+	for (GLuint chIdx = 0; chIdx < kCC3AnimationClipChannelCount; chIdx++)
+		_pose[chIdx] = block + (chIdx * _jointCapacity);
+	_locationWeights = block + (kCC3AnimationClipChannelCount * _jointCapacity);
+	_quaternionWeights = _locationWeights + _jointCapacity;
+	_scaleWeights = _quaternionWeights + _jointCapacity;
+}
+
+/** Captures the current location, quaternion, and scale of the node at the specified joint as its rest pose. */
+-(void) captureRestPoseOfJoint: (GLuint) jointIndex {
+	CC3Node* node = [_joints objectAtIndex: jointIndex];
+	_restLocations[jointIndex] = node.location;
+	_restQuaternions[jointIndex] = node.quaternion;
+	_restScales[jointIndex] = node.scale;
+}
+
+-(CC3NodeAnimationClip*) clipOnLayer: (GLuint) layerIndex { return [_clips objectAtIndex: layerIndex]; }
+
+-(GLfloat) weightOnLayer: (GLuint) layerIndex {
+	CC3Assert(layerIndex < _layerCount, @"%@ layer index %u is out of range", self, layerIndex);
+	return _layers[layerIndex].weight;
+}
+
+-(void) setWeight: (GLfloat) weight onLayer: (GLuint) layerIndex {
+	CC3Assert(layerIndex < _layerCount, @"%@ layer index %u is out of range", self, layerIndex);
+	_layers[layerIndex].weight = MAX(weight, 0.0f);
+}
+
+-(ccTime) timeOnLayer: (GLuint) layerIndex {
+	CC3Assert(layerIndex < _layerCount, @"%@ layer index %u is out of range", self, layerIndex);
+	return _layers[layerIndex].time;
+}
+
+-(void) setTime: (ccTime) t onLayer: (GLuint) layerIndex {
+	CC3Assert(layerIndex < _layerCount, @"%@ layer index %u is out of range", self, layerIndex);
+	_layers[layerIndex].time = CLAMP(t, 0.0f, 1.0f);
+}
+
+-(void) crossFadeFromLayer: (GLuint) fromLayerIndex toLayer: (GLuint) toLayerIndex by: (GLfloat) fraction {
+	fraction = CLAMP(fraction, 0.0f, 1.0f);
+	[self setWeight: (1.0f - fraction) onLayer: fromLayerIndex];
+	[self setWeight: fraction onLayer: toLayerIndex];
+}
+
+
+#pragma mark Evaluating
+
+-(void) evaluate {
+	GLuint jCnt = self.jointCount;
+	if (jCnt == 0) return;
+
+	memset(_pose[0], 0, (_jointCapacity * (kCC3AnimationClipChannelCount + 3) * sizeof(GLfloat)));
+
+	// Blend the normal layers, skipping any that have no weight
+	for (GLuint lIdx = 0; lIdx < _layerCount; lIdx++) {
+		CC3NodeAnimationBlendLayer* layer = &_layers[lIdx];
+		if (layer->isAdditive || layer->weight <= 0.0f) continue;
+
+		CC3NodeAnimationClip* clip = [_clips objectAtIndex: lIdx];
+		[clip samplePoseAt: layer->time];
+		[self accumulateClip: clip withWeight: layer->weight jointMap: layer->jointMap];
+	}
+	[self normalizePose];
+
+	// Add the additive layers on top, again skipping any that have no weight
+	for (GLuint lIdx = 0; lIdx < _layerCount; lIdx++) {
+		CC3NodeAnimationBlendLayer* layer = &_layers[lIdx];
+		if ( !layer->isAdditive || layer->weight <= 0.0f) continue;
+
+		CC3NodeAnimationClip* clip = [_clips objectAtIndex: lIdx];
+		[clip samplePoseAt: layer->time];
+		[self addClip: clip withWeight: layer->weight jointMap: layer->jointMap];
+	}
+
+	[self applyPose];
+}
+
+/**
+ * Adds the weighted pose of the specified clip to the pose accumulated in this blend tree, and
+ * accumulates the weight of each content type for each joint. Each quaternion is flipped, if
+ * needed, into the same hemisphere as the quaternion accumulated so far for its joint.
+ */
+-(void) accumulateClip: (CC3NodeAnimationClip*) clip withWeight: (GLfloat) weight jointMap: (const GLuint*) jointMap {
+	const GLfloat* lx = [clip poseChannel: kCC3AnimationClipChannelLocationX];
+	const GLfloat* ly = [clip poseChannel: kCC3AnimationClipChannelLocationY];
+	const GLfloat* lz = [clip poseChannel: kCC3AnimationClipChannelLocationZ];
+	const GLfloat* qx = [clip poseChannel: kCC3AnimationClipChannelQuaternionX];
+	const GLfloat* qy = [clip poseChannel: kCC3AnimationClipChannelQuaternionY];
+	const GLfloat* qz = [clip poseChannel: kCC3AnimationClipChannelQuaternionZ];
+	const GLfloat* qw = [clip poseChannel: kCC3AnimationClipChannelQuaternionW];
+	const GLfloat* sx = [clip poseChannel: kCC3AnimationClipChannelScaleX];
+	const GLfloat* sy = [clip poseChannel: kCC3AnimationClipChannelScaleY];
+	const GLfloat* sz = [clip poseChannel: kCC3AnimationClipChannelScaleZ];
+	const CC3AnimationClipContent* content = clip.jointContent;
+
+	GLuint cjCnt = clip.jointCount;
+	for (GLuint cjIdx = 0; cjIdx < cjCnt; cjIdx++) {
+		GLuint tjIdx = jointMap[cjIdx];
+		CC3AnimationClipContent jc = content[cjIdx];
+
+		if (jc & kCC3AnimationClipContentLocation) {
+			_pose[kCC3AnimationClipChannelLocationX][tjIdx] += weight * lx[cjIdx];
+			_pose[kCC3AnimationClipChannelLocationY][tjIdx] += weight * ly[cjIdx];
+			_pose[kCC3AnimationClipChannelLocationZ][tjIdx] += weight * lz[cjIdx];
+			_locationWeights[tjIdx] += weight;
+		}
+		if (jc & kCC3AnimationClipContentQuaternion) {
+			GLfloat dot = (_pose[kCC3AnimationClipChannelQuaternionX][tjIdx] * qx[cjIdx]) +
+						  (_pose[kCC3AnimationClipChannelQuaternionY][tjIdx] * qy[cjIdx]) +
+						  (_pose[kCC3AnimationClipChannelQuaternionZ][tjIdx] * qz[cjIdx]) +
+						  (_pose[kCC3AnimationClipChannelQuaternionW][tjIdx] * qw[cjIdx]);
+			GLfloat sWt = (dot < 0.0f) ? -weight : weight;
+			_pose[kCC3AnimationClipChannelQuaternionX][tjIdx] += sWt * qx[cjIdx];
+			_pose[kCC3AnimationClipChannelQuaternionY][tjIdx] += sWt * qy[cjIdx];
+			_pose[kCC3AnimationClipChannelQuaternionZ][tjIdx] += sWt * qz[cjIdx];
+			_pose[kCC3AnimationClipChannelQuaternionW][tjIdx] += sWt * qw[cjIdx];
+			_quaternionWeights[tjIdx] += weight;
+		}
+		if (jc & kCC3AnimationClipContentScale) {
+			_pose[kCC3AnimationClipChannelScaleX][tjIdx] += weight * sx[cjIdx];
+			_pose[kCC3AnimationClipChannelScaleY][tjIdx] += weight * sy[cjIdx];
+			_pose[kCC3AnimationClipChannelScaleZ][tjIdx] += weight * sz[cjIdx];
+			_scaleWeights[tjIdx] += weight;
+		}
+	}
+}
+
+/** Divides the accumulated pose of each joint by its accumulated weights, and normalizes quaternions. */
+-(void) normalizePose {
+	GLuint jCnt = self.jointCount;
+	for (GLuint jIdx = 0; jIdx < jCnt; jIdx++) {
+		GLfloat lWt = _locationWeights[jIdx];
+		if (lWt > 0.0f) {
+			GLfloat invWt = 1.0f / lWt;
+			_pose[kCC3AnimationClipChannelLocationX][jIdx] *= invWt;
+			_pose[kCC3AnimationClipChannelLocationY][jIdx] *= invWt;
+			_pose[kCC3AnimationClipChannelLocationZ][jIdx] *= invWt;
+		}
+		GLfloat sWt = _scaleWeights[jIdx];
+		if (sWt > 0.0f) {
+			GLfloat invWt = 1.0f / sWt;
+			_pose[kCC3AnimationClipChannelScaleX][jIdx] *= invWt;
+			_pose[kCC3AnimationClipChannelScaleY][jIdx] *= invWt;
+			_pose[kCC3AnimationClipChannelScaleZ][jIdx] *= invWt;
+		}
+	}
+	CC3AnimationClipNormalizeQuaternions(_pose[kCC3AnimationClipChannelQuaternionX],
+										 _pose[kCC3AnimationClipChannelQuaternionY],
+										 _pose[kCC3AnimationClipChannelQuaternionZ],
+										 _pose[kCC3AnimationClipChannelQuaternionW],
+										 jCnt);
+}
+
+/**
+ * Adds the difference between the pose of the specified clip and its first frame, scaled by the
+ * specified weight, to the blended pose. Joints that have not been animated by any normal layer
+ * use the rest pose of the node, captured when it was added to this blend tree, as the base to
+ * which the difference is added. Using the current state of the node instead would compound the
+ * difference on each evaluation, because that state is the result of the previous evaluation.
+ */
+-(void) addClip: (CC3NodeAnimationClip*) clip withWeight: (GLfloat) weight jointMap: (const GLuint*) jointMap {
+	const CC3AnimationClipContent* content = clip.jointContent;
+	GLuint cjCnt = clip.jointCount;
+	for (GLuint cjIdx = 0; cjIdx < cjCnt; cjIdx++) {
+		GLuint tjIdx = jointMap[cjIdx];
+		CC3AnimationClipContent jc = content[cjIdx];
+
+		if (jc & kCC3AnimationClipContentLocation) {
+			if (_locationWeights[tjIdx] <= 0.0f) {
+				CC3Vector base = _restLocations[tjIdx];
+				_pose[kCC3AnimationClipChannelLocationX][tjIdx] = base.x;
+				_pose[kCC3AnimationClipChannelLocationY][tjIdx] = base.y;
+				_pose[kCC3AnimationClipChannelLocationZ][tjIdx] = base.z;
+				_locationWeights[tjIdx] = 1.0f;
+			}
+			for (GLuint chIdx = kCC3AnimationClipChannelLocationX; chIdx <= kCC3AnimationClipChannelLocationZ; chIdx++)
+				_pose[chIdx][tjIdx] += weight * ([clip poseChannel: chIdx][cjIdx] - [clip channel: chIdx atFrame: 0][cjIdx]);
+		}
+
+		if (jc & kCC3AnimationClipContentQuaternion) {
+			CC3Quaternion base;
+			if (_quaternionWeights[tjIdx] > 0.0f) {
+				base = CC3QuaternionMake(_pose[kCC3AnimationClipChannelQuaternionX][tjIdx],
+										 _pose[kCC3AnimationClipChannelQuaternionY][tjIdx],
+										 _pose[kCC3AnimationClipChannelQuaternionZ][tjIdx],
+										 _pose[kCC3AnimationClipChannelQuaternionW][tjIdx]);
+			} else {
+				base = _restQuaternions[tjIdx];
+				_quaternionWeights[tjIdx] = 1.0f;
+			}
+			CC3Quaternion q = CC3QuaternionMake([clip poseChannel: kCC3AnimationClipChannelQuaternionX][cjIdx],
+												[clip poseChannel: kCC3AnimationClipChannelQuaternionY][cjIdx],
+												[clip poseChannel: kCC3AnimationClipChannelQuaternionZ][cjIdx],
+												[clip poseChannel: kCC3AnimationClipChannelQuaternionW][cjIdx]);
+			CC3Quaternion ref = CC3QuaternionMake([clip channel: kCC3AnimationClipChannelQuaternionX atFrame: 0][cjIdx],
+												  [clip channel: kCC3AnimationClipChannelQuaternionY atFrame: 0][cjIdx],
+												  [clip channel: kCC3AnimationClipChannelQuaternionZ atFrame: 0][cjIdx],
+												  [clip channel: kCC3AnimationClipChannelQuaternionW atFrame: 0][cjIdx]);
+
+			// Scale the rotation difference by the weight using nlerp from the identity rotation.
+			CC3Quaternion delta = CC3QuaternionMultiply(q, CC3QuaternionConjugate(ref));
+			if (delta.w < 0.0f) delta = CC3QuaternionNegate(delta);
+			delta = CC3QuaternionNormalize(CC3QuaternionMake((delta.x * weight),
+															 (delta.y * weight),
+															 (delta.z * weight),
+															 (1.0f - weight) + (delta.w * weight)));
+			CC3Quaternion rslt = CC3QuaternionMultiply(delta, base);
+			_pose[kCC3AnimationClipChannelQuaternionX][tjIdx] = rslt.x;
+			_pose[kCC3AnimationClipChannelQuaternionY][tjIdx] = rslt.y;
+			_pose[kCC3AnimationClipChannelQuaternionZ][tjIdx] = rslt.z;
+			_pose[kCC3AnimationClipChannelQuaternionW][tjIdx] = rslt.w;
+		}
+
+		if (jc & kCC3AnimationClipContentScale) {
+			if (_scaleWeights[tjIdx] <= 0.0f) {
+				CC3Vector base = _restScales[tjIdx];
+				_pose[kCC3AnimationClipChannelScaleX][tjIdx] = base.x;
+				_pose[kCC3AnimationClipChannelScaleY][tjIdx] = base.y;
+				_pose[kCC3AnimationClipChannelScaleZ][tjIdx] = base.z;
+				_scaleWeights[tjIdx] = 1.0f;
+			}
+			for (GLuint chIdx = kCC3AnimationClipChannelScaleX; chIdx <= kCC3AnimationClipChannelScaleZ; chIdx++) {
+				GLfloat ref = [clip channel: chIdx atFrame: 0][cjIdx];
+				GLfloat ratio = (ref != 0.0f) ? ([clip poseChannel: chIdx][cjIdx] / ref) : 1.0f;
+				_pose[chIdx][tjIdx] *= 1.0f + (weight * (ratio - 1.0f));
+			}
+		}
+	}
+}
+
+/** Applies the blended pose to each joint that was animated by at least one layer. */
+-(void) applyPose {
+	GLuint jCnt = self.jointCount;
+	for (GLuint jIdx = 0; jIdx < jCnt; jIdx++) {
+		CC3Node* node = [_joints objectAtIndex: jIdx];
+		if (_locationWeights[jIdx] > 0.0f)
+			node.location = cc3v(_pose[kCC3AnimationClipChannelLocationX][jIdx],
+								 _pose[kCC3AnimationClipChannelLocationY][jIdx],
+								 _pose[kCC3AnimationClipChannelLocationZ][jIdx]);
+		if (_quaternionWeights[jIdx] > 0.0f)
+			node.quaternion = CC3QuaternionMake(_pose[kCC3AnimationClipChannelQuaternionX][jIdx],
+												_pose[kCC3AnimationClipChannelQuaternionY][jIdx],
+												_pose[kCC3AnimationClipChannelQuaternionZ][jIdx],
+												_pose[kCC3AnimationClipChannelQuaternionW][jIdx]);
+		if (_scaleWeights[jIdx] > 0.0f)
+			node.scale = cc3v(_pose[kCC3AnimationClipChannelScaleX][jIdx],
+							  _pose[kCC3AnimationClipChannelScaleY][jIdx],
+							  _pose[kCC3AnimationClipChannelScaleZ][jIdx]);
+	}
+}
+
+
+#pragma mark Allocation and initialization
+
+-(id) init {
+	if ( (self = [super init]) ) {
+		_joints = [CCArray new];		// retained
+		_clips = [CCArray new];			// retained
+		_layers = NULL;
+		_layerCount = 0;
+		_layerCapacity = 0;
+		_jointCapacity = 0;
+		for (GLuint chIdx = 0; chIdx < kCC3AnimationClipChannelCount; chIdx++) _pose[chIdx] = NULL;
+		_locationWeights = NULL;
+		_quaternionWeights = NULL;
+		_scaleWeights = NULL;
+		_restLocations = NULL;
+		_restQuaternions = NULL;
+		_restScales = NULL;
+	}
+	return self;
+}
+
++(id) blendTree { return [[[self alloc] init] autorelease]; }
+
+-(NSString*) description {
+	return [NSString stringWithFormat: @"%@ with %u layers animating %u nodes",
+			[self class], _layerCount, self.jointCount];
+}
+
+@end
@@ -245,6 +245,17 @@
  */
 -(void) generateMipmap;
 
+/**
+ * Returns an estimate of the amount of GL memory, in bytes, occupied by the contained
+ * CCTexture2D, including any mipmap. Returns zero if the texture property is nil.
+ *
+ * Since the texture may be shared with other instances of CC3Texture, this is not
+ * the amount of memory that would be freed by deallocating this instance.
+ *
+ * This property simply returns the value of the cc3MemorySize property of the contained CCTexture2D.
+ */
+@property(nonatomic, readonly) NSUInteger memorySize;
+
 /**
  * Returns whether a mipmap should be generated for any textures that are loaded
  * via the loadTextureFile: method of this instance, or through one of the instance
@@ -771,6 +782,24 @@
  */
 -(BOOL) cc3GenerateMipmapIfNeeded;
 
+
+#pragma mark Memory usage
+
+/**
+ * Returns the number of bits occupied by each texel of this texture, as determined by its pixelFormat.
+ *
+ * For the compressed PVRTC formats, this is the average number of bits per texel.
+ */
+@property(nonatomic, readonly) GLuint cc3BitsPerPixel;
+
+/**
+ * Returns an estimate of the amount of GL memory, in bytes, occupied by this texture.
+ *
+ * This is calculated from the pixelsWide, pixelsHigh and cc3BitsPerPixel properties. If the
+ * cc3HasMipmap property is YES, the estimate is increased by a third, to account for the mipmap.
+ */
+@property(nonatomic, readonly) NSUInteger cc3MemorySize;
+
 @end
 
 
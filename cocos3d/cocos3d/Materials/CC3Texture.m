@@ -238,6 +238,8 @@ static ccTexParams _defaultTextureParameters = { GL_LINEAR_MIPMAP_NEAREST, GL_LI
 
 -(void) generateMipmap { [_texture cc3GenerateMipmapIfNeeded]; }
 
+-(NSUInteger) memorySize { return _texture ? _texture.cc3MemorySize : 0; }
+
 // Protected methods for copying
 -(GLenum) rawMinifyingFunction { return _minifyingFunction; }
 
@@ -479,6 +481,34 @@ static CC3CCTexture2DState kCC3InitialCCTexture2DState = { NO, YES };
 
 -(BOOL) cc3IsNPOT { return self.cc3WidthIsNPOT || self.cc3HeightIsNPOT; }
 
+
+#pragma mark Memory usage
+
+-(GLuint) cc3BitsPerPixel {
+	switch (self.pixelFormat) {
+		case kCCTexture2DPixelFormat_RGB565:
+		case kCCTexture2DPixelFormat_RGBA4444:
+		case kCCTexture2DPixelFormat_RGB5A1:
+		case kCCTexture2DPixelFormat_AI88:
+			return 16;
+		case kCCTexture2DPixelFormat_A8:
+		case kCCTexture2DPixelFormat_I8:
+			return 8;
+		case kCCTexture2DPixelFormat_PVRTC4:
+			return 4;
+		case kCCTexture2DPixelFormat_PVRTC2:
+			return 2;
+		case kCCTexture2DPixelFormat_RGBA8888:
+		default:
+			return 32;
+	}
+}
+
+-(NSUInteger) cc3MemorySize {
+	NSUInteger memSize = (NSUInteger)self.pixelsWide * self.pixelsHigh * self.cc3BitsPerPixel / 8;
+	return self.cc3HasMipmap ? (memSize + (memSize / 3)) : memSize;
+}
+
 @end
 
 
@@ -0,0 +1,317 @@
+/*
+ * CC3TextureManager.h
+ *
+ * cocos3d 2.0.0
+ * Author: Bill Hollings
+ * Copyright (c) 2010-2013 The Brenwill Workshop Ltd. All rights reserved.
+ * http://www.brenwill.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * http://en.wikipedia.org/wiki/MIT_License
+ */
+
+/** @file */	// Doxygen marker
+
+
+#import "CC3Texture.h"
+
+
+/** The default value of the initialResolution property of the CC3TextureManager. */
+#define kCC3DefaultTextureInitialResolution		64
+
+/** The default value of the maximumConcurrentLoads property of the CC3TextureManager. */
+#define kCC3DefaultTextureMaximumConcurrentLoads	2
+
+/** The default value of the idleInterval property of the CC3TextureManager. */
+#define kCC3DefaultTextureIdleInterval			1.0
+
+
+#pragma mark -
+#pragma mark CC3ManagedTexture2D
+
+/**
+ * CC3ManagedTexture2D is a CC3Texture2D whose content is loaded from an image file, and held
+ * by the CC3TextureManager, at a resolution that follows how large the texture appears on screen.
+ *
+ * The texture is loaded at several levels of resolution. Level zero is the full resolution of
+ * the image file, and each successive level halves the width and height of the level before it.
+ * Only one level is held in GL memory at a time, along with its mipmap, if the texture has one.
+ * The width and height of this texture, as reported by the pixelsWide and pixelsHigh properties,
+ * are those of the level currently held in GL memory.
+ *
+ * Instances are created by the CC3TextureManager, and should not be instantiated directly.
+ * Until the first level has been loaded, the texture content is transparent black.
+ */
+@interface CC3ManagedTexture2D : CC3Texture2D {
+	NSString* _filePath;
+	GLuint _fullWidth;
+	GLuint _fullHeight;
+	GLuint _levelCount;
+	GLuint _residentLevel;
+	GLuint _loadingLevel;
+	GLuint _demandedLevel;
+	GLuint _glMipmapCount;
+	NSTimeInterval _lastDrawTime;
+	NSUInteger _useCount;
+	BOOL _shouldMipmap : 1;
+	BOOL _isLoading : 1;
+	BOOL _hasLoadFailed : 1;
+}
+
+/** The absolute path of the image file from which this texture is loaded. */
+@property(nonatomic, retain, readonly) NSString* filePath;
+
+/** The width of the image file, which is the width of the texture at level zero. */
+@property(nonatomic, readonly) GLuint fullWidth;
+
+/** The height of the image file, which is the height of the texture at level zero. */
+@property(nonatomic, readonly) GLuint fullHeight;
+
+/**
+ * The number of levels of resolution at which this texture can be loaded.
+ *
+ * The coarsest level is the first level whose larger dimension does not exceed the
+ * initialResolution property of the CC3TextureManager. Since the width and height of
+ * each level must be exactly half of those of the level before it, an image file
+ * whose dimensions are odd has only one level.
+ */
+@property(nonatomic, readonly) GLuint levelCount;
+
+/**
+ * The level of resolution currently held in GL memory. Returns the value of the
+ * levelCount property if no level has been loaded yet.
+ */
+@property(nonatomic, readonly) GLuint residentLevel;
+
+/** The finest level of resolution requested by the most recent drawing of this texture. */
+@property(nonatomic, readonly) GLuint demandedLevel;
+
+/**
+ * The time at which this texture was most recently drawn, as measured by
+ * NSDate timeIntervalSinceReferenceDate, or zero if it has not been drawn yet.
+ */
+@property(nonatomic, readonly) NSTimeInterval lastDrawTime;
+
+/** Returns whether a level of resolution is currently being loaded for this texture. */
+@property(nonatomic, readonly) BOOL isLoading;
+
+/**
+ * Returns whether this texture is currently held by any CC3ManagedTexture.
+ *
+ * Each CC3ManagedTexture counts itself as a user of this texture while it holds it. The
+ * CC3TextureManager only removes textures that are not in use, and are not being loaded.
+ */
+@property(nonatomic, readonly) BOOL isInUse;
+
+/**
+ * Returns the amount of GL memory, in bytes, occupied by this texture when the
+ * specified level of resolution is loaded, including its mipmap, if it has one.
+ */
+-(NSUInteger) memorySizeAtLevel: (GLuint) level;
+
+/**
+ * Notes that this texture is being drawn across the specified number of pixels, selects the
+ * coarsest level of resolution that provides at least that many texels across the larger
+ * dimension of the texture, and asks the CC3TextureManager to load that level if it is finer
+ * than the level currently held in GL memory.
+ *
+ * This method is invoked automatically by CC3ManagedTexture each time it is drawn.
+ */
+-(void) noteDemandedResolution: (GLfloat) pixels;
+
+@end
+
+
+#pragma mark -
+#pragma mark CC3ManagedTexture
+
+/**
+ * CC3ManagedTexture is a CC3Texture whose texture is held by the CC3TextureManager.
+ *
+ * Each time this texture is drawn, it estimates how large the mesh node it is being drawn on
+ * appears on screen, and, if its texture is a CC3ManagedTexture2D, reports that demand to the
+ * texture, so that the texture can be streamed to the resolution required to draw that node.
+ * While it holds a CC3ManagedTexture2D, this texture marks that texture as being in use.
+ *
+ * Instances are retrieved from the textureFromFile: method of the CC3TextureManager. Since the
+ * CC3TextureManager removes textures that are no longer in use by any CC3ManagedTexture when it
+ * needs to free memory, each material should retain the CC3ManagedTexture it is drawn with.
+ */
+@interface CC3ManagedTexture : CC3Texture {
+	GLfloat _resolutionScale;
+}
+
+/**
+ * A factor that is applied to the on-screen size of the node drawn with this texture, to
+ * determine the resolution of texture that is required. Increase the value of this property
+ * for textures that are repeated across the mesh, or to favour sharper textures.
+ *
+ * The initial value of this property is one.
+ */
+@property(nonatomic, assign) GLfloat resolutionScale;
+
+@end
+
+
+#pragma mark -
+#pragma mark CC3TextureManager
+
+/**
+ * CC3TextureManager loads textures from image files, decoding the images on background threads,
+ * and manages the GL memory that those textures occupy, within an optional memory budget.
+ *
+ * Textures retrieved from the textureFromFile: method are shared by absolute file path, and are
+ * first loaded at a low resolution, determined by the initialResolution property. Each time a
+ * texture is drawn, the on-screen size of the node it is drawn on determines the resolution it
+ * requires, and, if that is finer than the resolution currently loaded, the image file is decoded
+ * again at that resolution in the background, and the texture is replaced once decoding completes.
+ * Each level of resolution is decoded directly from the image file at the size required, and
+ * its mipmap is built during decoding, so the full-resolution image is decoded only if it is
+ * actually required. See the CC3ManagedTexture2D class for more about levels of resolution.
+ *
+ * If the memoryBudget property is set, a texture is only streamed to a finer resolution if the
+ * GL memory required fits within the budget. To make room, the manager first removes textures
+ * that are no longer used by any CC3ManagedTexture, least recently drawn first, and then reduces
+ * textures that have not been drawn within the idleInterval to their coarsest resolution. Textures that are requested at a resolution that does not fit are loaded at the
+ * finest resolution that does.
+ *
+ * Images are decoded with ImageIO, and converted to the format indicated by the pixelFormat
+ * property. Image files that ImageIO cannot decode, such as PVR files, are loaded synchronously,
+ * at full resolution, using the loadTextureFile: method of CC3Texture, and are neither streamed
+ * nor counted against the memory budget.
+ *
+ * The manager, and the textures it loads, must only be accessed from the thread that holds the
+ * GL context, which is usually the main thread, and on which the completion of each background
+ * load is dispatched. To load the textures used by CC3PODResource models through the manager,
+ * set the shouldLoadResourceTextures property to YES.
+ */
+@interface CC3TextureManager : NSObject {
+	NSMutableDictionary* _texturesByFilePath;
+	NSMutableArray* _pendingLoads;
+	NSUInteger _memoryBudget;
+	NSTimeInterval _idleInterval;
+	GLuint _initialResolution;
+	GLuint _maximumConcurrentLoads;
+	GLuint _activeLoadCount;
+	CCTexture2DPixelFormat _pixelFormat;
+	BOOL _shouldLoadResourceTextures : 1;
+}
+
+/** Returns the singleton texture manager. */
++(CC3TextureManager*) sharedTextureManager;
+
+/**
+ * Returns a new autoreleased CC3ManagedTexture, named from the specified file path, that holds
+ * the CC3ManagedTexture2D that is loaded from the image file at the specified file path.
+ *
+ * The specified file path may be either an absolute path, or a path relative to the application
+ * resource directory. If the image file has already been loaded by this manager, the existing
+ * CC3ManagedTexture2D is shared. Otherwise, the coarsest level of resolution of the image is
+ * loaded in the background, and the texture will be transparent black until it has been loaded.
+ *
+ * Returns nil if the file could not be loaded.
+ */
+-(CC3ManagedTexture*) textureFromFile: (NSString*) aFilePath;
+
+/**
+ * The largest dimension, in pixels, at which textures are first loaded. Textures are
+ * subsequently streamed to finer resolutions as they are required on screen.
+ *
+ * Changing this property does not affect textures that have already been loaded.
+ *
+ * The initial value of this property is kCC3DefaultTextureInitialResolution.
+ */
+@property(nonatomic, assign) GLuint initialResolution;
+
+/**
+ * The pixel format in which textures are held in GL memory. This may be one of
+ * kCCTexture2DPixelFormat_RGBA8888, kCCTexture2DPixelFormat_RGBA4444, or
+ * kCCTexture2DPixelFormat_RGB565. Using one of the 16-bit formats halves
+ * the GL memory occupied by each texture, at the cost of color precision.
+ *
+ * Changing this property does not affect textures that have already been loaded.
+ *
+ * The initial value of this property is kCCTexture2DPixelFormat_RGBA8888.
+ */
+@property(nonatomic, assign) CCTexture2DPixelFormat pixelFormat;
+
+/**
+ * The maximum number of image files that may be decoded in the background at the same time.
+ * Additional requests wait until an earlier decoding has completed. This limits the amount
+ * of application memory used to hold the decoded images before they are loaded into GL memory.
+ *
+ * The initial value of this property is kCC3DefaultTextureMaximumConcurrentLoads.
+ */
+@property(nonatomic, assign) GLuint maximumConcurrentLoads;
+
+/**
+ * Indicates whether the textures used by models loaded from resources, such as CC3PODResource,
+ * should be loaded through this manager, instead of through the loadTextureFile: method of
+ * CC3Texture.
+ *
+ * The initial value of this property is NO.
+ */
+@property(nonatomic, assign) BOOL shouldLoadResourceTextures;
+
+
+#pragma mark Memory management
+
+/**
+ * The amount of GL memory, in bytes, that the textures held by this manager may occupy.
+ * Setting this property immediately invokes the enforceMemoryBudget method.
+ *
+ * The initial value of this property is zero, indicating that there is no budget.
+ */
+@property(nonatomic, assign) NSUInteger memoryBudget;
+
+/**
+ * Returns the amount of GL memory, in bytes, currently occupied by the textures held
+ * by this manager. See the cc3MemorySize property of CCTexture2D for more info.
+ */
+@property(nonatomic, readonly) NSUInteger memorySize;
+
+/**
+ * If the memoryBudget property is not zero, and the textures held by this manager, once any
+ * pending loads have completed, would exceed that budget, removes textures that are no longer
+ * used by any CC3ManagedTexture, least recently drawn first, and then reduces the textures that
+ * are still in use to their coarsest resolution, least recently drawn first, until the budget
+ * is met, or no further memory can be freed.
+ *
+ * This method is invoked automatically whenever a texture completes loading, and whenever the
+ * memoryBudget property is set.
+ */
+-(void) enforceMemoryBudget;
+
+/**
+ * The time, in seconds, after which a texture that has not been drawn is considered idle.
+ * To make room for a texture that requires a finer resolution, idle textures are reduced
+ * to their coarsest resolution.
+ *
+ * The initial value of this property is kCC3DefaultTextureIdleInterval.
+ */
+@property(nonatomic, assign) NSTimeInterval idleInterval;
+
+/**
+ * Removes all textures that are no longer used by any CC3ManagedTexture, freeing the GL memory
+ * that they occupy. You can invoke this method when the application receives a memory warning.
+ */
+-(void) removeUnusedTextures;
+
+@end
@@ -0,0 +1,705 @@
+/*
+ * CC3TextureManager.m
+ *
+ * cocos3d 2.0.0
+ * Author: Bill Hollings
+ * Copyright (c) 2010-2013 The Brenwill Workshop Ltd. All rights reserved.
+ * http://www.brenwill.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * http://en.wikipedia.org/wiki/MIT_License
+ *
+ * See header file CC3TextureManager.h for full API documentation.
+ */
+
+#import "CC3TextureManager.h"
+#import "CC3MeshNode.h"
+#import "CC3Scene.h"
+#import "CC3OpenGLESEngine.h"
+#import "CC3CC2Extensions.h"
+#import <ImageIO/ImageIO.h>
+
+
+#if COCOS2D_VERSION < 0x020100
+#	define CC2_TEX_WIDTH width_
+#	define CC2_TEX_HEIGHT height_
+#	define CC2_TEX_SIZE size_
+#	define CC2_TEX_MAX_S maxS_
+#	define CC2_TEX_MAX_T maxT_
+#	define CC2_TEX_HAS_PREMULTIPLIED_ALPHA hasPremultipliedAlpha_
+#else
+#	define CC2_TEX_WIDTH _width
+#	define CC2_TEX_HEIGHT _height
+#	define CC2_TEX_SIZE _size
+#	define CC2_TEX_MAX_S _maxS
+#	define CC2_TEX_MAX_T _maxT
+#	define CC2_TEX_HAS_PREMULTIPLIED_ALPHA _hasPremultipliedAlpha
+#endif
+
+
+#pragma mark -
+#pragma mark Image decoding
+
+/** Returns the number of bytes in each texel of the specified pixel format. */
+static GLuint CC3ManagedTextureBytesPerTexel(CCTexture2DPixelFormat pixFmt) {
+	return (pixFmt == kCCTexture2DPixelFormat_RGBA8888) ? 4 : 2;
+}
+
+/** Returns the number of levels in a complete mipmap of a texture of the specified size. */
+static GLuint CC3MipmapLevelCount(GLuint width, GLuint height) {
+	GLuint mipCount = 1;
+	while (width > 1 || height > 1) {
+		width = MAX(width >> 1, 1);
+		height = MAX(height >> 1, 1);
+		mipCount++;
+	}
+	return mipCount;
+}
+
+/** Returns the total number of texels in the specified number of mipmap levels, starting at the specified size. */
+static NSUInteger CC3MipmapTexelCount(GLuint width, GLuint height, GLuint mipCount) {
+	NSUInteger texelCount = 0;
+	for (GLuint mipIdx = 0; mipIdx < mipCount; mipIdx++) {
+		texelCount += (NSUInteger)width * height;
+		width = MAX(width >> 1, 1);
+		height = MAX(height >> 1, 1);
+	}
+	return texelCount;
+}
+
+/**
+ * Decodes the image file at the specified absolute file path at the specified size, builds the
+ * specified number of mipmap levels from it, and converts the texels to the specified pixel format.
+ *
+ * Returns a malloc'ed buffer holding the mipmap levels contiguously, from largest to smallest,
+ * which the caller must free, or returns NULL if the image could not be decoded.
+ *
+ * The image is decoded with premultiplied alpha, and its top row is held first. This function
+ * does not access the GL engine, and can be invoked from any thread.
+ */
+static GLvoid* CC3DecodeTextureFile(NSString* absFilePath, GLuint width, GLuint height,
+									GLuint mipCount, CCTexture2DPixelFormat pixFmt) {
+	CGImageSourceRef imgSrc = CGImageSourceCreateWithURL((CFURLRef)[NSURL fileURLWithPath: absFilePath], NULL);
+	if ( !imgSrc ) return NULL;
+
+	// Decode the image at the largest dimension required. For formats such as JPEG, this
+	// avoids decoding the image at full resolution when a coarser level is being loaded.
+	NSDictionary* decodeOptions = [NSDictionary dictionaryWithObjectsAndKeys:
+								   (id)kCFBooleanTrue, (id)kCGImageSourceCreateThumbnailFromImageAlways,
+								   [NSNumber numberWithUnsignedInt: MAX(width, height)], (id)kCGImageSourceThumbnailMaxPixelSize,
+								   nil];
+	CGImageRef img = CGImageSourceCreateThumbnailAtIndex(imgSrc, 0, (CFDictionaryRef)decodeOptions);
+	CFRelease(imgSrc);
+	if ( !img ) return NULL;
+
+	NSUInteger texelCount = CC3MipmapTexelCount(width, height, mipCount);
+	GLubyte* texels = calloc(texelCount, 4);
+	CGContextRef ctx = NULL;
+	if (texels) {
+		CGColorSpaceRef colorSpace = CGColorSpaceCreateDeviceRGB();
+		ctx = CGBitmapContextCreate(texels, width, height, 8, width * 4, colorSpace,
+									kCGImageAlphaPremultipliedLast | kCGBitmapByteOrder32Big);
+		CGColorSpaceRelease(colorSpace);
+	}
+	if (ctx) {
+		// Draw the image into the first level, scaling it to exactly the required size
+		CGContextSetInterpolationQuality(ctx, kCGInterpolationHigh);
+		CGContextDrawImage(ctx, CGRectMake(0, 0, width, height), img);
+		CGContextRelease(ctx);
+	}
+	CGImageRelease(img);
+	if ( !ctx ) {
+		free(texels);
+		return NULL;
+	}
+
+	// Build each subsequent mipmap level by averaging each 2x2 block of the level before it
+	GLubyte* srcLevel = texels;
+	GLuint srcWidth = width;
+	GLuint srcHeight = height;
+	for (GLuint mipIdx = 1; mipIdx < mipCount; mipIdx++) {
+		GLuint dstWidth = MAX(srcWidth >> 1, 1);
+		GLuint dstHeight = MAX(srcHeight >> 1, 1);
+		GLubyte* dstLevel = srcLevel + (srcWidth * srcHeight * 4);
+		for (GLuint y = 0; y < dstHeight; y++) {
+			GLubyte* srcRow0 = srcLevel + (MIN(y * 2, srcHeight - 1) * srcWidth * 4);
+			GLubyte* srcRow1 = srcLevel + (MIN(y * 2 + 1, srcHeight - 1) * srcWidth * 4);
+			GLubyte* dstRow = dstLevel + (y * dstWidth * 4);
+			for (GLuint x = 0; x < dstWidth; x++) {
+				GLuint sx0 = MIN(x * 2, srcWidth - 1) * 4;
+				GLuint sx1 = MIN(x * 2 + 1, srcWidth - 1) * 4;
+				for (GLuint c = 0; c < 4; c++)
+					dstRow[x * 4 + c] = (srcRow0[sx0 + c] + srcRow0[sx1 + c] +
+										 srcRow1[sx0 + c] + srcRow1[sx1 + c] + 2) >> 2;
+			}
+		}
+		srcLevel = dstLevel;
+		srcWidth = dstWidth;
+		srcHeight = dstHeight;
+	}
+
+	if (pixFmt == kCCTexture2DPixelFormat_RGBA8888) return texels;
+
+	// Convert to 16-bit texels in place. Each 16-bit texel is written no later
+	// than the 32-bit texel it is converted from, so no texel is overwritten
+	// before it has been read.
+	GLushort* texels16 = (GLushort*)texels;
+	for (NSUInteger i = 0; i < texelCount; i++) {
+		GLubyte* t = texels + (i * 4);
+		texels16[i] = (pixFmt == kCCTexture2DPixelFormat_RGB565)
+						? (((t[0] >> 3) << 11) | ((t[1] >> 2) << 5) | (t[2] >> 3))
+						: (((t[0] >> 4) << 12) | ((t[1] >> 4) << 8) | ((t[2] >> 4) << 4) | (t[3] >> 4));
+	}
+	return texels;
+}
+
+
+#pragma mark -
+#pragma mark CC3ManagedTexture2D
+
+@interface CC3TextureManager (TemplateMethods)
+-(void) streamTexture: (CC3ManagedTexture2D*) tex2D toLevel: (GLuint) level;
+-(void) queueLoadOfTexture: (CC3ManagedTexture2D*) tex2D;
+-(void) textureDidLoad: (CC3ManagedTexture2D*) tex2D;
+@end
+
+@interface CC3ManagedTexture2D (TemplateMethods)
+@property(nonatomic, readonly) GLuint committedLevel;
+@property(nonatomic, readonly) BOOL canReduce;
+-(void) beginUse;
+-(void) endUse;
+-(void) loadLevel: (GLuint) level;
+-(void) decodeLoadingLevel;
+-(void) completeLoadingLevel: (GLuint) level fromTexels: (const GLvoid*) texels;
+-(void) uploadTexels: (const GLvoid*) texels withWidth: (GLuint) width andHeight: (GLuint) height;
+@end
+
+@implementation CC3ManagedTexture2D
+
+@synthesize filePath=_filePath, fullWidth=_fullWidth, fullHeight=_fullHeight;
+@synthesize levelCount=_levelCount, residentLevel=_residentLevel, demandedLevel=_demandedLevel;
+@synthesize lastDrawTime=_lastDrawTime, isLoading=_isLoading;
+
+-(void) dealloc {
+	[_filePath release];
+	[super dealloc];
+}
+
+-(GLuint) widthAtLevel: (GLuint) level { return _fullWidth >> level; }
+
+-(GLuint) heightAtLevel: (GLuint) level { return _fullHeight >> level; }
+
+-(NSUInteger) memorySizeAtLevel: (GLuint) level {
+	level = MIN(level, _levelCount - 1);
+	NSUInteger memSize = (NSUInteger)[self widthAtLevel: level] * [self heightAtLevel: level] *
+							CC3ManagedTextureBytesPerTexel(self.pixelFormat);
+	return _shouldMipmap ? (memSize + (memSize / 3)) : memSize;
+}
+
+/** The level that will be resident once any load in progress has completed. */
+-(GLuint) committedLevel { return _isLoading ? _loadingLevel : MIN(_residentLevel, _levelCount - 1); }
+
+/** Returns whether this texture can be reduced to its coarsest level to free memory. */
+-(BOOL) canReduce { return !_isLoading && !_hasLoadFailed && self.committedLevel < _levelCount - 1; }
+
+-(BOOL) isInUse { return _useCount > 0; }
+
+/** Invoked by a CC3ManagedTexture when it starts holding this texture. */
+-(void) beginUse { _useCount++; }
+
+/** Invoked by a CC3ManagedTexture when it stops holding this texture. */
+-(void) endUse {
+	CC3Assert(_useCount > 0, @"%@ endUse invoked without a matching beginUse.", self);
+	if (_useCount > 0) _useCount--;
+}
+
+-(void) noteDemandedResolution: (GLfloat) pixels {
+	_lastDrawTime = [NSDate timeIntervalSinceReferenceDate];
+
+	// Select the coarsest level whose larger dimension covers the demanded number of pixels
+	GLuint maxDim = MAX(_fullWidth, _fullHeight);
+	GLuint level = 0;
+	while (level + 1 < _levelCount && (GLfloat)(maxDim >> (level + 1)) >= pixels) level++;
+	_demandedLevel = level;
+
+	if (level < self.committedLevel && !_isLoading && !_hasLoadFailed)
+		[CC3TextureManager.sharedTextureManager streamTexture: self toLevel: level];
+}
+
+
+#pragma mark Loading
+
+-(void) loadLevel: (GLuint) level {
+	LogTrace(@"%@ requesting level %u of %u", self, level, _levelCount);
+	_loadingLevel = level;
+	_isLoading = YES;
+	[CC3TextureManager.sharedTextureManager queueLoadOfTexture: self];
+}
+
+/**
+ * Decodes the level being loaded on a background thread, and then completes loading that
+ * level on the main thread. Both blocks retain this texture until loading is complete.
+ */
+-(void) decodeLoadingLevel {
+	NSString* absFilePath = _filePath;
+	GLuint level = _loadingLevel;
+	GLuint width = [self widthAtLevel: level];
+	GLuint height = [self heightAtLevel: level];
+	GLuint mipCount = _shouldMipmap ? CC3MipmapLevelCount(width, height) : 1;
+	CCTexture2DPixelFormat pixFmt = self.pixelFormat;
+
+	dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_LOW, 0), ^{
+		GLvoid* texels = NULL;
+		@autoreleasepool {
+			MarkRezActivityStart();
+			texels = CC3DecodeTextureFile(absFilePath, width, height, mipCount, pixFmt);
+			LogRez(@"Decoded '%@' at %u x %u in the background in %.4f seconds",
+				   absFilePath.lastPathComponent, width, height, GetRezActivityDuration());
+		}
+		dispatch_async(dispatch_get_main_queue(), ^{
+			[self completeLoadingLevel: level fromTexels: texels];
+			free(texels);
+		});
+	});
+}
+
+-(void) completeLoadingLevel: (GLuint) level fromTexels: (const GLvoid*) texels {
+	_isLoading = NO;
+	if (texels) {
+		[self uploadTexels: texels withWidth: [self widthAtLevel: level] andHeight: [self heightAtLevel: level]];
+		_residentLevel = level;
+		LogTrace(@"%@ loaded level %u of %u", self, level, _levelCount);
+	} else {
+		_hasLoadFailed = YES;
+		LogError(@"%@ could not decode level %u from file %@", self, level, _filePath);
+	}
+	[CC3TextureManager.sharedTextureManager textureDidLoad: self];
+}
+
+/**
+ * Replaces the content of the GL texture with the specified texels, which hold the contiguous
+ * mipmap levels of a texture of the specified size, and updates the size of this texture.
+ *
+ * The GL texture name does not change, so that all CC3Textures holding this texture draw the
+ * new content. When the new content is coarser than the old, the finer mipmap levels that are
+ * no longer needed are released.
+ */
+-(void) uploadTexels: (const GLvoid*) texels withWidth: (GLuint) width andHeight: (GLuint) height {
+	GLuint mipCount = _shouldMipmap ? CC3MipmapLevelCount(width, height) : 1;
+	GLuint bytesPerTexel = CC3ManagedTextureBytesPerTexel(self.pixelFormat);
+	GLenum glFormat = GL_RGBA;
+	GLenum glType = GL_UNSIGNED_BYTE;
+	switch (self.pixelFormat) {
+		case kCCTexture2DPixelFormat_RGBA4444:
+			glType = GL_UNSIGNED_SHORT_4_4_4_4;
+			break;
+		case kCCTexture2DPixelFormat_RGB565:
+			glFormat = GL_RGB;
+			glType = GL_UNSIGNED_SHORT_5_6_5;
+			break;
+		default:
+			break;
+	}
+
+	// Texels are uploaded outside of scene drawing, after cocos2d may have changed the GL texture
+	// state behind the trackers, so activate texture unit zero, and bind this texture to it,
+	// regardless of the values cached by the trackers.
+	CC3OpenGLESTextures* glesTextures = CC3OpenGLESEngine.engine.textures;
+	CC3OpenGLESTextureUnit* glesTexUnit = [glesTextures textureUnitAt: 0];
+	glesTextures.activeTexture.valueIsKnown = NO;
+	[glesTexUnit activate];
+	glesTexUnit.textureBinding.valueIsKnown = NO;
+	glesTexUnit.textureBinding.value = self.name;
+#if CC3_CC2_2
+	ccGLBindTexture2DN(0, self.name);		// Keep the cocos2d texture binding cache consistent
+#endif
+	glPixelStorei(GL_UNPACK_ALIGNMENT, bytesPerTexel);
+
+	const GLubyte* mipTexels = texels;
+	GLuint mipWidth = width;
+	GLuint mipHeight = height;
+	for (GLuint mipIdx = 0; mipIdx < mipCount; mipIdx++) {
+		glTexImage2D(GL_TEXTURE_2D, mipIdx, glFormat, mipWidth, mipHeight, 0, glFormat, glType, mipTexels);
+		mipTexels += mipWidth * mipHeight * bytesPerTexel;
+		mipWidth = MAX(mipWidth >> 1, 1);
+		mipHeight = MAX(mipHeight >> 1, 1);
+	}
+	for (GLuint mipIdx = mipCount; mipIdx < _glMipmapCount; mipIdx++)
+		glTexImage2D(GL_TEXTURE_2D, mipIdx, glFormat, 0, 0, 0, glFormat, glType, NULL);
+	_glMipmapCount = mipCount;
+
+	CC2_TEX_WIDTH = width;
+	CC2_TEX_HEIGHT = height;
+	CC2_TEX_SIZE = CGSizeMake(width, height);
+	CC2_TEX_MAX_S = 1.0f;
+	CC2_TEX_MAX_T = 1.0f;
+	self.cc3HasMipmap = _shouldMipmap;
+}
+
+
+#pragma mark Allocation and initialization
+
+/**
+ * Initializes this instance to load the image file at the specified absolute file path, whose
+ * image has the specified size, and clears the texture to transparent black at its coarsest level.
+ * The coarsest level is not loaded until the loadLevel: method is invoked.
+ */
+-(id) initFromFile: (NSString*) absFilePath withWidth: (GLuint) width andHeight: (GLuint) height {
+	CC3TextureManager* texMgr = CC3TextureManager.sharedTextureManager;
+	CCTexture2DPixelFormat pixFmt = texMgr.pixelFormat;
+
+	// Each level halves the level before it, until the larger dimension fits the initial resolution
+	GLuint initRez = MAX(texMgr.initialResolution, 1);
+	GLuint levelCount = 1;
+	GLuint lvlWidth = width;
+	GLuint lvlHeight = height;
+	while (MAX(lvlWidth, lvlHeight) > initRez && (lvlWidth & 1) == 0 && (lvlHeight & 1) == 0) {
+		lvlWidth >>= 1;
+		lvlHeight >>= 1;
+		levelCount++;
+	}
+
+	if ( (self = [self initWithData: NULL pixelFormat: pixFmt
+						 pixelsWide: lvlWidth pixelsHigh: lvlHeight
+						contentSize: CGSizeMake(lvlWidth, lvlHeight)]) ) {
+		_filePath = [absFilePath retain];
+		_fullWidth = width;
+		_fullHeight = height;
+		_levelCount = levelCount;
+		_residentLevel = levelCount;			// Nothing loaded yet
+		_loadingLevel = levelCount - 1;
+		_demandedLevel = levelCount - 1;
+		_glMipmapCount = 1;
+		_lastDrawTime = 0.0;
+		_useCount = 0;
+		_shouldMipmap = CC3Texture.shouldGenerateMipmaps && width == ccNextPOT(width) && height == ccNextPOT(height);
+		_isLoading = NO;
+		_hasLoadFailed = NO;
+		CC2_TEX_HAS_PREMULTIPLIED_ALPHA = YES;		// Images are decoded with premultiplied alpha
+		self.cc3IsFlippedVertically = YES;			// Images are decoded with the top row first
+
+		GLuint mipCount = _shouldMipmap ? CC3MipmapLevelCount(lvlWidth, lvlHeight) : 1;
+		GLvoid* clearTexels = calloc(CC3MipmapTexelCount(lvlWidth, lvlHeight, mipCount),
+									 CC3ManagedTextureBytesPerTexel(pixFmt));
+		[self uploadTexels: clearTexels withWidth: lvlWidth andHeight: lvlHeight];
+		free(clearTexels);
+	}
+	return self;
+}
+
+-(NSString*) description {
+	return [NSString stringWithFormat: @"%@ '%@' at level %u of %u", [self class],
+			_filePath.lastPathComponent, _residentLevel, _levelCount];
+}
+
+@end
+
+
+#pragma mark -
+#pragma mark CC3ManagedTexture
+
+@implementation CC3ManagedTexture
+
+@synthesize resolutionScale=_resolutionScale;
+
+-(void) dealloc {
+	[self endUseOfTexture];
+	[super dealloc];
+}
+
+/** If the texture is a CC3ManagedTexture2D, marks it as being in use by this instance. */
+-(void) beginUseOfTexture {
+	if ([_texture isKindOfClass: [CC3ManagedTexture2D class]]) [(CC3ManagedTexture2D*)_texture beginUse];
+}
+
+/** If the texture is a CC3ManagedTexture2D, marks it as no longer being in use by this instance. */
+-(void) endUseOfTexture {
+	if ([_texture isKindOfClass: [CC3ManagedTexture2D class]]) [(CC3ManagedTexture2D*)_texture endUse];
+}
+
+-(void) setTexture: (CCTexture2D*) texture {
+	if (texture == _texture) return;
+	[self endUseOfTexture];
+	[super setTexture: texture];
+	[self beginUseOfTexture];
+}
+
+-(id) initWithTag: (GLuint) aTag withName: (NSString*) aName {
+	if ( (self = [super initWithTag: aTag withName: aName]) ) {
+		_resolutionScale = 1.0f;
+	}
+	return self;
+}
+
+// Template method that populates this instance from the specified other instance.
+// This method is invoked automatically during object copying via the copyWithZone: method.
+-(void) populateFrom: (CC3ManagedTexture*) another {
+	[self endUseOfTexture];
+	[super populateFrom: another];
+	[self beginUseOfTexture];
+
+	_resolutionScale = another.resolutionScale;
+}
+
+/**
+ * Before drawing, reports the number of pixels across the node being drawn, as seen
+ * by the camera of the visitor, to the texture, so that it can be streamed to the
+ * resolution required.
+ */
+-(void) drawWithVisitor: (CC3NodeDrawingVisitor*) visitor {
+	if ([_texture isKindOfClass: [CC3ManagedTexture2D class]]) {
+		CC3MeshNode* aNode = visitor.currentMeshNode;
+		CC3Camera* cam = visitor.camera;
+		if (aNode && cam) {
+			GLfloat viewHeight = visitor.scene.viewportManager.viewport.h;
+			GLfloat screenSize = [aNode screenSizeFromCamera: cam];
+			[(CC3ManagedTexture2D*)_texture noteDemandedResolution: (screenSize * viewHeight * _resolutionScale)];
+		}
+	}
+	[super drawWithVisitor: visitor];
+}
+
+@end
+
+
+#pragma mark -
+#pragma mark CC3TextureManager
+
+@implementation CC3TextureManager
+
+@synthesize initialResolution=_initialResolution, pixelFormat=_pixelFormat;
+@synthesize maximumConcurrentLoads=_maximumConcurrentLoads, idleInterval=_idleInterval;
+@synthesize shouldLoadResourceTextures=_shouldLoadResourceTextures, memoryBudget=_memoryBudget;
+
+-(void) dealloc {
+	[_texturesByFilePath release];
+	[_pendingLoads release];
+	[super dealloc];
+}
+
+-(void) setPixelFormat: (CCTexture2DPixelFormat) pixFmt {
+	CC3Assert(pixFmt == kCCTexture2DPixelFormat_RGBA8888 ||
+			  pixFmt == kCCTexture2DPixelFormat_RGBA4444 ||
+			  pixFmt == kCCTexture2DPixelFormat_RGB565,
+			  @"%@ does not support texture pixel format %i", self, pixFmt);
+	_pixelFormat = pixFmt;
+}
+
+-(CC3ManagedTexture*) textureFromFile: (NSString*) aFilePath {
+	NSString* absFilePath = CC3EnsureAbsoluteFilePath(aFilePath);
+	CC3ManagedTexture* tex = [[[CC3ManagedTexture alloc] initWithName: absFilePath.lastPathComponent] autorelease];
+
+	CC3ManagedTexture2D* tex2D = [self managedTexture2DFromFile: absFilePath];
+	if (tex2D) {
+		tex.texture = tex2D;
+		return tex;
+	}
+
+	// Files that cannot be decoded in the background are loaded synchronously
+	return [tex loadTextureFile: absFilePath] ? tex : nil;
+}
+
+/**
+ * Returns the managed texture for the image file at the specified absolute file path, creating
+ * it and starting to load its coarsest level, if it has not yet been loaded by this manager.
+ *
+ * Returns nil if the image file cannot be decoded by ImageIO.
+ */
+-(CC3ManagedTexture2D*) managedTexture2DFromFile: (NSString*) absFilePath {
+	CC3ManagedTexture2D* tex2D = [_texturesByFilePath objectForKey: absFilePath];
+	if (tex2D) return tex2D;
+
+	// Read the size of the image from the file, without decoding the image
+	GLuint width = 0;
+	GLuint height = 0;
+	CGImageSourceRef imgSrc = CGImageSourceCreateWithURL((CFURLRef)[NSURL fileURLWithPath: absFilePath], NULL);
+	if (imgSrc) {
+		NSDictionary* imgProps = (NSDictionary*)CGImageSourceCopyPropertiesAtIndex(imgSrc, 0, NULL);
+		width = [[imgProps objectForKey: (id)kCGImagePropertyPixelWidth] unsignedIntValue];
+		height = [[imgProps objectForKey: (id)kCGImagePropertyPixelHeight] unsignedIntValue];
+		[imgProps release];
+		CFRelease(imgSrc);
+	}
+	if ( !(width && height) ) {
+		LogRez(@"%@ cannot decode '%@' in the background, and will load it without streaming", self, absFilePath);
+		return nil;
+	}
+
+	tex2D = [[CC3ManagedTexture2D alloc] initFromFile: absFilePath withWidth: width andHeight: height];
+	if ( !tex2D ) return nil;
+	[_texturesByFilePath setObject: tex2D forKey: absFilePath];
+	[tex2D release];
+
+	LogRez(@"%@ added %@ from an image of %u x %u", self, tex2D, width, height);
+	[tex2D loadLevel: (tex2D.levelCount - 1)];
+	return tex2D;
+}
+
+
+#pragma mark Loading
+
+-(void) streamTexture: (CC3ManagedTexture2D*) tex2D toLevel: (GLuint) level {
+	GLuint committedLevel = tex2D.committedLevel;
+
+	// Make room for the requested level, then back off to the finest level that fits.
+	if (_memoryBudget) {
+		NSUInteger committedSize = [tex2D memorySizeAtLevel: committedLevel];
+		NSTimeInterval idleTime = [NSDate timeIntervalSinceReferenceDate] - _idleInterval;
+		NSUInteger totalSize = [self freeMemory: ([tex2D memorySizeAtLevel: level] - committedSize)
+							   fromTexturesDrawnBefore: idleTime];
+		NSUInteger available = (totalSize < _memoryBudget) ? (_memoryBudget - totalSize) : 0;
+		while (level < committedLevel && ([tex2D memorySizeAtLevel: level] - committedSize) > available) level++;
+		if (level == committedLevel) return;
+	}
+	[tex2D loadLevel: level];
+}
+
+-(void) queueLoadOfTexture: (CC3ManagedTexture2D*) tex2D {
+	[_pendingLoads addObject: tex2D];
+	[self startPendingLoads];
+}
+
+/** Starts decoding pending loads, oldest first, up to the maximum number of concurrent loads. */
+-(void) startPendingLoads {
+	while (_activeLoadCount < MAX(_maximumConcurrentLoads, 1) && _pendingLoads.count > 0) {
+		CC3ManagedTexture2D* tex2D = [[[_pendingLoads objectAtIndex: 0] retain] autorelease];
+		[_pendingLoads removeObjectAtIndex: 0];
+		_activeLoadCount++;
+		[tex2D decodeLoadingLevel];
+	}
+}
+
+-(void) textureDidLoad: (CC3ManagedTexture2D*) tex2D {
+	_activeLoadCount--;
+	[self enforceMemoryBudget];
+	[self startPendingLoads];
+}
+
+
+#pragma mark Memory management
+
+-(void) setMemoryBudget: (NSUInteger) budget {
+	_memoryBudget = budget;
+	[self enforceMemoryBudget];
+}
+
+-(NSUInteger) memorySize {
+	NSUInteger memSize = 0;
+	for (CC3ManagedTexture2D* tex2D in _texturesByFilePath.objectEnumerator) memSize += tex2D.cc3MemorySize;
+	return memSize;
+}
+
+/** Returns the amount of GL memory that the textures will occupy once any pending loads have completed. */
+-(NSUInteger) committedMemorySize {
+	NSUInteger memSize = 0;
+	for (CC3ManagedTexture2D* tex2D in _texturesByFilePath.objectEnumerator)
+		memSize += [tex2D memorySizeAtLevel: tex2D.committedLevel];
+	return memSize;
+}
+
+/** Returns whether the specified texture is not in use by any CC3ManagedTexture, and is not being loaded. */
+-(BOOL) isUnused: (CC3ManagedTexture2D*) tex2D { return (!tex2D.isInUse && !tex2D.isLoading); }
+
+/**
+ * Frees memory until the committed memory, plus the specified amount of memory, fits within the
+ * memory budget. Removes unused textures first, least recently drawn first, and then reduces the
+ * textures that were last drawn before the specified time to their coarsest level, least recently
+ * drawn first. Returns the committed memory size once the memory has been freed.
+ */
+-(NSUInteger) freeMemory: (NSUInteger) required fromTexturesDrawnBefore: (NSTimeInterval) drawTime {
+	NSUInteger committedSize = self.committedMemorySize;
+	while (committedSize + required > _memoryBudget) {
+
+		// Find the least recently drawn texture that is unused, or failing that, that can be reduced.
+		CC3ManagedTexture2D* lruUnusedTex = nil;
+		CC3ManagedTexture2D* lruReducibleTex = nil;
+		for (CC3ManagedTexture2D* tex2D in _texturesByFilePath.objectEnumerator) {
+			if ([self isUnused: tex2D]) {
+				if ( !lruUnusedTex || tex2D.lastDrawTime < lruUnusedTex.lastDrawTime ) lruUnusedTex = tex2D;
+			} else if (tex2D.canReduce && tex2D.lastDrawTime < drawTime) {
+				if ( !lruReducibleTex || tex2D.lastDrawTime < lruReducibleTex.lastDrawTime ) lruReducibleTex = tex2D;
+			}
+		}
+
+		if (lruUnusedTex) {
+			LogRez(@"%@ removing unused %@ holding %lu bytes", self, lruUnusedTex,
+				   (unsigned long)[lruUnusedTex memorySizeAtLevel: lruUnusedTex.committedLevel]);
+			committedSize -= [lruUnusedTex memorySizeAtLevel: lruUnusedTex.committedLevel];
+			[_texturesByFilePath removeObjectForKey: lruUnusedTex.filePath];
+		} else if (lruReducibleTex) {
+			GLuint coarsestLevel = lruReducibleTex.levelCount - 1;
+			LogRez(@"%@ reducing %@ to its coarsest level", self, lruReducibleTex);
+			committedSize -= ([lruReducibleTex memorySizeAtLevel: lruReducibleTex.committedLevel] -
+							  [lruReducibleTex memorySizeAtLevel: coarsestLevel]);
+			[lruReducibleTex loadLevel: coarsestLevel];
+		} else {
+			break;
+		}
+	}
+	return committedSize;
+}
+
+-(void) enforceMemoryBudget {
+	if ( !_memoryBudget ) return;
+
+	NSUInteger committedSize = [self freeMemory: 0 fromTexturesDrawnBefore: DBL_MAX];
+	if (committedSize > _memoryBudget)
+		LogRez(@"%@ holds %lu bytes of textures, exceeding its budget of %lu bytes, but all textures are in use at their coarsest level",
+			   self, (unsigned long)committedSize, (unsigned long)_memoryBudget);
+}
+
+-(void) removeUnusedTextures {
+	NSMutableArray* unusedFilePaths = [NSMutableArray array];
+	for (CC3ManagedTexture2D* tex2D in _texturesByFilePath.objectEnumerator)
+		if ([self isUnused: tex2D]) [unusedFilePaths addObject: tex2D.filePath];
+	LogRez(@"%@ removing %lu unused textures", self, (unsigned long)unusedFilePaths.count);
+	[_texturesByFilePath removeObjectsForKeys: unusedFilePaths];
+}
+
+
+#pragma mark Allocation and initialization
+
+-(id) init {
+	if ( (self = [super init]) ) {
+		_texturesByFilePath = [NSMutableDictionary new];		// retained
+		_pendingLoads = [NSMutableArray new];					// retained
+		_memoryBudget = 0;
+		_idleInterval = kCC3DefaultTextureIdleInterval;
+		_initialResolution = kCC3DefaultTextureInitialResolution;
+		_maximumConcurrentLoads = kCC3DefaultTextureMaximumConcurrentLoads;
+		_activeLoadCount = 0;
+		_pixelFormat = kCCTexture2DPixelFormat_RGBA8888;
+		_shouldLoadResourceTextures = NO;
+	}
+	return self;
+}
+
+static CC3TextureManager* _sharedTextureManager = nil;
+
++(CC3TextureManager*) sharedTextureManager {
+	if ( !_sharedTextureManager ) _sharedTextureManager = [[self alloc] init];		// retained
+	return _sharedTextureManager;
+}
+
+-(NSString*) description {
+	return [NSString stringWithFormat: @"%@ holding %lu textures", [self class], (unsigned long)_texturesByFilePath.count];
+}
+
+@end
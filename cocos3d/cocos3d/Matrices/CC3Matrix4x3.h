@@ -454,6 +454,25 @@ CC3Vector CC3Matrix4x3TransformLocation(const CC3Matrix4x3* mtx, CC3Vector v);
  */
 CC3Vector CC3Matrix4x3TransformDirection(const CC3Matrix4x3* mtx, CC3Vector v);
 
+/**
+ * Transforms the specified number of 3D vectors using the specified matrix, reading each vector
+ * from the three GLfloats at the start of each element of the source array, and writing each
+ * transformed vector to the three GLfloats at the start of each element of the destination array.
+ * The source and destination arrays must not overlap.
+ *
+ * The source and destination strides are the number of bytes between consecutive elements in
+ * each array, allowing the vectors to be read from and written to interleaved vertex content.
+ *
+ * The specified W value is used as the homogeneous component of each vector. Use a value of one
+ * to transform locations, and a value of zero to transform directions.
+ *
+ * The loop in this function contains no branches and no function calls, so that the compiler
+ * can vectorize it.
+ */
+void CC3Matrix4x3TransformVectors(const CC3Matrix4x3* mtx, GLfloat w, GLuint vecCount,
+								  const GLvoid* srcVecs, GLuint srcStride,
+								  GLvoid* dstVecs, GLuint dstStride);
+
 /**
  * Orthonormalizes the rotation component of the specified matrix, using a Gram-Schmidt process,
  * and using the column indicated by the specified column number as the starting point of the
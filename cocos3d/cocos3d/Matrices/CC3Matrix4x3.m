@@ -147,4 +147,22 @@ CC3Vector CC3Matrix4x3TransformDirection(const CC3Matrix4x3* mtx, CC3Vector v) {
 	return vOut;
 }
 
+void CC3Matrix4x3TransformVectors(const CC3Matrix4x3* mtx, GLfloat w, GLuint vecCount,
+								  const GLvoid* srcVecs, GLuint srcStride,
+								  GLvoid* dstVecs, GLuint dstStride) {
+	const GLbyte* restrict src = srcVecs;
+	GLbyte* restrict dst = dstVecs;
+	GLfloat m11 = mtx->c1r1, m12 = mtx->c2r1, m13 = mtx->c3r1, m14 = mtx->c4r1 * w;
+	GLfloat m21 = mtx->c1r2, m22 = mtx->c2r2, m23 = mtx->c3r2, m24 = mtx->c4r2 * w;
+	GLfloat m31 = mtx->c1r3, m32 = mtx->c2r3, m33 = mtx->c3r3, m34 = mtx->c4r3 * w;
+	for (GLuint i = 0; i < vecCount; i++) {
+		const GLfloat* s = (const GLfloat*)(src + (srcStride * i));
+		GLfloat* d = (GLfloat*)(dst + (dstStride * i));
+		GLfloat x = s[0], y = s[1], z = s[2];
+		d[0] = (m11 * x) + (m12 * y) + (m13 * z) + m14;
+		d[1] = (m21 * x) + (m22 * y) + (m23 * z) + m24;
+		d[2] = (m31 * x) + (m32 * y) + (m33 * z) + m34;
+	}
+}
+
 
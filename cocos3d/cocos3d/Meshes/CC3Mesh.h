@@ -2515,6 +2515,7 @@ static inline CC3MeshIntersection* CC3NearestMeshIntersection(CC3MeshIntersectio
 	BOOL normalsAreDirty;
 	BOOL planesAreDirty;
 	BOOL neighboursAreDirty;
+	BOOL shouldMatchNeighboursByLocation;
 }
 
 /**
@@ -2915,6 +2916,24 @@ static inline CC3MeshIntersection* CC3NearestMeshIntersection(CC3MeshIntersectio
  */
 -(CC3FaceNeighbours) neighboursAt: (GLuint) faceIndex;
 
+/**
+ * Indicates whether vertices that share the same location should be treated as the
+ * same vertex when determining which faces are neighbours of each other.
+ *
+ * Meshes often duplicate vertices at the same location along UV or normal seams, so that
+ * the vertices on each side of the seam can hold different texture coordinates or normals.
+ * When this property is set to NO, faces on opposite sides of such a seam do not share
+ * vertex indices, and are therefore not considered to be neighbours. When this property
+ * is set to YES, the edges of faces are matched by vertex location instead of vertex index,
+ * and faces on both sides of a seam will be identified as neighbours.
+ *
+ * Changing the value of this property marks the neighbours data as dirty, so that it
+ * will be repopulated on the next access.
+ *
+ * The initial value of this property is NO.
+ */
+@property(nonatomic, assign) BOOL shouldMatchNeighboursByLocation;
+
 /**
  * Populates the contents of the neighbours property from the associated mesh,
  * automatically allocating memory for the property if needed.
@@ -2925,6 +2944,14 @@ static inline CC3MeshIntersection* CC3NearestMeshIntersection(CC3MeshIntersectio
  *
  * However, if the neighbours property has been set to an array created outside
  * this instance, this method may be invoked to populate that array from the mesh.
+ *
+ * Edges are matched by hashing each edge on its pair of end-point vertices, so the
+ * time taken by this method grows linearly with the number of faces in the mesh.
+ *
+ * If more than two faces share the same edge (a non-manifold edge), the faces are
+ * paired off in the order they appear in the mesh. The first face containing the edge
+ * is paired with the second, the third is paired with the fourth, and so on. If an odd
+ * number of faces share the edge, the last of those faces has no neighbour across that edge.
  */
 -(void) populateNeighbours;
 
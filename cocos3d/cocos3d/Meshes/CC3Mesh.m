@@ -1631,7 +1631,7 @@ static GLuint lastAssignedMeshTag;
 
 @implementation CC3FaceArray
 
-@synthesize mesh, shouldCacheFaces;
+@synthesize mesh, shouldCacheFaces, shouldMatchNeighboursByLocation;
 
 -(void) dealloc {
 	mesh = nil;					// not retained
@@ -1693,6 +1693,7 @@ static GLuint lastAssignedMeshTag;
 		neighbours = NULL;
 		neighboursAreRetained = NO;
 		neighboursAreDirty = YES;
+		shouldMatchNeighboursByLocation = NO;
 	}
 	return self;
 }
@@ -1729,6 +1730,7 @@ static GLuint lastAssignedMeshTag;
 	mesh = another.mesh;		// not retained
 	
 	shouldCacheFaces = another.shouldCacheFaces;
+	shouldMatchNeighboursByLocation = another.shouldMatchNeighboursByLocation;
 	
 	// If indices should be retained, allocate memory and copy the data over.
 	[self deallocateIndices];
@@ -2043,89 +2045,148 @@ static GLuint lastAssignedMeshTag;
 	}
 }
 
+-(void) setShouldMatchNeighboursByLocation: (BOOL) shouldMatch {
+	if (shouldMatch != shouldMatchNeighboursByLocation) [self markNeighboursDirty];
+	shouldMatchNeighboursByLocation = shouldMatch;
+}
+
+/** Returns the smallest power of two that is at least twice the specified count. */
+static GLuint CC3FaceArrayHashCapacity(GLuint count) {
+	GLuint capacity = 16;
+	while (capacity < (count << 1)) capacity <<= 1;
+	return capacity;
+}
+
+/** Hashes the two specified 32-bit values into a single value. */
+static inline GLuint CC3FaceArrayHash(GLuint v1, GLuint v2) {
+	GLuint h = (v1 * 0x9E3779B1) ^ (v2 * 0x85EBCA77);
+	return h ^ (h >> 15);
+}
+
+/**
+ * Returns a malloc'ed array that maps each vertex index in the mesh to the lowest vertex
+ * index that shares the same location. The caller is responsible for freeing the array.
+ */
+-(GLuint*) allocateLocationMatchedVertexIndices {
+	GLuint vtxCnt = mesh.vertexCount;
+	GLuint* matchedIndices = malloc(vtxCnt * sizeof(GLuint));
+	GLuint capacity = CC3FaceArrayHashCapacity(vtxCnt);
+	GLuint mask = capacity - 1;
+	GLuint* slots = malloc(capacity * sizeof(GLuint));
+	memset(slots, 0xFF, capacity * sizeof(GLuint));	// All slots set to kCC3FaceNoNeighbour
+
+	for (GLuint vtxIdx = 0; vtxIdx < vtxCnt; vtxIdx++) {
+		CC3Vector loc = [mesh vertexLocationAt: vtxIdx];
+
+		// Normalize negative zero so that it hashes the same as positive zero
+		GLfloat comps[3] = { loc.x + 0.0f, loc.y + 0.0f, loc.z + 0.0f };
+		GLuint bits[3];
+		memcpy(bits, comps, sizeof(bits));
+
+		GLuint slotIdx = CC3FaceArrayHash(CC3FaceArrayHash(bits[0], bits[1]), bits[2]) & mask;
+		matchedIndices[vtxIdx] = vtxIdx;
+		while (slots[slotIdx] != kCC3FaceNoNeighbour) {
+			GLuint otherIdx = slots[slotIdx];
+			if (CC3VectorsAreEqual([mesh vertexLocationAt: otherIdx], loc)) {
+				matchedIndices[vtxIdx] = otherIdx;
+				break;
+			}
+			slotIdx = (slotIdx + 1) & mask;
+		}
+		if (matchedIndices[vtxIdx] == vtxIdx) slots[slotIdx] = vtxIdx;
+	}
+	free(slots);
+	return matchedIndices;
+}
+
+/**
+ * Hash table slot used to match face edges while populating neighbours. The slot
+ * is keyed by the ordered pair of vertex indices at the ends of the edge, and holds
+ * the face and edge that are waiting to be paired with a neighbour, if any.
+ */
+typedef struct {
+	GLuint minVertex;		/**< The lower vertex index at the end of the edge. */
+	GLuint maxVertex;		/**< The higher vertex index at the end of the edge. */
+	GLuint faceIndex;		/**< The face waiting for a neighbour on this edge, or kCC3FaceNoNeighbour. */
+	GLuint edgeIndex;		/**< The edge of that face that is waiting for a neighbour. */
+	BOOL isOccupied;		/**< Indicates whether this slot has been assigned to an edge. */
+} CC3FaceEdgeSlot;
+
 -(void) populateNeighbours {
 	LogTrace(@"%@ populating neighbours for %u faces", self, self.faceCount);
 	if ( !neighbours ) [self allocateNeighbours];
 	
 	GLuint faceCnt = self.faceCount;
 	
-	// Break all neighbour links. Done in batch so that we can skip
-	// testing neighbour connections from both directions later.
-	for (int faceIdx = 0; faceIdx < faceCnt; faceIdx++) {
+	// Break all neighbour links before matching edges
+	for (GLuint faceIdx = 0; faceIdx < faceCnt; faceIdx++) {
 		GLuint* neighbourEdge = neighbours[faceIdx].edges;
 		neighbourEdge[0] = neighbourEdge[1] = neighbourEdge[2] = kCC3FaceNoNeighbour;
 	}
 	
-	// Iterate through all the faces
-	for (int f1Idx = 0; f1Idx < faceCnt; f1Idx++) {
-
-		// Get the neighbours of the current face, and if any of the edges still
-		// need to have a neighbour assigned, look for them. We check this early
-		// to avoid iterating through the remaining faces
-		GLuint* f1Neighbours = neighbours[f1Idx].edges;
-		if (f1Neighbours[0] == kCC3FaceNoNeighbour ||
-			f1Neighbours[1] == kCC3FaceNoNeighbour ||
-			f1Neighbours[2] == kCC3FaceNoNeighbour) {
-
-			// For the current face, retrieve the vertex indices
-			GLuint* f1Vertices = [mesh faceIndicesAt: f1Idx].vertices;
+	// If matching by location, map each vertex index to a common index for its location
+	GLuint vtxCnt = mesh.vertexCount;
+	GLuint* matchedIndices = (shouldMatchNeighboursByLocation && vtxCnt)
+								? [self allocateLocationMatchedVertexIndices]
+								: NULL;
+	
+	// Each edge is looked up in a hash table keyed by its end points. The first face to
+	// contain an edge leaves itself in the slot, and the next face to contain that same
+	// edge is paired with it, emptying the slot for any further non-manifold pairing.
+	GLuint capacity = CC3FaceArrayHashCapacity(faceCnt * 3);
+	GLuint mask = capacity - 1;
+	CC3FaceEdgeSlot* slots = calloc(capacity, sizeof(CC3FaceEdgeSlot));
+	
+	for (GLuint faceIdx = 0; faceIdx < faceCnt; faceIdx++) {
+		CC3FaceIndices faceIndices = [mesh faceIndicesAt: faceIdx];
+		GLuint* faceVertices = faceIndices.vertices;
+		GLuint* faceNeighbours = neighbours[faceIdx].edges;
+		
+		for (GLuint edgeIdx = 0; edgeIdx < 3; edgeIdx++) {
+			GLuint edgeStart = faceVertices[edgeIdx];
+			GLuint edgeEnd = faceVertices[(edgeIdx < 2) ? (edgeIdx + 1) : 0];
+			if (matchedIndices) {
+				if (edgeStart < vtxCnt) edgeStart = matchedIndices[edgeStart];
+				if (edgeEnd < vtxCnt) edgeEnd = matchedIndices[edgeEnd];
+			}
+			if (edgeStart == edgeEnd) continue;		// Degenerate edge has no neighbour
+			
+			GLuint minVtx = MIN(edgeStart, edgeEnd);
+			GLuint maxVtx = MAX(edgeStart, edgeEnd);
 			
-			// Iterate through all the faces beyond the current face
-			for (int f2Idx = f1Idx + 1; f2Idx < faceCnt; f2Idx++) {
-
-				// Get the neighbours of the other face, and if any of the edges still
-				// need to have a neighbour assigned, see if any of the edges between
-				// the current face and other face match. We check for neighbours early
-				// to avoid iterating through all the face combinations.
-				GLuint* f2Neighbours = neighbours[f2Idx].edges;
-				if (f2Neighbours[0] == kCC3FaceNoNeighbour ||
-					f2Neighbours[1] == kCC3FaceNoNeighbour ||
-					f2Neighbours[2] == kCC3FaceNoNeighbour) {
-				
-					// For the other face, retrieve the vertex indices
-					GLuint* f2Vertices = [mesh faceIndicesAt: f2Idx].vertices;
-					
-					// Compare each edge of the current face with each edge of the other face
-					for (int f1EdgeIdx = 0; f1EdgeIdx < 3; f1EdgeIdx++) {
-						
-						// If this edge already has a neighbour, skip it
-						if (f1Neighbours[f1EdgeIdx] == (GLuint)kCC3FaceNoNeighbour) {
-							
-							// Get the end points of an edge of the current face
-							GLuint f1EdgeStart = f1Vertices[f1EdgeIdx];
-							GLuint f1EdgeEnd = f1Vertices[(f1EdgeIdx < 2) ? (f1EdgeIdx + 1) : 0];
-							
-							// Iterate each edge of other face and compare against current face edge
-							for (int f2EdgeIdx = 0; f2EdgeIdx < 3; f2EdgeIdx++) {
-								
-								// If this edge already has a neighbour, skip it
-								if (f2Neighbours[f2EdgeIdx] == (GLuint)kCC3FaceNoNeighbour) {
-									
-									// Get the end points of an edge of the other face
-									GLuint f2EdgeStart = f2Vertices[f2EdgeIdx];
-									GLuint f2EdgeEnd = f2Vertices[(f2EdgeIdx < 2) ? (f2EdgeIdx + 1) : 0];
-									
-									// If the two edges have the same endpoints, mark each as a neighbour of the other
-									if ((f1EdgeStart == f2EdgeStart && f1EdgeEnd == f2EdgeEnd) ||
-										(f1EdgeStart == f2EdgeEnd && f1EdgeEnd == f2EdgeStart) ){
-										f1Neighbours[f1EdgeIdx] = f2Idx;
-										f2Neighbours[f2EdgeIdx] = f1Idx;
-										LogTrace(@"Matched face %@ with face %@",
-													  NSStringFromCC3FaceIndices(f1Indices),
-													  NSStringFromCC3FaceIndices(f2Indices));
-									}
-								}
-							}
-						}
-					}
-				}
+			// Find the slot for this edge, or the empty slot where it should be added
+			GLuint slotIdx = CC3FaceArrayHash(minVtx, maxVtx) & mask;
+			CC3FaceEdgeSlot* slot = &slots[slotIdx];
+			while (slot->isOccupied && (slot->minVertex != minVtx || slot->maxVertex != maxVtx)) {
+				slotIdx = (slotIdx + 1) & mask;
+				slot = &slots[slotIdx];
+			}
+			
+			if ( !slot->isOccupied ) {
+				slot->isOccupied = YES;
+				slot->minVertex = minVtx;
+				slot->maxVertex = maxVtx;
+				slot->faceIndex = kCC3FaceNoNeighbour;
+			}
+			
+			if (slot->faceIndex == kCC3FaceNoNeighbour || slot->faceIndex == faceIdx) {
+				// No face waiting on this edge, so this face waits for a neighbour
+				slot->faceIndex = faceIdx;
+				slot->edgeIndex = edgeIdx;
+			} else {
+				// Pair this face with the face waiting on this edge, and empty the slot
+				faceNeighbours[edgeIdx] = slot->faceIndex;
+				neighbours[slot->faceIndex].edges[slot->edgeIndex] = faceIdx;
+				LogTrace(@"Matched face %u with face %u", slot->faceIndex, faceIdx);
+				slot->faceIndex = kCC3FaceNoNeighbour;
 			}
-			LogTrace(@"Face %i has indices %@ and neighbours %@", f1Idx,
-						  NSStringFromCC3FaceIndices([mesh faceIndicesAt: f1Idx]),
-						  NSStringFromCC3FaceNeighbours(neighbours[f1Idx]));
 		}
-		
+		LogTrace(@"Face %u has indices %@", faceIdx, NSStringFromCC3FaceIndices(faceIndices));
 	}
+	
+	free(slots);
+	free(matchedIndices);
+	
 	neighboursAreDirty = NO;
 	LogTrace(@"%@ finished building neighbours", self);
 }
@@ -0,0 +1,229 @@
+/*
+ * CC3MeshSimplifier.h
+ *
+ * cocos3d 2.0.0
+ * Author: Bill Hollings
+ * Copyright (c) 2010-2013 The Brenwill Workshop Ltd. All rights reserved.
+ * http://www.brenwill.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * http://en.wikipedia.org/wiki/MIT_License
+ */
+
+/** @file */	// Doxygen marker
+
+
+#import "CC3Mesh.h"
+#import "CC3MeshNode.h"
+
+
+#pragma mark -
+#pragma mark CC3MeshSimplifier
+
+/**
+ * CC3MeshSimplifier reduces the number of triangle faces in a CC3Mesh, by repeatedly collapsing
+ * the mesh edge whose removal least changes the shape of the mesh, as measured by the quadric
+ * error metric, until either a target number of faces or a maximum error has been reached.
+ *
+ * The simplified mesh is returned as a new mesh, leaving the original mesh unchanged, and is
+ * suitable for use as a coarser level of detail in a CC3LODMeshNode.
+ *
+ * Each edge is collapsed by moving one of its vertices onto the other. Since no new vertices are
+ * created, every vertex remaining in the simplified mesh keeps the exact content it had in the
+ * original mesh, including normals, texture coordinates, colors, and skinning weights and matrix
+ * indices. In addition, the following restrictions preserve the appearance of the mesh:
+ *   - Vertices on an open border of the mesh are only moved along that border.
+ *   - Where a texture or normal seam splits a location into two vertices, both vertices
+ *     are moved together, and only along the seam, so that the seam does not open up.
+ *   - Vertices where a seam ends, and at any more complex junctions of borders and seams,
+ *     are never moved.
+ *   - If the shouldPreserveSkinning property is YES, a vertex is never moved onto a vertex
+ *     that is most strongly influenced by a different bone.
+ *   - An edge is not collapsed if doing so would flip or badly distort a remaining face.
+ *
+ * Simplification proceeds in passes. In each pass, the cost of collapsing every edge is evaluated,
+ * and the edges are then collapsed from cheapest to most expensive, skipping any edge that touches
+ * a vertex already moved during the same pass. For large meshes, the cost evaluation is spread
+ * across multiple threads. See the shouldUseConcurrency property for more info.
+ *
+ * The mesh to be simplified must be drawn with triangles, and must hold its vertex locations,
+ * and any vertex indices, in application memory. See the canSimplifyMesh: method for more info.
+ * The simplified mesh always uses GL_TRIANGLES, and is always indexed.
+ *
+ * The faces of the simplified mesh remain in the same order as the faces of the original mesh
+ * from which they came, and the sourceFaceIndices property maps each simplified face back to
+ * that original face. This allows ranges of faces that are drawn separately, such as the skin
+ * sections of a skinned mesh, to be located within the simplified mesh.
+ *
+ * An instance of this class can be used on any thread, but should not be accessed by more than
+ * one thread at a time, and the mesh should not be modified while it is being simplified.
+ * Simplification does not access the GL engine, so GL buffers are not created for the simplified
+ * mesh. If they are needed, invoke the createGLBuffers method of the simplified mesh, or of the
+ * node that holds it, on the thread that holds the GL context.
+ */
+@interface CC3MeshSimplifier : NSObject {
+	CC3Mesh* _mesh;
+	GLuint* _sourceFaceIndices;
+	GLuint _targetFaceCount;
+	GLuint _simplifiedFaceCount;
+	GLfloat _maximumError;
+	GLfloat _achievedError;
+	BOOL _shouldPreserveSkinning : 1;
+	BOOL _shouldUseConcurrency : 1;
+}
+
+/** The mesh to be simplified. */
+@property(nonatomic, retain, readonly) CC3Mesh* mesh;
+
+/**
+ * The number of faces at which simplification stops. Since each edge collapse removes more
+ * than one face, the simplified mesh may contain slightly fewer faces than this value.
+ *
+ * The initial value of this property is half the number of faces in the mesh.
+ */
+@property(nonatomic, assign) GLuint targetFaceCount;
+
+/**
+ * The largest error that may be introduced by collapsing any single edge, expressed as a
+ * proportion of the diagonal of the bounding box of the mesh. Simplification stops, before
+ * the targetFaceCount is reached, if no edge can be collapsed without exceeding this error.
+ *
+ * The initial value of this property is one, which effectively places no bound on the error.
+ */
+@property(nonatomic, assign) GLfloat maximumError;
+
+/**
+ * Indicates whether a vertex may only be moved onto a vertex that is most strongly influenced
+ * by the same bone. This property has no effect if the mesh does not contain vertex weights and
+ * vertex matrix indices.
+ *
+ * The initial value of this property is YES.
+ */
+@property(nonatomic, assign) BOOL shouldPreserveSkinning;
+
+/**
+ * Indicates whether the cost of collapsing the edges of large meshes should be evaluated across
+ * multiple threads, using Grand Central Dispatch. Small meshes are always simplified on the
+ * calling thread.
+ *
+ * The initial value of this property is YES.
+ */
+@property(nonatomic, assign) BOOL shouldUseConcurrency;
+
+/**
+ * The largest error introduced by any edge collapse during the most recent invocation of the
+ * simplifiedMesh method, expressed as a proportion of the diagonal of the bounding box of the mesh.
+ */
+@property(nonatomic, readonly) GLfloat achievedError;
+
+/** The number of faces in the mesh returned by the most recent invocation of the simplifiedMesh method. */
+@property(nonatomic, readonly) GLuint simplifiedFaceCount;
+
+/**
+ * An array of simplifiedFaceCount elements, each holding the index of the face in the original
+ * mesh from which the corresponding face of the most recently simplified mesh came.
+ *
+ * The faces of the simplified mesh are in the same order as the faces of the original mesh,
+ * so this array is always in ascending order.
+ */
+@property(nonatomic, readonly) GLuint* sourceFaceIndices;
+
+/**
+ * Simplifies the mesh, and returns the result as a new autoreleased mesh of the same class and
+ * vertex content types as the original mesh.
+ *
+ * GL buffers are not created for the simplified mesh, even if the original mesh is using them,
+ * so that this method can be invoked on a background thread. If the simplified mesh is to use
+ * GL buffers, invoke its createGLBuffers method on the thread that holds the GL context.
+ *
+ * Returns nil if the mesh cannot be simplified, as determined by the canSimplifyMesh: method.
+ */
+-(CC3Mesh*) simplifiedMesh;
+
+/**
+ * Returns whether the specified mesh can be simplified.
+ *
+ * Returns YES if the mesh is drawn with GL_TRIANGLES, GL_TRIANGLE_STRIP or GL_TRIANGLE_FAN, holds
+ * its GL_FLOAT vertex locations and any vertex indices in application memory, and has no more
+ * vertices than can be addressed by 16-bit vertex indices.
+ */
++(BOOL) canSimplifyMesh: (CC3Mesh*) aMesh;
+
+
+#pragma mark Allocation and initialization
+
+/** Initializes this instance to simplify the specified mesh. */
+-(id) initWithMesh: (CC3Mesh*) aMesh;
+
+/** Allocates and initializes an autoreleased instance to simplify the specified mesh. */
++(id) simplifierWithMesh: (CC3Mesh*) aMesh;
+
+@end
+
+
+#pragma mark -
+#pragma mark CC3Mesh extension for simplification
+
+/** Extension category to support simplification of meshes. */
+@interface CC3Mesh (Simplification)
+
+/**
+ * Returns a new autoreleased simplified copy of this mesh, containing approximately the
+ * specified number of faces, using a CC3MeshSimplifier with its default configuration.
+ *
+ * Returns nil if this mesh cannot be simplified. See the canSimplifyMesh: method of
+ * CC3MeshSimplifier for more info.
+ *
+ * GL buffers are not created for the returned mesh. See the simplifiedMesh method of
+ * CC3MeshSimplifier for more info.
+ */
+-(CC3Mesh*) simplifiedMeshWithFaceCount: (GLuint) faceCount;
+
+@end
+
+
+#pragma mark -
+#pragma mark CC3LODMeshNode extension for simplification
+
+/** Extension category to support generating levels of detail by simplifying the full-detail mesh. */
+@interface CC3LODMeshNode (Simplification)
+
+/**
+ * Generates the specified number of coarser levels of detail by simplifying the full-detail
+ * mesh in the mesh property, and adds them to this node.
+ *
+ * Each level contains the specified proportion of the faces of the level before it. The first
+ * generated level is drawn below the specified screen size, and, since the number of faces
+ * visible on screen is proportional to the area of the node on the screen, the screen size
+ * threshold of each subsequent level is reduced by the square root of the face ratio.
+ *
+ * Generation stops early if the full-detail mesh cannot be simplified, or if a level cannot
+ * be simplified further. Generation can take some time for large meshes, so you should
+ * consider invoking this method during loading, or on a background thread.
+ *
+ * This method does not access the GL engine, so GL buffers are not created for the generated
+ * levels of detail. If this node uses GL buffers, invoke the createGLBuffers method of this
+ * node, on the thread that holds the GL context, once this method has completed.
+ */
+-(void) addSimplifiedLevelsOfDetail: (GLuint) lodCount
+					  withFaceRatio: (GLfloat) faceRatio
+				 forScreenSizeBelow: (GLfloat) screenSize;
+
+@end
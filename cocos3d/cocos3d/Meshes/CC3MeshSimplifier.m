@@ -0,0 +1,771 @@
+/*
+ * CC3MeshSimplifier.m
+ *
+ * cocos3d 2.0.0
+ * Author: Bill Hollings
+ * Copyright (c) 2010-2013 The Brenwill Workshop Ltd. All rights reserved.
+ * http://www.brenwill.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * http://en.wikipedia.org/wiki/MIT_License
+ *
+ * See header file CC3MeshSimplifier.h for full API documentation.
+ */
+
+#import "CC3MeshSimplifier.h"
+
+
+/** The number of vertices or candidate edges processed by each concurrent task. */
+#define kCC3MeshSimplifierRangeLength			4096
+
+/** The weight of the planes that hold the border edges of the mesh in place. */
+#define kCC3MeshSimplifierBorderWeight			10.0
+
+/** An edge is not collapsed if a remaining face would turn by more than about 75 degrees. */
+#define kCC3MeshSimplifierMinFaceNormalCosine	0.25
+
+/** Marks the absence of a vertex in the index arrays used during simplification. */
+#define kCC3MeshSimplifierNoVertex				kCC3MaxGLuint
+
+
+#pragma mark -
+#pragma mark Simplification structures and functions
+
+/** Determines how a vertex may be moved during simplification. */
+typedef enum {
+	kCC3SimplifierVertexManifold,		/**< Surrounded by faces. Can be moved onto any neighbour. */
+	kCC3SimplifierVertexBorder,			/**< On an open border. Can be moved along the border. */
+	kCC3SimplifierVertexSeam,			/**< On a texture or normal seam. Can be moved along the seam. */
+	kCC3SimplifierVertexLocked,			/**< On a junction of borders or seams, or where a seam ends. Never moved. */
+} CC3SimplifierVertexKind;
+
+/**
+ * A symmetric 4x4 quadric matrix, accumulating the squared distances to a set of planes,
+ * along with the total weight of those planes.
+ */
+typedef struct {
+	double a2, ab, ac, ad, b2, bc, bd, c2, cd, d2;
+	double weight;
+} CC3Quadric;
+
+/** A candidate edge collapse, moving one vertex onto another, and the error it introduces. */
+typedef struct {
+	GLuint from;
+	GLuint to;
+	GLfloat cost;
+} CC3SimplifierCollapse;
+
+/** The working state of the mesh during simplification. */
+typedef struct {
+	CC3Vector* locations;			/**< The location of each vertex. */
+	GLuint* indices;				/**< Three vertex indices per face. */
+	GLuint* faceSources;			/**< The index of the original face of each face. */
+	GLubyte* isFaceRemoved;			/**< Whether each face has collapsed during the current pass. */
+	GLuint* positions;				/**< The first vertex sharing the location of each vertex. */
+	GLuint* siblings;				/**< The next vertex sharing the location of each vertex. */
+	GLubyte* kinds;					/**< The CC3SimplifierVertexKind of each vertex. */
+	GLuint* dominantBones;			/**< The most influential bone of each vertex, or NULL. */
+	CC3Quadric* quadrics;			/**< The quadric of each location, indexed by position. */
+	GLuint* adjacencyStarts;		/**< Where the faces around each vertex start in the adjacency array. */
+	GLuint* adjacency;				/**< The faces around each vertex. */
+	GLubyte* isPositionTouched;		/**< Whether each position has moved during the current pass. */
+	GLuint vertexCount;
+	GLuint faceCount;
+	GLuint liveFaceCount;
+} CC3SimplifierContext;
+
+static inline void CC3QuadricAddPlane(CC3Quadric* q, double a, double b, double c, double d, double w) {
+	q->a2 += w * a * a;  q->ab += w * a * b;  q->ac += w * a * c;  q->ad += w * a * d;
+	q->b2 += w * b * b;  q->bc += w * b * c;  q->bd += w * b * d;
+	q->c2 += w * c * c;  q->cd += w * c * d;
+	q->d2 += w * d * d;
+	q->weight += w;
+}
+
+static inline void CC3QuadricAdd(CC3Quadric* q, const CC3Quadric* other) {
+	q->a2 += other->a2;  q->ab += other->ab;  q->ac += other->ac;  q->ad += other->ad;
+	q->b2 += other->b2;  q->bc += other->bc;  q->bd += other->bd;
+	q->c2 += other->c2;  q->cd += other->cd;
+	q->d2 += other->d2;
+	q->weight += other->weight;
+}
+
+/** Returns the weighted sum of the squared distances from the specified location to the planes of the quadric. */
+static inline double CC3QuadricEvaluate(const CC3Quadric* q, CC3Vector loc) {
+	double x = loc.x, y = loc.y, z = loc.z;
+	return (q->a2 * x * x) + (2.0 * q->ab * x * y) + (2.0 * q->ac * x * z) + (2.0 * q->ad * x)
+		 + (q->b2 * y * y) + (2.0 * q->bc * y * z) + (2.0 * q->bd * y)
+		 + (q->c2 * z * z) + (2.0 * q->cd * z)
+		 + q->d2;
+}
+
+/**
+ * Returns the mean squared distance from the specified location to the planes
+ * of the two quadrics, which is the error of moving both locations there.
+ */
+static inline double CC3QuadricPairError(const CC3Quadric* q1, const CC3Quadric* q2, CC3Vector loc) {
+	double w = q1->weight + q2->weight;
+	double err = CC3QuadricEvaluate(q1, loc) + CC3QuadricEvaluate(q2, loc);
+	return (w > 0.0) ? (ABS(err) / w) : 0.0;
+}
+
+/** Returns a hash of the specified location, treating positive and negative zero as the same. */
+static inline GLuint CC3SimplifierHashLocation(CC3Vector loc) {
+	union { GLfloat f; GLuint u; } x, y, z;
+	x.f = loc.x + 0.0f;
+	y.f = loc.y + 0.0f;
+	z.f = loc.z + 0.0f;
+	return (x.u * 73856093u) ^ (y.u * 19349663u) ^ (z.u * 83492791u);
+}
+
+/**
+ * Processes the specified number of elements in ranges, invoking the specified block for each
+ * range. If concurrency is allowed and there is more than one range, the ranges are processed
+ * concurrently, and this function returns once all of the ranges have been processed.
+ */
+static void CC3SimplifierApply(GLuint count, BOOL shouldUseConcurrency, void (^rangeBlock)(GLuint, GLuint)) {
+	GLuint rangeCount = (count + kCC3MeshSimplifierRangeLength - 1) / kCC3MeshSimplifierRangeLength;
+	if (shouldUseConcurrency && rangeCount > 1) {
+		dispatch_apply(rangeCount, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t rIdx) {
+			GLuint start = (GLuint)rIdx * kCC3MeshSimplifierRangeLength;
+			rangeBlock(start, MIN(start + kCC3MeshSimplifierRangeLength, count));
+		});
+	} else if (count) {
+		rangeBlock(0, count);
+	}
+}
+
+/**
+ * Links together the vertices that share the same location, so that texture and normal seams,
+ * where a single location is split into several vertices, can be identified and preserved.
+ */
+static void CC3SimplifierWeldPositions(CC3SimplifierContext* ctx) {
+	GLuint vtxCount = ctx->vertexCount;
+	GLuint tblSize = 1;
+	while (tblSize < vtxCount * 2) tblSize <<= 1;
+	GLuint tblMask = tblSize - 1;
+	GLuint* table = malloc(tblSize * sizeof(GLuint));
+	memset(table, 0xFF, tblSize * sizeof(GLuint));
+
+	for (GLuint vtxIdx = 0; vtxIdx < vtxCount; vtxIdx++) {
+		CC3Vector loc = ctx->locations[vtxIdx];
+		GLuint slot = CC3SimplifierHashLocation(loc) & tblMask;
+		while (table[slot] != kCC3MeshSimplifierNoVertex &&
+			   !CC3VectorsAreEqual(ctx->locations[table[slot]], loc)) slot = (slot + 1) & tblMask;
+
+		GLuint firstIdx = table[slot];
+		if (firstIdx == kCC3MeshSimplifierNoVertex) {
+			table[slot] = vtxIdx;
+			ctx->positions[vtxIdx] = vtxIdx;
+			ctx->siblings[vtxIdx] = vtxIdx;
+		} else {
+			ctx->positions[vtxIdx] = firstIdx;
+			ctx->siblings[vtxIdx] = ctx->siblings[firstIdx];
+			ctx->siblings[firstIdx] = vtxIdx;
+		}
+	}
+	free(table);
+}
+
+/** Returns whether two corners of the specified face share the same location. */
+static inline BOOL CC3SimplifierIsFaceDegenerate(CC3SimplifierContext* ctx, GLuint faceIdx) {
+	GLuint* fi = &ctx->indices[faceIdx * 3];
+	GLuint p0 = ctx->positions[fi[0]], p1 = ctx->positions[fi[1]], p2 = ctx->positions[fi[2]];
+	return (p0 == p1 || p1 == p2 || p2 == p0);
+}
+
+/** Removes the faces that collapsed during the last pass, preserving the order of the remaining faces. */
+static void CC3SimplifierCompactFaces(CC3SimplifierContext* ctx) {
+	GLuint dstIdx = 0;
+	for (GLuint faceIdx = 0; faceIdx < ctx->faceCount; faceIdx++) {
+		if (ctx->isFaceRemoved[faceIdx]) continue;
+		if (dstIdx != faceIdx) {
+			memcpy(&ctx->indices[dstIdx * 3], &ctx->indices[faceIdx * 3], 3 * sizeof(GLuint));
+			ctx->faceSources[dstIdx] = ctx->faceSources[faceIdx];
+			ctx->isFaceRemoved[dstIdx] = NO;
+		}
+		dstIdx++;
+	}
+	ctx->faceCount = dstIdx;
+	ctx->liveFaceCount = dstIdx;
+}
+
+/** Rebuilds the lists of the faces around each vertex. */
+static void CC3SimplifierBuildAdjacency(CC3SimplifierContext* ctx) {
+	GLuint* starts = ctx->adjacencyStarts;
+	memset(starts, 0, (ctx->vertexCount + 1) * sizeof(GLuint));
+
+	GLuint idxCount = ctx->faceCount * 3;
+	for (GLuint i = 0; i < idxCount; i++) starts[ctx->indices[i] + 1]++;
+	for (GLuint vtxIdx = 0; vtxIdx < ctx->vertexCount; vtxIdx++) starts[vtxIdx + 1] += starts[vtxIdx];
+
+	// Fill each list, temporarily advancing each start, then shift the starts back into place.
+	for (GLuint i = 0; i < idxCount; i++) ctx->adjacency[starts[ctx->indices[i]]++] = i / 3;
+	for (GLuint vtxIdx = ctx->vertexCount; vtxIdx > 0; vtxIdx--) starts[vtxIdx] = starts[vtxIdx - 1];
+	starts[0] = 0;
+}
+
+/**
+ * Returns the number of live faces around the specified vertex that contain a vertex at the
+ * specified position, and returns the last such vertex found in the foundVtx parameter.
+ */
+static GLuint CC3SimplifierCountFacesAtPosition(CC3SimplifierContext* ctx, GLuint vtxIdx,
+												GLuint position, GLuint* foundVtx) {
+	GLuint faceCount = 0;
+	for (GLuint adjIdx = ctx->adjacencyStarts[vtxIdx]; adjIdx < ctx->adjacencyStarts[vtxIdx + 1]; adjIdx++) {
+		GLuint faceIdx = ctx->adjacency[adjIdx];
+		if (ctx->isFaceRemoved[faceIdx]) continue;
+		GLuint* fi = &ctx->indices[faceIdx * 3];
+		for (int i = 0; i < 3; i++) {
+			if (ctx->positions[fi[i]] == position) {
+				if (foundVtx) *foundVtx = fi[i];
+				faceCount++;
+				break;
+			}
+		}
+	}
+	return faceCount;
+}
+
+/** Returns the number of live faces around the specified vertex that also contain the other vertex. */
+static GLuint CC3SimplifierCountSharedFaces(CC3SimplifierContext* ctx, GLuint vtxIdx, GLuint otherIdx) {
+	GLuint faceCount = 0;
+	for (GLuint adjIdx = ctx->adjacencyStarts[vtxIdx]; adjIdx < ctx->adjacencyStarts[vtxIdx + 1]; adjIdx++) {
+		GLuint faceIdx = ctx->adjacency[adjIdx];
+		if (ctx->isFaceRemoved[faceIdx]) continue;
+		GLuint* fi = &ctx->indices[faceIdx * 3];
+		if (fi[0] == otherIdx || fi[1] == otherIdx || fi[2] == otherIdx) faceCount++;
+	}
+	return faceCount;
+}
+
+/** Returns the unit normal of the specified face, and its area in the area parameter. */
+static CC3Vector CC3SimplifierFaceNormal(CC3SimplifierContext* ctx, GLuint faceIdx, GLfloat* area) {
+	GLuint* fi = &ctx->indices[faceIdx * 3];
+	CC3Vector v0 = ctx->locations[fi[0]];
+	CC3Vector n = CC3VectorCross(CC3VectorDifference(ctx->locations[fi[1]], v0),
+								 CC3VectorDifference(ctx->locations[fi[2]], v0));
+	GLfloat len = CC3VectorLength(n);
+	*area = len * 0.5f;
+	return (len > 0.0f) ? CC3VectorScaleUniform(n, 1.0f / len) : kCC3VectorZero;
+}
+
+/** Accumulates the plane of each face into the quadrics of the three locations of the face. */
+static void CC3SimplifierAddFaceQuadrics(CC3SimplifierContext* ctx) {
+	for (GLuint faceIdx = 0; faceIdx < ctx->faceCount; faceIdx++) {
+		GLfloat area;
+		CC3Vector n = CC3SimplifierFaceNormal(ctx, faceIdx, &area);
+		if (area <= 0.0f) continue;
+		GLuint* fi = &ctx->indices[faceIdx * 3];
+		double d = -CC3VectorDot(n, ctx->locations[fi[0]]);
+		for (int i = 0; i < 3; i++)
+			CC3QuadricAddPlane(&ctx->quadrics[ctx->positions[fi[i]]], n.x, n.y, n.z, d, area);
+	}
+}
+
+/**
+ * Classifies the vertices at the specified position as manifold, border, seam or locked vertices,
+ * by counting the open edges around the position, and around each of the vertices at the position.
+ * A single vertex whose own open edges differ from the open edges of its position lies where a
+ * seam ends, and is locked, since moving it onto one side of the seam would drag the faces on
+ * the other side onto the texture coordinates and normals of that side.
+ * Adds a heavily weighted plane, perpendicular to the face, to the quadric of the position for
+ * each open border edge, to hold the border in place.
+ */
+static void CC3SimplifierClassifyPosition(CC3SimplifierContext* ctx, GLuint position) {
+	GLuint wedgeCount = 0, openPosEdgeCount = 0, openWedgeEdgeCount = 0;
+	BOOL areWedgesOnSeam = YES;
+	GLuint vtxIdx = position;
+	do {
+		wedgeCount++;
+		GLuint openVtxEdgeCount = 0;
+		for (GLuint adjIdx = ctx->adjacencyStarts[vtxIdx]; adjIdx < ctx->adjacencyStarts[vtxIdx + 1]; adjIdx++) {
+			GLuint faceIdx = ctx->adjacency[adjIdx];
+			GLuint* fi = &ctx->indices[faceIdx * 3];
+			for (int i = 0; i < 3; i++) {
+				GLuint otherIdx = fi[i];
+				if (otherIdx == vtxIdx) continue;
+
+				if (CC3SimplifierCountSharedFaces(ctx, vtxIdx, otherIdx) == 1) openVtxEdgeCount++;
+
+				// Count the faces around all the vertices at this position that contain the other position.
+				GLuint otherPos = ctx->positions[otherIdx];
+				GLuint posFaceCount = 0;
+				GLuint wedgeIdx = position;
+				do {
+					posFaceCount += CC3SimplifierCountFacesAtPosition(ctx, wedgeIdx, otherPos, NULL);
+					wedgeIdx = ctx->siblings[wedgeIdx];
+				} while (wedgeIdx != position);
+
+				if (posFaceCount == 1) {
+					openPosEdgeCount++;
+					GLfloat area;
+					CC3Vector faceNorm = CC3SimplifierFaceNormal(ctx, faceIdx, &area);
+					CC3Vector loc = ctx->locations[vtxIdx];
+					CC3Vector edge = CC3VectorDifference(ctx->locations[otherIdx], loc);
+					CC3Vector n = CC3VectorCross(edge, faceNorm);
+					GLfloat len = CC3VectorLength(n);
+					if (len > 0.0f) {
+						n = CC3VectorScaleUniform(n, 1.0f / len);
+						CC3QuadricAddPlane(&ctx->quadrics[position], n.x, n.y, n.z, -CC3VectorDot(n, loc),
+										   CC3VectorLengthSquared(edge) * kCC3MeshSimplifierBorderWeight);
+					}
+				}
+			}
+		}
+		if (openVtxEdgeCount != 2) areWedgesOnSeam = NO;
+		openWedgeEdgeCount += openVtxEdgeCount;
+		vtxIdx = ctx->siblings[vtxIdx];
+	} while (vtxIdx != position);
+
+	CC3SimplifierVertexKind kind = kCC3SimplifierVertexLocked;
+	if (wedgeCount == 1 && openWedgeEdgeCount == openPosEdgeCount) {
+		if (openPosEdgeCount == 0) kind = kCC3SimplifierVertexManifold;
+		else if (openPosEdgeCount == 2) kind = kCC3SimplifierVertexBorder;
+	} else if (wedgeCount == 2 && openPosEdgeCount == 0 && areWedgesOnSeam) {
+		kind = kCC3SimplifierVertexSeam;
+	}
+
+	vtxIdx = position;
+	do {
+		ctx->kinds[vtxIdx] = kind;
+		vtxIdx = ctx->siblings[vtxIdx];
+	} while (vtxIdx != position);
+}
+
+/** Returns whether the kinds and skinning of the two vertices allow the first to be moved onto the second. */
+static BOOL CC3SimplifierIsCollapseAllowed(CC3SimplifierContext* ctx, GLuint fromIdx, GLuint toIdx) {
+	if (ctx->positions[fromIdx] == ctx->positions[toIdx]) return NO;
+	GLubyte toKind = ctx->kinds[toIdx];
+	switch (ctx->kinds[fromIdx]) {
+		case kCC3SimplifierVertexManifold:
+			break;
+		case kCC3SimplifierVertexBorder:
+			if (toKind != kCC3SimplifierVertexBorder && toKind != kCC3SimplifierVertexLocked) return NO;
+			break;
+		case kCC3SimplifierVertexSeam:
+			if (toKind != kCC3SimplifierVertexSeam && toKind != kCC3SimplifierVertexLocked) return NO;
+			break;
+		default:
+			return NO;
+	}
+	if (ctx->dominantBones && ctx->dominantBones[fromIdx] != ctx->dominantBones[toIdx]) return NO;
+	return YES;
+}
+
+/**
+ * Evaluates the cost of collapsing the specified candidate edge in each allowed direction,
+ * and orients the candidate in the cheaper direction. If neither direction is allowed,
+ * the cost is set to kCC3MaxGLfloat.
+ */
+static void CC3SimplifierEvaluateCollapse(CC3SimplifierContext* ctx, CC3SimplifierCollapse* collapse) {
+	GLuint v0 = collapse->from, v1 = collapse->to;
+	CC3Quadric* q0 = &ctx->quadrics[ctx->positions[v0]];
+	CC3Quadric* q1 = &ctx->quadrics[ctx->positions[v1]];
+	double cost01 = CC3SimplifierIsCollapseAllowed(ctx, v0, v1)
+						? CC3QuadricPairError(q0, q1, ctx->locations[v1]) : kCC3MaxGLfloat;
+	double cost10 = CC3SimplifierIsCollapseAllowed(ctx, v1, v0)
+						? CC3QuadricPairError(q0, q1, ctx->locations[v0]) : kCC3MaxGLfloat;
+	if (cost10 < cost01) {
+		collapse->from = v1;
+		collapse->to = v0;
+		collapse->cost = (GLfloat)cost10;
+	} else {
+		collapse->cost = (GLfloat)cost01;
+	}
+}
+
+static int CC3SimplifierCompareCollapses(const void* c1, const void* c2) {
+	GLfloat cost1 = ((const CC3SimplifierCollapse*)c1)->cost;
+	GLfloat cost2 = ((const CC3SimplifierCollapse*)c2)->cost;
+	return (cost1 < cost2) ? -1 : ((cost1 > cost2) ? 1 : 0);
+}
+
+/**
+ * Returns whether moving the first vertex onto the location of the second would flip, or badly
+ * distort, any of the faces around the first vertex that would not collapse as a result.
+ */
+static BOOL CC3SimplifierIsCollapseFlipping(CC3SimplifierContext* ctx, GLuint fromIdx, GLuint toIdx) {
+	CC3Vector newLoc = ctx->locations[toIdx];
+	GLuint toPos = ctx->positions[toIdx];
+	for (GLuint adjIdx = ctx->adjacencyStarts[fromIdx]; adjIdx < ctx->adjacencyStarts[fromIdx + 1]; adjIdx++) {
+		GLuint faceIdx = ctx->adjacency[adjIdx];
+		if (ctx->isFaceRemoved[faceIdx]) continue;
+
+		GLuint* fi = &ctx->indices[faceIdx * 3];
+		if (ctx->positions[fi[0]] == toPos || ctx->positions[fi[1]] == toPos || ctx->positions[fi[2]] == toPos) continue;
+
+		CC3Vector oldLocs[3], newLocs[3];
+		for (int i = 0; i < 3; i++) {
+			oldLocs[i] = ctx->locations[fi[i]];
+			newLocs[i] = (fi[i] == fromIdx) ? newLoc : oldLocs[i];
+		}
+		CC3Vector oldNorm = CC3VectorCross(CC3VectorDifference(oldLocs[1], oldLocs[0]),
+										   CC3VectorDifference(oldLocs[2], oldLocs[0]));
+		CC3Vector newNorm = CC3VectorCross(CC3VectorDifference(newLocs[1], newLocs[0]),
+										   CC3VectorDifference(newLocs[2], newLocs[0]));
+		double dot = CC3VectorDot(oldNorm, newNorm);
+		double minDot = kCC3MeshSimplifierMinFaceNormalCosine;
+		if (dot <= 0.0 || dot * dot < minDot * minDot * CC3VectorLengthSquared(oldNorm) * CC3VectorLengthSquared(newNorm))
+			return YES;
+	}
+	return NO;
+}
+
+/** Moves the first vertex onto the second in each of its faces, removing any faces that collapse. */
+static void CC3SimplifierMoveVertex(CC3SimplifierContext* ctx, GLuint fromIdx, GLuint toIdx) {
+	for (GLuint adjIdx = ctx->adjacencyStarts[fromIdx]; adjIdx < ctx->adjacencyStarts[fromIdx + 1]; adjIdx++) {
+		GLuint faceIdx = ctx->adjacency[adjIdx];
+		if (ctx->isFaceRemoved[faceIdx]) continue;
+
+		GLuint* fi = &ctx->indices[faceIdx * 3];
+		for (int i = 0; i < 3; i++) if (fi[i] == fromIdx) fi[i] = toIdx;
+		if (CC3SimplifierIsFaceDegenerate(ctx, faceIdx)) {
+			ctx->isFaceRemoved[faceIdx] = YES;
+			ctx->liveFaceCount--;
+		}
+	}
+}
+
+/**
+ * Attempts to perform the specified collapse, and returns whether it was performed. The collapse
+ * is not performed if either location has already moved during this pass, if a border or seam
+ * vertex would leave its border or seam, or if any remaining face would be flipped.
+ */
+static BOOL CC3SimplifierPerformCollapse(CC3SimplifierContext* ctx, CC3SimplifierCollapse* collapse) {
+	GLuint fromIdx = collapse->from, toIdx = collapse->to;
+	GLuint fromPos = ctx->positions[fromIdx], toPos = ctx->positions[toIdx];
+	if (ctx->isPositionTouched[fromPos] || ctx->isPositionTouched[toPos]) return NO;
+
+	GLuint sibFromIdx = kCC3MeshSimplifierNoVertex, sibToIdx = kCC3MeshSimplifierNoVertex;
+	switch (ctx->kinds[fromIdx]) {
+		case kCC3SimplifierVertexBorder:
+			if (CC3SimplifierCountFacesAtPosition(ctx, fromIdx, toPos, NULL) != 1) return NO;
+			break;
+		case kCC3SimplifierVertexSeam:
+			// Both vertices at the location must move along the seam together
+			if (CC3SimplifierCountSharedFaces(ctx, fromIdx, toIdx) != 1) return NO;
+			sibFromIdx = ctx->siblings[fromIdx];
+			if (CC3SimplifierCountFacesAtPosition(ctx, sibFromIdx, toPos, &sibToIdx) != 1) return NO;
+			if (CC3SimplifierIsCollapseFlipping(ctx, sibFromIdx, sibToIdx)) return NO;
+			break;
+		default:
+			break;
+	}
+	if (CC3SimplifierIsCollapseFlipping(ctx, fromIdx, toIdx)) return NO;
+
+	CC3SimplifierMoveVertex(ctx, fromIdx, toIdx);
+	if (sibFromIdx != kCC3MeshSimplifierNoVertex) CC3SimplifierMoveVertex(ctx, sibFromIdx, sibToIdx);
+
+	CC3QuadricAdd(&ctx->quadrics[toPos], &ctx->quadrics[fromPos]);
+	ctx->isPositionTouched[fromPos] = YES;
+	ctx->isPositionTouched[toPos] = YES;
+	return YES;
+}
+
+
+#pragma mark -
+#pragma mark CC3MeshSimplifier
+
+@interface CC3MeshSimplifier (TemplateMethods)
+-(void) populateContext: (CC3SimplifierContext*) ctx;
+-(CC3Mesh*) meshFromContext: (CC3SimplifierContext*) ctx;
+-(void) matchVertexArraysOf: (CC3Mesh*) aMesh;
+@end
+
+@implementation CC3MeshSimplifier
+
+@synthesize mesh=_mesh, targetFaceCount=_targetFaceCount, maximumError=_maximumError;
+@synthesize shouldPreserveSkinning=_shouldPreserveSkinning, shouldUseConcurrency=_shouldUseConcurrency;
+@synthesize achievedError=_achievedError, simplifiedFaceCount=_simplifiedFaceCount;
+@synthesize sourceFaceIndices=_sourceFaceIndices;
+
+-(void) dealloc {
+	[_mesh release];
+	free(_sourceFaceIndices);
+	[super dealloc];
+}
+
++(BOOL) canSimplifyMesh: (CC3Mesh*) aMesh {
+	switch (aMesh.drawingMode) {
+		case GL_TRIANGLES:
+		case GL_TRIANGLE_STRIP:
+		case GL_TRIANGLE_FAN:
+			break;
+		default:
+			return NO;
+	}
+	CC3VertexLocations* vLocs = aMesh.vertexLocations;
+	if ( !vLocs.vertices || vLocs.elementType != GL_FLOAT ) return NO;
+	if (aMesh.hasVertexIndices && !aMesh.vertexIndices.vertices) return NO;
+	return (aMesh.vertexCount > 0 && aMesh.vertexCount <= (kCC3MaxGLushort + 1));
+}
+
+
+#pragma mark Simplification
+
+-(CC3Mesh*) simplifiedMesh {
+	if ( ![[self class] canSimplifyMesh: _mesh] ) {
+		LogError(@"%@ cannot simplify %@", self, _mesh);
+		return nil;
+	}
+	NSDate* startTime = [NSDate date];
+
+	GLuint vtxCount = _mesh.vertexCount;
+	GLuint faceCount = _mesh.faceCount;
+	CC3SimplifierContext ctx;
+	memset(&ctx, 0, sizeof(CC3SimplifierContext));
+	ctx.vertexCount = vtxCount;
+	ctx.faceCount = faceCount;
+	ctx.locations = malloc(vtxCount * sizeof(CC3Vector));
+	ctx.indices = malloc(faceCount * 3 * sizeof(GLuint));
+	ctx.faceSources = malloc(faceCount * sizeof(GLuint));
+	ctx.isFaceRemoved = calloc(faceCount, sizeof(GLubyte));
+	ctx.positions = malloc(vtxCount * sizeof(GLuint));
+	ctx.siblings = malloc(vtxCount * sizeof(GLuint));
+	ctx.kinds = calloc(vtxCount, sizeof(GLubyte));
+	ctx.quadrics = calloc(vtxCount, sizeof(CC3Quadric));
+	ctx.adjacencyStarts = malloc((vtxCount + 1) * sizeof(GLuint));
+	ctx.adjacency = malloc(faceCount * 3 * sizeof(GLuint));
+	ctx.isPositionTouched = malloc(vtxCount * sizeof(GLubyte));
+	[self populateContext: &ctx];
+
+	// Establish the topology, and measure the shape, of the original mesh
+	CC3SimplifierWeldPositions(&ctx);
+	for (GLuint faceIdx = 0; faceIdx < ctx.faceCount; faceIdx++)
+		ctx.isFaceRemoved[faceIdx] = CC3SimplifierIsFaceDegenerate(&ctx, faceIdx);
+	CC3SimplifierCompactFaces(&ctx);
+	CC3SimplifierBuildAdjacency(&ctx);
+	CC3SimplifierAddFaceQuadrics(&ctx);
+
+	CC3SimplifierContext* pCtx = &ctx;
+	CC3SimplifierApply(vtxCount, _shouldUseConcurrency, ^(GLuint start, GLuint end) {
+		for (GLuint vtxIdx = start; vtxIdx < end; vtxIdx++)
+			if (pCtx->positions[vtxIdx] == vtxIdx) CC3SimplifierClassifyPosition(pCtx, vtxIdx);
+	});
+
+	CC3BoundingBox bb = _mesh.boundingBox;
+	double meshSize = CC3BoundingBoxIsNull(bb) ? 0.0 : CC3VectorDistance(bb.minimum, bb.maximum);
+	double maxCost = _maximumError * meshSize;
+	maxCost *= maxCost;
+	double worstCost = 0.0;
+
+	// Collapse edges in passes, from cheapest to most expensive in each pass,
+	// until the target face count or maximum error is reached.
+	CC3SimplifierCollapse* collapses = malloc(ctx.faceCount * 3 * sizeof(CC3SimplifierCollapse));
+	GLuint passCount = 0;
+	while (ctx.liveFaceCount > _targetFaceCount) {
+		GLuint collapseCount = ctx.faceCount * 3;
+		for (GLuint i = 0; i < collapseCount; i++) {
+			collapses[i].from = ctx.indices[i];
+			collapses[i].to = ctx.indices[(i % 3 == 2) ? (i - 2) : (i + 1)];
+		}
+		CC3SimplifierApply(collapseCount, _shouldUseConcurrency, ^(GLuint start, GLuint end) {
+			for (GLuint i = start; i < end; i++) CC3SimplifierEvaluateCollapse(pCtx, &collapses[i]);
+		});
+		qsort(collapses, collapseCount, sizeof(CC3SimplifierCollapse), CC3SimplifierCompareCollapses);
+
+		memset(ctx.isPositionTouched, 0, vtxCount * sizeof(GLubyte));
+		GLuint performedCount = 0;
+		for (GLuint i = 0; i < collapseCount && ctx.liveFaceCount > _targetFaceCount; i++) {
+			CC3SimplifierCollapse* collapse = &collapses[i];
+			if (collapse->cost > maxCost) break;
+			if (CC3SimplifierPerformCollapse(&ctx, collapse)) {
+				worstCost = MAX(worstCost, collapse->cost);
+				performedCount++;
+			}
+		}
+		passCount++;
+		LogTrace(@"%@ pass %u collapsed %u edges leaving %u faces", self, passCount, performedCount, ctx.liveFaceCount);
+		if (performedCount == 0) break;
+
+		CC3SimplifierCompactFaces(&ctx);
+		CC3SimplifierBuildAdjacency(&ctx);
+	}
+	free(collapses);
+
+	_achievedError = (meshSize > 0.0) ? (GLfloat)(sqrt(worstCost) / meshSize) : 0.0f;
+	CC3Mesh* simpMesh = [self meshFromContext: &ctx];
+
+	free(_sourceFaceIndices);
+	_sourceFaceIndices = ctx.faceSources;
+	_simplifiedFaceCount = ctx.faceCount;
+
+	free(ctx.locations);
+	free(ctx.indices);
+	free(ctx.isFaceRemoved);
+	free(ctx.positions);
+	free(ctx.siblings);
+	free(ctx.kinds);
+	free(ctx.dominantBones);
+	free(ctx.quadrics);
+	free(ctx.adjacencyStarts);
+	free(ctx.adjacency);
+	free(ctx.isPositionTouched);
+
+	LogInfo(@"%@ simplified %u faces to %u faces in %u passes with error %.4f in %.3f ms",
+			self, faceCount, _simplifiedFaceCount, passCount, _achievedError,
+			-[startTime timeIntervalSinceNow] * 1000.0);
+	return simpMesh;
+}
+
+/**
+ * Reads the vertex locations, faces and, if skinning is to be preserved, the most
+ * influential bone of each vertex, from the mesh into the specified context.
+ */
+-(void) populateContext: (CC3SimplifierContext*) ctx {
+	for (GLuint vtxIdx = 0; vtxIdx < ctx->vertexCount; vtxIdx++)
+		ctx->locations[vtxIdx] = [_mesh vertexLocationAt: vtxIdx];
+
+	for (GLuint faceIdx = 0; faceIdx < ctx->faceCount; faceIdx++) {
+		CC3FaceIndices fi = [_mesh faceIndicesAt: faceIdx];
+		memcpy(&ctx->indices[faceIdx * 3], fi.vertices, 3 * sizeof(GLuint));
+		ctx->faceSources[faceIdx] = faceIdx;
+	}
+
+	if (_shouldPreserveSkinning && _mesh.hasVertexWeights && _mesh.hasVertexMatrixIndices) {
+		GLuint vuCount = _mesh.vertexUnitCount;
+		ctx->dominantBones = malloc(ctx->vertexCount * sizeof(GLuint));
+		for (GLuint vtxIdx = 0; vtxIdx < ctx->vertexCount; vtxIdx++) {
+			GLuint domUnit = 0;
+			GLfloat domWeight = -1.0f;
+			for (GLuint vuIdx = 0; vuIdx < vuCount; vuIdx++) {
+				GLfloat weight = [_mesh vertexWeightForVertexUnit: vuIdx at: vtxIdx];
+				if (weight > domWeight) {
+					domWeight = weight;
+					domUnit = vuIdx;
+				}
+			}
+			ctx->dominantBones[vtxIdx] = [_mesh vertexMatrixIndexForVertexUnit: domUnit at: vtxIdx];
+		}
+	}
+}
+
+/**
+ * Returns a new mesh containing the faces remaining in the specified context,
+ * and only the vertices of the original mesh that are used by those faces.
+ */
+-(CC3Mesh*) meshFromContext: (CC3SimplifierContext*) ctx {
+	GLuint* vtxMap = malloc(ctx->vertexCount * sizeof(GLuint));
+	memset(vtxMap, 0xFF, ctx->vertexCount * sizeof(GLuint));
+	GLuint idxCount = ctx->faceCount * 3;
+	GLuint simpVtxCount = 0;
+	for (GLuint i = 0; i < idxCount; i++) {
+		GLuint vtxIdx = ctx->indices[i];
+		if (vtxMap[vtxIdx] == kCC3MeshSimplifierNoVertex) vtxMap[vtxIdx] = simpVtxCount++;
+	}
+
+	CC3Mesh* simpMesh = [[_mesh class] meshWithName: [NSString stringWithFormat: @"%@-Simplified", _mesh.name]];
+	simpMesh.shouldInterleaveVertices = _mesh.shouldInterleaveVertices;
+	simpMesh.vertexContentTypes = _mesh.vertexContentTypes;
+	[self matchVertexArraysOf: simpMesh];
+	simpMesh.allocatedVertexCapacity = simpVtxCount;
+	simpMesh.allocatedVertexIndexCapacity = idxCount;
+	simpMesh.drawingMode = GL_TRIANGLES;
+
+	for (GLuint vtxIdx = 0; vtxIdx < ctx->vertexCount; vtxIdx++)
+		if (vtxMap[vtxIdx] != kCC3MeshSimplifierNoVertex)
+			[simpMesh copyVertexAt: vtxIdx from: _mesh to: vtxMap[vtxIdx]];
+	for (GLuint i = 0; i < idxCount; i++)
+		[simpMesh setVertexIndex: vtxMap[ctx->indices[i]] at: i];
+	free(vtxMap);
+
+	return simpMesh;
+}
+
+/**
+ * Configures the vertex arrays of the specified mesh, which has the same vertex content types as
+ * the original mesh, to hold content of the same type and size as the vertex arrays of the original
+ * mesh, so that vertex content, particularly skinning content, can be copied without loss.
+ */
+-(void) matchVertexArraysOf: (CC3Mesh*) aMesh {
+	aMesh.vertexLocations.elementSize = _mesh.vertexLocations.elementSize;
+	aMesh.vertexColors.elementType = _mesh.vertexColors.elementType;
+	aMesh.vertexWeights.elementSize = _mesh.vertexWeights.elementSize;
+	aMesh.vertexMatrixIndices.elementType = _mesh.vertexMatrixIndices.elementType;
+	aMesh.vertexMatrixIndices.elementSize = _mesh.vertexMatrixIndices.elementSize;
+
+	GLuint tcCount = _mesh.textureCoordinatesArrayCount;
+	for (GLuint tcIdx = aMesh.textureCoordinatesArrayCount; tcIdx < tcCount; tcIdx++)
+		[aMesh addTextureCoordinates: [CC3VertexTextureCoordinates vertexArray]];
+
+	[aMesh updateVertexStride];
+}
+
+
+#pragma mark Allocation and initialization
+
+-(id) init { return [self initWithMesh: nil]; }
+
+-(id) initWithMesh: (CC3Mesh*) aMesh {
+	if ( (self = [super init]) ) {
+		_mesh = [aMesh retain];
+		_sourceFaceIndices = NULL;
+		_targetFaceCount = aMesh.faceCount / 2;
+		_simplifiedFaceCount = 0;
+		_maximumError = 1.0f;
+		_achievedError = 0.0f;
+		_shouldPreserveSkinning = YES;
+		_shouldUseConcurrency = YES;
+	}
+	return self;
+}
+
++(id) simplifierWithMesh: (CC3Mesh*) aMesh { return [[[self alloc] initWithMesh: aMesh] autorelease]; }
+
+-(NSString*) description { return [NSString stringWithFormat: @"%@ for %@", [self class], _mesh]; }
+
+@end
+
+
+#pragma mark -
+#pragma mark CC3Mesh extension for simplification
+
+@implementation CC3Mesh (Simplification)
+
+-(CC3Mesh*) simplifiedMeshWithFaceCount: (GLuint) faceCount {
+	CC3MeshSimplifier* simplifier = [CC3MeshSimplifier simplifierWithMesh: self];
+	simplifier.targetFaceCount = faceCount;
+	return simplifier.simplifiedMesh;
+}
+
+@end
+
+
+#pragma mark -
+#pragma mark CC3LODMeshNode extension for simplification
+
+@implementation CC3LODMeshNode (Simplification)
+
+-(void) addSimplifiedLevelsOfDetail: (GLuint) lodCount
+					  withFaceRatio: (GLfloat) faceRatio
+				 forScreenSizeBelow: (GLfloat) screenSize {
+	CC3Mesh* lodMesh = self.mesh;
+	GLfloat sizeRatio = sqrtf(faceRatio);
+	for (GLuint lodIdx = 0; lodIdx < lodCount; lodIdx++) {
+		GLuint prevFaceCount = lodMesh.faceCount;
+		lodMesh = [lodMesh simplifiedMeshWithFaceCount: (GLuint)(prevFaceCount * faceRatio)];
+		if ( !lodMesh || lodMesh.faceCount >= prevFaceCount ) break;
+		[self addLevelOfDetailMesh: lodMesh forScreenSizeBelow: screenSize];
+		screenSize *= sizeRatio;
+	}
+}
+
+@end
@@ -595,7 +595,9 @@ static GLuint lastAssignedVertexArrayTag;
 		forCount: (GLuint) vtxCount
 	 withVisitor: (CC3NodeDrawingVisitor*) visitor {
 	LogTrace(@"%@ drawing %u vertices", self, vtxCount);
-	[visitor.performanceStatistics addSingleCallFacesPresented: [self faceCountFromVertexIndexCount: vtxCount]];
+	CC3PerformanceStatistics* perfStats = visitor.performanceStatistics;
+	[perfStats addSingleCallFacesPresented: [self faceCountFromVertexIndexCount: vtxCount]];
+	[perfStats addGLStateChangesForDrawingCall: [CC3OpenGLESEngine engine].stateChangesSinceDrawingCall];
 }
 
 -(void) allocateStripLengths: (GLuint) sCount {
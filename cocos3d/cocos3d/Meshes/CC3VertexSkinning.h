@@ -468,6 +468,19 @@
  */
 -(CC3Matrix*) getDrawTransformMatrixForBoneAt: (GLuint) boneIdx;
 
+/**
+ * Populates the specified matrix with the matrix used to transform the bone at the
+ * specified index within this skin section into global coordinates.
+ *
+ * If the specified visitor is drawing from a CC3FramePacket, the currentBonePalette
+ * property of the visitor holds the bone matrices captured in the frame packet, and the
+ * matrix is copied from there. Otherwise, the matrix is retrieved from the bone, using
+ * the getDrawTransformMatrixForBoneAt: method.
+ */
+-(void) populateDrawTransformMatrix: (CC3Matrix4x3*) mtx
+						  forBoneAt: (GLuint) boneIdx
+						withVisitor: (CC3NodeDrawingVisitor*) visitor;
+
 @end
 
 
@@ -232,12 +232,31 @@
 	
 	[mesh bindWithVisitor: visitor];	// Bind the arrays
 	
-	for (CC3SkinSection* skinSctn in skinSections)
+	for (CC3SkinSection* skinSctn in skinSections) {
 		[skinSctn drawVerticesOfMesh: mesh withVisitor: visitor];
+
+		// If drawing from a frame packet, move the palette along to the bones of the next section
+		CC3Matrix4x3* palette = visitor.currentBonePalette;
+		if (palette) visitor.currentBonePalette = palette + skinSctn.boneCount;
+	}
 	
 	[glesMatrixPalette disable];		// We are finished with the matrix pallete so disable it.
 }
 
+-(GLuint) bonePaletteCount {
+	GLuint boneCnt = 0;
+	for (CC3SkinSection* skinSctn in skinSections) boneCnt += skinSctn.boneCount;
+	return boneCnt;
+}
+
+-(void) populateBonePalette: (CC3Matrix4x3*) palette {
+	for (CC3SkinSection* skinSctn in skinSections) {
+		GLuint boneCnt = skinSctn.boneCount;
+		for (GLuint boneIdx = 0; boneIdx < boneCnt; boneIdx++)
+			[[skinSctn getDrawTransformMatrixForBoneAt: boneIdx] populateCC3Matrix4x3: palette++];
+	}
+}
+
 
 #pragma mark Deprecated methods
 
@@ -390,17 +409,27 @@
 
 #if CC3_OGLES_1
 	CC3OpenGLESMatrices* glesMatrices = [CC3OpenGLESEngine engine].matrices;
+	CC3Matrix4x3* palette = visitor.currentBonePalette;
+	CC3Matrix* packetMtx = palette ? [CC3AffineMatrix matrix] : nil;
 
 	GLuint boneCnt = self.boneCount;
 	for (GLuint boneNum = 0; boneNum < boneCnt; boneNum++) {
-		CC3SkinnedBone* sb = [skinnedBones objectAtIndex: boneNum];
+
+		// Use the bone matrix captured in the frame packet if there is one, otherwise use the bone.
+		CC3Matrix* boneMtx;
+		if (palette) {
+			[packetMtx populateFromCC3Matrix4x3: &palette[boneNum]];
+			boneMtx = packetMtx;
+		} else {
+			boneMtx = ((CC3SkinnedBone*)[skinnedBones objectAtIndex: boneNum]).drawTransformMatrix;
+		}
 
 		// Load this palette matrix from the modelview matrix and the apply the bone draw matrix.
 		// Since the CC3SkinMeshNode does not transform the modelview stack, the modelview will
 		// only contain the view matrix. All other transforms are captured in the bone matrices.
 		CC3OpenGLESMatrixStack* glesPaletteMatrix = [glesMatrices paletteMatrixAt: boneNum];
 		[glesPaletteMatrix loadFromModelView];
-		[glesPaletteMatrix multiply: sb.drawTransformMatrix];
+		[glesPaletteMatrix multiply: boneMtx];
 	}
 #endif
 	
@@ -412,6 +441,16 @@
 	return ((CC3SkinnedBone*)[skinnedBones objectAtIndex: boneIdx]).drawTransformMatrix;
 }
 
+-(void) populateDrawTransformMatrix: (CC3Matrix4x3*) mtx
+						  forBoneAt: (GLuint) boneIdx
+						withVisitor: (CC3NodeDrawingVisitor*) visitor {
+	CC3Matrix4x3* palette = visitor.currentBonePalette;
+	if (palette)
+		CC3Matrix4x3PopulateFrom4x3(mtx, &palette[boneIdx]);
+	else
+		[[self getDrawTransformMatrixForBoneAt: boneIdx] populateCC3Matrix4x3: mtx];
+}
+
 @end
 
 
@@ -636,6 +636,206 @@
 @end
 
 
+#pragma mark -
+#pragma mark CC3BillboardCloud
+
+/** The maximum number of billboards that can be held by a single CC3BillboardCloud. */
+#define kCC3BillboardCloudMaxBillboards		((kCC3MaxGLushort + 1) / 4)
+
+/**
+ * CC3BillboardCloud draws a large number of small camera-facing textured rectangles, such as
+ * labels, health bars, foliage, or impostors of distant crowds, in a single draw call.
+ *
+ * Unlike CC3Billboard, which wraps a cocos2d CCNode, orients itself to the camera, and draws
+ * that CCNode separately, each billboard in a CC3BillboardCloud is simply a rectangle, defined by
+ * a location, a size, a rectangle within the texture of the material of this node, and a color.
+ * This content is held in four separate arrays (structure-of-arrays), which are accessible
+ * directly through the billboardLocations, billboardSizes, billboardTextureRectangles, and
+ * billboardColors properties, so that large numbers of billboards can be updated efficiently.
+ *
+ * All of the billboards in a cloud are drawn together, using the material of this node. To draw
+ * billboards with different images in a single draw call, combine the images into a single
+ * texture atlas, and use the texture rectangle of each billboard to select its image within that
+ * atlas. Billboards that use different texture atlases must be held in different clouds.
+ *
+ * The billboards are oriented to face the camera each time this node is drawn, and are always
+ * parallel to the plane of the screen. By default, the orientation is performed by the CPU, which
+ * rewrites the corner locations of each billboard whenever the camera rotates relative to this
+ * node, or the content of the billboard changes. Under OpenGL ES 2, you can set the
+ * shouldAlignInShader property to YES to have the orientation performed by the vertex shader,
+ * in which case the vertex content only needs to be rewritten when the billboards change.
+ *
+ * The location and size of each billboard are expressed in the local coordinate system of
+ * this node, and the billboards are not illuminated. The texture rectangle of each billboard
+ * is expressed as a fraction of the texture image, with the origin at the bottom-left corner
+ * of the image, and is automatically adjusted for the orientation and mapSize of the texture.
+ *
+ * The bounding volume of this node encompasses the billboards in any orientation, and is
+ * rebuilt whenever billboards are added, removed or changed.
+ *
+ * The billboards are read, and the camera orientation is determined, when this node is drawn.
+ * Because of this, if the scene is drawn from a frame packet on a background thread, billboards
+ * changed while the frame is being drawn may be drawn with either their old or new content.
+ */
+@interface CC3BillboardCloud : CC3MeshNode {
+	CC3Vector* _billboardLocations;
+	CGSize* _billboardSizes;
+	CGRect* _billboardTextureRectangles;
+	ccColor4B* _billboardColors;
+	GLuint _billboardCount;
+	GLuint _billboardCapacity;
+	GLuint _firstDirtyBillboard;
+	GLuint _lastDirtyBillboard;
+	CC3Vector _alignedRightDirection;
+	CC3Vector _alignedUpDirection;
+	CC3BoundingBox _billboardsBoundingBox;
+	BOOL _shouldAlignInShader : 1;
+	BOOL _isCloudMeshDirty : 1;
+}
+
+/** The number of billboards in this cloud. */
+@property(nonatomic, readonly) GLuint billboardCount;
+
+/**
+ * The number of billboards for which space has been allocated. This grows automatically as
+ * billboards are added. You can also set this property to allocate space for billboards in
+ * advance, to avoid reallocation as billboards are added. This property cannot be set lower
+ * than the billboardCount property, nor higher than kCC3BillboardCloudMaxBillboards.
+ */
+@property(nonatomic, assign) GLuint billboardCapacity;
+
+/**
+ * Adds a billboard at the specified location, with the specified size, in the local coordinate
+ * system of this node, and returns the index of the new billboard. The new billboard displays
+ * the entire texture, and has a white color.
+ *
+ * If this cloud already holds kCC3BillboardCloudMaxBillboards billboards, the billboard is not
+ * added, and this method returns kCC3MaxGLuint.
+ */
+-(GLuint) addBillboardAt: (CC3Vector) location withSize: (CGSize) size;
+
+/**
+ * Removes the billboard at the specified index, by moving the last billboard into its place.
+ * Because of this, the index of the last billboard changes when another billboard is removed.
+ */
+-(void) removeBillboardAt: (GLuint) index;
+
+/** Removes all of the billboards from this cloud. */
+-(void) removeAllBillboards;
+
+/** Returns the location of the billboard at the specified index, in the local coordinates of this node. */
+-(CC3Vector) billboardLocationAt: (GLuint) index;
+
+/** Sets the location of the billboard at the specified index, in the local coordinates of this node. */
+-(void) setBillboardLocation: (CC3Vector) location at: (GLuint) index;
+
+/** Returns the width and height of the billboard at the specified index. */
+-(CGSize) billboardSizeAt: (GLuint) index;
+
+/** Sets the width and height of the billboard at the specified index. */
+-(void) setBillboardSize: (CGSize) size at: (GLuint) index;
+
+/**
+ * Returns the rectangle, within the texture of the material of this node, that is displayed by
+ * the billboard at the specified index. The rectangle is expressed in texture coordinates.
+ */
+-(CGRect) billboardTextureRectangleAt: (GLuint) index;
+
+/**
+ * Sets the rectangle, within the texture of the material of this node, that is displayed by
+ * the billboard at the specified index. The rectangle is expressed in texture coordinates.
+ */
+-(void) setBillboardTextureRectangle: (CGRect) texRect at: (GLuint) index;
+
+/** Returns the color of the billboard at the specified index. */
+-(ccColor4B) billboardColorAt: (GLuint) index;
+
+/** Sets the color of the billboard at the specified index. */
+-(void) setBillboardColor: (ccColor4B) color at: (GLuint) index;
+
+/**
+ * The locations of the billboards, as an array of billboardCount elements.
+ *
+ * You can modify the elements of this array directly, but, having done so, you must invoke
+ * the markBillboardsDirtyFrom:to: method to indicate which billboards have been changed.
+ *
+ * The array is reallocated whenever the billboardCapacity changes, so you should not retain
+ * this pointer while billboards are being added.
+ */
+@property(nonatomic, readonly) CC3Vector* billboardLocations;
+
+/**
+ * The sizes of the billboards, as an array of billboardCount elements.
+ *
+ * You can modify the elements of this array directly, but, having done so, you must invoke
+ * the markBillboardsDirtyFrom:to: method to indicate which billboards have been changed.
+ */
+@property(nonatomic, readonly) CGSize* billboardSizes;
+
+/**
+ * The texture rectangles of the billboards, as an array of billboardCount elements.
+ *
+ * You can modify the elements of this array directly, but, having done so, you must invoke
+ * the markBillboardsDirtyFrom:to: method to indicate which billboards have been changed.
+ */
+@property(nonatomic, readonly) CGRect* billboardTextureRectangles;
+
+/**
+ * The colors of the billboards, as an array of billboardCount elements.
+ *
+ * You can modify the elements of this array directly, but, having done so, you must invoke
+ * the markBillboardsDirtyFrom:to: method to indicate which billboards have been changed.
+ */
+@property(nonatomic, readonly) ccColor4B* billboardColors;
+
+/**
+ * Indicates that the billboards between the specified indices, inclusive, have been changed
+ * directly within the arrays, and that their vertex content must be rebuilt before the next
+ * time this node is drawn.
+ *
+ * This method is invoked automatically by the methods that add, remove or change individual
+ * billboards. The application need only invoke this method after changing billboard content
+ * directly within the arrays.
+ */
+-(void) markBillboardsDirtyFrom: (GLuint) firstIndex to: (GLuint) lastIndex;
+
+/**
+ * Indicates whether the billboards should be oriented to face the camera by the vertex shader,
+ * instead of by the CPU.
+ *
+ * When this property is set to YES, the four vertices of each billboard are all located at the
+ * center of the billboard, and the vertex normals of the mesh hold the offset of each corner from
+ * that center. The vertex content is rewritten only when billboards change, and the shader
+ * program of the material is set to one built from the CC3BillboardCloud.vsh vertex shader.
+ *
+ * Because the vertex normals are used to hold corner offsets, node picking under this mode uses
+ * the billboard centers, and does not detect touches on the billboard rectangles.
+ *
+ * This property only has effect under OpenGL ES 2. Under OpenGL ES 1.1, the billboards are
+ * always oriented by the CPU.
+ *
+ * The initial value of this property is NO.
+ */
+@property(nonatomic, assign) BOOL shouldAlignInShader;
+
+/**
+ * Returns whether the vertex shader is expected to orient the billboards of this cloud to face
+ * the camera. Returns the value of the shouldAlignInShader property.
+ */
+@property(nonatomic, readonly) BOOL isDrawingShaderAlignedBillboards;
+
+
+#pragma mark Allocation and initialization
+
+/**
+ * Allocates and initializes an autoreleased instance with the specified name,
+ * and with space allocated for the specified number of billboards.
+ */
++(id) nodeWithName: (NSString*) aName withBillboardCapacity: (GLuint) capacity;
+
+@end
+
+
 #pragma mark -
 #pragma mark CC3NodeDescriptor
 
@@ -818,6 +818,408 @@ static GLfloat deviceScaleFactor = 0.0f;
 @end
 
 
+#pragma mark -
+#pragma mark CC3BillboardCloud
+
+/** The number of billboards whose corners are oriented by each concurrent task. */
+#define kCC3BillboardCloudRangeLength		1024
+
+/** Indicates that no billboards are waiting to have their vertices rebuilt. */
+#define kCC3BillboardCloudNoDirtyBillboards	kCC3MaxGLuint
+
+@interface CC3BillboardCloud (TemplateMethods)
+-(void) buildCloudMesh;
+-(void) updateCloudMeshWithVisitor: (CC3NodeDrawingVisitor*) visitor;
+-(void) writeLocationsFrom: (GLuint) firstIndex to: (GLuint) lastIndex
+			withRightDirection: (CC3Vector) rightDir andUpDirection: (CC3Vector) upDir;
+-(void) writeContentFrom: (GLuint) firstIndex to: (GLuint) lastIndex;
+@end
+
+@implementation CC3BillboardCloud
+
+@synthesize billboardCount=_billboardCount, billboardCapacity=_billboardCapacity;
+@synthesize billboardLocations=_billboardLocations, billboardSizes=_billboardSizes;
+@synthesize billboardTextureRectangles=_billboardTextureRectangles, billboardColors=_billboardColors;
+@synthesize shouldAlignInShader=_shouldAlignInShader;
+
+-(void) dealloc {
+	free(_billboardLocations);
+	free(_billboardSizes);
+	free(_billboardTextureRectangles);
+	free(_billboardColors);
+	[super dealloc];
+}
+
+-(void) setBillboardCapacity: (GLuint) capacity {
+	capacity = MIN(MAX(capacity, _billboardCount), kCC3BillboardCloudMaxBillboards);
+	if (capacity == _billboardCapacity) return;
+
+	_billboardLocations = realloc(_billboardLocations, capacity * sizeof(CC3Vector));
+	_billboardSizes = realloc(_billboardSizes, capacity * sizeof(CGSize));
+	_billboardTextureRectangles = realloc(_billboardTextureRectangles, capacity * sizeof(CGRect));
+	_billboardColors = realloc(_billboardColors, capacity * sizeof(ccColor4B));
+	_billboardCapacity = capacity;
+	_isCloudMeshDirty = YES;
+	LogTrace(@"%@ billboard capacity changed to %u", self, capacity);
+}
+
+-(void) setShouldAlignInShader: (BOOL) shouldAlign {
+#if CC3_OGLES_2
+	if (shouldAlign == _shouldAlignInShader) return;
+	_shouldAlignInShader = shouldAlign;
+	_isCloudMeshDirty = YES;
+	material.shaderProgram = nil;		// Reselect a program suited to the new alignment
+#endif
+}
+
+-(BOOL) isDrawingShaderAlignedBillboards { return _shouldAlignInShader; }
+
+// Billboards are re-oriented as the camera moves, so the box must hold each billboard in any orientation.
+-(CC3NodeBoundingVolume*) defaultBoundingVolume { return [CC3NodeBoundingBoxVolume boundingVolume]; }
+
+/**
+ * Returns the box that holds each billboard in any orientation, which is the box that
+ * holds the sphere around each billboard, whose radius is half the billboard diagonal.
+ */
+-(CC3BoundingBox) localContentBoundingBox {
+	if (CC3BoundingBoxIsNull(_billboardsBoundingBox)) {
+		for (GLuint bbIdx = 0; bbIdx < _billboardCount; bbIdx++) {
+			CGSize bbSize = _billboardSizes[bbIdx];
+			GLfloat radius = sqrtf((bbSize.width * bbSize.width) + (bbSize.height * bbSize.height)) * 0.5f;
+			CC3Vector center = _billboardLocations[bbIdx];
+			CC3Vector extent = cc3v(radius, radius, radius);
+			CC3BoundingBox bb = { CC3VectorDifference(center, extent), CC3VectorAdd(center, extent) };
+			_billboardsBoundingBox = CC3BoundingBoxUnion(_billboardsBoundingBox, bb);
+		}
+	}
+	return CC3BoundingBoxIsNull(_billboardsBoundingBox)
+			? kCC3BoundingBoxNull
+			: CC3BoundingBoxAddUniformPadding(_billboardsBoundingBox, boundingVolumePadding);
+}
+
+
+#pragma mark Billboards
+
+-(GLuint) addBillboardAt: (CC3Vector) location withSize: (CGSize) size {
+	if (_billboardCount == _billboardCapacity) {
+		if (_billboardCapacity == kCC3BillboardCloudMaxBillboards) {
+			LogError(@"%@ cannot hold more than %u billboards", self, (GLuint)kCC3BillboardCloudMaxBillboards);
+			return kCC3MaxGLuint;
+		}
+		self.billboardCapacity = MAX(_billboardCapacity * 2, 16);
+	}
+
+	GLuint bbIdx = _billboardCount++;
+	_billboardLocations[bbIdx] = location;
+	_billboardSizes[bbIdx] = size;
+	_billboardTextureRectangles[bbIdx] = CGRectMake(0.0f, 0.0f, 1.0f, 1.0f);
+	_billboardColors[bbIdx] = ccc4(255, 255, 255, 255);
+	[self markBillboardsDirtyFrom: bbIdx to: bbIdx];
+	return bbIdx;
+}
+
+-(void) removeBillboardAt: (GLuint) index {
+	CC3Assert(index < _billboardCount, @"%@ billboard index %u is out of range", self, index);
+
+	GLuint lastIdx = --_billboardCount;
+	if (index != lastIdx) {
+		_billboardLocations[index] = _billboardLocations[lastIdx];
+		_billboardSizes[index] = _billboardSizes[lastIdx];
+		_billboardTextureRectangles[index] = _billboardTextureRectangles[lastIdx];
+		_billboardColors[index] = _billboardColors[lastIdx];
+	}
+	[self markBillboardsDirtyFrom: index to: index];
+}
+
+-(void) removeAllBillboards {
+	_billboardCount = 0;
+	[self markBillboardsDirtyFrom: 0 to: 0];
+}
+
+-(CC3Vector) billboardLocationAt: (GLuint) index { return _billboardLocations[index]; }
+
+-(void) setBillboardLocation: (CC3Vector) location at: (GLuint) index {
+	_billboardLocations[index] = location;
+	[self markBillboardsDirtyFrom: index to: index];
+}
+
+-(CGSize) billboardSizeAt: (GLuint) index { return _billboardSizes[index]; }
+
+-(void) setBillboardSize: (CGSize) size at: (GLuint) index {
+	_billboardSizes[index] = size;
+	[self markBillboardsDirtyFrom: index to: index];
+}
+
+-(CGRect) billboardTextureRectangleAt: (GLuint) index { return _billboardTextureRectangles[index]; }
+
+-(void) setBillboardTextureRectangle: (CGRect) texRect at: (GLuint) index {
+	_billboardTextureRectangles[index] = texRect;
+	[self markBillboardsDirtyFrom: index to: index];
+}
+
+-(ccColor4B) billboardColorAt: (GLuint) index { return _billboardColors[index]; }
+
+-(void) setBillboardColor: (ccColor4B) color at: (GLuint) index {
+	_billboardColors[index] = color;
+	[self markBillboardsDirtyFrom: index to: index];
+}
+
+-(void) markBillboardsDirtyFrom: (GLuint) firstIndex to: (GLuint) lastIndex {
+	_firstDirtyBillboard = MIN(_firstDirtyBillboard, firstIndex);
+	_lastDirtyBillboard = (_lastDirtyBillboard == kCC3BillboardCloudNoDirtyBillboards)
+							? lastIndex : MAX(_lastDirtyBillboard, lastIndex);
+	_billboardsBoundingBox = kCC3BoundingBoxNull;
+	[self markBoundingVolumeDirty];
+}
+
+/** The texture coordinates are rebuilt from the billboard texture rectangles, using the new texture. */
+-(void) alignTextureUnit: (GLuint) texUnit {
+	if (_billboardCount) [self markBillboardsDirtyFrom: 0 to: (_billboardCount - 1)];
+}
+
+
+#pragma mark Allocation and initialization
+
+-(id) initWithTag: (GLuint) aTag withName: (NSString*) aName {
+	if ( (self = [super initWithTag: aTag withName: aName]) ) {
+		_billboardLocations = NULL;
+		_billboardSizes = NULL;
+		_billboardTextureRectangles = NULL;
+		_billboardColors = NULL;
+		_billboardCount = 0;
+		_billboardCapacity = 0;
+		_firstDirtyBillboard = kCC3BillboardCloudNoDirtyBillboards;
+		_lastDirtyBillboard = kCC3BillboardCloudNoDirtyBillboards;
+		_alignedRightDirection = kCC3VectorZero;
+		_alignedUpDirection = kCC3VectorZero;
+		_billboardsBoundingBox = kCC3BoundingBoxNull;
+		_shouldAlignInShader = NO;
+		[self buildCloudMesh];		// Establish texture coordinates before a texture is assigned
+		self.shouldUseLighting = NO;
+	}
+	return self;
+}
+
++(id) nodeWithName: (NSString*) aName withBillboardCapacity: (GLuint) capacity {
+	CC3BillboardCloud* cloud = [self nodeWithName: aName];
+	cloud.billboardCapacity = capacity;
+	return cloud;
+}
+
+// Template method that populates this instance from the specified other instance.
+// This method is invoked automatically during object copying via the copyWithZone: method.
+// The billboards are copied, and the copy builds its own mesh when it is first drawn.
+-(void) populateFrom: (CC3BillboardCloud*) another {
+	[super populateFrom: another];
+
+	_shouldAlignInShader = another.shouldAlignInShader;
+	_billboardCount = 0;
+	self.billboardCapacity = another.billboardCount;
+	_billboardCount = another.billboardCount;
+	memcpy(_billboardLocations, another.billboardLocations, _billboardCount * sizeof(CC3Vector));
+	memcpy(_billboardSizes, another.billboardSizes, _billboardCount * sizeof(CGSize));
+	memcpy(_billboardTextureRectangles, another.billboardTextureRectangles, _billboardCount * sizeof(CGRect));
+	memcpy(_billboardColors, another.billboardColors, _billboardCount * sizeof(ccColor4B));
+	_billboardsBoundingBox = kCC3BoundingBoxNull;
+	_isCloudMeshDirty = YES;
+}
+
+-(NSString*) description {
+	return [NSString stringWithFormat: @"%@ with %u billboards", [super description], _billboardCount];
+}
+
+
+#pragma mark Drawing
+
+/**
+ * Builds the mesh, with four vertices and two triangles for each billboard that can be held
+ * within the current capacity. The vertex content is not interleaved, so that the locations,
+ * which are rewritten whenever the camera rotates, can be updated in the GL buffers
+ * independently of the texture coordinates and colors, which change only with the billboards.
+ * The vertex indices never change, and are written only once here.
+ */
+-(void) buildCloudMesh {
+	_isCloudMeshDirty = NO;
+
+	CC3Mesh* cloudMesh = [CC3Mesh meshWithName: [NSString stringWithFormat: @"%@-Billboards", self.name]];
+	cloudMesh.shouldInterleaveVertices = NO;
+	cloudMesh.vertexContentTypes = (kCC3VertexContentLocation |
+									kCC3VertexContentTextureCoordinates |
+									kCC3VertexContentColor |
+									(_shouldAlignInShader ? kCC3VertexContentNormal : kCC3VertexContentNone));
+	cloudMesh.drawingMode = GL_TRIANGLES;
+	cloudMesh.allocatedVertexCapacity = _billboardCapacity * 4;
+	cloudMesh.allocatedVertexIndexCapacity = _billboardCapacity * 6;
+
+	GLushort* indices = (GLushort*)[cloudMesh.vertexIndices addressOfElement: 0];
+	for (GLuint bbIdx = 0; bbIdx < _billboardCapacity; bbIdx++) {
+		GLushort vtxIdx = (GLushort)(bbIdx * 4);
+		GLushort* bbIndices = indices + (bbIdx * 6);
+		bbIndices[0] = vtxIdx;			bbIndices[1] = vtxIdx + 1;		bbIndices[2] = vtxIdx + 2;
+		bbIndices[3] = vtxIdx + 2;		bbIndices[4] = vtxIdx + 1;		bbIndices[5] = vtxIdx + 3;
+	}
+
+	[cloudMesh retainVertexContent];
+	cloudMesh.vertexLocations.bufferUsage = GL_DYNAMIC_DRAW;
+	if (_billboardCapacity) [cloudMesh createGLBuffers];
+
+	self.mesh = cloudMesh;
+
+	// Force all vertex content to be written
+	_alignedRightDirection = kCC3VectorZero;
+	_alignedUpDirection = kCC3VectorZero;
+	if (_billboardCount) [self markBillboardsDirtyFrom: 0 to: (_billboardCount - 1)];
+
+	LogRez(@"%@ built mesh for %u billboards", self, _billboardCapacity);
+}
+
+/**
+ * Writes the corner locations of the billboards in the specified range. When orienting the
+ * billboards on the CPU, each corner is offset from the billboard center along the specified
+ * camera directions. When orienting the billboards in the vertex shader, each corner is placed
+ * at the billboard center, and the offset of the corner is written to the vertex normal.
+ *
+ * If the range is large, it is split into smaller ranges that are processed concurrently.
+ */
+-(void) writeLocationsFrom: (GLuint) firstIndex to: (GLuint) lastIndex
+		withRightDirection: (CC3Vector) rightDir andUpDirection: (CC3Vector) upDir {
+	CC3Vector* vtxLocs = (CC3Vector*)[mesh.vertexLocations addressOfElement: 0];
+	CC3Vector* vtxNorms = _shouldAlignInShader ? (CC3Vector*)[mesh.vertexNormals addressOfElement: 0] : NULL;
+	CC3Vector* bbLocs = _billboardLocations;
+	CGSize* bbSizes = _billboardSizes;
+
+	void (^writeRange)(GLuint, GLuint) = ^(GLuint startIdx, GLuint endIdx) {
+		for (GLuint bbIdx = startIdx; bbIdx < endIdx; bbIdx++) {
+			CC3Vector center = bbLocs[bbIdx];
+			GLfloat halfWidth = bbSizes[bbIdx].width * 0.5f;
+			GLfloat halfHeight = bbSizes[bbIdx].height * 0.5f;
+			CC3Vector* corners = vtxLocs + (bbIdx * 4);
+			if (vtxNorms) {
+				CC3Vector* offsets = vtxNorms + (bbIdx * 4);
+				corners[0] = corners[1] = corners[2] = corners[3] = center;
+				offsets[0] = cc3v(-halfWidth, -halfHeight, 0.0f);
+				offsets[1] = cc3v( halfWidth, -halfHeight, 0.0f);
+				offsets[2] = cc3v(-halfWidth,  halfHeight, 0.0f);
+				offsets[3] = cc3v( halfWidth,  halfHeight, 0.0f);
+			} else {
+				CC3Vector right = CC3VectorScaleUniform(rightDir, halfWidth);
+				CC3Vector up = CC3VectorScaleUniform(upDir, halfHeight);
+				CC3Vector bottom = CC3VectorDifference(center, up);
+				CC3Vector top = CC3VectorAdd(center, up);
+				corners[0] = CC3VectorDifference(bottom, right);
+				corners[1] = CC3VectorAdd(bottom, right);
+				corners[2] = CC3VectorDifference(top, right);
+				corners[3] = CC3VectorAdd(top, right);
+			}
+		}
+	};
+
+	GLuint bbCount = lastIndex - firstIndex + 1;
+	GLuint rangeCount = (bbCount + kCC3BillboardCloudRangeLength - 1) / kCC3BillboardCloudRangeLength;
+	if (rangeCount > 1) {
+		dispatch_apply(rangeCount, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t rIdx) {
+			GLuint startIdx = firstIndex + ((GLuint)rIdx * kCC3BillboardCloudRangeLength);
+			writeRange(startIdx, MIN(startIdx + kCC3BillboardCloudRangeLength, lastIndex + 1));
+		});
+	} else {
+		writeRange(firstIndex, lastIndex + 1);
+	}
+}
+
+/**
+ * Writes the texture coordinates and colors of the billboards in the specified range.
+ * The texture rectangles are mapped to the area of the texture that holds the image,
+ * and are flipped if the texture is upside-down.
+ */
+-(void) writeContentFrom: (GLuint) firstIndex to: (GLuint) lastIndex {
+	CC3Texture* tex = self.texture;
+	CGSize mapSize = tex ? tex.mapSize : CGSizeMake(1.0f, 1.0f);
+	BOOL isFlipped = tex && XOR(mesh.expectsVerticallyFlippedTextures, tex.isFlippedVertically);
+
+	ccTex2F* texCoords = (ccTex2F*)[mesh.vertexTextureCoordinates addressOfElement: 0];
+	ccColor4B* colors = (ccColor4B*)[mesh.vertexColors addressOfElement: 0];
+	for (GLuint bbIdx = firstIndex; bbIdx <= lastIndex; bbIdx++) {
+		CGRect texRect = _billboardTextureRectangles[bbIdx];
+		GLfloat uMin = CGRectGetMinX(texRect) * mapSize.width;
+		GLfloat uMax = CGRectGetMaxX(texRect) * mapSize.width;
+		GLfloat vMin = CGRectGetMinY(texRect);
+		GLfloat vMax = CGRectGetMaxY(texRect);
+		if (isFlipped) {
+			vMin = 1.0f - vMin;
+			vMax = 1.0f - vMax;
+		}
+		vMin *= mapSize.height;
+		vMax *= mapSize.height;
+
+		ccTex2F* bbTexCoords = texCoords + (bbIdx * 4);
+		bbTexCoords[0] = (ccTex2F){ uMin, vMin };
+		bbTexCoords[1] = (ccTex2F){ uMax, vMin };
+		bbTexCoords[2] = (ccTex2F){ uMin, vMax };
+		bbTexCoords[3] = (ccTex2F){ uMax, vMax };
+
+		ccColor4B color = _billboardColors[bbIdx];
+		ccColor4B* bbColors = colors + (bbIdx * 4);
+		bbColors[0] = bbColors[1] = bbColors[2] = bbColors[3] = color;
+	}
+}
+
+/**
+ * Rewrites the vertex content of any billboards that have changed since the last time this node
+ * was drawn and, when orienting on the CPU, the corners of all billboards if the camera has rotated
+ * relative to this node. Only the changed ranges of each vertex array are copied to the GL buffers.
+ */
+-(void) updateCloudMeshWithVisitor: (CC3NodeDrawingVisitor*) visitor {
+	GLuint bbCount = _billboardCount;
+	GLuint firstDirty = _firstDirtyBillboard;
+	GLuint lastDirty = MIN(_lastDirtyBillboard, bbCount - 1);
+	BOOL isContentDirty = (firstDirty <= lastDirty);
+	_firstDirtyBillboard = _lastDirtyBillboard = kCC3BillboardCloudNoDirtyBillboards;
+
+	// Determine the camera axes in the local coordinates of this node
+	CC3Vector rightDir = kCC3VectorZero, upDir = kCC3VectorZero;
+	BOOL isReoriented = NO;
+	if ( !_shouldAlignInShader ) {
+		CC3Camera* cam = visitor.camera;
+		CC3Matrix* invMtx = self.transformMatrixInverted;
+		rightDir = CC3VectorNormalize([invMtx transformDirection: cam.globalRightDirection]);
+		upDir = CC3VectorNormalize([invMtx transformDirection: cam.globalUpDirection]);
+		isReoriented = !(CC3VectorsAreEqual(rightDir, _alignedRightDirection) &&
+						 CC3VectorsAreEqual(upDir, _alignedUpDirection));
+		_alignedRightDirection = rightDir;
+		_alignedUpDirection = upDir;
+	}
+
+	if (isReoriented || isContentDirty) {
+		GLuint firstLoc = isReoriented ? 0 : firstDirty;
+		GLuint lastLoc = isReoriented ? (bbCount - 1) : lastDirty;
+		[self writeLocationsFrom: firstLoc to: lastLoc withRightDirection: rightDir andUpDirection: upDir];
+		[mesh.vertexLocations updateGLBufferStartingAt: (firstLoc * 4) forLength: ((lastLoc - firstLoc + 1) * 4)];
+		if (_shouldAlignInShader)
+			[mesh.vertexNormals updateGLBufferStartingAt: (firstLoc * 4) forLength: ((lastLoc - firstLoc + 1) * 4)];
+	}
+	if (isContentDirty) {
+		[self writeContentFrom: firstDirty to: lastDirty];
+		[mesh.vertexTextureCoordinates updateGLBufferStartingAt: (firstDirty * 4) forLength: ((lastDirty - firstDirty + 1) * 4)];
+		[mesh.vertexColors updateGLBufferStartingAt: (firstDirty * 4) forLength: ((lastDirty - firstDirty + 1) * 4)];
+	}
+
+	mesh.vertexCount = bbCount * 4;
+	mesh.vertexIndexCount = bbCount * 6;
+	LogTrace(@"%@ updated %u billboards%@", self, (isContentDirty ? (lastDirty - firstDirty + 1) : 0),
+			 (isReoriented ? @" and reoriented all billboards" : @""));
+}
+
+-(void) drawMeshWithVisitor: (CC3NodeDrawingVisitor*) visitor {
+	if (_isCloudMeshDirty) [self buildCloudMesh];
+	if (_billboardCount == 0) return;
+
+	[self updateCloudMeshWithVisitor: visitor];
+	[super drawMeshWithVisitor: visitor];
+}
+
+@end
+
+
 #pragma mark -
 #pragma mark CC3NodeDescriptor
 
@@ -31,7 +31,6 @@
 
 #import "CC3MeshNode.h"
 #import "CC3Mesh.h"
-#import "uthash.h"
 
 /** Bitmap information for a single character. */
 typedef struct {
@@ -50,28 +49,41 @@ typedef struct {
 	int bottom;
 } CC3BitmapFontPadding;
 
-/** Dictionary hash of the character definitions. */
+/** An entry in the kerning hash table of a font. */
 typedef struct {
-	NSUInteger key;					/**< The character unicode value as a hash key. */
-	CC3BitmapCharDef charDef;		/**< The character definition. */
-	UT_hash_handle hh;				/**< The lookup hash. */
-} CC3BitmapCharDefHashElement;
+	GLuint key;						/**< The hash key. 16-bit for 1st char, 16-bit for 2nd char. Zero if the entry is empty. */
+	GLint amount;					/**< The amount in pixels to kern between the two characters. */
+} CC3KerningHashEntry;
 
-/** Dictionary hash of the kerning info between two characters. */
+/** The position of a single character within the layout of a line of text. */
 typedef struct {
-	NSUInteger key;					/**< The hash key. 16-bit for 1st char, 16-bit for 2nd char. */
-	NSInteger amount;				/**< The amount in pixels to kern between the two characters. */
-	UT_hash_handle hh;				/**< The lookup hash. */
-} CC3KerningHashElement;
+	CC3BitmapCharDef* charSpec;		/**< The specification of the character. */
+	CGPoint position;				/**< The location of the top-left corner of the character. */
+} CC3BitmapGlyphLayout;
+
+/** The number of characters, starting from zero, whose specifications are indexed directly by character code. */
+#define kCC3BitmapFontDirectGlyphCount		256
 
 
 #pragma mark -
 #pragma mark CC3BitmapFontConfiguration
 
-/** Extends CC3BitmapFontConfiguration to support cocos3d functionality. */
+/**
+ * Extends CC3BitmapFontConfiguration to support cocos3d functionality.
+ *
+ * The character specifications are held in a single flat table, sorted by character code.
+ * Characters whose codes are less than kCC3BitmapFontDirectGlyphCount are found by direct
+ * lookup, and other characters are found by binary search. Kerning amounts are held in an
+ * open-addressed hash table, keyed by the pair of characters.
+ */
 @interface CC3BitmapFontConfiguration : NSObject {
-	CC3BitmapCharDefHashElement* _charDefDictionary;
-	CC3KerningHashElement* _kerningDictionary;
+	CC3BitmapCharDef* _glyphs;
+	CC3BitmapCharDef* _directGlyphs[kCC3BitmapFontDirectGlyphCount];
+	CC3KerningHashEntry* _kerningTable;
+	GLuint _glyphCount;
+	GLuint _glyphCapacity;
+	GLuint _kerningCount;
+	GLuint _kerningTableSize;
 	NSCharacterSet* _characterSet;
 	NSString* _atlasName;
 	NSInteger _commonHeight;
@@ -108,6 +120,23 @@ typedef struct {
  */
 -(NSInteger) kerningBetween: (unichar) firstChar and: (unichar) secondChar;
 
+/**
+ * Lays out the characters of the specified string, as they would be displayed in this font,
+ * populating the specified array of glyph layouts with the position of each character, and
+ * returns the number of characters laid out, which excludes any newline characters.
+ *
+ * The specified array must have space for at least as many elements as the length of the string.
+ *
+ * The lineHeight, textAlignment and origin arguments have the same meaning as the corresponding
+ * arguments of the populateAsBitmapFontLabelFromString:andFont:andLineHeight:andTextAlignment:
+ * andRelativeOrigin:andTessellation: method of CC3Mesh.
+ */
+-(GLuint) layoutGlyphs: (CC3BitmapGlyphLayout*) glyphs
+			fromString: (NSString*) aString
+		withLineHeight: (GLfloat) lineHeight
+	  andTextAlignment: (UITextAlignment) textAlignment
+	 andRelativeOrigin: (CGPoint) origin;
+
 
 #pragma mark Allocation and initialization
 
@@ -240,6 +269,16 @@ typedef struct {
  * change the visual aspects of the label. Changing any of the properties in this class causes the
  * underlying mesh to be automatically rebuilt.
  *
+ * Changing the labelString, textAlignment or relativeOrigin properties does not reallocate the mesh,
+ * as long as the new text contains no more characters than the mesh was last built to hold. Instead,
+ * the existing mesh is updated in place, and only those characters whose content or position has
+ * changed are rewritten, and, if the mesh is using GL buffers, copied to the GL engine. This makes
+ * labels whose text changes frequently, such as scores or timers, inexpensive to update. Changing
+ * the fontFileName, lineHeight or tessellation properties, or the mesh itself, causes the mesh to be
+ * rebuilt completely. To update the label in place, the vertex content of the mesh must be retained
+ * in application memory, and so you should avoid invoking the releaseRedundantContent method on a
+ * label whose text will change.
+ *
  * The vertexContentType property of this mesh may be set to define the content type for each vertex.
  * Content types kCC3VertexContentLocation, kCC3VertexContentNormal, and kCC3VertexContentTextureCoordinate
  * are populated by this method.
@@ -256,6 +295,11 @@ typedef struct {
 	CGPoint relativeOrigin;
 	CC3Tessellation tessellation;
 	GLfloat lineHeight;
+	CC3BitmapGlyphLayout* glyphLayouts;
+	CC3BitmapGlyphLayout* pendingGlyphLayouts;
+	GLuint glyphLayoutCapacity;
+	GLuint glyphCount;
+	BOOL shouldRebuildLabelMesh : 1;
 }
 
 /**
@@ -35,6 +35,22 @@
 #import "CGPointExtension.h"
 
 
+/** The dimensional characteristics of a single line of text within a label layout. */
+typedef struct {
+	GLfloat lineWidth;
+	GLuint firstGlyphIndex;
+} CC3BMLineSpec;
+
+@interface CC3Mesh (BitmapLabelTemplateMethods)
+-(void) populateAsBitmapFontGlyph: (CC3BitmapGlyphLayout*) glyph
+							   at: (GLuint) glyphIndex
+						  andFont: (CC3BitmapFontConfiguration*) fontConfig
+					 andFontScale: (GLfloat) fontScale
+				  andTessellation: (CC3Tessellation) divsPerChar;
+-(void) populateAsBitmapFontGlyphIndicesAt: (GLuint) glyphIndex andTessellation: (CC3Tessellation) divsPerChar;
+@end
+
+
 #pragma mark -
 #pragma mark CC3BitmapFontConfiguration
 
@@ -44,48 +60,144 @@
 @synthesize commonHeight=_commonHeight, padding=_padding, textureSize=_textureSize;
 
 -(void) dealloc {
-	[self purgeCharDefDictionary];
-	[self purgeKerningDictionary];
+	free(_glyphs);
+	free(_kerningTable);
 	[_characterSet release];
 	[_atlasName release];
 	[super dealloc];
 }
 
--(void) purgeCharDefDictionary {
-	CC3BitmapCharDefHashElement *current, *tmp;
-	HASH_ITER(hh, _charDefDictionary, current, tmp) {
-		HASH_DEL(_charDefDictionary, current);
-		free(current);
+
+#pragma mark Character definitions
+
+-(CC3BitmapCharDef*) characterSpecFor: (unichar) c {
+	if (c < kCC3BitmapFontDirectGlyphCount) return _directGlyphs[c];
+
+	// Binary search of the glyphs beyond the directly indexed characters
+	GLuint lowIdx = 0;
+	GLuint highIdx = _glyphCount;
+	while (lowIdx < highIdx) {
+		GLuint midIdx = (lowIdx + highIdx) >> 1;
+		unichar midChar = _glyphs[midIdx].charCode;
+		if (midChar == c) return &_glyphs[midIdx];
+		if (midChar < c)
+			lowIdx = midIdx + 1;
+		else
+			highIdx = midIdx;
 	}
+	return NULL;
 }
 
--(void) purgeKerningDictionary {
-	CC3KerningHashElement *current;
-	while(_kerningDictionary) {
-		current = _kerningDictionary;
-		HASH_DEL(_kerningDictionary, current);
-		free(current);
+/** Returns the slot in the kerning hash table at which to start searching for the specified key. */
+static inline GLuint CC3KerningHashSlot(GLuint key, GLuint tableSize) {
+	return (key * 2654435761u) & (tableSize - 1);
+}
+
+-(NSInteger) kerningBetween: (unichar) firstChar and: (unichar) secondChar {
+	if (_kerningTableSize == 0) return 0;
+
+	GLuint key = (firstChar << 16) | (secondChar & 0xffff);
+	GLuint slot = CC3KerningHashSlot(key, _kerningTableSize);
+	while (_kerningTable[slot].key) {
+		if (_kerningTable[slot].key == key) return _kerningTable[slot].amount;
+		slot = (slot + 1) & (_kerningTableSize - 1);
 	}
+	return 0;
 }
 
+-(GLuint) layoutGlyphs: (CC3BitmapGlyphLayout*) glyphs
+			fromString: (NSString*) aString
+		withLineHeight: (GLfloat) lineHeight
+	  andTextAlignment: (UITextAlignment) textAlignment
+	 andRelativeOrigin: (CGPoint) origin {
 
-#pragma mark Character definitions
+	if (lineHeight == 0.0f) lineHeight = _commonHeight;
+	GLfloat fontScale = lineHeight / (GLfloat)_commonHeight;
+	NSUInteger strLen = aString.length;
 
--(CC3BitmapCharDef*) characterSpecFor: (unichar) c {
-	CC3BitmapCharDefHashElement *element = NULL;
-	NSUInteger key = (NSUInteger)c;
-	HASH_FIND_INT(_charDefDictionary , &key, element);
-	return element ? &(element->charDef) : NULL;
-}
+	// Line count needs to be calculated before parsing the lines to get Y position
+	NSUInteger lineCount = 1;
+	for (NSUInteger i = 0; i < strLen; i++)
+		if ([aString characterAtIndex: i] == '\n') lineCount++;
+	
+	// Create a local array to hold the dimensional characteristics of each line of text
+	CC3BMLineSpec lineSpecs[lineCount];
+	lineSpecs[0].lineWidth = 0.0f;
+	lineSpecs[0].firstGlyphIndex = 0;
 
--(NSInteger) kerningBetween: (unichar) firstChar and: (unichar) secondChar {
-	if(_kerningDictionary) {
-		unsigned int key = (firstChar << 16) | (secondChar & 0xffff);
-		CC3KerningHashElement* element = NULL;
-		HASH_FIND_INT(_kerningDictionary, &key, element);
-		if(element) return element->amount;
+	// Start at the top-left corner of the label, above the first line.
+	// Place the first character at the left of the first line.
+	// Width will be determined as the lines are laid out.
+	CGPoint charPos = ccp(0.0f, lineCount * lineHeight);
+	GLfloat layoutWidth = 0.0f;
+	unichar prevChar = -1;
+	NSUInteger lineIdx = 0;
+	GLuint glyphIdx = 0;
+
+	for (NSUInteger i = 0; i < strLen; i++) {
+		unichar c = [aString characterAtIndex: i];
+		
+		// If the character is a newline, don't lay anything out and move down a line
+		if (c == '\n') {
+			lineIdx++;
+			lineSpecs[lineIdx].lineWidth = 0.0f;
+			lineSpecs[lineIdx].firstGlyphIndex = glyphIdx;
+			charPos.x = 0.0f;
+			charPos.y -= lineHeight;
+			prevChar = -1;
+			continue;
+		}
+		
+		// Get the font specification and for the character, the kerning between the previous
+		// character and this character, and determine a positioning adjustment for the character.
+		CC3BitmapCharDef* charSpec = [self characterSpecFor: c];
+		CC3Assert(charSpec, @"%@: no font specification loaded for character %i", self, c);
+		
+		GLfloat kerningAmount = [self kerningBetween: prevChar and: c] * fontScale;
+		CC3BitmapGlyphLayout* glyph = &glyphs[glyphIdx++];
+		glyph->charSpec = charSpec;
+		glyph->position.x = charPos.x + (charSpec->xOffset * fontScale) + kerningAmount;
+		glyph->position.y = charPos.y - (charSpec->yOffset * fontScale);
+
+		// If needed, expand the line and layout width to account for the character
+		GLfloat rightEdge = glyph->position.x + (charSpec->rect.size.width * fontScale);
+		lineSpecs[lineIdx].lineWidth = MAX(lineSpecs[lineIdx].lineWidth, rightEdge);
+		layoutWidth = MAX(layoutWidth, rightEdge);
+
+		// Horizontal position of the next character
+		charPos.x += (charSpec->xAdvance * fontScale) + kerningAmount;
+		
+		prevChar = c;	// Remember the current character before moving on to the next
 	}
-	return 0;
+
+	// Iterate through the lines, calculating the width adjustment to correctly align each line,
+	// and applying that adjustment, less the location of the origin derived from the origin
+	// factor, to the position of each character contained within that line.
+	CGPoint originLoc = ccp(layoutWidth * origin.x, lineHeight * lineCount * origin.y);
+	for (NSUInteger i = 0; i < lineCount; i++) {
+		GLfloat widthAdj;
+		switch (textAlignment) {
+			case UITextAlignmentCenter:
+				// Adjust characters so half the white space is on each side
+				widthAdj = (layoutWidth - lineSpecs[i].lineWidth) * 0.5f;
+				break;
+			case UITextAlignmentRight:
+				// Adjust characters so all the white space is on the left side
+				widthAdj = layoutWidth - lineSpecs[i].lineWidth;
+				break;
+			case UITextAlignmentLeft:
+			default:
+				// Leave all characters where they are
+				widthAdj = 0.0f;
+				break;
+		}
+		GLuint endGlyphIdx = (i + 1 < lineCount) ? lineSpecs[i + 1].firstGlyphIndex : glyphIdx;
+		for (GLuint gIdx = lineSpecs[i].firstGlyphIndex; gIdx < endGlyphIdx; gIdx++) {
+			glyphs[gIdx].position.x += widthAdj - originLoc.x;
+			glyphs[gIdx].position.y -= originLoc.y;
+		}
+	}
+	return glyphIdx;
 }
 
 
@@ -93,14 +205,20 @@
 
 -(id) initFromFontFile: (NSString*) fontFile {
 	if( (self = [super init]) ) {
-		_kerningDictionary = NULL;
-		_charDefDictionary = NULL;
+		_glyphs = NULL;
+		_glyphCount = 0;
+		_glyphCapacity = 0;
+		_kerningTable = NULL;
+		_kerningCount = 0;
+		_kerningTableSize = 0;
 		NSString *validChars = [self parseConfigFile: fontFile];
 		if( !validChars ) {
 			[self release];
 			return nil;
 		}
 		_characterSet = [[NSCharacterSet characterSetWithCharactersInString: validChars] retain];
+		[self buildGlyphTable];
+		[self buildKerningTable];
 	}
 	return self;
 }
@@ -125,11 +243,60 @@ static NSMutableDictionary* _fontConfigurations = nil;
 +(void) clearFontConfigurations { [_fontConfigurations removeAllObjects]; }
 
 - (NSString*) description {
-	return [NSString stringWithFormat:@"%@ with glphys: %d, kernings:%d, image = %@",
-			[self class],
-			HASH_COUNT(_charDefDictionary),
-			HASH_COUNT(_kerningDictionary),
-			_atlasName];
+	return [NSString stringWithFormat:@"%@ with glphys: %u, kernings:%u, image = %@",
+			[self class], _glyphCount, _kerningCount, _atlasName];
+}
+
+
+#pragma mark Lookup tables
+
+static int CC3BitmapCharDefCompare(const void* p1, const void* p2) {
+	return (int)((CC3BitmapCharDef*)p1)->charCode - (int)((CC3BitmapCharDef*)p2)->charCode;
+}
+
+/**
+ * Sorts the parsed character specifications by character code, so that they can be found by
+ * binary search, and points the direct lookup table at those with low character codes.
+ */
+-(void) buildGlyphTable {
+	qsort(_glyphs, _glyphCount, sizeof(CC3BitmapCharDef), CC3BitmapCharDefCompare);
+	memset(_directGlyphs, 0, sizeof(_directGlyphs));
+	for (GLuint gIdx = 0; gIdx < _glyphCount; gIdx++) {
+		unichar c = _glyphs[gIdx].charCode;
+		if (c < kCC3BitmapFontDirectGlyphCount) _directGlyphs[c] = &_glyphs[gIdx];
+	}
+}
+
+/**
+ * Moves the parsed kerning entries, which are held in a simple list during parsing, into a hash
+ * table that is at least twice the size of the number of entries, and is a power of two in size.
+ */
+-(void) buildKerningTable {
+	CC3KerningHashEntry* kerningList = _kerningTable;
+	_kerningTable = NULL;
+	_kerningTableSize = 0;
+	if (_kerningCount == 0) {
+		free(kerningList);
+		return;
+	}
+
+	GLuint tableSize = 16;
+	while (tableSize < (_kerningCount * 2)) tableSize <<= 1;
+	_kerningTable = calloc(tableSize, sizeof(CC3KerningHashEntry));
+	_kerningTableSize = tableSize;
+
+	GLuint entryCount = 0;
+	for (GLuint kIdx = 0; kIdx < _kerningCount; kIdx++) {
+		GLuint key = kerningList[kIdx].key;
+		if ( !key ) continue;
+		GLuint slot = CC3KerningHashSlot(key, tableSize);
+		while (_kerningTable[slot].key && _kerningTable[slot].key != key)
+			slot = (slot + 1) & (tableSize - 1);
+		if ( !_kerningTable[slot].key ) entryCount++;
+		_kerningTable[slot] = kerningList[kIdx];		// A repeated pair replaces the earlier amount
+	}
+	_kerningCount = entryCount;
+	free(kerningList);
 }
 
 
@@ -165,7 +332,12 @@ static NSMutableDictionary* _fontConfigurations = nil;
 
 /** Parses a character definition line. */
 -(void) parseCharacterDefinition:(NSString*)line validChars: (NSMutableString*) validChars {
-	CC3BitmapCharDefHashElement *element = calloc(sizeof(CC3BitmapCharDefHashElement), 1);
+	if (_glyphCount == _glyphCapacity) {
+		_glyphCapacity = MAX(_glyphCapacity * 2, 128);
+		_glyphs = realloc(_glyphs, _glyphCapacity * sizeof(CC3BitmapCharDef));
+	}
+	CC3BitmapCharDef* charDef = &_glyphs[_glyphCount++];
+	memset(charDef, 0, sizeof(CC3BitmapCharDef));
 
 	NSArray *values = [line componentsSeparatedByString:@"="];
 	NSEnumerator *nse = [values objectEnumerator];
@@ -175,33 +347,30 @@ static NSMutableDictionary* _fontConfigurations = nil;
     
 	propertyValue = [nse nextObject];							// Character unicode value
 	propertyValue = [propertyValue substringToIndex: [propertyValue rangeOfString: @" "].location];
-	element->charDef.charCode = [propertyValue intValue];
+	charDef->charCode = [propertyValue intValue];
     
 	propertyValue = [nse nextObject];							// Character rect x
-	element->charDef.rect.origin.x = [propertyValue intValue];
+	charDef->rect.origin.x = [propertyValue intValue];
 	
 	propertyValue = [nse nextObject];							// Character rect y
-	element->charDef.rect.origin.y = [propertyValue intValue];
+	charDef->rect.origin.y = [propertyValue intValue];
 	
 	propertyValue = [nse nextObject];							// Character rect width
-	element->charDef.rect.size.width = [propertyValue intValue];
+	charDef->rect.size.width = [propertyValue intValue];
 	
 	propertyValue = [nse nextObject];							// Character rect height
-	element->charDef.rect.size.height = [propertyValue intValue];
+	charDef->rect.size.height = [propertyValue intValue];
 	
 	propertyValue = [nse nextObject];							// Character xoffset
-	element->charDef.xOffset = [propertyValue intValue];
+	charDef->xOffset = [propertyValue intValue];
 	
 	propertyValue = [nse nextObject];							// Character yoffset
-	element->charDef.yOffset = [propertyValue intValue];
+	charDef->yOffset = [propertyValue intValue];
 	
 	propertyValue = [nse nextObject];							// Character xadvance
-	element->charDef.xAdvance = [propertyValue intValue];
-	
-	element->key = element->charDef.charCode;
-	HASH_ADD_INT(_charDefDictionary, key, element);
+	charDef->xAdvance = [propertyValue intValue];
 	
-	[validChars appendString: [NSString stringWithFormat: @"%C", element->charDef.charCode]];
+	[validChars appendString: [NSString stringWithFormat: @"%C", charDef->charCode]];
 }
 
 /** Parses a kerning line. */
@@ -221,10 +390,14 @@ static NSMutableDictionary* _fontConfigurations = nil;
 	propertyValue = [nse nextObject];				// Kerning amount
 	int amount = [propertyValue intValue];
     
-	CC3KerningHashElement *element = calloc(sizeof(CC3KerningHashElement), 1);
-	element->key = (first<<16) | (second&0xffff);
-	element->amount = amount;
-	HASH_ADD_INT(_kerningDictionary,key, element);
+	// Held in a simple list until parsing is complete, then moved into the hash table.
+	if (_kerningCount == _kerningTableSize) {
+		_kerningTableSize = MAX(_kerningTableSize * 2, 64);
+		_kerningTable = realloc(_kerningTable, _kerningTableSize * sizeof(CC3KerningHashEntry));
+	}
+	CC3KerningHashEntry* entry = &_kerningTable[_kerningCount++];
+	entry->key = (first<<16) | (second&0xffff);
+	entry->amount = amount;
 }
 
 /** Parses the info line. */
@@ -380,6 +553,8 @@ static NSMutableDictionary* _fontConfigurations = nil;
 	[labelString release];
 	[fontFileName release];
 	[fontConfig release];
+	free(glyphLayouts);
+	free(pendingGlyphLayouts);
 	[super dealloc];
 }
 
@@ -388,6 +563,7 @@ static NSMutableDictionary* _fontConfigurations = nil;
 -(void) setLineHeight: (GLfloat) lineHt {
 	if (lineHt != lineHeight) {
 		lineHeight = lineHt;
+		shouldRebuildLabelMesh = YES;
 		[self populateLabelMesh];
 	}
 }
@@ -412,6 +588,7 @@ static NSMutableDictionary* _fontConfigurations = nil;
 		[fontConfig release];
 		fontConfig = [[CC3BitmapFontConfiguration configurationFromFontFile: fontFileName] retain];
 
+		shouldRebuildLabelMesh = YES;
 		[self populateLabelMesh];
 	}
 }
@@ -439,6 +616,7 @@ static NSMutableDictionary* _fontConfigurations = nil;
 -(void) setTessellation: (CC3Tessellation) aGrid {
 	if ( !((aGrid.x == tessellation.x) && (aGrid.y == tessellation.y)) ) {
 		tessellation = aGrid;
+		shouldRebuildLabelMesh = YES;
 		[self populateLabelMesh];
 	}
 }
@@ -450,10 +628,38 @@ static NSMutableDictionary* _fontConfigurations = nil;
 	return 1.0f - (GLfloat)fontConfig.baseline / (GLfloat)fontConfig.commonHeight;
 }
 
+/** Replacing the mesh invalidates the character layouts used to update the existing mesh. */
+-(void) setMesh: (CC3Mesh*) aMesh {
+	[super setMesh: aMesh];
+	shouldRebuildLabelMesh = YES;
+}
+
+-(void) setVertexContentTypes: (CC3VertexContent) vtxContentTypes {
+	[super setVertexContentTypes: vtxContentTypes];
+	shouldRebuildLabelMesh = YES;
+}
+
+
 #pragma mark Mesh population
 
+/**
+ * Lays out the characters of the label string, and either updates the existing mesh in place,
+ * or, if that is not possible, rebuilds the mesh completely.
+ *
+ * The layout of the characters currently in the mesh is retained in the glyphLayouts array,
+ * so that the new layout, in the pendingGlyphLayouts array, can be compared against it.
+ */
 -(void) populateLabelMesh {
-	if (fontFileName && labelString) {
+	if ( !(fontFileName && labelString) ) return;
+
+	[self ensureGlyphLayoutCapacity: (GLuint)labelString.length];
+	GLuint newGlyphCount = [fontConfig layoutGlyphs: pendingGlyphLayouts
+										 fromString: labelString
+									 withLineHeight: self.lineHeight
+								   andTextAlignment: textAlignment
+								  andRelativeOrigin: relativeOrigin];
+	
+	if ( ![self updateLabelMeshWithGlyphCount: newGlyphCount] ) {
 		[self populateAsBitmapFontLabelFromString: self.labelString
 									 fromFontFile: self.fontFileName
 									andLineHeight: self.lineHeight
@@ -465,7 +671,77 @@ static NSMutableDictionary* _fontConfigurations = nil;
 			[mesh deleteGLBuffers];
 			[mesh createGLBuffers];
 		}
+		shouldRebuildLabelMesh = NO;
 	}
+
+	// The pending layouts now describe the mesh content
+	CC3BitmapGlyphLayout* prevGlyphLayouts = glyphLayouts;
+	glyphLayouts = pendingGlyphLayouts;
+	pendingGlyphLayouts = prevGlyphLayouts;
+	glyphCount = newGlyphCount;
+}
+
+/**
+ * Updates the existing mesh in place to display the characters laid out in the pendingGlyphLayouts
+ * array, rewriting only those characters whose content or position differs from the corresponding
+ * character in the glyphLayouts array, and copying only the rewritten range of vertices to any GL
+ * buffers. Since the vertex indices of each character depend only on its position within the mesh,
+ * they are never rewritten.
+ *
+ * Returns NO, without changing the mesh, if the mesh must be rebuilt, because it does not exist, it
+ * was built with a different font, line height or tessellation, its vertex content is no longer held
+ * in application memory, or it does not have the capacity to hold the specified number of characters.
+ */
+-(BOOL) updateLabelMeshWithGlyphCount: (GLuint) newGlyphCount {
+	if (shouldRebuildLabelMesh || !mesh.vertexLocations.vertices || !mesh.vertexIndices.vertices) return NO;
+	
+	GLuint vtxCountPerChar = (tessellation.x + 1) * (tessellation.y + 1);
+	GLuint vtxIdxCountPerChar = tessellation.x * tessellation.y * 6;
+	if ((newGlyphCount * vtxCountPerChar) > mesh.allocatedVertexCapacity ||
+		(newGlyphCount * vtxIdxCountPerChar) > mesh.allocatedVertexIndexCapacity) return NO;
+
+	GLfloat fontScale = self.lineHeight / (GLfloat)fontConfig.commonHeight;
+	GLuint firstDirtyGlyph = newGlyphCount;
+	GLuint lastDirtyGlyph = 0;
+	for (GLuint gIdx = 0; gIdx < newGlyphCount; gIdx++) {
+		CC3BitmapGlyphLayout* glyph = &pendingGlyphLayouts[gIdx];
+		if (gIdx < glyphCount) {
+			CC3BitmapGlyphLayout* prevGlyph = &glyphLayouts[gIdx];
+			if (glyph->charSpec == prevGlyph->charSpec &&
+				CGPointEqualToPoint(glyph->position, prevGlyph->position)) continue;
+		}
+		[mesh populateAsBitmapFontGlyph: glyph
+									 at: gIdx
+								andFont: fontConfig
+						   andFontScale: fontScale
+						andTessellation: tessellation];
+		firstDirtyGlyph = MIN(firstDirtyGlyph, gIdx);
+		lastDirtyGlyph = gIdx;
+	}
+	
+	mesh.vertexCount = newGlyphCount * vtxCountPerChar;
+	mesh.vertexIndexCount = newGlyphCount * vtxIdxCountPerChar;
+
+	BOOL wasChanged = (firstDirtyGlyph <= lastDirtyGlyph);
+	if (wasChanged)
+		[mesh updateGLBuffersStartingAt: (firstDirtyGlyph * vtxCountPerChar)
+							  forLength: ((lastDirtyGlyph - firstDirtyGlyph + 1) * vtxCountPerChar)];
+	if (wasChanged || newGlyphCount != glyphCount) [self markBoundingVolumeDirty];
+
+	LogTrace(@"%@ updated %u of %u characters in place", self,
+			 (wasChanged ? (lastDirtyGlyph - firstDirtyGlyph + 1) : 0), newGlyphCount);
+	return YES;
+}
+
+/**
+ * Ensures the glyph layout arrays can each hold the specified number of characters,
+ * retaining the content of the glyphLayouts array.
+ */
+-(void) ensureGlyphLayoutCapacity: (GLuint) glyphCapacity {
+	if (glyphCapacity <= glyphLayoutCapacity) return;
+	glyphLayouts = realloc(glyphLayouts, glyphCapacity * sizeof(CC3BitmapGlyphLayout));
+	pendingGlyphLayouts = realloc(pendingGlyphLayouts, glyphCapacity * sizeof(CC3BitmapGlyphLayout));
+	glyphLayoutCapacity = glyphCapacity;
 }
 
 
@@ -480,6 +756,11 @@ static NSMutableDictionary* _fontConfigurations = nil;
 		textAlignment = UITextAlignmentLeft;
 		relativeOrigin = ccp(0,0);
 		tessellation = CC3TessellationMake(1,1);
+		glyphLayouts = NULL;
+		pendingGlyphLayouts = NULL;
+		glyphLayoutCapacity = 0;
+		glyphCount = 0;
+		shouldRebuildLabelMesh = YES;
 	}
 	return self;
 }
@@ -505,11 +786,6 @@ static NSMutableDictionary* _fontConfigurations = nil;
 #pragma mark -
 #pragma mark CC3Mesh bitmapped label extension
 
-typedef struct {
-	GLfloat lineWidth;
-	NSUInteger lastVertexIndex;
-} CC3BMLineSpec;
-
 /** CC3MeshNode extension to support bitmapped labels. */
 @implementation CC3Mesh (BitmapLabel)
 
@@ -520,27 +796,16 @@ typedef struct {
 						  andRelativeOrigin: (CGPoint) origin
 							andTessellation: (CC3Tessellation) divsPerChar {
 	
-	CGPoint charPos, adjCharPos;
-	CGSize layoutSize;
-	NSInteger kerningAmount;
-	unichar prevChar = -1;
-	NSUInteger strLen = [lblString length];
-	
 	if (lineHeight == 0.0f) lineHeight = fontConfig.commonHeight;
 	GLfloat fontScale = lineHeight / (GLfloat)fontConfig.commonHeight;
-	
-	// Line count needs to be calculated before parsing the lines to get Y position
-	NSUInteger charCount = 0;
-	NSUInteger lineCount = 1;
-	for(NSUInteger i = 0; i < strLen; i++)
-		([lblString characterAtIndex: i] == '\n') ? lineCount++ : charCount++;
-	
-	// Create a local array to hold the dimensional characteristics of each line of text
-	CC3BMLineSpec lineSpecs[lineCount];
-	
-	// We now know the height of the layout. Width will be determined as the lines are laid out.
-	layoutSize.width =  0;
-	layoutSize.height = lineHeight * lineCount;
+
+	// Lay out the characters. There is at most one character per element of the string.
+	CC3BitmapGlyphLayout* glyphs = malloc(MAX(lblString.length, 1) * sizeof(CC3BitmapGlyphLayout));
+	GLuint charCount = [fontConfig layoutGlyphs: glyphs
+									 fromString: lblString
+								 withLineHeight: lineHeight
+							   andTextAlignment: textAlignment
+							  andRelativeOrigin: origin];
 	
 	// Prepare the vertex content and allocate space for the vertices and indexes.
 	[self ensureVertexContent];
@@ -549,145 +814,90 @@ typedef struct {
 	self.allocatedVertexCapacity = vtxCountPerChar * charCount;
 	self.allocatedVertexIndexCapacity = triCountPerChar * 3 * charCount;
 	
-	LogTrace(@"Creating label %@ with %i (%i) vertices and %i (%i) vertex indices from %i chars on %i lines in text %@",
+	LogTrace(@"Creating label %@ with %i (%i) vertices and %i (%i) vertex indices from %i chars in text %@",
 			 self, self.vertexCount, self.allocatedVertexCapacity,
-			 self.vertexIndexCount, self.allocatedVertexIndexCapacity, charCount, lineCount, lblString);
-	
-	// Start at the top-left corner of the label, above the first line.
-	// Place the first character at the left of the first line.
-	charPos.x = 0;
-	charPos.y = lineCount * lineHeight;
-	
-	NSUInteger lineIndx = 0;
-	NSUInteger vIdx = 0;
-	NSUInteger iIdx = 0;
-	
-	// Iterate through the characters
-	for (NSUInteger i = 0; i < strLen; i++) {
-		unichar c = [lblString characterAtIndex: i];
-		
-		// If the character is a newline, don't draw anything and move down a line
-		if (c == '\n') {
-			lineIndx++;
-			charPos.x = 0;
-			charPos.y -= lineHeight;
-			continue;
-		}
-		
-		// Get the font specification and for the character, the kerning between the previous
-		// character and this character, and determine a positioning adjustment for the character.
-		CC3BitmapCharDef* charSpec = [fontConfig characterSpecFor: c];
-		CC3Assert(charSpec, @"%@: no font specification loaded for character %i", self, c);
-		
-		kerningAmount = [fontConfig kerningBetween: prevChar and: c] * fontScale;
-		adjCharPos.x = charPos.x + (charSpec->xOffset * fontScale) + kerningAmount;
-		adjCharPos.y = charPos.y - (charSpec->yOffset * fontScale);
-		
-		// Determine the size of each tesselation division for this character.
-		// This is specified in terms of the unscaled font config. It will be scaled later.
-		CGSize divSize = CGSizeMake(charSpec->rect.size.width / divsPerChar.x,
-									charSpec->rect.size.height / divsPerChar.y);
-		
-		// Initialize the current line spec
-		lineSpecs[lineIndx].lastVertexIndex = 0;
-		lineSpecs[lineIndx].lineWidth = 0.0f;
-		
-		// Populate the tesselated vertex locations, normals & texture coordinates for a single
-		// character. Iterate through the rows and columns of the tesselation grid, from the top-left
-		// corner downwards. This orientation aligns with the texture coords in the font file.
-		// Set the location of each vertex and tex coords to be proportional to its position in the
-		// grid, and set the normal of each vertex to point up the Z-axis.
-		for (NSUInteger iy = 0; iy <= divsPerChar.y; iy++) {
-			for (NSUInteger ix = 0; ix <= divsPerChar.x; ix++, vIdx++) {
-				
-				// Cache the index of the last vertex of this line. Since the vertices are accessed
-				// in consecutive, ascending order, this is done by simply setting it each time.
-				lineSpecs[lineIndx].lastVertexIndex = vIdx;
-				
-				// Vertex location
-				GLfloat vx = adjCharPos.x + (divSize.width * ix * fontScale);
-				GLfloat vy = adjCharPos.y - (divSize.height * iy * fontScale);
-				[self setVertexLocation: cc3v(vx, vy, 0.0) at: vIdx];
-				
-				// If needed, expand the line and layout width to account for the vertices
-				lineSpecs[lineIndx].lineWidth = MAX(lineSpecs[lineIndx].lineWidth, vx);
-				layoutSize.width = MAX(layoutSize.width, vx);
-				
-				// Vertex normal. Will do nothing if this mesh does not include normals.
-				[self setVertexNormal: kCC3VectorUnitZPositive at: vIdx];
-				
-				// Vertex texture coordinates, inverted vertically, because we're working top-down.
-				CGSize texSize = fontConfig.textureSize;
-				GLfloat u = (charSpec->rect.origin.x + (divSize.width * ix)) / texSize.width;
-				GLfloat v = (charSpec->rect.origin.y + (divSize.height * iy)) / texSize.height;
-				[self setVertexTexCoord2F: cc3tc(u, v) at: vIdx];
-				
-				// In the grid of division quads for each character, each vertex that is not
-				// in either the top-most row or the right-most column is the bottom-left corner
-				// of a division. Break the division into two triangles.
-				if (iy < divsPerChar.y && ix < divsPerChar.x) {
-					
-					// First triangle of face wound counter-clockwise
-					[self setVertexIndex: vIdx at: iIdx++];						// TL
-					[self setVertexIndex: (vIdx + divsPerChar.x + 1) at: iIdx++];	// BL
-					[self setVertexIndex: (vIdx + divsPerChar.x + 2) at: iIdx++];	// BR
-					
-					// Second triangle of face wound counter-clockwise
-					[self setVertexIndex: (vIdx + divsPerChar.x + 2) at: iIdx++];	// BR
-					[self setVertexIndex: (vIdx + 1) at: iIdx++];					// TR
-					[self setVertexIndex: vIdx at: iIdx++];						// TL
-				}
-			}
-		}
-		
-		// Horizontal position of the next character
-		charPos.x += (charSpec->xAdvance * fontScale) + kerningAmount;
-		
-		prevChar = c;	// Remember the current character before moving on to the next
+			 self.vertexIndexCount, self.allocatedVertexIndexCapacity, charCount, lblString);
+	
+	for (GLuint gIdx = 0; gIdx < charCount; gIdx++) {
+		[self populateAsBitmapFontGlyph: &glyphs[gIdx]
+									 at: gIdx
+								andFont: fontConfig
+						   andFontScale: fontScale
+						andTessellation: divsPerChar];
+		[self populateAsBitmapFontGlyphIndicesAt: gIdx andTessellation: divsPerChar];
 	}
-	
-	// Iterate through the lines, calculating the width adjustment to correctly align each line,
-	// and applying that adjustment to the X-component of the location of each vertex that is
-	// contained within that text line.
-	for (NSUInteger i = 0; i < lineCount; i++) {
-		GLfloat widthAdj;
-		switch (textAlignment) {
-			case UITextAlignmentCenter:
-				// Adjust vertices so half the white space is on each side
-				widthAdj = (layoutSize.width - lineSpecs[i].lineWidth) * 0.5f;
-				break;
-			case UITextAlignmentRight:
-				// Adjust vertices so all the white space is on the left side
-				widthAdj = layoutSize.width - lineSpecs[i].lineWidth;
-				break;
-			case UITextAlignmentLeft:
-			default:
-				// Leave all vertices where they are
-				widthAdj = 0.0f;
-				break;
-		}
-		if (widthAdj) {
-			NSUInteger startVtxIdx = (i > 0) ? (lineSpecs[i - 1].lastVertexIndex + 1) : 0;
-			NSUInteger endVtxIdx = lineSpecs[i].lastVertexIndex;
-			LogTrace(@"%@ adjusting line %i by %.3f (from line width %i in layout width %i) from vertex %i to %i",
-					 self, i, widthAdj, lineSpecs[i].lineWidth, layoutSize.width, startVtxIdx, endVtxIdx);
-			for (vIdx = startVtxIdx; vIdx <= endVtxIdx; vIdx++) {
-				CC3Vector vtxLoc = [self vertexLocationAt: vIdx];
-				vtxLoc.x += widthAdj;
-				[self setVertexLocation: vtxLoc at: vIdx];
-			}
+	free(glyphs);
+}
+
+-(void) populateAsBitmapFontGlyph: (CC3BitmapGlyphLayout*) glyph
+							   at: (GLuint) glyphIndex
+						  andFont: (CC3BitmapFontConfiguration*) fontConfig
+					 andFontScale: (GLfloat) fontScale
+				  andTessellation: (CC3Tessellation) divsPerChar {
+	CC3BitmapCharDef* charSpec = glyph->charSpec;
+	CGSize texSize = fontConfig.textureSize;
+	
+	// Determine the size of each tesselation division for this character.
+	// This is specified in terms of the unscaled font config. It will be scaled later.
+	CGSize divSize = CGSizeMake(charSpec->rect.size.width / divsPerChar.x,
+								charSpec->rect.size.height / divsPerChar.y);
+	
+	// The texture coordinates may already have been aligned with the font texture, if this mesh
+	// is being updated in place. Align the coordinates of this character in the same way.
+	CC3VertexTextureCoordinates* texCoords = self.vertexTextureCoordinates;
+	CGSize mapSize = texCoords ? texCoords.mapSize : CGSizeMake(1.0f, 1.0f);
+	BOOL isFlipped = texCoords && XOR(texCoords.expectsVerticallyFlippedTextures,
+									  CC3VertexTextureCoordinates.defaultExpectsVerticallyFlippedTextures);
+	
+	// Populate the tesselated vertex locations, normals & texture coordinates for a single
+	// character. Iterate through the rows and columns of the tesselation grid, from the top-left
+	// corner downwards. This orientation aligns with the texture coords in the font file.
+	// Set the location of each vertex and tex coords to be proportional to its position in the
+	// grid, and set the normal of each vertex to point up the Z-axis.
+	GLuint vIdx = glyphIndex * (divsPerChar.x + 1) * (divsPerChar.y + 1);
+	for (GLuint iy = 0; iy <= divsPerChar.y; iy++) {
+		for (GLuint ix = 0; ix <= divsPerChar.x; ix++, vIdx++) {
+			
+			// Vertex location
+			GLfloat vx = glyph->position.x + (divSize.width * ix * fontScale);
+			GLfloat vy = glyph->position.y - (divSize.height * iy * fontScale);
+			[self setVertexLocation: cc3v(vx, vy, 0.0) at: vIdx];
+			
+			// Vertex normal. Will do nothing if this mesh does not include normals.
+			[self setVertexNormal: kCC3VectorUnitZPositive at: vIdx];
+			
+			// Vertex texture coordinates, inverted vertically, because we're working top-down.
+			GLfloat u = (charSpec->rect.origin.x + (divSize.width * ix)) / texSize.width;
+			GLfloat v = (charSpec->rect.origin.y + (divSize.height * iy)) / texSize.height;
+			if (isFlipped) v = 1.0f - v;
+			[self setVertexTexCoord2F: cc3tc((u * mapSize.width), (v * mapSize.height)) at: vIdx];
 		}
 	}
-	
-	// Move all vertices so that the origin of the vertex coordinate system is aligned
-	// with a location derived from the origin factor.
-	NSUInteger vtxCnt = self.vertexCount;
-	CC3Vector originLoc = cc3v((layoutSize.width * origin.x), (layoutSize.height * origin.y), 0);
-	for (vIdx = 0; vIdx < vtxCnt; vIdx++) {
-		CC3Vector locOld = [self vertexLocationAt: vIdx];
-		CC3Vector locNew = CC3VectorDifference(locOld, originLoc);
-		[self setVertexLocation: locNew at: vIdx];
+}
+
+-(void) populateAsBitmapFontGlyphIndicesAt: (GLuint) glyphIndex andTessellation: (CC3Tessellation) divsPerChar {
+	GLuint vtxCountPerRow = divsPerChar.x + 1;
+	GLuint vIdx = glyphIndex * vtxCountPerRow * (divsPerChar.y + 1);
+	GLuint iIdx = glyphIndex * divsPerChar.x * divsPerChar.y * 6;
+	
+	// In the grid of division quads for each character, each vertex that is not in either
+	// the bottom-most row or the right-most column is the top-left corner of a division.
+	// Break the division into two triangles.
+	for (GLuint iy = 0; iy < divsPerChar.y; iy++) {
+		for (GLuint ix = 0; ix < divsPerChar.x; ix++) {
+			GLuint tlIdx = vIdx + (iy * vtxCountPerRow) + ix;
+			
+			// First triangle of face wound counter-clockwise
+			[self setVertexIndex: tlIdx at: iIdx++];							// TL
+			[self setVertexIndex: (tlIdx + vtxCountPerRow) at: iIdx++];		// BL
+			[self setVertexIndex: (tlIdx + vtxCountPerRow + 1) at: iIdx++];	// BR
+			
+			// Second triangle of face wound counter-clockwise
+			[self setVertexIndex: (tlIdx + vtxCountPerRow + 1) at: iIdx++];	// BR
+			[self setVertexIndex: (tlIdx + 1) at: iIdx++];					// TR
+			[self setVertexIndex: tlIdx at: iIdx++];							// TL
+		}
 	}
 }
 
-@end
\ No newline at end of file
+@end
@@ -1112,6 +1112,21 @@ static const GLfloat kCC3DefaultFrustumFitPadding = 0.02f;
 @end
 
 
+#pragma mark -
+#pragma mark Visibility bitmasks
+
+/**
+ * Returns the number of GLuint elements required to hold a visibility bitmask for the specified
+ * number of objects, when used with the batch intersection methods of CC3Frustum.
+ */
+static inline GLuint CC3VisibilityBitmaskLength(GLuint objectCount) { return (objectCount + 31) / 32; }
+
+/** Returns whether the object at the specified index is marked as visible in the specified visibility bitmask. */
+static inline BOOL CC3IsVisibleInBitmask(const GLuint* visibility, GLuint objIdx) {
+	return (visibility[objIdx >> 5] & (1u << (objIdx & 31))) != 0;
+}
+
+
 #pragma mark -
 #pragma mark CC3Frustum
 
@@ -1253,6 +1268,54 @@ static const GLfloat kCC3DefaultFrustumFitPadding = 0.02f;
 		 andNearClip: (GLfloat) nearClip
 		  andFarClip: (GLfloat) farClip;
 
+
+#pragma mark Batch intersection testing
+
+/**
+ * Tests each of the specified spheres, which must be in global coordinates, against this frustum,
+ * marks each sphere that intersects this frustum in the specified visibility bitmask, and returns
+ * the number of spheres that intersect this frustum.
+ *
+ * This is much faster than invoking doesIntersectSphere: for each sphere, because the planes of
+ * this frustum are retrieved only once, and each sphere is tested against the planes in a tight
+ * loop, without any method dispatch.
+ *
+ * The visibility of the sphere at index i is held in bit (i % 32) of visibility[i / 32]. The
+ * visibility array must contain at least CC3VisibilityBitmaskLength(count) elements, all of which
+ * are overwritten. Use the CC3IsVisibleInBitmask function to read the visibility of each sphere.
+ *
+ * The planeHints parameter may be NULL, or may point to an array of count bytes, one for each
+ * sphere, that this method uses to remember the index of the plane that last rejected each sphere.
+ * That plane is tested first the next time the sphere is tested, and because objects usually
+ * remain outside the same plane from frame to frame, most rejected spheres are then rejected by
+ * a single plane test. The contents of the array should be zeroed before the first test, and
+ * should be retained by the application, along with the spheres, between tests.
+ */
+-(GLuint) testSpheres: (const CC3Sphere*) spheres
+				count: (GLuint) count
+		   planeHints: (GLubyte*) planeHints
+		   visibility: (GLuint*) visibility;
+
+/**
+ * Tests each of the specified axially-aligned bounding boxes, which must be in global coordinates,
+ * against this frustum, marks each box that intersects this frustum in the specified visibility
+ * bitmask, and returns the number of boxes that intersect this frustum.
+ *
+ * Each box is tested against each plane using only the single corner of the box that lies
+ * farthest behind that plane. That corner is determined once for each plane, from the octant
+ * into which the normal of the plane points, and is the same for all boxes.
+ *
+ * As with boxes that are tested individually, a box that lies outside this frustum, but is not
+ * entirely in front of any single plane of this frustum, may be reported as visible.
+ *
+ * The visibility and planeHints parameters are interpreted as described for the
+ * testSpheres:count:planeHints:visibility: method.
+ */
+-(GLuint) testBoxes: (const CC3BoundingBox*) boxes
+			  count: (GLuint) count
+		 planeHints: (GLubyte*) planeHints
+		 visibility: (GLuint*) visibility;
+
 /** @deprecated Renamed to markDirty. */
 -(void) markPlanesDirty DEPRECATED_ATTRIBUTE;
 
@@ -1127,6 +1127,126 @@
 	_vertices[kCC3FarBtmRgtIdx] = CC3TriplePlaneIntersection(fp, bp, rp);
 }
 
+
+#pragma mark Batch intersection testing
+
+/**
+ * The planes of a frustum, laid out as separate arrays of each plane coefficient, so that
+ * the distance of a location from all six planes can be calculated in a vectorizable loop.
+ * The octant of each plane identifies the box corner that lies farthest behind that plane.
+ */
+typedef struct {
+	GLfloat a[6];
+	GLfloat b[6];
+	GLfloat c[6];
+	GLfloat d[6];
+	GLubyte octant[6];
+} CC3FrustumPlaneSet;
+
+/** Populates the specified plane set from the specified array of six planes. */
+static void CC3FrustumPlaneSetPopulate(CC3FrustumPlaneSet* ps, const CC3Plane* planes) {
+	for (GLuint pIdx = 0; pIdx < 6; pIdx++) {
+		CC3Plane p = planes[pIdx];
+		ps->a[pIdx] = p.a;
+		ps->b[pIdx] = p.b;
+		ps->c[pIdx] = p.c;
+		ps->d[pIdx] = p.d;
+		ps->octant[pIdx] = (p.a < 0.0f ? 1 : 0) | (p.b < 0.0f ? 2 : 0) | (p.c < 0.0f ? 4 : 0);
+	}
+}
+
+/**
+ * Returns the corner of the specified box that lies farthest behind a plane whose normal points
+ * into the specified octant. If that corner is in front of the plane, the whole box is.
+ */
+static inline CC3Vector CC3BoundingBoxCornerBehindOctant(const CC3BoundingBox* bb, GLubyte octant) {
+	return cc3v((octant & 1) ? bb->maximum.x : bb->minimum.x,
+				(octant & 2) ? bb->maximum.y : bb->minimum.y,
+				(octant & 4) ? bb->maximum.z : bb->minimum.z);
+}
+
+/** Returns the distance of the specified location from the specified plane of the plane set. */
+static inline GLfloat CC3FrustumPlaneSetDistance(const CC3FrustumPlaneSet* ps, GLuint pIdx, CC3Vector v) {
+	return (ps->a[pIdx] * v.x) + (ps->b[pIdx] * v.y) + (ps->c[pIdx] * v.z) + ps->d[pIdx];
+}
+
+/**
+ * Returns the index of the first plane of the plane set from which the specified sphere lies
+ * entirely in front, or 6 if the sphere intersects the frustum. The plane at the hinted index
+ * is tested first, and the remaining distances are calculated together, without branching.
+ */
+static inline GLuint CC3FrustumPlaneSetRejectSphere(const CC3FrustumPlaneSet* ps, CC3Sphere sphere, GLuint hint) {
+	CC3Vector c = sphere.center;
+	if (hint < 6 && CC3FrustumPlaneSetDistance(ps, hint, c) > sphere.radius) return hint;
+
+	GLfloat dists[6];
+	for (GLuint pIdx = 0; pIdx < 6; pIdx++)
+		dists[pIdx] = (ps->a[pIdx] * c.x) + (ps->b[pIdx] * c.y) + (ps->c[pIdx] * c.z) + ps->d[pIdx];
+	for (GLuint pIdx = 0; pIdx < 6; pIdx++) if (dists[pIdx] > sphere.radius) return pIdx;
+	return 6;
+}
+
+/**
+ * Returns the index of the first plane of the plane set from which the specified box lies
+ * entirely in front, or 6 if no such plane exists. The plane at the hinted index is tested first.
+ */
+static inline GLuint CC3FrustumPlaneSetRejectBox(const CC3FrustumPlaneSet* ps, const CC3BoundingBox* bb, GLuint hint) {
+	if (hint < 6 && CC3FrustumPlaneSetDistance(ps, hint, CC3BoundingBoxCornerBehindOctant(bb, ps->octant[hint])) > 0.0f)
+		return hint;
+
+	GLfloat dists[6];
+	for (GLuint pIdx = 0; pIdx < 6; pIdx++)
+		dists[pIdx] = CC3FrustumPlaneSetDistance(ps, pIdx, CC3BoundingBoxCornerBehindOctant(bb, ps->octant[pIdx]));
+	for (GLuint pIdx = 0; pIdx < 6; pIdx++) if (dists[pIdx] > 0.0f) return pIdx;
+	return 6;
+}
+
+-(GLuint) testSpheres: (const CC3Sphere*) spheres
+				count: (GLuint) count
+		   planeHints: (GLubyte*) planeHints
+		   visibility: (GLuint*) visibility {
+	CC3FrustumPlaneSet ps;
+	CC3FrustumPlaneSetPopulate(&ps, self.planes);
+	memset(visibility, 0, CC3VisibilityBitmaskLength(count) * sizeof(GLuint));
+
+	GLuint visCnt = 0;
+	for (GLuint objIdx = 0; objIdx < count; objIdx++) {
+		GLuint hint = planeHints ? planeHints[objIdx] : 0;
+		GLuint rejIdx = CC3FrustumPlaneSetRejectSphere(&ps, spheres[objIdx], hint);
+		if (rejIdx < 6) {
+			if (planeHints) planeHints[objIdx] = rejIdx;
+		} else {
+			visibility[objIdx >> 5] |= (1u << (objIdx & 31));
+			visCnt++;
+		}
+	}
+	LogTrace(@"%@ found %u of %u spheres visible", self, visCnt, count);
+	return visCnt;
+}
+
+-(GLuint) testBoxes: (const CC3BoundingBox*) boxes
+			  count: (GLuint) count
+		 planeHints: (GLubyte*) planeHints
+		 visibility: (GLuint*) visibility {
+	CC3FrustumPlaneSet ps;
+	CC3FrustumPlaneSetPopulate(&ps, self.planes);
+	memset(visibility, 0, CC3VisibilityBitmaskLength(count) * sizeof(GLuint));
+
+	GLuint visCnt = 0;
+	for (GLuint objIdx = 0; objIdx < count; objIdx++) {
+		GLuint hint = planeHints ? planeHints[objIdx] : 0;
+		GLuint rejIdx = CC3FrustumPlaneSetRejectBox(&ps, &boxes[objIdx], hint);
+		if (rejIdx < 6) {
+			if (planeHints) planeHints[objIdx] = rejIdx;
+		} else {
+			visibility[objIdx >> 5] |= (1u << (objIdx & 31));
+			visCnt++;
+		}
+	}
+	LogTrace(@"%@ found %u of %u boxes visible", self, visCnt, count);
+	return visCnt;
+}
+
 // Deprecated method
 -(void) markPlanesDirty { [self markDirty]; }
 
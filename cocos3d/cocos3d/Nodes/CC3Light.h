@@ -610,6 +610,23 @@ static const CC3AttenuationCoefficients kCC3DefaultLightAttenuationCoefficients
 -(void) turnOff;
 
 
+#pragma mark Light selection
+
+/**
+ * Returns the distance from this light at which the intensity of the diffuse color of this
+ * light, after attenuation, falls below the specified fraction of full intensity.
+ *
+ * The distance is derived from the attenuation property, using the GL attenuation function
+ * 1/(a + b * r + c * r * r), and the brightest component of the diffuseColor property.
+ *
+ * Returns INFINITY if this light is directional, or is not attenuated with distance.
+ * Returns zero if this light is never as bright as the specified threshold.
+ *
+ * This method is used by CC3LightGrid to determine which nodes this light can influence.
+ */
+-(GLfloat) rangeForIntensityThreshold: (GLfloat) threshold;
+
+
 #pragma mark Managing the pool of available GL lights
 
 /**
@@ -652,6 +669,113 @@ static const CC3AttenuationCoefficients kCC3DefaultLightAttenuationCoefficients
 @end
 
 
+#pragma mark -
+#pragma mark CC3LightGrid
+
+/** The default size of each cell in a CC3LightGrid, in global coordinates. */
+#define kCC3DefaultLightGridCellSize			10.0f
+
+/** The default intensity below which a light is considered to have no influence on a node. */
+#define kCC3DefaultLightInfluenceThreshold		(1.0f / 256.0f)
+
+/**
+ * CC3LightGrid assigns to each node only the few lights that most strongly illuminate it.
+ *
+ * Without a light grid, each lit node is drawn with all of the lights in the scene, no matter
+ * how far away those lights are. To allow a scene to contain many more lights than can be
+ * applied to a single draw call, set an instance of this class into the lightGrid property
+ * of the CC3Scene.
+ *
+ * At the start of each frame, the scene invokes the binLights: method, which places each
+ * visible light into the cells of a uniform spatial grid that are covered by the sphere of
+ * influence of that light. The grid is sparse, and is stored as a fixed-size hash table, so
+ * its extent is unbounded and its memory use does not depend on the size of the scene.
+ * Lights that cover too many cells, including directional and unattenuated lights, are kept
+ * in a separate list and are considered for every node.
+ *
+ * When each node is drawn, the drawing visitor invokes the selectLights:forNode: method, which
+ * examines the lights in the cells overlapped by the bounding volume of the node, and selects
+ * up to maximumLightsPerNode lights, ordered by the intensity of each light at the node.
+ *
+ * Under OpenGL ES 2, the selected lights are passed to the shader through the light uniforms.
+ * Under OpenGL ES 1, the number of lights is limited by the platform, and selection enables
+ * only the selected lights among those available.
+ *
+ * Setting a light grid does not, by itself, allow more lights to be created. The number of
+ * lights that can exist in the scene is still limited by the value of
+ * [CC3OpenGLESEngine engine].platform.maxLights.value, which under OpenGL ES 2 defaults to the
+ * value of the kCC3MaxGL2Lights compiler build setting, which is 8. To use a light grid with
+ * more lights than that, raise that value, up to a maximum of 256, before any lights are
+ * created, either by defining the kCC3MaxGL2Lights build setting, or by setting the
+ * originalValue of the maxLights platform tracker. The default is not raised automatically,
+ * because, without a light grid, the shaders will only apply as many lights as they have
+ * been programmed for, and any additional lights would be silently ignored.
+ */
+@interface CC3LightGrid : NSObject {
+	CCArray* _globalLights;
+	CCArray** _cells;
+	GLuint _cellBucketCount;
+	GLfloat _cellSize;
+	GLfloat _influenceThreshold;
+	GLuint _maximumLightsPerNode;
+}
+
+/**
+ * The length of each side of the cubic cells of this grid, in global coordinates.
+ *
+ * For best performance, this should be about the size of the sphere of influence of
+ * a typical light. Changes to this property take effect the next time lights are binned.
+ *
+ * The initial value of this property is kCC3DefaultLightGridCellSize.
+ */
+@property(nonatomic, assign) GLfloat cellSize;
+
+/**
+ * The fraction of full intensity below which a light is considered to have no influence on a node.
+ *
+ * The initial value of this property is kCC3DefaultLightInfluenceThreshold.
+ */
+@property(nonatomic, assign) GLfloat influenceThreshold;
+
+/**
+ * The maximum number of lights that will be selected for each node.
+ *
+ * This value is limited to kCC3MaxSelectedLights, and should not be larger than the number
+ * of lights declared by the shaders in use under OpenGL ES 2, or the number of lights
+ * supported by the platform under OpenGL ES 1.
+ *
+ * The initial value of this property is kCC3MaxSelectedLights.
+ */
+@property(nonatomic, assign) GLuint maximumLightsPerNode;
+
+/**
+ * Places each of the visible lights in the specified array into the cells of this grid
+ * covered by the sphere of influence of that light, after removing all previously binned lights.
+ *
+ * This method is invoked automatically by CC3Scene near the beginning of each frame drawing
+ * cycle. Usually, the application never needs to invoke this method directly.
+ */
+-(void) binLights: (CCArray*) lights;
+
+/**
+ * Populates the specified array with the binned lights that most strongly illuminate the
+ * specified node, ordered from most to least influential, and returns the number of lights
+ * selected. No more than maximumLightsPerNode lights will be selected.
+ *
+ * The node is represented by the sphere of its bounding volume, or by its global location
+ * if it has no spherical bounding volume.
+ *
+ * This method is invoked automatically by CC3NodeDrawingVisitor as each node is drawn.
+ * Usually, the application never needs to invoke this method directly.
+ */
+-(GLuint) selectLights: (CC3Light**) selectedLights forNode: (CC3Node*) aNode;
+
+/** Allocates and initializes an autoreleased instance. */
++(id) lightGrid;
+
+@end
+
+
 #pragma mark -
 #pragma mark CC3ShadowProtocol
 
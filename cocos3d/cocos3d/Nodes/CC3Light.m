@@ -32,6 +32,7 @@
 #import "CC3Light.h"
 #import "CC3Camera.h"
 #import "CC3ShadowVolumes.h"
+#import "CC3BoundingVolumes.h"
 #import "CC3Scene.h"
 #import "CC3OpenGLESEngine.h"
 #import "CC3CC2Extensions.h"
@@ -357,6 +358,23 @@
 }
 
 
+#pragma mark Light selection
+
+-(GLfloat) rangeForIntensityThreshold: (GLfloat) threshold {
+	if (isDirectionalOnly) return INFINITY;
+
+	CC3AttenuationCoefficients ac = CC3AttenuationCoefficientsLegalize(_attenuation);
+	if (ac.b == 0.0f && ac.c == 0.0f) return INFINITY;
+
+	// Solve a + b*r + c*r*r = brightness / threshold for the positive root r
+	GLfloat brightness = MAX(MAX(diffuseColor.r, diffuseColor.g), diffuseColor.b);
+	GLfloat k = ac.a - (brightness / MAX(threshold, FLT_EPSILON));
+	if (k >= 0.0f) return 0.0f;
+	if (ac.c == 0.0f) return -k / ac.b;
+	return (-ac.b + sqrtf((ac.b * ac.b) - (4.0f * ac.c * k))) / (2.0f * ac.c);
+}
+
+
 #pragma mark Shadows
 
 -(BOOL) shouldCastShadowsWhenInvisible { return shouldCastShadowsWhenInvisible; }
@@ -578,7 +596,9 @@
 // When a new instance is instantiated, it's lightIndex property is assigned from the pool
 // of indexes. When the instance is deallocated, its index is returned to the pool for use
 // by any subsequently instantiated lights.
-static BOOL _lightIndexPool[32] = {NO};
+// The pool is large enough to allow a scene to hold many lights when using a CC3LightGrid.
+#define kCC3LightIndexPoolSize	256
+static BOOL _lightIndexPool[kCC3LightIndexPoolSize] = {NO};
 
 +(BOOL*) lightIndexPool { return _lightIndexPool; }
 
@@ -591,7 +611,7 @@ static GLuint lightPoolStartIndex = 0;
  */
 -(GLuint) nextLightIndex {
 	BOOL* indexPool = [[self class] lightIndexPool];
-	GLint platformMaxLights = [CC3OpenGLESEngine engine].platform.maxLights.value;
+	GLint platformMaxLights = MIN([CC3OpenGLESEngine engine].platform.maxLights.value, kCC3LightIndexPoolSize);
 	for (int lgtIdx = lightPoolStartIndex; lgtIdx < platformMaxLights; lgtIdx++) {
 		if (!indexPool[lgtIdx]) {
 			LogTrace(@"Allocating light index %u", lgtIdx);
@@ -614,7 +634,7 @@ static GLuint lightPoolStartIndex = 0;
 +(GLuint) lightCount {
 	GLuint count = 0;
 	BOOL* indexPool = [self lightIndexPool];
-	GLint platformMaxLights = [CC3OpenGLESEngine engine].platform.maxLights.value;
+	GLint platformMaxLights = MIN([CC3OpenGLESEngine engine].platform.maxLights.value, kCC3LightIndexPoolSize);
 	for (int i = lightPoolStartIndex; i < platformMaxLights; i++) {
 		if (indexPool[i]) {
 			count++;
@@ -640,6 +660,217 @@ static GLuint lightPoolStartIndex = 0;
 @end
 
 
+#pragma mark -
+#pragma mark CC3LightGrid
+
+/** The number of hash buckets holding the cells of the grid. Must be a power of two. */
+#define kCC3LightGridBucketCount		256
+
+/** Lights whose influence covers more than this number of cells are applied to all nodes. */
+#define kCC3LightGridMaxCellsPerLight	64
+
+/** Returns the index of the grid cell containing the specified coordinate. */
+static inline GLint CC3LightGridCellIndex(GLfloat coord, GLfloat cellSize) {
+	return (GLint)floorf(coord / cellSize);
+}
+
+/** Returns the index of the hash bucket holding the grid cell at the specified indices. */
+static inline GLuint CC3LightGridBucketIndex(GLint x, GLint y, GLint z) {
+	return (((GLuint)x * 73856093u) ^ ((GLuint)y * 19349663u) ^ ((GLuint)z * 83492791u))
+			& (kCC3LightGridBucketCount - 1);
+}
+
+@implementation CC3LightGrid
+
+@synthesize cellSize=_cellSize, influenceThreshold=_influenceThreshold;
+@synthesize maximumLightsPerNode=_maximumLightsPerNode;
+
+-(void) dealloc {
+	for (GLuint i = 0; i < _cellBucketCount; i++) [_cells[i] release];
+	free(_cells);
+	[_globalLights release];
+	[super dealloc];
+}
+
+-(void) setCellSize: (GLfloat) cellSize { _cellSize = MAX(cellSize, FLT_EPSILON); }
+
+-(void) setMaximumLightsPerNode: (GLuint) maxLights {
+	_maximumLightsPerNode = MIN(maxLights, kCC3MaxSelectedLights);
+}
+
+
+#pragma mark Allocation and initialization
+
+-(id) init {
+	if ( (self = [super init]) ) {
+		_globalLights = [[CCArray array] retain];
+		_cellBucketCount = kCC3LightGridBucketCount;
+		_cells = calloc(_cellBucketCount, sizeof(CCArray*));
+		for (GLuint i = 0; i < _cellBucketCount; i++) _cells[i] = [[CCArray array] retain];
+		_cellSize = kCC3DefaultLightGridCellSize;
+		_influenceThreshold = kCC3DefaultLightInfluenceThreshold;
+		_maximumLightsPerNode = kCC3MaxSelectedLights;
+	}
+	return self;
+}
+
++(id) lightGrid { return [[[self alloc] init] autorelease]; }
+
+-(NSString*) description {
+	return [NSString stringWithFormat: @"%@ with cell size %.3f, selecting up to %u lights per node",
+			[self class], _cellSize, _maximumLightsPerNode];
+}
+
+
+#pragma mark Binning lights
+
+-(void) binLights: (CCArray*) lights {
+	[_globalLights removeAllObjects];
+	for (GLuint i = 0; i < _cellBucketCount; i++) [_cells[i] removeAllObjects];
+
+	for (CC3Light* lgt in lights) {
+		if ( !lgt.visible ) continue;
+
+		GLfloat range = [lgt rangeForIntensityThreshold: _influenceThreshold];
+		if (range <= 0.0f) continue;
+
+		// Lights with unbounded or very large influence are applied to all nodes
+		if (isinf(range) || (range * 2.0f / _cellSize) >= kCC3LightGridMaxCellsPerLight) {
+			[_globalLights addObject: lgt];
+			continue;
+		}
+
+		CC3Vector loc = lgt.globalLocation;
+		GLint minX = CC3LightGridCellIndex(loc.x - range, _cellSize);
+		GLint maxX = CC3LightGridCellIndex(loc.x + range, _cellSize);
+		GLint minY = CC3LightGridCellIndex(loc.y - range, _cellSize);
+		GLint maxY = CC3LightGridCellIndex(loc.y + range, _cellSize);
+		GLint minZ = CC3LightGridCellIndex(loc.z - range, _cellSize);
+		GLint maxZ = CC3LightGridCellIndex(loc.z + range, _cellSize);
+		GLuint cellCnt = (maxX - minX + 1) * (maxY - minY + 1) * (maxZ - minZ + 1);
+		if (cellCnt > kCC3LightGridMaxCellsPerLight) {
+			[_globalLights addObject: lgt];
+			continue;
+		}
+
+		for (GLint x = minX; x <= maxX; x++)
+			for (GLint y = minY; y <= maxY; y++)
+				for (GLint z = minZ; z <= maxZ; z++) {
+					CCArray* cell = _cells[CC3LightGridBucketIndex(x, y, z)];
+					if (cell.lastObject != lgt) [cell addObject: lgt];
+				}
+	}
+	LogTrace(@"%@ binned %u lights, of which %u influence all nodes",
+			 self, (GLuint)lights.count, (GLuint)_globalLights.count);
+}
+
+
+#pragma mark Selecting lights
+
+/**
+ * Returns the intensity of the specified light at the surface of the sphere with the
+ * specified center and radius, or zero if the light does not illuminate the sphere.
+ */
+-(GLfloat) influenceOf: (CC3Light*) aLight onSphereAt: (CC3Vector) center withRadius: (GLfloat) radius {
+	if ( !aLight.visible ) return 0.0f;
+
+	ccColor4F diffuse = aLight.diffuseColor;
+	GLfloat brightness = MAX(MAX(diffuse.r, diffuse.g), diffuse.b);
+	if (aLight.isDirectionalOnly) return brightness;
+
+	CC3AttenuationCoefficients ac = CC3AttenuationCoefficientsLegalize(aLight.attenuation);
+	GLfloat dist = MAX(CC3VectorDistance(aLight.globalLocation, center) - radius, 0.0f);
+	GLfloat atten = ac.a + (ac.b * dist) + (ac.c * dist * dist);
+	return (atten > 0.0f) ? (brightness / atten) : brightness;
+}
+
+/**
+ * Inserts the specified light into the specified selection, which is ordered by decreasing
+ * influence, unless the light is already selected, or is less influential than the lights
+ * already in a full selection. Returns the new number of selected lights.
+ */
+-(GLuint) insertLight: (CC3Light*) aLight
+		withInfluence: (GLfloat) influence
+		  intoLights: (CC3Light**) selectedLights
+		withInfluences: (GLfloat*) influences
+			 ofCount: (GLuint) selCnt {
+	if (influence < _influenceThreshold) return selCnt;
+	for (GLuint i = 0; i < selCnt; i++) if (selectedLights[i] == aLight) return selCnt;
+
+	GLuint insIdx = selCnt;
+	while (insIdx > 0 && influences[insIdx - 1] < influence) insIdx--;
+	if (insIdx >= _maximumLightsPerNode) return selCnt;
+
+	GLuint lastIdx = MIN(selCnt, _maximumLightsPerNode - 1);
+	for (GLuint i = lastIdx; i > insIdx; i--) {
+		selectedLights[i] = selectedLights[i - 1];
+		influences[i] = influences[i - 1];
+	}
+	selectedLights[insIdx] = aLight;
+	influences[insIdx] = influence;
+	return lastIdx + 1;
+}
+
+/** Returns the spherical bounding volume of the specified node, or nil if it does not have one. */
+-(CC3NodeSphericalBoundingVolume*) sphericalBoundingVolumeOf: (CC3Node*) aNode {
+	CC3NodeBoundingVolume* bv = aNode.boundingVolume;
+	if ([bv isKindOfClass: [CC3NodeSphericalBoundingVolume class]])
+		return (CC3NodeSphericalBoundingVolume*)bv;
+	if ([bv isKindOfClass: [CC3NodeSphereThenBoxBoundingVolume class]])
+		return ((CC3NodeSphereThenBoxBoundingVolume*)bv).sphericalBoundingVolume;
+	return nil;
+}
+
+-(GLuint) selectLights: (CC3Light**) selectedLights forNode: (CC3Node*) aNode {
+	CC3NodeSphericalBoundingVolume* sbv = [self sphericalBoundingVolumeOf: aNode];
+	CC3Vector center = sbv ? sbv.globalCenterOfGeometry : aNode.globalLocation;
+	GLfloat radius = sbv ? sbv.globalRadius : 0.0f;
+
+	GLfloat influences[kCC3MaxSelectedLights];
+	GLuint selCnt = 0;
+
+	for (CC3Light* lgt in _globalLights)
+		selCnt = [self insertLight: lgt
+					 withInfluence: [self influenceOf: lgt onSphereAt: center withRadius: radius]
+						intoLights: selectedLights
+					withInfluences: influences
+						   ofCount: selCnt];
+
+	GLint minX = CC3LightGridCellIndex(center.x - radius, _cellSize);
+	GLint maxX = CC3LightGridCellIndex(center.x + radius, _cellSize);
+	GLint minY = CC3LightGridCellIndex(center.y - radius, _cellSize);
+	GLint maxY = CC3LightGridCellIndex(center.y + radius, _cellSize);
+	GLint minZ = CC3LightGridCellIndex(center.z - radius, _cellSize);
+	GLint maxZ = CC3LightGridCellIndex(center.z + radius, _cellSize);
+	GLfloat cellCnt = (GLfloat)(maxX - minX + 1) * (GLfloat)(maxY - minY + 1) * (GLfloat)(maxZ - minZ + 1);
+
+	// If the node covers more cells than there are buckets, examine every bucket once instead
+	if (cellCnt > _cellBucketCount) {
+		for (GLuint bktIdx = 0; bktIdx < _cellBucketCount; bktIdx++)
+			for (CC3Light* lgt in _cells[bktIdx])
+				selCnt = [self insertLight: lgt
+							 withInfluence: [self influenceOf: lgt onSphereAt: center withRadius: radius]
+								intoLights: selectedLights
+							withInfluences: influences
+								   ofCount: selCnt];
+	} else {
+		for (GLint x = minX; x <= maxX; x++)
+			for (GLint y = minY; y <= maxY; y++)
+				for (GLint z = minZ; z <= maxZ; z++)
+					for (CC3Light* lgt in _cells[CC3LightGridBucketIndex(x, y, z)])
+						selCnt = [self insertLight: lgt
+									 withInfluence: [self influenceOf: lgt onSphereAt: center withRadius: radius]
+										intoLights: selectedLights
+									withInfluences: influences
+										   ofCount: selCnt];
+	}
+	LogTrace(@"%@ selected %u lights for %@", self, selCnt, aNode);
+	return selCnt;
+}
+
+@end
+
+
 #pragma mark -
 #pragma mark CC3LightCameraBridgeVolume
 
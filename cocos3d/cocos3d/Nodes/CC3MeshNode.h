@@ -33,6 +33,8 @@
 #import "CC3Mesh.h"
 #import "CC3Material.h"
 
+@class CC3MeshInstancingNode, CC3StaticBatchNode, CC3Camera;
+
 
 #pragma mark -
 #pragma mark CC3MeshNode
@@ -98,6 +100,8 @@
 @interface CC3MeshNode : CC3LocalContentNode {
 	CC3Mesh* mesh;
 	CC3Material* material;
+	CC3MeshInstancingNode* instancingNode;
+	CC3StaticBatchNode* staticBatchNode;
 	ccColor4F pureColor;
 	GLenum depthFunction;
 	GLfloat decalOffsetFactor;
@@ -738,6 +742,16 @@
  */
 @property(nonatomic, readonly) BOOL isDrawingPointSprites;
 
+/**
+ * Returns whether the vertex shader is expected to orient the vertices of this mesh node to
+ * face the camera, as billboards. A shader program matcher uses this property to select a
+ * shader program that performs that orientation.
+ *
+ * This implementation returns NO. Subclasses, such as CC3BillboardCloud, that hand the
+ * orientation of their billboards off to the vertex shader will override.
+ */
+@property(nonatomic, readonly) BOOL isDrawingShaderAlignedBillboards;
+
 /**
  * Returns whether the RGB components of each pixel of the encapsulated textures
  * have had the corresponding alpha component applied already.
@@ -1726,6 +1740,459 @@ globalIntersections: (CC3MeshIntersection*) intersections
  */
 -(void) drawWithVisitor: (CC3NodeDrawingVisitor*) visitor;
 
+/**
+ * Returns the screen size of this node, as seen by the specified camera. This is the ratio
+ * of the projected diameter of the bounding sphere of the mesh, as transformed by this node,
+ * to the height of the view of the camera. Returns kCC3MaxGLfloat if the camera is inside
+ * the bounding sphere, and zero if this node has no mesh.
+ *
+ * For a CC3LODMeshNode, the bounding sphere is that of the full-detail mesh.
+ *
+ * The transform of this node must be up to date before this method is invoked.
+ */
+-(GLfloat) screenSizeFromCamera: (CC3Camera*) aCamera;
+
+/**
+ * If this node has been added as an instance to a CC3MeshInstancingNode, this property
+ * references that instancing node. Otherwise, this property returns nil.
+ *
+ * While this property is set, the instancing node draws this node as part of its batch,
+ * and this node does not draw itself, except when drawn by a visitor that does not decorate
+ * nodes, such as during node picking, in which case this node draws itself individually.
+ *
+ * This property is set automatically when this node is added to, or removed from, a
+ * CC3MeshInstancingNode, and is cleared automatically when this node is removed from the
+ * scene. The application should not set this property directly.
+ */
+@property(nonatomic, assign) CC3MeshInstancingNode* instancingNode;
+
+/**
+ * If the mesh of this node has been merged into a CC3StaticBatchNode, this property
+ * references that batch node. Otherwise, this property returns nil.
+ *
+ * While this property is set, the batch node draws the mesh of this node, and this node does
+ * not draw itself, except when drawn by a visitor that does not decorate nodes, such as during
+ * node picking, in which case this node draws itself individually.
+ *
+ * This property is set automatically when this node is merged into a CC3StaticBatchNode,
+ * and is cleared automatically when this node is removed from the scene. The application
+ * should not set this property directly.
+ */
+@property(nonatomic, assign) CC3StaticBatchNode* staticBatchNode;
+
+@end
+
+
+#pragma mark -
+#pragma mark CC3MeshInstancingNode
+
+/**
+ * CC3MeshInstancingNode draws many CC3MeshNodes that share the same mesh and material in a
+ * single draw call, replacing the per-node draw call, uniform updates, and matrix upload that
+ * would otherwise be made when each of those mesh nodes draws itself.
+ *
+ * Each mesh node added to this node via the addInstance: method is an instance. The first
+ * instance added establishes the instanceMesh and material shared by all of the instances.
+ * The material is shared by reference with the instances, so that changes to the material
+ * of any instance are reflected in the batch.
+ *
+ * When drawn, this node gathers the global transform of each instance into the array of
+ * CC3Matrix4x3 in the instanceTransforms property, expressed relative to the transform of this
+ * node. OpenGL ES 1.1 and OpenGL ES 2.0 do not provide instanced drawing, so this node uses
+ * that per-instance transform stream to pre-transform a copy of the vertex locations and normals
+ * of the instanceMesh, into a single batched mesh held in the mesh property of this node. The
+ * vertices of each instance are re-transformed, and re-copied to the GL buffers, only when
+ * the transform of that instance has changed since it was last drawn. All other vertex content,
+ * including texture coordinates and colors, is copied to the batched mesh once.
+ *
+ * Instances that are not visible are not drawn. If the shouldCullInstances property is set to
+ * YES, instances that lie outside the camera frustum are not drawn either. Because the batched vertices of each instance are
+ * recalculated when it moves, you can freely move, rotate and scale individual instances.
+ *
+ * The instances need not be children of this node, and typically remain in their original
+ * positions in the node structural hierarchy, where they continue to be updated and animated
+ * as usual. Each instance does not draw itself while it is part of this batch. Node picking
+ * draws each instance individually, so that instances remain individually pickable.
+ *
+ * When an instance, or one of its ancestors, is removed from the scene, the instance is removed
+ * from this node automatically, so that it is no longer drawn in the batch. If the instance is
+ * later added back to the scene, it draws itself individually, unless it is added to this node
+ * again using the addInstance: method.
+ *
+ * The easiest way to create instancing nodes is to invoke the instanceMeshNodesRepeatedAtLeast:
+ * method on the node structure that contains the repeated mesh nodes. You can also create
+ * instances of this class directly, and add instances using the addInstance: method.
+ *
+ * The vertex locations and normals of the instanceMesh must remain in application memory, so
+ * if you intend to release the vertex content of the meshes, by invoking releaseRedundantContent,
+ * you should add the mesh nodes to instancing nodes before doing so. The instanceMesh must use
+ * GL_FLOAT vertex locations and normals, must not be skinned, and must be drawn with one of the
+ * GL_TRIANGLES, GL_LINES or GL_POINTS drawing modes, so that the vertices of successive instances
+ * can be concatenated into a single mesh. See the canAddInstance: method for more info.
+ *
+ * The transform of each instance is read when this node is drawn. Because of this, if the scene
+ * is drawn from a frame packet on a background thread, an instance moved while the frame is being
+ * drawn may be drawn in either its old or new position.
+ */
+@interface CC3MeshInstancingNode : CC3MeshNode {
+	CCArray* _instances;
+	CC3Mesh* _instanceMesh;
+	CC3Matrix4x3* _instanceTransforms;
+	CC3MeshNode** _drawnInstances;
+	GLuint _instanceSlotCapacity;
+	GLuint _drawnInstanceCount;
+	BOOL _isBatchMeshDirty : 1;
+	BOOL _shouldCullInstances : 1;
+}
+
+/**
+ * The mesh drawn by each instance.
+ *
+ * This property is set automatically from the mesh of the first instance added to this node.
+ * It is distinct from the mesh property of this node, which holds the batched vertices of all
+ * of the instances, and which is built automatically from this mesh.
+ */
+@property(nonatomic, retain, readonly) CC3Mesh* instanceMesh;
+
+/** The CC3MeshNodes that have been added to this node as instances. */
+@property(nonatomic, retain, readonly) CCArray* instances;
+
+/** The number of instances that have been added to this node. */
+@property(nonatomic, readonly) GLuint instanceCount;
+
+/**
+ * The maximum number of instances that can be added to this node.
+ *
+ * The vertices of all instances are concatenated into a single mesh that is indexed with
+ * 16-bit vertex indices, so the number of instances is limited by the number of vertices
+ * in the instanceMesh. If the instanceMesh has not yet been established, returns zero.
+ */
+@property(nonatomic, readonly) GLuint maximumInstanceCount;
+
+/**
+ * The per-instance transform stream, as an array of CC3Matrix4x3, containing drawnInstanceCount
+ * elements. Each element holds the transform of an instance that was drawn during the most recent
+ * drawing pass, expressed relative to the global transform of this node.
+ */
+@property(nonatomic, readonly) CC3Matrix4x3* instanceTransforms;
+
+/**
+ * The number of instances that were drawn during the most recent drawing pass.
+ *
+ * If the shouldCullInstances property is YES, this may be fewer than the value of the
+ * instanceCount property.
+ */
+@property(nonatomic, readonly) GLuint drawnInstanceCount;
+
+/**
+ * Indicates whether each instance should be tested for intersection with the camera frustum
+ * before it is drawn, and only drawn if it is within the frustum. Instances that are not
+ * visible are never drawn, regardless of the value of this property.
+ *
+ * When this property is set to YES, this node is always considered to intersect the camera frustum,
+ * because the instances may be spread across the scene, and are culled individually.
+ *
+ * The initial value of this property is YES.
+ */
+@property(nonatomic, assign) BOOL shouldCullInstances;
+
+/**
+ * Returns whether the specified mesh node can be added to this node as an instance.
+ *
+ * Returns YES if the specified node is a CC3MeshNode that is not already an instance of this or
+ * another instancing node, and, if the instanceMesh has already been established, has the same
+ * mesh, material, pureColor and face culling configuration as the first instance, and this node
+ * has not reached maximumInstanceCount. Since all instances are drawn together, using the settings
+ * taken from the first instance, nodes whose settings differ are not accepted.
+ *
+ * If the instanceMesh has not been established yet, the mesh of the specified node must have
+ * vertex locations of type GL_FLOAT with three components, whose content is still held in
+ * application memory. If it has vertex normals, they must also be of type GL_FLOAT, and held
+ * in memory. The mesh must not contain vertex weights or more than one set of texture coordinates,
+ * and must be drawn with one of the GL_TRIANGLES, GL_LINES or GL_POINTS drawing modes.
+ */
+-(BOOL) canAddInstance: (CC3MeshNode*) aNode;
+
+/**
+ * Adds the specified mesh node as an instance to be drawn by this node, if it can be added,
+ * as determined by the canAddInstance: method, and returns whether the node was added.
+ *
+ * If this is the first instance to be added, the mesh of the specified node becomes the
+ * instanceMesh, and the material of the specified node becomes the material of this node.
+ *
+ * The batched mesh of this node is rebuilt automatically the next time this node is drawn.
+ */
+-(BOOL) addInstance: (CC3MeshNode*) aNode;
+
+/**
+ * Removes the specified mesh node as an instance of this node. The specified node will once
+ * again draw itself. If the specified node is not an instance of this node, does nothing.
+ *
+ * This method is invoked automatically when an instance is removed from the scene.
+ *
+ * The batched mesh of this node is rebuilt automatically the next time this node is drawn.
+ */
+-(void) removeInstance: (CC3MeshNode*) aNode;
+
+/** Removes all instances from this node. Each of the removed nodes will once again draw itself. */
+-(void) removeAllInstances;
+
+@end
+
+
+#pragma mark -
+#pragma mark CC3StaticBatchNode
+
+/**
+ * Describes the range of vertex indices within the merged mesh of a CC3StaticBatchNode
+ * that holds the vertices of one source CC3MeshNode, along with the bounds of that range.
+ */
+typedef struct {
+	GLuint start;					/**< The first vertex index of the range within the merged mesh. */
+	GLuint count;					/**< The number of vertex indices in the range. */
+	CC3BoundingBox boundingBox;		/**< The bounds of the range, in the local coordinates of the batch node. */
+	CC3MeshNode* sourceNode;		/**< The mesh node whose vertices occupy the range, or nil if it has been removed. Not retained. */
+} CC3StaticBatchRange;
+
+/**
+ * CC3StaticBatchNode merges the meshes of many static CC3MeshNodes that share the same material
+ * into a single interleaved mesh, so that they can all be drawn with far fewer draw calls.
+ *
+ * Mesh nodes are added as sources with the addSourceNode: method, and are then merged together
+ * by invoking the mergeSourceNodes method. During merging, the vertices of each source mesh are
+ * transformed by the global transform of the source node, relative to the global transform of
+ * this node, and are appended to the merged mesh, along with vertex indices offset accordingly.
+ * This is a one-time cost, and the duration of the merge is available in the mergeDuration
+ * property, and is logged as info. Because the vertices are transformed only once, the source
+ * nodes must be static. Subsequent movement of the source nodes is not reflected in the batch.
+ *
+ * The range of vertex indices occupied by each source node within the merged mesh, together with
+ * the bounding box of that range, is retained in the ranges property. If the shouldCullRanges
+ * property is set to YES, each range is tested against the camera frustum, and against the
+ * visibility of its source node, before drawing, and contiguous runs of ranges that pass these
+ * tests are drawn with a single draw call each. In the best case, when all ranges are visible,
+ * the entire batch is drawn with one draw call.
+ *
+ * The source nodes remain in their original positions in the node structural hierarchy, but do
+ * not draw themselves while they are merged into this batch. When a source node is removed from
+ * the scene, it is also removed from this batch, using the removeSourceNode: method, and its range
+ * within the merged mesh is no longer drawn. Node picking draws each source node
+ * individually, so that source nodes remain individually pickable. Source nodes therefore retain
+ * their own meshes. If picking is not needed, you can free the memory used by the source meshes.
+ *
+ * The easiest way to create static batch nodes is to invoke the mergeStaticMeshNodes method on
+ * the node structure that contains the static mesh nodes, such as a CC3PODResourceNode containing
+ * level geometry. That method groups the mesh nodes by material, and creates a static batch node
+ * for each group.
+ *
+ * All source meshes must hold their vertex content in application memory when merged. If you
+ * intend to release the vertex content of the meshes, by invoking releaseRedundantContent,
+ * you should merge the mesh nodes before doing so. See the canAddSourceNode: method for the
+ * other requirements that must be met by each source mesh.
+ */
+@interface CC3StaticBatchNode : CC3MeshNode {
+	CCArray* _sourceNodes;
+	CC3StaticBatchRange* _ranges;
+	CC3Sphere* _rangeSpheres;
+	GLubyte* _rangePlaneHints;
+	GLuint* _rangeVisibility;
+	GLuint _rangeCount;
+	GLuint _sourceVertexCount;
+	GLuint _drawnRangeCount;
+	GLuint _drawCallCount;
+	NSTimeInterval _mergeDuration;
+	BOOL _shouldCullRanges : 1;
+	BOOL _hasRemovedRanges : 1;
+}
+
+/** The CC3MeshNodes whose meshes have been, or will be, merged into this node. */
+@property(nonatomic, retain, readonly) CCArray* sourceNodes;
+
+/**
+ * Returns an array of CC3StaticBatchRange structures, one for each source node, describing
+ * where the vertex indices of each source node lie within the merged mesh. The number of
+ * elements in this array is available from the rangeCount property.
+ *
+ * This array is populated by the mergeSourceNodes method.
+ */
+@property(nonatomic, readonly) CC3StaticBatchRange* ranges;
+
+/** The number of elements in the ranges array. */
+@property(nonatomic, readonly) GLuint rangeCount;
+
+/**
+ * Indicates whether each range should be tested against the camera frustum, and against the
+ * visibility of its source node, before it is drawn.
+ *
+ * Regardless of the value of this property, the ranges of source nodes that have been removed
+ * using the removeSourceNode: method are not drawn.
+ *
+ * The initial value of this property is YES.
+ */
+@property(nonatomic, assign) BOOL shouldCullRanges;
+
+/** The number of ranges drawn during the most recent drawing pass. */
+@property(nonatomic, readonly) GLuint drawnRangeCount;
+
+/** The number of GL draw calls made by this node during the most recent drawing pass. */
+@property(nonatomic, readonly) GLuint drawCallCount;
+
+/** The time, in seconds, that the mergeSourceNodes method took to merge the source meshes. */
+@property(nonatomic, readonly) NSTimeInterval mergeDuration;
+
+/**
+ * Returns whether the specified mesh node can be merged into this node.
+ *
+ * Returns YES if the specified node is a CC3MeshNode that has not already been merged into a
+ * batch, and is not a CC3MeshInstancingNode or an instance of one. Its mesh must have vertex
+ * locations of type GL_FLOAT with three components, whose content is still held in application
+ * memory, and any vertex normals, tangents and bitangents must also be of type GL_FLOAT. The mesh
+ * must not contain vertex weights or more than one set of texture coordinates, must be drawn with
+ * one of the GL_TRIANGLES, GL_LINES or GL_POINTS drawing modes, and must not use GL_DYNAMIC_DRAW
+ * vertex locations, which indicate content that changes over time, such as a particle system.
+ *
+ * If this node already has source nodes, the specified node must also have the same material,
+ * vertex content types, drawing mode and face culling configuration as the first source node,
+ * and adding its vertices must not raise the total number of vertices in this node above the
+ * number that can be addressed using 16-bit vertex indices.
+ */
+-(BOOL) canAddSourceNode: (CC3MeshNode*) aNode;
+
+/**
+ * Adds the specified mesh node as a source for this node, if it can be added, as determined
+ * by the canAddSourceNode: method, and returns whether the node was added.
+ *
+ * If this is the first source node to be added, the material of the specified node becomes
+ * the material of this node, and is shared by reference with the source nodes.
+ *
+ * The mesh of the source node is not merged until the mergeSourceNodes method is invoked.
+ */
+-(BOOL) addSourceNode: (CC3MeshNode*) aNode;
+
+/**
+ * Removes the specified mesh node as a source for this node, and clears its staticBatchNode
+ * property. If the mesh of the node has already been merged, the range of the node within the
+ * merged mesh is no longer drawn. Its vertices remain in the merged mesh until the
+ * mergeSourceNodes method is invoked again.
+ *
+ * This method is invoked automatically when a source node is removed from the scene.
+ * Does nothing if the specified node is not a source node of this node.
+ */
+-(void) removeSourceNode: (CC3MeshNode*) aNode;
+
+/**
+ * Merges the meshes of the source nodes into a single interleaved mesh, which is set into
+ * the mesh property of this node, and populates the ranges property. Any previously merged
+ * mesh is replaced.
+ *
+ * The global transforms of this node and the source nodes must be up to date when this method
+ * is invoked. You can ensure this by invoking the updateTransformMatrices method on the common
+ * ancestor of this node and the source nodes before invoking this method.
+ *
+ * If the mesh of the first source node is using GL buffers, GL buffers are also created for the
+ * merged mesh. The time taken by this method is recorded in the mergeDuration property.
+ */
+-(void) mergeSourceNodes;
+
+@end
+
+
+#pragma mark -
+#pragma mark CC3LODMeshNode
+
+/** The default value of the levelOfDetailHysteresis property of a CC3LODMeshNode. */
+#define kCC3DefaultLevelOfDetailHysteresis		0.1f
+
+/**
+ * CC3LODMeshNode is a mesh node that holds several versions of its mesh, each at a different
+ * level of detail, and draws only one of them in each frame, based on how large this node
+ * appears on the screen.
+ *
+ * The mesh property holds the full-detail mesh, which is level zero, and is the mesh used for
+ * bounding volumes, face access and ray intersections. Progressively coarser meshes are added
+ * with the addLevelOfDetailMesh:forScreenSizeBelow: method, each with the screen size below
+ * which it should be drawn. The coarser meshes may be authored, or generated by simplifying
+ * the full-detail mesh. All levels share the material of this node, and each coarser mesh
+ * should have the same vertex content types as the full-detail mesh, and should lie within
+ * its bounds.
+ *
+ * Each time this node is drawn, its screen size is estimated from the bounding sphere of the
+ * full-detail mesh, as transformed by this node, and the camera of the drawing visitor. The
+ * screen size is the ratio of the projected diameter of the bounding sphere to the height of
+ * the view. To keep this node from flickering between two levels when its screen size hovers
+ * near the threshold between them, a level only changes once the screen size has moved beyond
+ * the threshold by the proportion indicated by the levelOfDetailHysteresis property.
+ *
+ * Each time a coarser level is drawn, the number of faces saved, relative to the full-detail
+ * mesh, is added to the facesSavedByLevelOfDetail property of the CC3PerformanceStatistics
+ * of the scene, if it has one.
+ */
+@interface CC3LODMeshNode : CC3MeshNode {
+	CCArray* _levelOfDetailMeshes;
+	GLfloat* _levelOfDetailScreenSizes;
+	GLfloat _levelOfDetailHysteresis;
+	GLfloat _screenSize;
+	GLuint _currentLevelOfDetail;
+}
+
+/**
+ * The number of levels of detail held by this node, including the full-detail mesh in the
+ * mesh property. Returns zero if this node has no mesh.
+ */
+@property(nonatomic, readonly) GLuint levelOfDetailCount;
+
+/**
+ * Returns the mesh at the specified level of detail. Level zero is the full-detail mesh in
+ * the mesh property, and each successive level is coarser than the one before it.
+ */
+-(CC3Mesh*) meshAtLevelOfDetail: (GLuint) lodIndex;
+
+/**
+ * Returns the screen size below which the mesh at the specified level of detail is drawn.
+ * Since the full-detail mesh is drawn at all larger screen sizes, this method returns
+ * kCC3MaxGLfloat for level zero.
+ */
+-(GLfloat) screenSizeAtLevelOfDetail: (GLuint) lodIndex;
+
+/**
+ * Adds the specified mesh as the next coarser level of detail, to be drawn when the screen size
+ * of this node falls below the specified value, which is the ratio of the projected diameter of
+ * the bounding sphere of this node to the height of the view.
+ *
+ * Levels must be added from finest to coarsest, and the specified screen size must be smaller
+ * than the screen size of the previously added level.
+ */
+-(void) addLevelOfDetailMesh: (CC3Mesh*) aMesh forScreenSizeBelow: (GLfloat) screenSize;
+
+/** Removes all levels of detail other than the full-detail mesh in the mesh property. */
+-(void) removeAllLevelsOfDetail;
+
+/**
+ * The proportion by which the screen size of this node must move beyond the threshold between
+ * two levels of detail before the level drawn is changed. A value of 0.1 means that the screen
+ * size must fall 10% below the threshold before the coarser level is drawn, and must rise
+ * 10% above the threshold before the finer level is drawn again.
+ *
+ * The initial value of this property is kCC3DefaultLevelOfDetailHysteresis.
+ */
+@property(nonatomic, assign) GLfloat levelOfDetailHysteresis;
+
+/** The level of detail that was drawn during the most recent drawing pass. */
+@property(nonatomic, readonly) GLuint currentLevelOfDetail;
+
+/** The screen size of this node, as estimated during the most recent drawing pass. */
+@property(nonatomic, readonly) GLfloat screenSize;
+
+/**
+ * Selects the level of detail to draw for the specified screen size, taking into consideration
+ * the currently selected level and the levelOfDetailHysteresis property, and sets it into the
+ * currentLevelOfDetail property.
+ *
+ * This method is invoked automatically each time this node is drawn. Usually, the application
+ * never needs to invoke this method directly.
+ */
+-(void) selectLevelOfDetailForScreenSize: (GLfloat) screenSize;
+
 @end
 
 
@@ -1752,6 +2219,51 @@ globalIntersections: (CC3MeshIntersection*) intersections
  */
 -(CC3MeshNode*) getMeshNodeNamed: (NSString*) aName;
 
+/**
+ * Searches the descendants of this node for CC3MeshNodes that share the same mesh and material,
+ * and for each such group that contains at least the specified minimum number of mesh nodes,
+ * creates a CC3MeshInstancingNode, adds the mesh nodes of the group to it as instances, and adds
+ * the instancing node to this node as a child. Returns the instancing nodes that were added.
+ *
+ * If a group contains more mesh nodes than can be held by a single instancing node, as determined
+ * by the maximumInstanceCount property of the instancing node, more than one instancing node is
+ * created for that group.
+ *
+ * Mesh nodes that are already instances of a CC3MeshInstancingNode, or whose meshes cannot be
+ * instanced, as determined by the canAddInstance: method of CC3MeshInstancingNode, are ignored.
+ *
+ * Mesh nodes are matched by sharing the same CC3Mesh and CC3Material instances, and the same
+ * pureColor and face culling configuration. Copies of a node
+ * share the same mesh, but each copy is given its own copy of the material. To allow copies of
+ * a mesh node to be matched by this method, set the material of each copy to that of the original.
+ *
+ * Since the vertex content of the matched meshes must remain in application memory, this method
+ * should be invoked before the releaseRedundantContent method is invoked.
+ */
+-(CCArray*) instanceMeshNodesRepeatedAtLeast: (GLuint) minCount;
+
+/**
+ * Searches the descendants of this node for static CC3MeshNodes that share the same material,
+ * merges the meshes of each group of two or more such mesh nodes into a CC3StaticBatchNode,
+ * adds each static batch node to this node as a child, and returns the static batch nodes.
+ *
+ * If a group contains more vertices than can be addressed with 16-bit vertex indices, more
+ * than one static batch node is created for that group. Mesh nodes that cannot be merged,
+ * as determined by the canAddSourceNode: method of CC3StaticBatchNode, are ignored.
+ *
+ * Mesh nodes are matched by sharing the same CC3Material instance. Materials loaded from
+ * resource files are usually distinct instances for each mesh node, even if they are identical
+ * in content. To allow such mesh nodes to be merged, set their materials to a common instance.
+ *
+ * The meshes are merged using the current global transforms of the mesh nodes, so this method
+ * should be invoked only on node structures that will not move relative to this node afterwards.
+ * Since the vertex content of the merged meshes must be held in application memory, this method
+ * should be invoked before the releaseRedundantContent method is invoked.
+ *
+ * The total time taken to merge the meshes is logged as info.
+ */
+-(CCArray*) mergeStaticMeshNodes;
+
 @end
 
 
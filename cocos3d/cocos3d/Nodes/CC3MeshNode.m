@@ -34,6 +34,8 @@
 #import "CC3OpenGLESEngine.h"
 #import "CC3Mesh.h"
 #import "CC3Light.h"
+#import "CC3Scene.h"
+#import "CC3Camera.h"
 #import "CC3GLProgramMatchers.h"
 #import "CC3IOSExtensions.h"
 
@@ -53,6 +55,7 @@
 -(void) configureDecalParameters: (CC3NodeDrawingVisitor*) visitor;
 -(void) cleanupDrawingParameters: (CC3NodeDrawingVisitor*) visitor;
 -(void) configureLineProperties: (CC3NodeDrawingVisitor*) visitor;
+-(void) configureLighting: (CC3NodeDrawingVisitor*) visitor;
 -(void) configureMaterialWithVisitor: (CC3NodeDrawingVisitor*) visitor;
 -(void) drawMeshWithVisitor: (CC3NodeDrawingVisitor*) visitor;
 -(void) alignTextureUnit: (GLuint) texUnit;
@@ -71,7 +74,7 @@
 
 @implementation CC3MeshNode
 
-@synthesize mesh, material, pureColor;
+@synthesize mesh, material, pureColor, instancingNode, staticBatchNode;
 @synthesize lineWidth, shouldSmoothLines, lineSmoothingHint;
 
 -(void) dealloc {
@@ -535,6 +538,8 @@
 
 -(BOOL) isDrawingPointSprites { return (self.drawingMode == GL_POINTS) && (self.textureCount > 0); }
 
+-(BOOL) isDrawingShaderAlignedBillboards { return NO; }
+
 -(BOOL) hasPremultipliedAlpha { return material ? material.hasPremultipliedAlpha : NO; }
 
 -(BOOL) shouldApplyOpacityToColor { return material ? material.shouldApplyOpacityToColor : NO; }
@@ -717,6 +722,17 @@
 
 -(GLenum) drawingMode { return mesh ? mesh.drawingMode : GL_TRIANGLE_STRIP; }
 
+/**
+ * If this node is an instance of a CC3MeshInstancingNode, or has been merged into a
+ * CC3StaticBatchNode, it is drawn as part of that batch,
+ * unless the visitor does not decorate nodes (eg- during node picking), in which case each
+ * instance is drawn individually.
+ */
+-(void) transformAndDrawWithVisitor: (CC3NodeDrawingVisitor*) visitor {
+	if ((instancingNode || staticBatchNode) && visitor.shouldDecorateNode) return;
+	[super transformAndDrawWithVisitor: visitor];
+}
+
 -(void) setDrawingMode: (GLenum) aMode { mesh.drawingMode = aMode; }
 
 /**
@@ -733,6 +749,27 @@
 	[self cleanupDrawingParameters: visitor];
 }
 
+-(GLfloat) screenSizeFromCamera: (CC3Camera*) aCamera {
+	CC3BoundingBox bb = self.localContentBoundingBox;
+	if (CC3BoundingBoxIsNull(bb)) return 0.0f;
+
+	CC3Vector gs = self.globalScale;
+	GLfloat maxScale = MAX(MAX(ABS(gs.x), ABS(gs.y)), ABS(gs.z));
+	CC3Vector center = CC3BoundingBoxCenter(bb);
+	GLfloat radius = CC3VectorDistance(center, bb.maximum) * maxScale;
+
+	// Half the height of the view, at the distance of the bounding sphere.
+	CC3Frustum* frustum = aCamera.frustum;
+	GLfloat halfViewHeight = frustum.top;
+	if ( !frustum.isUsingParallelProjection ) {
+		GLfloat dist = CC3VectorDistance([self.transformMatrix transformLocation: center],
+										 aCamera.globalLocation);
+		if (dist <= radius) return kCC3MaxGLfloat;		// Camera is inside the bounding sphere
+		halfViewHeight *= dist / frustum.near;
+	}
+	return (halfViewHeight > 0.0f) ? (radius / halfViewHeight) : kCC3MaxGLfloat;
+}
+
 /**
  * Template method to configure the drawing parameters.
  *
@@ -745,6 +782,7 @@
 	[self configureDepthTesting: visitor];
 	[self configureDecalParameters: visitor];
 	[self configureLineProperties: visitor];
+	[self configureLighting: visitor];
 }
 
 /**
@@ -859,6 +897,28 @@
 	glesEngine.hints.lineSmooth.value = lineSmoothingHint;
 }
 
+#if CC3_OGLES_1
+/**
+ * Template method that, if the visitor has selected the lights that illuminate this node,
+ * turns on the selected lights in the GL engine, and turns off all other lights in the scene.
+ */
+-(void) configureLighting: (CC3NodeDrawingVisitor*) visitor {
+	if ( !visitor.isSelectingLights ) return;
+
+	GLuint selCnt = (GLuint)visitor.lightCount;
+	for (CC3Light* lgt in visitor.scene.lights) {
+		BOOL isSelected = NO;
+		for (GLuint i = 0; i < selCnt; i++) if ([visitor lightAt: i] == lgt) isSelected = YES;
+		if ( !isSelected ) [lgt turnOff];
+	}
+	for (GLuint i = 0; i < selCnt; i++) [[visitor lightAt: i] turnOn];
+}
+#endif
+#if CC3_OGLES_2
+/** Selected lights are passed to the shader program through the light scope uniforms. */
+-(void) configureLighting: (CC3NodeDrawingVisitor*) visitor {}
+#endif
+
 /**
  * Reverts any drawing parameters that were set in the configureDrawingParameters:
  * method that need to be cleaned up.
@@ -1207,6 +1267,804 @@ globalIntersections: (CC3MeshIntersection*) intersections
 @end
 
 
+#pragma mark -
+#pragma mark CC3MeshInstancingNode
+
+@interface CC3MeshInstancingNode (TemplateMethods)
+-(BOOL) canInstanceMesh: (CC3Mesh*) aMesh;
+-(void) buildBatchMesh;
+-(void) ensureInstanceSlotCapacity: (GLuint) slotCount;
+-(void) updateInstancesWithVisitor: (CC3NodeDrawingVisitor*) visitor;
+@end
+
+@implementation CC3MeshInstancingNode
+
+@synthesize instanceMesh=_instanceMesh, instances=_instances, instanceTransforms=_instanceTransforms;
+@synthesize drawnInstanceCount=_drawnInstanceCount, shouldCullInstances=_shouldCullInstances;
+
+-(void) dealloc {
+	[self removeAllInstances];
+	[_instances release];
+	[_instanceMesh release];
+	free(_instanceTransforms);
+	free(_drawnInstances);
+	[super dealloc];
+}
+
+-(GLuint) instanceCount { return (GLuint)_instances.count; }
+
+-(GLuint) maximumInstanceCount {
+	GLuint vtxCount = _instanceMesh.vertexCount;
+	return vtxCount ? (kCC3MaxGLushort + 1) / vtxCount : 0;
+}
+
+// Instances are culled individually, so the batch as a whole is not culled.
+-(BOOL) doesIntersectFrustum: (CC3Frustum*) aFrustum {
+	return _shouldCullInstances ? YES : [super doesIntersectFrustum: aFrustum];
+}
+
+
+#pragma mark Instances
+
+-(BOOL) canAddInstance: (CC3MeshNode*) aNode {
+	if ( !aNode.isMeshNode || aNode.instancingNode ) return NO;
+	if ([aNode isKindOfClass: [CC3MeshInstancingNode class]]) return NO;
+	if (_instanceMesh) return (aNode.mesh == _instanceMesh &&
+							   aNode.material == material &&
+							   CCC4FAreEqual(aNode.pureColor, pureColor) &&
+							   aNode.shouldCullBackFaces == shouldCullBackFaces &&
+							   aNode.shouldCullFrontFaces == shouldCullFrontFaces &&
+							   aNode.shouldUseClockwiseFrontFaceWinding == shouldUseClockwiseFrontFaceWinding &&
+							   self.instanceCount < self.maximumInstanceCount);
+	return [self canInstanceMesh: aNode.mesh];
+}
+
+/**
+ * Returns whether the vertices of the specified mesh can be pre-transformed and concatenated
+ * into a batched mesh. The vertex locations and normals must be floats held in memory, and the
+ * drawing mode must allow the vertices of successive instances to be appended to each other.
+ */
+-(BOOL) canInstanceMesh: (CC3Mesh*) aMesh {
+	CC3VertexLocations* vtxLocs = aMesh.vertexLocations;
+	if ( !vtxLocs.vertices || vtxLocs.elementType != GL_FLOAT || vtxLocs.elementSize != 3 ) return NO;
+
+	CC3VertexNormals* vtxNorms = aMesh.vertexNormals;
+	if ( vtxNorms && (!vtxNorms.vertices || vtxNorms.elementType != GL_FLOAT) ) return NO;
+
+	if (aMesh.hasVertexWeights || aMesh.textureCoordinatesArrayCount > 1) return NO;
+	if (aMesh.vertexCount == 0 || aMesh.vertexCount > kCC3MaxGLushort + 1) return NO;
+
+	switch (aMesh.drawingMode) {
+		case GL_TRIANGLES:
+		case GL_LINES:
+		case GL_POINTS:
+			return YES;
+		default:
+			return NO;
+	}
+}
+
+-(BOOL) addInstance: (CC3MeshNode*) aNode {
+	if ( ![self canAddInstance: aNode] ) return NO;
+
+	if ( !_instanceMesh ) {
+		_instanceMesh = [aNode.mesh retain];
+		self.material = aNode.material;			// Shared, not copied
+		pureColor = aNode.pureColor;
+		shouldCullBackFaces = aNode.shouldCullBackFaces;
+		shouldCullFrontFaces = aNode.shouldCullFrontFaces;
+		shouldUseClockwiseFrontFaceWinding = aNode.shouldUseClockwiseFrontFaceWinding;
+		shouldUseSmoothShading = aNode.shouldUseSmoothShading;
+	}
+
+	if ( !_instances ) _instances = [[CCArray array] retain];
+	[_instances addObject: aNode];
+	aNode.instancingNode = self;
+	_isBatchMeshDirty = YES;
+	LogTrace(@"%@ added instance %@", self, aNode);
+	return YES;
+}
+
+-(void) removeInstance: (CC3MeshNode*) aNode {
+	if (aNode.instancingNode != self) return;
+
+	aNode.instancingNode = nil;
+	[_instances removeObjectIdenticalTo: aNode];
+	_isBatchMeshDirty = YES;
+	LogTrace(@"%@ removed instance %@", self, aNode);
+}
+
+-(void) removeAllInstances {
+	for (CC3MeshNode* aNode in _instances) aNode.instancingNode = nil;
+	[_instances removeAllObjects];
+	_drawnInstanceCount = 0;
+	_isBatchMeshDirty = YES;
+}
+
+
+#pragma mark Allocation and initialization
+
+-(id) initWithTag: (GLuint) aTag withName: (NSString*) aName {
+	if ( (self = [super initWithTag: aTag withName: aName]) ) {
+		_instances = nil;
+		_instanceMesh = nil;
+		_instanceTransforms = NULL;
+		_drawnInstances = NULL;
+		_instanceSlotCapacity = 0;
+		_drawnInstanceCount = 0;
+		_isBatchMeshDirty = NO;
+		_shouldCullInstances = YES;
+		normalScalingMethod = kCC3NormalScalingNormalize;	// Instances may be scaled differently
+	}
+	return self;
+}
+
+// Instances are not copied, because each mesh node can be an instance of only one instancing node.
+-(void) populateFrom: (CC3MeshInstancingNode*) another {
+	[super populateFrom: another];
+	[mesh release];		// The batch mesh is rebuilt from instances
+	mesh = nil;
+	_shouldCullInstances = another.shouldCullInstances;
+}
+
+
+#pragma mark Drawing
+
+/** Ensures the per-instance arrays can hold the specified number of instances. */
+-(void) ensureInstanceSlotCapacity: (GLuint) slotCount {
+	if (slotCount <= _instanceSlotCapacity) return;
+	free(_instanceTransforms);
+	free(_drawnInstances);
+	_instanceTransforms = calloc(slotCount, sizeof(CC3Matrix4x3));
+	_drawnInstances = calloc(slotCount, sizeof(CC3MeshNode*));
+	_instanceSlotCapacity = slotCount;
+}
+
+/**
+ * Builds the batched mesh, holding one copy of the vertex content of the instance mesh for each
+ * instance. The vertex content is not interleaved, so that the locations and normals, which are
+ * rewritten whenever an instance moves, can be updated in the GL buffers independently of the
+ * remaining vertex content, which is copied only once here.
+ */
+-(void) buildBatchMesh {
+	_isBatchMeshDirty = NO;
+	_drawnInstanceCount = 0;
+
+	GLuint instCount = self.instanceCount;
+	if ( !_instanceMesh || instCount == 0 ) {
+		[mesh release];		// Avoid setter, which would alter the shared material
+		mesh = nil;
+		return;
+	}
+
+	[self ensureInstanceSlotCapacity: instCount];
+	memset(_drawnInstances, 0, instCount * sizeof(CC3MeshNode*));		// Force all slots to update
+
+	GLuint vtxPerInst = _instanceMesh.vertexCount;
+	GLuint idxPerInst = _instanceMesh.vertexIndexCount;
+
+	CC3Mesh* batchMesh = [CC3Mesh meshWithName: [NSString stringWithFormat: @"%@-Batch", self.name]];
+	batchMesh.shouldInterleaveVertices = NO;
+	batchMesh.vertexContentTypes = _instanceMesh.vertexContentTypes;
+	batchMesh.drawingMode = _instanceMesh.drawingMode;
+	batchMesh.allocatedVertexCapacity = vtxPerInst * instCount;
+	if (_instanceMesh.hasVertexIndices)
+		batchMesh.allocatedVertexIndexCapacity = idxPerInst * instCount;
+
+	// Copy the first instance from the template mesh, and replicate it within the batch mesh.
+	[batchMesh copyVertices: vtxPerInst from: 0 inMesh: _instanceMesh to: 0];
+	[batchMesh copyVertexIndices: idxPerInst from: 0 inMesh: _instanceMesh to: 0 offsettingBy: 0];
+	for (GLuint instIdx = 1; instIdx < instCount; instIdx++) {
+		[batchMesh copyVertices: vtxPerInst from: 0 to: (vtxPerInst * instIdx)];
+		[batchMesh copyVertexIndices: idxPerInst from: 0 to: (idxPerInst * instIdx)
+						offsettingBy: (vtxPerInst * instIdx)];
+	}
+
+	// Locations and normals are rewritten as instances move.
+	[batchMesh retainVertexLocations];
+	[batchMesh retainVertexNormals];
+	batchMesh.vertexLocations.bufferUsage = GL_DYNAMIC_DRAW;
+	batchMesh.vertexNormals.bufferUsage = GL_DYNAMIC_DRAW;
+	if (_instanceMesh.isUsingGLBuffers) [batchMesh createGLBuffers];
+
+	self.mesh = batchMesh;
+	LogRez(@"%@ built batch mesh of %u instances of %@ containing %u vertices",
+		   self, instCount, _instanceMesh, batchMesh.vertexCount);
+}
+
+/**
+ * Gathers the transforms of the instances to be drawn into the per-instance transform stream,
+ * culling instances that are invisible or outside the camera frustum, and packing the remaining
+ * instances into the leading slots of the batched mesh. The vertices in a slot are transformed
+ * only if the instance drawn in that slot, or its transform, has changed since the last frame.
+ */
+-(void) updateInstancesWithVisitor: (CC3NodeDrawingVisitor*) visitor {
+	CC3Frustum* frustum = visitor.camera.frustum;
+	CC3VertexLocations* tmplLocs = _instanceMesh.vertexLocations;
+	CC3VertexNormals* tmplNorms = _instanceMesh.vertexNormals;
+	CC3VertexLocations* batchLocs = mesh.vertexLocations;
+	CC3VertexNormals* batchNorms = mesh.vertexNormals;
+	GLuint vtxPerInst = _instanceMesh.vertexCount;
+
+	CC3Matrix4x3 batchMtx, batchMtxInv, instMtx, normMtx, instGlobalMtx;
+	[self.transformMatrix populateCC3Matrix4x3: &batchMtx];
+	[self.transformMatrixInverted populateCC3Matrix4x3: &batchMtxInv];
+
+	GLuint slotIdx = 0;
+	GLuint firstDirtySlot = UINT_MAX;
+	GLuint lastDirtySlot = 0;
+	for (CC3MeshNode* inst in _instances) {
+		if ( !inst.visible ) continue;
+		if (_shouldCullInstances && ![inst doesIntersectFrustum: frustum]) continue;
+
+		// Transform of the instance relative to this node
+		[inst.transformMatrix populateCC3Matrix4x3: &instGlobalMtx];
+		CC3Matrix4x3Multiply(&instMtx, &batchMtxInv, &instGlobalMtx);
+
+		if (_drawnInstances[slotIdx] != inst ||
+			memcmp(&_instanceTransforms[slotIdx], &instMtx, sizeof(CC3Matrix4x3)) != 0) {
+
+			_drawnInstances[slotIdx] = inst;
+			_instanceTransforms[slotIdx] = instMtx;
+			firstDirtySlot = MIN(firstDirtySlot, slotIdx);
+			lastDirtySlot = MAX(lastDirtySlot, slotIdx);
+
+			GLuint vtxIdx = vtxPerInst * slotIdx;
+			CC3Matrix4x3TransformVectors(&instMtx, 1.0f, vtxPerInst,
+										 [tmplLocs addressOfElement: 0], tmplLocs.vertexStride,
+										 [batchLocs addressOfElement: vtxIdx], batchLocs.vertexStride);
+			if (tmplNorms) {
+				// Normals are transformed by the inverse-transpose of the instance transform.
+				[inst.transformMatrixInverted populateCC3Matrix4x3: &instGlobalMtx];
+				CC3Matrix4x3Multiply(&normMtx, &instGlobalMtx, &batchMtx);
+				CC3Matrix4x3Transpose(&normMtx);
+				CC3Matrix4x3TransformVectors(&normMtx, 0.0f, vtxPerInst,
+											 [tmplNorms addressOfElement: 0], tmplNorms.vertexStride,
+											 [batchNorms addressOfElement: vtxIdx], batchNorms.vertexStride);
+			}
+		}
+		slotIdx++;
+	}
+	_drawnInstanceCount = slotIdx;
+
+	// Copy only the changed range of slots to the GL buffers
+	if (firstDirtySlot <= lastDirtySlot) {
+		GLuint dirtyVtxStart = vtxPerInst * firstDirtySlot;
+		GLuint dirtyVtxCount = vtxPerInst * (lastDirtySlot - firstDirtySlot + 1);
+		[batchLocs updateGLBufferStartingAt: dirtyVtxStart forLength: dirtyVtxCount];
+		[batchNorms updateGLBufferStartingAt: dirtyVtxStart forLength: dirtyVtxCount];
+		if ( !_shouldCullInstances ) [self markBoundingVolumeDirty];
+	}
+
+	mesh.vertexCount = vtxPerInst * _drawnInstanceCount;
+	if (mesh.hasVertexIndices) mesh.vertexIndexCount = _instanceMesh.vertexIndexCount * _drawnInstanceCount;
+}
+
+/** Only decorated drawing uses the batch. Otherwise, each instance is drawn individually. */
+-(void) transformAndDrawWithVisitor: (CC3NodeDrawingVisitor*) visitor {
+	if ( !visitor.shouldDecorateNode ) return;
+	[super transformAndDrawWithVisitor: visitor];
+}
+
+-(void) drawMeshWithVisitor: (CC3NodeDrawingVisitor*) visitor {
+	if (_isBatchMeshDirty) [self buildBatchMesh];
+	if ( !mesh ) return;
+
+	[self updateInstancesWithVisitor: visitor];
+	if (_drawnInstanceCount) [super drawMeshWithVisitor: visitor];
+}
+
+-(NSString*) description {
+	return [NSString stringWithFormat: @"%@ with %u instances", [super description], self.instanceCount];
+}
+
+@end
+
+
+#pragma mark -
+#pragma mark CC3StaticBatchNode
+
+@interface CC3StaticBatchNode (TemplateMethods)
+-(BOOL) canMergeMesh: (CC3Mesh*) aMesh;
+-(void) mergeSourceNode: (CC3MeshNode*) srcNode
+			 intoMesh: (CC3Mesh*) batchMesh
+			  atVertex: (GLuint) vtxOffset
+			   atIndex: (GLuint) idxOffset
+			  forRange: (CC3StaticBatchRange*) range;
+-(void) testRangesInFrustum: (CC3Frustum*) frustum;
+-(BOOL) shouldDrawRangeAt: (GLuint) rngIdx;
+@end
+
+@implementation CC3StaticBatchNode
+
+@synthesize sourceNodes=_sourceNodes, ranges=_ranges, rangeCount=_rangeCount;
+@synthesize shouldCullRanges=_shouldCullRanges, drawnRangeCount=_drawnRangeCount;
+@synthesize drawCallCount=_drawCallCount, mergeDuration=_mergeDuration;
+
+-(void) dealloc {
+	for (CC3MeshNode* srcNode in _sourceNodes)
+		if (srcNode.staticBatchNode == self) srcNode.staticBatchNode = nil;
+	[_sourceNodes release];
+	free(_ranges);
+	free(_rangeSpheres);
+	free(_rangePlaneHints);
+	free(_rangeVisibility);
+	[super dealloc];
+}
+
+
+#pragma mark Source nodes
+
+-(BOOL) canAddSourceNode: (CC3MeshNode*) aNode {
+	if ( !aNode.isMeshNode || aNode.staticBatchNode || aNode.instancingNode ) return NO;
+	if ([aNode isKindOfClass: [CC3MeshInstancingNode class]]) return NO;
+	if ([aNode isKindOfClass: [CC3StaticBatchNode class]]) return NO;
+	if ([_sourceNodes containsObject: aNode]) return NO;
+
+	CC3Mesh* aMesh = aNode.mesh;
+	if ( ![self canMergeMesh: aMesh] ) return NO;
+	if (_sourceVertexCount + aMesh.vertexCount > kCC3MaxGLushort + 1) return NO;
+
+	if (_sourceNodes.count == 0) return YES;
+
+	CC3MeshNode* firstNode = [_sourceNodes objectAtIndex: 0];
+	CC3Mesh* firstMesh = firstNode.mesh;
+	return (aNode.material == firstNode.material &&
+			aMesh.vertexContentTypes == firstMesh.vertexContentTypes &&
+			aMesh.drawingMode == firstMesh.drawingMode &&
+			aNode.shouldCullBackFaces == firstNode.shouldCullBackFaces &&
+			aNode.shouldCullFrontFaces == firstNode.shouldCullFrontFaces &&
+			aNode.shouldUseClockwiseFrontFaceWinding == firstNode.shouldUseClockwiseFrontFaceWinding);
+}
+
+/**
+ * Returns whether the vertices of the specified mesh can be transformed and appended to a merged
+ * mesh. The vertex locations and directions must be floats held in memory, the content must be
+ * static, and the drawing mode must allow the vertices of successive meshes to be concatenated.
+ */
+-(BOOL) canMergeMesh: (CC3Mesh*) aMesh {
+	CC3VertexLocations* vtxLocs = aMesh.vertexLocations;
+	if ( !vtxLocs.vertices || vtxLocs.elementType != GL_FLOAT || vtxLocs.elementSize != 3 ) return NO;
+	if (vtxLocs.bufferUsage == GL_DYNAMIC_DRAW) return NO;
+
+	if (aMesh.hasVertexNormals && aMesh.vertexNormals.elementType != GL_FLOAT) return NO;
+	if (aMesh.hasVertexTangents && aMesh.vertexTangents.elementType != GL_FLOAT) return NO;
+	if (aMesh.hasVertexBitangents && aMesh.vertexBitangents.elementType != GL_FLOAT) return NO;
+
+	if (aMesh.hasVertexWeights || aMesh.textureCoordinatesArrayCount > 1) return NO;
+	if (aMesh.vertexCount == 0) return NO;
+
+	switch (aMesh.drawingMode) {
+		case GL_TRIANGLES:
+		case GL_LINES:
+		case GL_POINTS:
+			return YES;
+		default:
+			return NO;
+	}
+}
+
+-(BOOL) addSourceNode: (CC3MeshNode*) aNode {
+	if ( ![self canAddSourceNode: aNode] ) return NO;
+
+	if ( !_sourceNodes ) _sourceNodes = [[CCArray array] retain];
+	if (_sourceNodes.count == 0) {
+		self.material = aNode.material;			// Shared, not copied
+		pureColor = aNode.pureColor;
+		shouldCullBackFaces = aNode.shouldCullBackFaces;
+		shouldCullFrontFaces = aNode.shouldCullFrontFaces;
+		shouldUseClockwiseFrontFaceWinding = aNode.shouldUseClockwiseFrontFaceWinding;
+		shouldUseSmoothShading = aNode.shouldUseSmoothShading;
+	}
+	[_sourceNodes addObject: aNode];
+	_sourceVertexCount += aNode.mesh.vertexCount;
+	return YES;
+}
+
+-(void) removeSourceNode: (CC3MeshNode*) aNode {
+	NSUInteger srcIdx = [_sourceNodes indexOfObjectIdenticalTo: aNode];
+	if (srcIdx == NSNotFound) return;
+
+	// Stop drawing the range of the node within the merged mesh
+	for (GLuint rngIdx = 0; rngIdx < _rangeCount; rngIdx++) {
+		CC3StaticBatchRange* range = &_ranges[rngIdx];
+		if (range->sourceNode == aNode) {
+			range->sourceNode = nil;
+			_hasRemovedRanges = YES;
+		}
+	}
+
+	if (aNode.staticBatchNode == self) aNode.staticBatchNode = nil;
+	_sourceVertexCount -= MIN(aNode.mesh.vertexCount, _sourceVertexCount);
+	[_sourceNodes removeObjectAtIndex: srcIdx];
+	LogTrace(@"%@ removed source node %@", self, aNode);
+}
+
+
+#pragma mark Merging
+
+-(void) mergeSourceNodes {
+	NSDate* startTime = [NSDate date];
+
+	GLuint srcCount = (GLuint)_sourceNodes.count;
+	if (srcCount == 0) return;
+
+	// Count the vertices and vertex indices to be merged
+	GLuint vtxCount = 0, idxCount = 0;
+	for (CC3MeshNode* srcNode in _sourceNodes) {
+		CC3Mesh* srcMesh = srcNode.mesh;
+		vtxCount += srcMesh.vertexCount;
+		idxCount += srcMesh.hasVertexIndices ? srcMesh.vertexIndexCount : srcMesh.vertexCount;
+	}
+
+	CC3MeshNode* firstNode = [_sourceNodes objectAtIndex: 0];
+	CC3Mesh* firstMesh = firstNode.mesh;
+	CC3Mesh* batchMesh = [CC3Mesh meshWithName: [NSString stringWithFormat: @"%@-Merged", self.name]];
+	batchMesh.shouldInterleaveVertices = YES;
+	batchMesh.vertexContentTypes = firstMesh.vertexContentTypes;
+	batchMesh.drawingMode = firstMesh.drawingMode;
+	batchMesh.allocatedVertexCapacity = vtxCount;
+	batchMesh.allocatedVertexIndexCapacity = idxCount;
+
+	free(_ranges);
+	_ranges = calloc(srcCount, sizeof(CC3StaticBatchRange));
+	_rangeCount = srcCount;
+
+	free(_rangeSpheres);
+	free(_rangePlaneHints);
+	free(_rangeVisibility);
+	_rangeSpheres = calloc(srcCount, sizeof(CC3Sphere));
+	_rangePlaneHints = calloc(srcCount, sizeof(GLubyte));
+	_rangeVisibility = calloc(CC3VisibilityBitmaskLength(srcCount), sizeof(GLuint));
+	_hasRemovedRanges = NO;
+
+	GLuint vtxOffset = 0, idxOffset = 0, rngIdx = 0;
+	for (CC3MeshNode* srcNode in _sourceNodes) {
+		CC3StaticBatchRange* range = &_ranges[rngIdx++];
+		[self mergeSourceNode: srcNode intoMesh: batchMesh atVertex: vtxOffset atIndex: idxOffset forRange: range];
+		vtxOffset += srcNode.mesh.vertexCount;
+		idxOffset += range->count;
+		srcNode.staticBatchNode = self;
+	}
+
+	// Merged normals are not unit length if any source node is scaled
+	if (batchMesh.hasVertexNormals) normalScalingMethod = kCC3NormalScalingNormalize;
+	if (firstMesh.isUsingGLBuffers) [batchMesh createGLBuffers];
+	self.mesh = batchMesh;
+
+	_mergeDuration = -[startTime timeIntervalSinceNow];
+	LogInfo(@"%@ merged %u mesh nodes into %u vertices and %u vertex indices in %.3f ms",
+			self, srcCount, vtxCount, idxCount, _mergeDuration * 1000.0);
+}
+
+/**
+ * Copies the vertex content of the mesh of the specified source node into the specified merged
+ * mesh, starting at the specified vertex and vertex index offsets, transforming the locations and
+ * directions into the coordinate system of this node, and populates the specified range structure.
+ */
+-(void) mergeSourceNode: (CC3MeshNode*) srcNode
+			 intoMesh: (CC3Mesh*) batchMesh
+			  atVertex: (GLuint) vtxOffset
+			   atIndex: (GLuint) idxOffset
+			  forRange: (CC3StaticBatchRange*) range {
+	CC3Mesh* srcMesh = srcNode.mesh;
+	GLuint vtxCount = srcMesh.vertexCount;
+	GLuint idxCount = srcMesh.hasVertexIndices ? srcMesh.vertexIndexCount : vtxCount;
+
+	[batchMesh copyVertices: vtxCount from: 0 inMesh: srcMesh to: vtxOffset];
+	[batchMesh copyVertexIndices: idxCount from: 0 inMesh: srcMesh to: idxOffset offsettingBy: vtxOffset];
+
+	// Transform of the source node relative to this node, and its inverse-transpose for normals
+	CC3Matrix4x3 batchMtx, batchMtxInv, srcMtx, srcMtxInv, locMtx, normMtx;
+	[self.transformMatrix populateCC3Matrix4x3: &batchMtx];
+	[self.transformMatrixInverted populateCC3Matrix4x3: &batchMtxInv];
+	[srcNode.transformMatrix populateCC3Matrix4x3: &srcMtx];
+	[srcNode.transformMatrixInverted populateCC3Matrix4x3: &srcMtxInv];
+	CC3Matrix4x3Multiply(&locMtx, &batchMtxInv, &srcMtx);
+	CC3Matrix4x3Multiply(&normMtx, &srcMtxInv, &batchMtx);
+	CC3Matrix4x3Transpose(&normMtx);
+
+	CC3VertexArray* srcVA = srcMesh.vertexLocations;
+	CC3VertexArray* dstVA = batchMesh.vertexLocations;
+	CC3Matrix4x3TransformVectors(&locMtx, 1.0f, vtxCount,
+								 [srcVA addressOfElement: 0], srcVA.vertexStride,
+								 [dstVA addressOfElement: vtxOffset], dstVA.vertexStride);
+	if (srcMesh.hasVertexNormals) {
+		srcVA = srcMesh.vertexNormals;
+		dstVA = batchMesh.vertexNormals;
+		CC3Matrix4x3TransformVectors(&normMtx, 0.0f, vtxCount,
+									 [srcVA addressOfElement: 0], srcVA.vertexStride,
+									 [dstVA addressOfElement: vtxOffset], dstVA.vertexStride);
+	}
+	if (srcMesh.hasVertexTangents) {
+		srcVA = srcMesh.vertexTangents;
+		dstVA = batchMesh.vertexTangents;
+		CC3Matrix4x3TransformVectors(&locMtx, 0.0f, vtxCount,
+									 [srcVA addressOfElement: 0], srcVA.vertexStride,
+									 [dstVA addressOfElement: vtxOffset], dstVA.vertexStride);
+	}
+	if (srcMesh.hasVertexBitangents) {
+		srcVA = srcMesh.vertexBitangents;
+		dstVA = batchMesh.vertexBitangents;
+		CC3Matrix4x3TransformVectors(&locMtx, 0.0f, vtxCount,
+									 [srcVA addressOfElement: 0], srcVA.vertexStride,
+									 [dstVA addressOfElement: vtxOffset], dstVA.vertexStride);
+	}
+
+	// Bounds of the transformed vertices, for culling the range
+	CC3BoundingBox bb = kCC3BoundingBoxNull;
+	for (GLuint vtxIdx = 0; vtxIdx < vtxCount; vtxIdx++)
+		bb = CC3BoundingBoxEngulfLocation(bb, [batchMesh vertexLocationAt: (vtxOffset + vtxIdx)]);
+
+	range->start = idxOffset;
+	range->count = idxCount;
+	range->boundingBox = bb;
+	range->sourceNode = srcNode;
+}
+
+
+#pragma mark Allocation and initialization
+
+-(id) initWithTag: (GLuint) aTag withName: (NSString*) aName {
+	if ( (self = [super initWithTag: aTag withName: aName]) ) {
+		_sourceNodes = nil;
+		_ranges = NULL;
+		_rangeSpheres = NULL;
+		_rangePlaneHints = NULL;
+		_rangeVisibility = NULL;
+		_rangeCount = 0;
+		_sourceVertexCount = 0;
+		_drawnRangeCount = 0;
+		_drawCallCount = 0;
+		_mergeDuration = 0.0;
+		_shouldCullRanges = YES;
+		_hasRemovedRanges = NO;
+	}
+	return self;
+}
+
+// Source nodes are not copied, because each mesh node can be merged into only one batch node.
+// The merged mesh is shared, and is drawn as a whole.
+-(void) populateFrom: (CC3StaticBatchNode*) another {
+	[super populateFrom: another];
+	_shouldCullRanges = NO;
+}
+
+
+#pragma mark Drawing
+
+/** Only decorated drawing uses the batch. Otherwise, each source node is drawn individually. */
+-(void) transformAndDrawWithVisitor: (CC3NodeDrawingVisitor*) visitor {
+	if ( !visitor.shouldDecorateNode ) return;
+	[super transformAndDrawWithVisitor: visitor];
+}
+
+/**
+ * Builds the global bounding sphere of each range, and tests them against the specified frustum
+ * in a single batch, marking the visible ranges in the range visibility bitmask.
+ */
+-(void) testRangesInFrustum: (CC3Frustum*) frustum {
+	CC3Matrix* tMtx = self.transformMatrix;
+	CC3Vector gs = self.globalScale;
+	GLfloat maxScale = MAX(MAX(ABS(gs.x), ABS(gs.y)), ABS(gs.z));
+	for (GLuint rngIdx = 0; rngIdx < _rangeCount; rngIdx++) {
+		CC3BoundingBox bb = _ranges[rngIdx].boundingBox;
+		CC3Vector center = CC3BoundingBoxCenter(bb);
+		GLfloat radius = CC3VectorDistance(center, bb.maximum) * maxScale;
+		_rangeSpheres[rngIdx] = CC3SphereMake([tMtx transformLocation: center], radius);
+	}
+	[frustum testSpheres: _rangeSpheres count: _rangeCount
+			  planeHints: _rangePlaneHints visibility: _rangeVisibility];
+}
+
+/**
+ * Returns whether the range at the specified index should be drawn. The range of a removed
+ * source node is never drawn. If ranges are being culled, the range must also be visible
+ * in the frustum, as marked by the testRangesInFrustum: method, and its source node visible.
+ */
+-(BOOL) shouldDrawRangeAt: (GLuint) rngIdx {
+	CC3MeshNode* srcNode = _ranges[rngIdx].sourceNode;
+	if ( !srcNode ) return NO;
+	if ( !_shouldCullRanges ) return YES;
+	return srcNode.visible && CC3IsVisibleInBitmask(_rangeVisibility, rngIdx);
+}
+
+/**
+ * Draws contiguous runs of visible ranges, so that the entire merged mesh is drawn with
+ * a single draw call when all of the ranges are visible, or when ranges are not being
+ * culled and no source node has been removed.
+ */
+-(void) drawMeshWithVisitor: (CC3NodeDrawingVisitor*) visitor {
+	if ( !(_shouldCullRanges || _hasRemovedRanges) || _rangeCount == 0 ) {
+		_drawnRangeCount = _rangeCount;
+		_drawCallCount = 1;
+		[super drawMeshWithVisitor: visitor];
+		return;
+	}
+
+	if (_shouldCullRanges) [self testRangesInFrustum: visitor.camera.frustum];
+
+	GLuint runStart = 0, runCount = 0;
+	_drawnRangeCount = 0;
+	_drawCallCount = 0;
+	for (GLuint rngIdx = 0; rngIdx < _rangeCount; rngIdx++) {
+		CC3StaticBatchRange* range = &_ranges[rngIdx];
+		if ([self shouldDrawRangeAt: rngIdx]) {
+			if (runCount == 0) runStart = range->start;
+			runCount += range->count;
+			_drawnRangeCount++;
+		} else if (runCount) {
+			[mesh drawFrom: runStart forCount: runCount withVisitor: visitor];
+			_drawCallCount++;
+			runCount = 0;
+		}
+	}
+	if (runCount) {
+		[mesh drawFrom: runStart forCount: runCount withVisitor: visitor];
+		_drawCallCount++;
+	}
+}
+
+-(NSString*) description {
+	return [NSString stringWithFormat: @"%@ merging %u source nodes", [super description], _rangeCount];
+}
+
+@end
+
+
+#pragma mark -
+#pragma mark CC3LODMeshNode
+
+@implementation CC3LODMeshNode
+
+@synthesize levelOfDetailHysteresis=_levelOfDetailHysteresis;
+@synthesize currentLevelOfDetail=_currentLevelOfDetail, screenSize=_screenSize;
+
+-(void) dealloc {
+	[_levelOfDetailMeshes release];
+	free(_levelOfDetailScreenSizes);
+	[super dealloc];
+}
+
+
+#pragma mark Levels of detail
+
+-(GLuint) levelOfDetailCount { return mesh ? (GLuint)_levelOfDetailMeshes.count + 1 : 0; }
+
+-(CC3Mesh*) meshAtLevelOfDetail: (GLuint) lodIndex {
+	return (lodIndex == 0) ? mesh : [_levelOfDetailMeshes objectAtIndex: (lodIndex - 1)];
+}
+
+-(GLfloat) screenSizeAtLevelOfDetail: (GLuint) lodIndex {
+	return (lodIndex == 0) ? kCC3MaxGLfloat : _levelOfDetailScreenSizes[lodIndex - 1];
+}
+
+-(void) addLevelOfDetailMesh: (CC3Mesh*) aMesh forScreenSizeBelow: (GLfloat) screenSize {
+	CC3Assert(aMesh, @"%@ cannot add a nil level of detail mesh", self);
+	GLuint lodCount = (GLuint)_levelOfDetailMeshes.count;
+	CC3Assert(lodCount == 0 || screenSize < _levelOfDetailScreenSizes[lodCount - 1],
+			  @"%@ levels of detail must be added with decreasing screen sizes", self);
+
+	if ( !_levelOfDetailMeshes ) _levelOfDetailMeshes = [[CCArray array] retain];
+	_levelOfDetailScreenSizes = realloc(_levelOfDetailScreenSizes, (lodCount + 1) * sizeof(GLfloat));
+	_levelOfDetailScreenSizes[lodCount] = screenSize;
+	[_levelOfDetailMeshes addObject: aMesh];
+	[aMesh deriveNameFrom: self usingSuffix: [NSString stringWithFormat: @"LOD%u", lodCount + 1]];
+	LogRez(@"%@ added level of detail %u with %u faces for screen sizes below %.3f",
+		   self, lodCount + 1, aMesh.faceCount, screenSize);
+}
+
+-(void) removeAllLevelsOfDetail {
+	[_levelOfDetailMeshes release];
+	_levelOfDetailMeshes = nil;
+	free(_levelOfDetailScreenSizes);
+	_levelOfDetailScreenSizes = NULL;
+	_currentLevelOfDetail = 0;
+}
+
+-(void) selectLevelOfDetailForScreenSize: (GLfloat) screenSize {
+	GLuint lodCount = (GLuint)_levelOfDetailMeshes.count;
+	GLuint lodIdx = MIN(_currentLevelOfDetail, lodCount);
+
+	// Coarsen while the screen size is below the next threshold by more than the hysteresis,
+	// then refine while it is above the current threshold by more than the hysteresis.
+	GLfloat coarsenFactor = 1.0f - _levelOfDetailHysteresis;
+	GLfloat refineFactor = 1.0f + _levelOfDetailHysteresis;
+	while (lodIdx < lodCount && screenSize < _levelOfDetailScreenSizes[lodIdx] * coarsenFactor) lodIdx++;
+	while (lodIdx > 0 && screenSize >= _levelOfDetailScreenSizes[lodIdx - 1] * refineFactor) lodIdx--;
+
+	if (lodIdx != _currentLevelOfDetail)
+		LogTrace(@"%@ changing from level of detail %u to %u at screen size %.3f",
+				 self, _currentLevelOfDetail, lodIdx, screenSize);
+	_currentLevelOfDetail = lodIdx;
+}
+
+
+#pragma mark Allocation and initialization
+
+-(id) initWithTag: (GLuint) aTag withName: (NSString*) aName {
+	if ( (self = [super initWithTag: aTag withName: aName]) ) {
+		_levelOfDetailMeshes = nil;
+		_levelOfDetailScreenSizes = NULL;
+		_levelOfDetailHysteresis = kCC3DefaultLevelOfDetailHysteresis;
+		_screenSize = 0.0f;
+		_currentLevelOfDetail = 0;
+	}
+	return self;
+}
+
+// The level of detail meshes are shared with the other node, in the same way as the mesh.
+-(void) populateFrom: (CC3LODMeshNode*) another {
+	[super populateFrom: another];
+
+	[self removeAllLevelsOfDetail];
+	GLuint lodCount = another.levelOfDetailCount;
+	for (GLuint lodIdx = 1; lodIdx < lodCount; lodIdx++)
+		[self addLevelOfDetailMesh: [another meshAtLevelOfDetail: lodIdx]
+				forScreenSizeBelow: [another screenSizeAtLevelOfDetail: lodIdx]];
+	_levelOfDetailHysteresis = another.levelOfDetailHysteresis;
+}
+
+-(void) createGLBuffers {
+	[_levelOfDetailMeshes makeObjectsPerformSelector: @selector(createGLBuffers)];
+	[super createGLBuffers];
+}
+
+-(void) deleteGLBuffers {
+	[_levelOfDetailMeshes makeObjectsPerformSelector: @selector(deleteGLBuffers)];
+	[super deleteGLBuffers];
+}
+
+-(void) releaseRedundantContent {
+	[_levelOfDetailMeshes makeObjectsPerformSelector: @selector(releaseRedundantContent)];
+	[super releaseRedundantContent];
+}
+
+-(void) retainVertexContent {
+	[_levelOfDetailMeshes makeObjectsPerformSelector: @selector(retainVertexContent)];
+	[super retainVertexContent];
+}
+
+
+#pragma mark Drawing
+
+/**
+ * Selects the level of detail from the screen size of this node as seen by the camera of the
+ * visitor, draws the mesh at that level, and reports the faces saved to the visitor statistics.
+ */
+-(void) drawMeshWithVisitor: (CC3NodeDrawingVisitor*) visitor {
+	if (_levelOfDetailMeshes.count == 0) {
+		[super drawMeshWithVisitor: visitor];
+		return;
+	}
+
+	CC3Camera* cam = visitor.camera;
+	if (cam) {
+		_screenSize = [self screenSizeFromCamera: cam];
+		[self selectLevelOfDetailForScreenSize: _screenSize];
+	}
+
+	if (_currentLevelOfDetail == 0) {
+		[super drawMeshWithVisitor: visitor];
+		return;
+	}
+
+	CC3Mesh* lodMesh = [self meshAtLevelOfDetail: _currentLevelOfDetail];
+	[lodMesh drawWithVisitor: visitor];
+
+	GLuint fullFaceCount = mesh.faceCount;
+	GLuint lodFaceCount = lodMesh.faceCount;
+	if (fullFaceCount > lodFaceCount)
+		[visitor.performanceStatistics addFacesSavedByLevelOfDetail: (fullFaceCount - lodFaceCount)];
+}
+
+-(NSString*) description {
+	return [NSString stringWithFormat: @"%@ with %u levels of detail", [super description], self.levelOfDetailCount];
+}
+
+@end
+
+
 #pragma mark -
 #pragma mark CC3Node extension for mesh nodes
 
@@ -1220,6 +2078,75 @@ globalIntersections: (CC3MeshIntersection*) intersections
 	return (CC3MeshNode*)retrievedNode;
 }
 
+-(CCArray*) instanceMeshNodesRepeatedAtLeast: (GLuint) minCount {
+	// Group the descendant mesh nodes by mesh and material, each group is an instancing node.
+	CCArray* candidates = [CCArray array];
+	for (CC3Node* aNode in [self flatten]) {
+		if ( !aNode.isMeshNode ) continue;
+
+		CC3MeshNode* meshNode = (CC3MeshNode*)aNode;
+		BOOL wasAdded = NO;
+		for (CC3MeshInstancingNode* batchNode in candidates)
+			if ( (wasAdded = [batchNode addInstance: meshNode]) ) break;
+
+		if ( !wasAdded ) {
+			NSString* batchName = [NSString stringWithFormat: @"%@-Instances-%u", self.name, (GLuint)candidates.count];
+			CC3MeshInstancingNode* batchNode = [CC3MeshInstancingNode nodeWithName: batchName];
+			if ([batchNode addInstance: meshNode]) [candidates addObject: batchNode];
+		}
+	}
+
+	// Keep the groups that are repeated often enough to be worth batching
+	CCArray* batchNodes = [CCArray array];
+	for (CC3MeshInstancingNode* batchNode in candidates) {
+		if (batchNode.instanceCount >= minCount) {
+			[self addChild: batchNode];
+			[batchNodes addObject: batchNode];
+		} else {
+			[batchNode removeAllInstances];
+		}
+	}
+	LogRez(@"%@ batched %u groups of repeated mesh nodes into instancing nodes", self, (GLuint)batchNodes.count);
+	return batchNodes;
+}
+
+-(CCArray*) mergeStaticMeshNodes {
+	NSDate* startTime = [NSDate date];
+	[self updateTransformMatrices];
+
+	// Group the descendant mesh nodes by material, each group is a static batch node.
+	CCArray* candidates = [CCArray array];
+	for (CC3Node* aNode in [self flatten]) {
+		if ( !aNode.isMeshNode ) continue;
+
+		CC3MeshNode* meshNode = (CC3MeshNode*)aNode;
+		BOOL wasAdded = NO;
+		for (CC3StaticBatchNode* batchNode in candidates)
+			if ( (wasAdded = [batchNode addSourceNode: meshNode]) ) break;
+
+		if ( !wasAdded ) {
+			NSString* batchName = [NSString stringWithFormat: @"%@-Static-%u", self.name, (GLuint)candidates.count];
+			CC3StaticBatchNode* batchNode = [CC3StaticBatchNode nodeWithName: batchName];
+			if ([batchNode addSourceNode: meshNode]) [candidates addObject: batchNode];
+		}
+	}
+
+	// Merging a single mesh node gains nothing
+	CCArray* batchNodes = [CCArray array];
+	GLuint srcCount = 0;
+	for (CC3StaticBatchNode* batchNode in candidates) {
+		if (batchNode.sourceNodes.count < 2) continue;
+		[self addChild: batchNode];
+		[batchNode updateTransformMatrix];
+		[batchNode mergeSourceNodes];
+		[batchNodes addObject: batchNode];
+		srcCount += batchNode.rangeCount;
+	}
+	LogInfo(@"%@ merged %u static mesh nodes into %u batches in %.3f ms", self,
+			srcCount, (GLuint)batchNodes.count, -[startTime timeIntervalSinceNow] * 1000.0);
+	return batchNodes;
+}
+
 @end
 
 #pragma mark -
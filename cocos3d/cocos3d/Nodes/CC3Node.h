@@ -224,6 +224,7 @@ typedef enum {
 	CC3Vector projectedLocation;
 	CC3Vector scale;
 	CC3Vector globalScale;
+	CC3BoundingBox _globalBoundingBox;
 	GLfloat boundingVolumePadding;
 	BOOL isTransformDirty : 1;
 	BOOL isTransformInvertedDirty : 1;
@@ -237,6 +238,7 @@ typedef enum {
 	BOOL shouldUseFixedBoundingVolume : 1;
 	BOOL shouldStopActionsWhenRemoved : 1;
 	BOOL _isAnimationDirty : 1;
+	BOOL _isGlobalBoundingBoxDirty : 1;
 	BOOL _cascadeColorEnabled;
 	BOOL _cascadeOpacityEnabled;
 }
@@ -628,12 +630,37 @@ typedef enum {
  *
  * Returns kCC3BoundingBoxNull if this node has no local content or descendants.
  *
- * Since the bounding box of a node can change based on the locations, rotations, or
- * scales of any descendant node, this property is measured dynamically on each access,
- * by traversing all descendant nodes. This is a computationally expensive method.
+ * The value of this property is cached, and is only recalculated when this node, or one
+ * of its descendants, has been moved, rotated or scaled, has had its local content changed,
+ * or when a descendant has been added or removed. When that happens, the cached bounding
+ * boxes of the changed node and its ancestors are marked as dirty. On the next access, the
+ * bounding box is refitted by merging the global local content bounding box of this node
+ * with the cached bounding boxes of its children, descending only into those children
+ * whose own bounding boxes have been marked as dirty.
+ *
+ * Reading this property repeatedly, with no intervening changes to the node hierarchy,
+ * therefore has a constant cost, and refitting after a change is proportional to the
+ * number of changed nodes, rather than to the number of nodes in this hierarchy.
+ *
+ * Any dirty transforms of this node and its descendants are rebuilt before the bounding
+ * box is refitted, so the value of this property is always current.
  */
 @property(nonatomic, readonly) CC3BoundingBox globalBoundingBox;
 
+/**
+ * Marks the globalBoundingBox of this node, and the globalBoundingBox of each ancestor
+ * of this node, as dirty, so that they will be refitted when next accessed.
+ *
+ * Marking stops at the first ancestor whose bounding box is already marked as dirty, since
+ * all of the ancestors above that node must already be marked as dirty as well.
+ *
+ * This method is invoked automatically when this node is transformed, when a child is
+ * added or removed, and from the markBoundingVolumeDirty method. Usually, the application
+ * never needs to invoke this method directly. Subclasses whose local content changes shape
+ * without invoking the markBoundingVolumeDirty method should invoke this method instead.
+ */
+-(void) markGlobalBoundingBoxDirty;
+
 /**
  * Returns the center of geometry of this node, including any local content of
  * this node, plus all descendants of this node.
@@ -2271,6 +2298,10 @@ typedef enum {
  *
  * The bounding volume is automatically transformed as the node is transformed, so this
  * method does NOT need to be invoked when the node is transformed (moved, rotated, or scaled).
+ *
+ * Regardless of the value of the shouldUseFixedBoundingVolume property, this method also
+ * invokes the markGlobalBoundingBoxDirty method, so that the cached globalBoundingBox of
+ * this node and its ancestors will be refitted to the new content.
  */
 -(void) markBoundingVolumeDirty;
 
@@ -2517,6 +2548,24 @@ typedef enum {
  */
 -(void) transformAndDrawWithVisitor: (CC3NodeDrawingVisitor*) visitor;
 
+/**
+ * Returns the number of bone matrices that are used to draw this node.
+ *
+ * This is used when capturing the state of this node into a CC3FramePacket, and is
+ * non-zero only for nodes that use vertex skinning. This implementation returns zero.
+ */
+@property(nonatomic, readonly) GLuint bonePaletteCount;
+
+/**
+ * Populates the specified array of matrices with the bone matrices used to draw this node.
+ * The array must be large enough to hold the number of matrices indicated by the
+ * bonePaletteCount property.
+ *
+ * This is used when capturing the state of this node into a CC3FramePacket.
+ * This implementation does nothing. Nodes that use vertex skinning will override.
+ */
+-(void) populateBonePalette: (CC3Matrix4x3*) palette;
+
 /**
  * Returns whether the bounding volume of this node intersects the specified camera frustum.
  * This check does not include checking children, only the local content.
@@ -84,6 +84,8 @@
 -(void) updateGlobalScale;
 -(void) updateTargetLocation;
 -(void) transformBoundingVolume;
+-(void) refitGlobalBoundingBox;
+-(BOOL) shouldContributeToParentBoundingBox;
 -(void) didAddDescendant: (CC3Node*) aNode;
 -(void) didRemoveDescendant: (CC3Node*) aNode;
 -(void) descendantDidModifySequencingCriteria: (CC3Node*) aNode;
@@ -655,13 +657,44 @@
 	return bbVisitor.boundingBox;
 }
 
-// Creates a specialized transforming visitor that traverses the node hierarchy below
-// this node, accumulating a bounding box that surrounds all descendant nodes.
+// Returns the cached bounding box, refitting it first if it has been marked dirty.
+// Any dirty ancestor transforms are rebuilt first, so that the refit, which then works
+// down through only the dirty descendants, is performed against current transforms.
 -(CC3BoundingBox) globalBoundingBox {
-	CC3NodeBoundingBoxVisitor* bbVisitor = [CC3NodeBoundingBoxVisitor visitor];
-	[bbVisitor visit: self];
-	LogTrace(@"Measured %@ global bounding box: %@", self, NSStringFromCC3BoundingBox(bbVisitor.boundingBox));
-	return bbVisitor.boundingBox;
+	if (_isGlobalBoundingBoxDirty) {
+		if (parent.dirtiestAncestor) [self updateTransformMatrices];
+		[self refitGlobalBoundingBox];
+	}
+	return _globalBoundingBox;
+}
+
+/**
+ * Rebuilds the cached global bounding box from the global local content bounding box of this
+ * node, if it contributes to the bounding box, and the cached bounding boxes of the children.
+ * Only children whose bounding boxes have been marked dirty are refitted.
+ *
+ * The transforms of all ancestors must be current before this method is invoked. If the transform
+ * of this node is dirty, it is rebuilt, along with the transforms of all descendants.
+ */
+-(void) refitGlobalBoundingBox {
+	if (isTransformDirty) [self updateTransformMatrices];
+
+	CC3BoundingBox gbb = self.shouldContributeToParentBoundingBox
+							? ((CC3LocalContentNode*)self).globalLocalContentBoundingBox
+							: kCC3BoundingBoxNull;
+	for (CC3Node* child in children) {
+		if (child->_isGlobalBoundingBoxDirty) [child refitGlobalBoundingBox];
+		gbb = CC3BoundingBoxUnion(gbb, child->_globalBoundingBox);
+	}
+	_globalBoundingBox = gbb;
+	_isGlobalBoundingBoxDirty = NO;
+	LogTrace(@"Refitted %@ global bounding box: %@", self, NSStringFromCC3BoundingBox(_globalBoundingBox));
+}
+
+-(void) markGlobalBoundingBoxDirty {
+	if (_isGlobalBoundingBoxDirty) return;
+	_isGlobalBoundingBoxDirty = YES;
+	[parent markGlobalBoundingBoxDirty];
 }
 
 -(CC3Vector) centerOfGeometry {
@@ -989,6 +1022,8 @@
 		projectedLocation = kCC3VectorZero;
 		scale = kCC3VectorUnitCube;
 		globalScale = kCC3VectorUnitCube;
+		_globalBoundingBox = kCC3BoundingBoxNull;
+		_isGlobalBoundingBoxDirty = YES;
 		isTransformDirty = YES;			// Force transform notification on first update
 		_touchEnabled = NO;
 		shouldInheritTouchability = YES;
@@ -1327,8 +1362,14 @@ static GLuint lastAssignedNodeTag;
 	}
 }
 
-/** Marks the node's transformMatrix as requiring a recalculation. */
--(void) markTransformDirty { isTransformDirty = YES; }
+/**
+ * Marks the node's transformMatrix as requiring a recalculation, and marks the global
+ * bounding boxes of this node and its ancestors as needing to be refitted.
+ */
+-(void) markTransformDirty {
+	isTransformDirty = YES;
+	[self markGlobalBoundingBoxDirty];
+}
 
 -(CC3Node*) dirtiestAncestor {
 	CC3Node* da = parent.dirtiestAncestor;
@@ -1529,10 +1570,12 @@ static GLuint lastAssignedNodeTag;
 /**
  * Template method that is invoked automatically whenever the transform matrix of this node
  * is changed. Updates the bounding volume of this node, and marks the transformInvertedMatrix
- * as dirty so it will be lazily rebuilt.
+ * as dirty so it will be lazily rebuilt. Descendants are transformed when an ancestor moves,
+ * without being marked dirty themselves, so the global bounding box is marked dirty here too.
  */
 -(void) transformMatrixChanged {
 	[self transformBoundingVolume];
+	[self markGlobalBoundingBoxDirty];
 	isTransformDirty = NO;
 	isTransformInvertedDirty = YES;
 }
@@ -1631,7 +1674,10 @@ static GLuint lastAssignedNodeTag;
  */
 -(void) transformBoundingVolume { [boundingVolume markTransformDirty]; }
 
--(void) markBoundingVolumeDirty { if (!shouldUseFixedBoundingVolume) [boundingVolume markDirty]; }
+-(void) markBoundingVolumeDirty {
+	if (!shouldUseFixedBoundingVolume) [boundingVolume markDirty];
+	[self markGlobalBoundingBoxDirty];
+}
 
 // Deprecated method
 -(void) rebuildBoundingVolume { [self markBoundingVolumeDirty]; }
@@ -1649,17 +1695,25 @@ static GLuint lastAssignedNodeTag;
 	LogTrace(@"Drawing %@", self);
 	CC3OpenGLESMatrixStack* glesMatrixStack = [CC3OpenGLESEngine engine].matrices.modelview;
 
+	// When drawing from a frame packet, use the transform captured at the end of the update
+	CC3Matrix* drawMtx = visitor.framePacketTransformMatrix;
+	if ( !drawMtx ) drawMtx = transformMatrix;
+
 	[glesMatrixStack push];
 
-	LogTrace(@"%@ applying transform matrix: %@", self, transformMatrix);
-	[glesMatrixStack multiply: transformMatrix];
+	LogTrace(@"%@ applying transform matrix: %@", self, drawMtx);
+	[glesMatrixStack multiply: drawMtx];
 
-	[visitor populateModelMatrixFrom: transformMatrix];
+	[visitor populateModelMatrixFrom: drawMtx];
 	[visitor draw: self];
 
 	[glesMatrixStack pop];
 }
 
+-(GLuint) bonePaletteCount { return 0; }
+
+-(void) populateBonePalette: (CC3Matrix4x3*) palette {}
+
 -(void) checkDrawingOrder { for (CC3Node* child in children) [child checkDrawingOrder]; }
 
 
@@ -1667,10 +1721,14 @@ static GLuint lastAssignedNodeTag;
 
 /**
  * When assigned to a new parent, ensure that the transform will be recalculated,
- * since it changes this child's overall transform.
+ * since it changes this child's overall transform. The global bounding boxes of both
+ * the old and new parents are marked dirty explicitly, since this node may already be
+ * marked dirty, which would stop the marking from propagating up to either parent.
  */
 -(void) setParent: (CC3Node*) aNode {
+	[parent markGlobalBoundingBoxDirty];
 	parent = aNode;
+	[parent markGlobalBoundingBoxDirty];
 	[self markTransformDirty];
 }
 
@@ -2679,6 +2737,12 @@ static ccColor4F directionMarkerColor = { 1.0, 0.0, 0.0, 1.0 };		// kCCC4FRed
 	globalLocalContentBoundingBox = kCC3BoundingBoxNull;
 }
 
+/** Overridden to force a lazy recalculation of the globalLocalContentBoundingBox. */
+-(void) markBoundingVolumeDirty {
+	[super markBoundingVolumeDirty];
+	globalLocalContentBoundingBox = kCC3BoundingBoxNull;
+}
+
 
 #pragma mark Developer support
 
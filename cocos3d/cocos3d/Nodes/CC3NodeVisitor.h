@@ -34,7 +34,12 @@
 #import "CC3PerformanceStatistics.h"
 
 @class CC3Node, CC3MeshNode, CC3Camera, CC3Light, CC3Scene, CC3GLProgram;
-@class CC3Material, CC3TextureUnit, CC3Mesh, CC3NodeSequencer, CC3SkinSection;
+@class CC3Material, CC3TextureUnit, CC3Mesh, CC3NodeSequencer, CC3SkinSection, CC3FramePacket;
+
+/** The maximum number of lights that can be selected to illuminate a single node. */
+#ifndef kCC3MaxSelectedLights
+#	define kCC3MaxSelectedLights		8
+#endif
 
 
 #pragma mark -
@@ -307,12 +312,20 @@
 	CC3NodeSequencer* _drawingSequencer;
 	CC3SkinSection* _currentSkinSection;
 	CC3GLProgram* _currentShaderProgram;
+	CC3Matrix* _framePacketTransformMatrix;
+	CC3Matrix4x3* _currentBonePalette;
 	CC3Matrix4x4 _projMatrix;
 	CC3Matrix4x3 _viewMatrix;
 	CC3Matrix4x3 _modelMatrix;
 	CC3Matrix4x4 _viewProjMatrix;
 	CC3Matrix4x3 _modelViewMatrix;
 	CC3Matrix4x4 _modelViewProjMatrix;
+	GLuint _projMatrixVersion;
+	GLuint _viewMatrixVersion;
+	GLuint _modelMatrixVersion;
+	CC3Light* _selectedLights[kCC3MaxSelectedLights];
+	GLuint _selectedLightCount;
+	GLuint _lightSelectionVersion;
 	ccColor4F _currentColor;
 	GLuint _textureUnitCount;
 	GLuint _textureUnit;
@@ -322,6 +335,7 @@
 	BOOL _isVPMtxDirty : 1;
 	BOOL _isMVMtxDirty : 1;
 	BOOL _isMVPMtxDirty : 1;
+	BOOL _isSelectingLights : 1;
 }
 
 /**
@@ -389,6 +403,40 @@
  */
 -(void) draw: (CC3Node*) aNode;
 
+/**
+ * Draws the nodes captured in the specified frame packet, which was captured from the
+ * specified scene, using the transform matrices and bone palettes that were captured in
+ * the frame packet, instead of the current state of each node.
+ *
+ * The nodes in the frame packet have already been tested for visibility and for intersection
+ * with the camera frustum when the frame packet was captured, and are drawn in the order in
+ * which they were captured.
+ *
+ * This method is invoked automatically by the CC3Scene when its shouldUpdateSceneConcurrently
+ * property is set to YES. The application should never need to invoke this method directly.
+ */
+-(void) visitFramePacket: (CC3FramePacket*) aPacket forScene: (CC3Scene*) aScene;
+
+/**
+ * While a frame packet is being drawn by the visitFramePacket:forScene: method, this property
+ * holds the global transform matrix of the node being drawn, as captured in the frame packet.
+ * Nodes should apply this matrix, instead of their own transformMatrix, when it is not nil.
+ *
+ * At all other times, the value of this property is nil.
+ */
+@property(nonatomic, readonly) CC3Matrix* framePacketTransformMatrix;
+
+/**
+ * While a frame packet is being drawn by the visitFramePacket:forScene: method, this property
+ * points to the captured bone matrices of the skin section currently being drawn, in the same
+ * order as the bones of that skin section. Each skin section advances this pointer past its
+ * own bones once it has been drawn.
+ *
+ * At all other times, and for nodes that do not use vertex skinning, this property is NULL,
+ * and the bone matrices should be retrieved from the bones themselves.
+ */
+@property(nonatomic, assign) CC3Matrix4x3* currentBonePalette;
+
 
 #pragma mark Accessing node contents
 
@@ -477,18 +525,43 @@
  */
 @property(nonatomic, assign) ccColor4B currentColor4B;
 
-/** The number of lights in the scene. */
+/**
+ * The number of lights illuminating the current node.
+ *
+ * If the isSelectingLights property is YES, this is the number of lights selected for the
+ * current node by the lightGrid of the scene. Otherwise, it is the number of lights in the scene.
+ */
 @property(nonatomic, readonly) NSUInteger lightCount;
 
 /**
  * Returns the light indicated by the index, or nil if the specified index is greater than
- * the number of lights currently existing in the scene.
+ * the number of lights illuminating the current node.
  *
- * The specified index is an index into the lights array of the scene, and is not necessarily
- * the same as the lightIndex property of the CC3Light.
+ * If the isSelectingLights property is YES, the specified index is an index into the lights
+ * selected for the current node, ordered from most to least influential. Otherwise, the
+ * specified index is an index into the lights array of the scene. In either case, the index
+ * is not necessarily the same as the lightIndex property of the CC3Light.
  */
 -(CC3Light*) lightAt: (GLuint) index;
 
+/**
+ * Indicates whether the lights illuminating the current node have been selected from the
+ * lights in the scene, by the CC3LightGrid held in the lightGrid property of the scene.
+ *
+ * Lights are selected as each node is drawn, if the scene has a lightGrid, and the node
+ * uses lighting, and the shouldDecorateNode property of this visitor is YES.
+ */
+@property(nonatomic, readonly) BOOL isSelectingLights;
+
+/**
+ * A version stamp that changes whenever the set of lights selected for the current node
+ * is different than the set selected for the previous node drawn.
+ *
+ * Shader programs use this value to avoid repopulating light uniforms when consecutive
+ * nodes are illuminated by the same lights. This value is unique across all visitors.
+ */
+@property(nonatomic, readonly) GLuint lightSelectionVersion;
+
 
 #pragma mark Environmental matrices
 
@@ -527,6 +600,120 @@
 /** Populates the current model-to-global matrix from the specified matrix. */
 -(void) populateModelMatrixFrom: (CC3Matrix*) modelMtx;
 
+/**
+ * Returns a version stamp that identifies the content of the current projection matrix.
+ *
+ * Each time the content of the projection matrix is changed by the populateProjMatrixFrom:
+ * method, this property is set to a new value, taken from a counter that is shared by all
+ * of the version stamps of all drawing visitors. Two version stamps are therefore equal only
+ * if they identify the same content. Populating the matrix with the same content it already
+ * contains does not change the version stamp.
+ *
+ * This allows shader uniforms whose values are derived only from the environmental matrices
+ * to avoid being recalculated when the matrices have not changed.
+ *
+ * The value of this property is zero until the projection matrix is first populated.
+ */
+@property(nonatomic, readonly) GLuint projMatrixVersion;
+
+/**
+ * Returns a version stamp that identifies the content of the current view matrix.
+ *
+ * See the notes for the projMatrixVersion property for more information.
+ */
+@property(nonatomic, readonly) GLuint viewMatrixVersion;
+
+/**
+ * Returns a version stamp that identifies the content of the current model-to-global matrix.
+ *
+ * See the notes for the projMatrixVersion property for more information.
+ */
+@property(nonatomic, readonly) GLuint modelMatrixVersion;
+
+@end
+
+
+#pragma mark -
+#pragma mark CC3FramePacket
+
+/** The captured drawing state of a single node within a CC3FramePacket. */
+typedef struct {
+	CC3Matrix4x3 modelMatrix;		/**< The global transform matrix of the node. */
+	GLuint firstBoneMatrix;			/**< The index of the first bone matrix of the node in the frame packet. */
+	GLuint boneMatrixCount;			/**< The number of bone matrices captured for the node. */
+} CC3FramePacketEntry;
+
+/**
+ * CC3FramePacket is a snapshot of the state that is needed to draw the nodes of a scene,
+ * captured at the end of a scene update.
+ *
+ * For each node that has local content, is visible, and intersects the camera frustum, the
+ * frame packet retains the node, and captures its global transform matrix and, for nodes
+ * that use vertex skinning, the palette of bone matrices. The view
+ * and projection matrices of the camera are captured as well. Nodes are captured in the order
+ * of the drawing sequencer of the scene, if it has one, so they can be drawn in that order.
+ *
+ * A CC3Scene whose shouldUpdateSceneConcurrently property is set to YES keeps two frame
+ * packets. The scene is updated, and a frame packet captured, on a background thread, while
+ * the other frame packet, captured after the previous update, is drawn on the rendering thread.
+ *
+ * Only the state listed above is captured. Other node state, such as materials and mesh
+ * content, is read directly from the nodes when they are drawn.
+ */
+@interface CC3FramePacket : NSObject {
+	CCArray* nodes;
+	CC3FramePacketEntry* entries;
+	NSUInteger entryCapacity;
+	CC3Matrix4x3* boneMatrices;
+	NSUInteger boneMatrixCount;
+	NSUInteger boneMatrixCapacity;
+	CC3Matrix* viewMatrix;
+	CC3Matrix* projectionMatrix;
+}
+
+/** The number of nodes captured in this frame packet. */
+@property(nonatomic, readonly) NSUInteger nodeCount;
+
+/** The view matrix of the camera, as captured in this frame packet. */
+@property(nonatomic, readonly) CC3Matrix* viewMatrix;
+
+/** The projection matrix of the camera, as captured in this frame packet. */
+@property(nonatomic, readonly) CC3Matrix* projectionMatrix;
+
+/** Returns the node captured at the specified index. */
+-(CC3Node*) nodeAt: (NSUInteger) index;
+
+/** Returns a pointer to the captured state of the node at the specified index. */
+-(CC3FramePacketEntry*) entryAt: (NSUInteger) index;
+
+/**
+ * Returns a pointer to the first captured bone matrix of the node at the specified index,
+ * or NULL if no bone matrices were captured for that node.
+ */
+-(CC3Matrix4x3*) bonePaletteAt: (NSUInteger) index;
+
+/**
+ * Captures the drawing state of the specified scene into this frame packet,
+ * replacing any state that was previously captured.
+ *
+ * The nodes previously retained by this frame packet are released on the main thread,
+ * so that any node that is deallocated as a result releases its GL resources there.
+ */
+-(void) captureScene: (CC3Scene*) aScene;
+
+/**
+ * Pushes the GL projection and modelview matrix stacks, and loads the captured projection
+ * and view matrices into them. This is the frame packet equivalent of the open method of
+ * the camera.
+ */
+-(void) openCamera;
+
+/** Pops the GL projection and modelview matrix stacks. This is the compliment of openCamera. */
+-(void) closeCamera;
+
+/** Allocates and initializes an autoreleased instance. */
++(id) framePacket;
+
 @end
 
 
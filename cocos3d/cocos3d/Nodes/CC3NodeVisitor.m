@@ -31,6 +31,8 @@
 
 #import "CC3NodeVisitor.h"
 #import "CC3Scene.h"
+#import "CC3Light.h"
+#import "CC3OcclusionCulling.h"
 #import "CC3Layer.h"
 #import "CC3Mesh.h"
 #import "CC3OpenGLESEngine.h"
@@ -38,6 +40,8 @@
 #import "CC3EAGLView.h"
 #import "CC3NodeSequencer.h"
 #import "CC3VertexSkinning.h"
+#import "CC3AffineMatrix.h"
+#import "CC3ProjectionMatrix.h"
 
 @interface CC3Node (TemplateMethods)
 -(void) processUpdateBeforeTransform: (CC3NodeUpdatingVisitor*) visitor;
@@ -375,6 +379,8 @@
 @interface CC3NodeDrawingVisitor (TemplateMethods)
 -(BOOL) shouldDrawNode: (CC3Node*) aNode;
 -(BOOL) isNodeVisibleForDrawing: (CC3Node*) aNode;
+-(BOOL) isNodeOccluded: (CC3Node*) aNode;
+-(void) selectLightsForNode: (CC3Node*) aNode;
 @end
 
 @implementation CC3NodeDrawingVisitor
@@ -383,11 +389,17 @@
 @synthesize shouldDecorateNode=_shouldDecorateNode, shouldClearDepthBuffer=_shouldClearDepthBuffer;
 @synthesize textureUnit=_textureUnit, textureUnitCount=_textureUnitCount, currentColor=_currentColor;
 @synthesize currentSkinSection=_currentSkinSection, currentShaderProgram=_currentShaderProgram;
+@synthesize projMatrixVersion=_projMatrixVersion, viewMatrixVersion=_viewMatrixVersion;
+@synthesize modelMatrixVersion=_modelMatrixVersion;
+@synthesize isSelectingLights=_isSelectingLights, lightSelectionVersion=_lightSelectionVersion;
+@synthesize framePacketTransformMatrix=_framePacketTransformMatrix, currentBonePalette=_currentBonePalette;
 
 -(void) dealloc {
 	_drawingSequencer = nil;		// not retained
 	_currentSkinSection = nil;		// not retained
 	_currentShaderProgram = nil;	// not retained
+	_currentBonePalette = NULL;		// not owned
+	[_framePacketTransformMatrix release];
 	[super dealloc];
 }
 
@@ -396,8 +408,13 @@
 		_drawingSequencer = nil;
 		_currentSkinSection = nil;
 		_currentShaderProgram = nil;
+		_framePacketTransformMatrix = nil;
+		_currentBonePalette = NULL;
 		_shouldDecorateNode = YES;
 		_shouldClearDepthBuffer = YES;
+		_selectedLightCount = 0;
+		_lightSelectionVersion = 0;
+		_isSelectingLights = NO;
 	}
 	return self;
 }
@@ -417,7 +434,17 @@
 -(BOOL) shouldDrawNode: (CC3Node*) aNode {
 	return aNode.hasLocalContent
 			&& [self isNodeVisibleForDrawing: aNode]
-			&& [aNode doesIntersectFrustum: _camera.frustum];
+			&& [aNode doesIntersectFrustum: _camera.frustum]
+			&& ![self isNodeOccluded: aNode];
+}
+
+/**
+ * Returns whether the specified node is hidden behind the occluders of the occlusion culler of
+ * the scene. Only decorated drawing is culled, so that node picking is not affected by occlusion.
+ */
+-(BOOL) isNodeOccluded: (CC3Node*) aNode {
+	CC3OcclusionCuller* culler = self.scene.occlusionCuller;
+	return (culler && _shouldDecorateNode && [culler isNodeOccluded: aNode]);
 }
 
 -(BOOL) isNodeVisibleForDrawing: (CC3Node*) aNode { return aNode.visible; }
@@ -458,10 +485,84 @@
 }
 
 -(void) draw: (CC3Node*) aNode {
+	[self selectLightsForNode: aNode];
 	[aNode drawWithVisitor: self];
 	[self.performanceStatistics incrementNodesDrawn];
 }
 
+// Source of unique light selection versions, shared by all visitors. Zero is never issued.
+static GLuint _lastLightSelectionVersion = 0;
+
+/**
+ * If the scene has a light grid, and the specified node is to be lit and decorated, selects
+ * the lights that will illuminate the node, and issues a new selection version if the
+ * selected lights differ from those selected for the previous node.
+ */
+-(void) selectLightsForNode: (CC3Node*) aNode {
+	CC3LightGrid* lightGrid = self.scene.lightGrid;
+	_isSelectingLights = (lightGrid && aNode.shouldUseLighting && _shouldDecorateNode);
+	if ( !_isSelectingLights ) return;
+
+	CC3Light* newLights[kCC3MaxSelectedLights];
+	GLuint newCount = [lightGrid selectLights: newLights forNode: aNode];
+
+	BOOL isChanged = (newCount != _selectedLightCount) || (_lightSelectionVersion == 0);
+	for (GLuint i = 0; i < newCount; i++) {
+		if (newLights[i] != _selectedLights[i]) isChanged = YES;
+		_selectedLights[i] = newLights[i];		// not retained
+	}
+	_selectedLightCount = newCount;
+
+	if (isChanged) {
+		if (++_lastLightSelectionVersion == 0) _lastLightSelectionVersion++;
+		_lightSelectionVersion = _lastLightSelectionVersion;
+	}
+}
+
+/**
+ * The nodes in the frame packet have already been culled, and are drawn in the order captured.
+ * Each node is still checked with isNodeVisibleForDrawing:, so that subclasses, such as the
+ * picking visitor, can apply their own criteria.
+ * The camera is set through the superclass, because the view and projection matrices are
+ * taken from the frame packet, instead of from the camera, which may be in the middle of
+ * being updated on another thread.
+ */
+-(void) visitFramePacket: (CC3FramePacket*) aPacket forScene: (CC3Scene*) aScene {
+	if ( !(aPacket && aScene) ) return;
+
+	_startingNode = aScene;					// Not retained
+	if (!_camera) super.camera = aScene.activeCamera;	// Not retained
+	[self populateProjMatrixFrom: aPacket.projectionMatrix];
+	[self populateViewMatrixFrom: aPacket.viewMatrix];
+	[self open];
+
+	_framePacketTransformMatrix = [CC3AffineMatrix new];
+	CC3PerformanceStatistics* perfStats = self.performanceStatistics;
+
+	NSUInteger nodeCnt = aPacket.nodeCount;
+	for (NSUInteger nodeIdx = 0; nodeIdx < nodeCnt; nodeIdx++) {
+		CC3Node* aNode = [aPacket nodeAt: nodeIdx];
+		[perfStats incrementNodesVisitedForDrawing];
+		if ( ![self isNodeVisibleForDrawing: aNode] ) continue;
+
+		_currentNode = aNode;				// Not retained
+		[_framePacketTransformMatrix populateFromCC3Matrix4x3: &[aPacket entryAt: nodeIdx]->modelMatrix];
+		_currentBonePalette = [aPacket bonePaletteAt: nodeIdx];
+
+		[aNode transformAndDrawWithVisitor: self];
+		_currentSkinSection = nil;			// not retained
+	}
+
+	[_framePacketTransformMatrix release];
+	_framePacketTransformMatrix = nil;
+	_currentBonePalette = NULL;
+
+	[self close];
+	_currentNode = nil;						// Not retained
+	_camera = nil;							// Not retained
+	_startingNode = nil;					// Not retained
+}
+
 
 #pragma mark Accessing node contents
 
@@ -481,9 +582,13 @@
 
 -(void) setCurrentColor4B: (ccColor4B) color4B { self.currentColor = CCC4FFromCCC4B(color4B); }
 
--(NSUInteger) lightCount { return self.scene.lights.count; }
+-(NSUInteger) lightCount {
+	return _isSelectingLights ? _selectedLightCount : self.scene.lights.count;
+}
 
 -(CC3Light*) lightAt: (GLuint) index {
+	if (_isSelectingLights) return (index < _selectedLightCount) ? _selectedLights[index] : nil;
+
 	CCArray* lights = self.scene.lights;
 	if (index < lights.count) return [lights objectAtIndex: index];
 	return nil;
@@ -526,33 +631,52 @@
 	return &_modelViewProjMatrix;
 }
 
+/** The source of the version stamps of the environmental matrices of all drawing visitors. */
+static GLuint _lastMatrixVersion = 0;
+
+// If the content of the matrix has not changed, the derived matrices remain valid.
 -(void) populateProjMatrixFrom: (CC3Matrix*) projMtx {
+	CC3Matrix4x4 newMtx;
 	if (projMtx)
-		[projMtx populateCC3Matrix4x4: &_projMatrix];
+		[projMtx populateCC3Matrix4x4: &newMtx];
 	else
-		CC3Matrix4x4PopulateIdentity(&_projMatrix);
+		CC3Matrix4x4PopulateIdentity(&newMtx);
+
+	if (_projMatrixVersion && memcmp(&newMtx, &_projMatrix, sizeof(newMtx)) == 0) return;
 
+	_projMatrix = newMtx;
+	_projMatrixVersion = ++_lastMatrixVersion;
 	_isVPMtxDirty = YES;
 	_isMVPMtxDirty = YES;
 }
 
 -(void) populateViewMatrixFrom: (CC3Matrix*) viewMtx {
+	CC3Matrix4x3 newMtx;
 	if (viewMtx)
-		[viewMtx populateCC3Matrix4x3: &_viewMatrix];
+		[viewMtx populateCC3Matrix4x3: &newMtx];
 	else
-		CC3Matrix4x3PopulateIdentity(&_viewMatrix);
+		CC3Matrix4x3PopulateIdentity(&newMtx);
 
+	if (_viewMatrixVersion && memcmp(&newMtx, &_viewMatrix, sizeof(newMtx)) == 0) return;
+
+	_viewMatrix = newMtx;
+	_viewMatrixVersion = ++_lastMatrixVersion;
 	_isVPMtxDirty = YES;
 	_isMVMtxDirty = YES;
 	_isMVPMtxDirty = YES;
 }
 
 -(void) populateModelMatrixFrom: (CC3Matrix*) modelMtx {
+	CC3Matrix4x3 newMtx;
 	if (modelMtx)
-		[modelMtx populateCC3Matrix4x3: &_modelMatrix];
+		[modelMtx populateCC3Matrix4x3: &newMtx];
 	else
-		CC3Matrix4x3PopulateIdentity(&_modelMatrix);
+		CC3Matrix4x3PopulateIdentity(&newMtx);
+
+	if (_modelMatrixVersion && memcmp(&newMtx, &_modelMatrix, sizeof(newMtx)) == 0) return;
 
+	_modelMatrix = newMtx;
+	_modelMatrixVersion = ++_lastMatrixVersion;
 	_isMVMtxDirty = YES;
 	_isMVPMtxDirty = YES;
 }
@@ -560,6 +684,134 @@
 @end
 
 
+#pragma mark -
+#pragma mark CC3FramePacket
+
+@interface CC3FramePacket (TemplateMethods)
+-(void) ensureEntryCapacity: (NSUInteger) entryCount;
+-(void) ensureBoneMatrixCapacity: (NSUInteger) matrixCount;
+@end
+
+@implementation CC3FramePacket
+
+@synthesize viewMatrix, projectionMatrix;
+
+-(void) dealloc {
+	[nodes release];
+	[viewMatrix release];
+	[projectionMatrix release];
+	free(entries);
+	free(boneMatrices);
+	[super dealloc];
+}
+
+-(NSUInteger) nodeCount { return nodes.count; }
+
+-(CC3Node*) nodeAt: (NSUInteger) index { return (CC3Node*)[nodes objectAtIndex: index]; }
+
+-(CC3FramePacketEntry*) entryAt: (NSUInteger) index { return &entries[index]; }
+
+-(CC3Matrix4x3*) bonePaletteAt: (NSUInteger) index {
+	CC3FramePacketEntry* entry = &entries[index];
+	return (entry->boneMatrixCount > 0) ? &boneMatrices[entry->firstBoneMatrix] : NULL;
+}
+
+
+#pragma mark Allocation and initialization
+
+-(id) init {
+	if ( (self = [super init]) ) {
+		nodes = nil;
+		entries = NULL;
+		entryCapacity = 0;
+		boneMatrices = NULL;
+		boneMatrixCount = 0;
+		boneMatrixCapacity = 0;
+		viewMatrix = [CC3AffineMatrix new];
+		projectionMatrix = [CC3ProjectionMatrix new];
+	}
+	return self;
+}
+
++(id) framePacket { return [[[self alloc] init] autorelease]; }
+
+-(NSString*) description {
+	return [NSString stringWithFormat: @"%@ with %u nodes and %u bone matrices",
+			[self class], self.nodeCount, boneMatrixCount];
+}
+
+
+#pragma mark Capturing
+
+-(void) captureScene: (CC3Scene*) aScene {
+	CC3Camera* cam = aScene.activeCamera;
+	CC3Frustum* frustum = cam.frustum;
+	CC3NodeSequencer* seqncr = aScene.drawingSequencer;
+	CCArray* candidates = seqncr ? seqncr.nodes : [aScene flatten];
+
+	// Nodes captured last time might be released for good here, so release them on the
+	// main thread, where any GL resources they hold can be safely deleted.
+	CCArray* prevNodes = nodes;
+	nodes = [[CCArray alloc] initWithCapacity: candidates.count];
+	if (prevNodes) dispatch_async(dispatch_get_main_queue(), ^{ [prevNodes release]; });
+
+	[self ensureEntryCapacity: candidates.count];
+	boneMatrixCount = 0;
+
+	for (CC3Node* aNode in candidates) {
+		if ( !(aNode.hasLocalContent && aNode.visible && [aNode doesIntersectFrustum: frustum]) ) continue;
+
+		CC3FramePacketEntry* entry = &entries[nodes.count];
+		[aNode.transformMatrix populateCC3Matrix4x3: &entry->modelMatrix];
+
+		GLuint boneCnt = aNode.bonePaletteCount;
+		[self ensureBoneMatrixCapacity: (boneMatrixCount + boneCnt)];
+		entry->firstBoneMatrix = boneMatrixCount;
+		entry->boneMatrixCount = boneCnt;
+		[aNode populateBonePalette: &boneMatrices[boneMatrixCount]];
+		boneMatrixCount += boneCnt;
+
+		[nodes addObject: aNode];
+	}
+
+	[viewMatrix populateFrom: cam.viewMatrix];
+	[projectionMatrix populateFrom: cam.projectionMatrix];
+
+	LogTrace(@"%@ captured from %@", self, aScene);
+}
+
+-(void) ensureEntryCapacity: (NSUInteger) entryCount {
+	if (entryCount <= entryCapacity) return;
+	entries = realloc(entries, entryCount * sizeof(CC3FramePacketEntry));
+	entryCapacity = entryCount;
+}
+
+-(void) ensureBoneMatrixCapacity: (NSUInteger) matrixCount {
+	if (matrixCount <= boneMatrixCapacity) return;
+	boneMatrixCapacity = MAX(matrixCount, boneMatrixCapacity * 2);
+	boneMatrices = realloc(boneMatrices, boneMatrixCapacity * sizeof(CC3Matrix4x3));
+}
+
+
+#pragma mark Drawing
+
+-(void) openCamera {
+	CC3OpenGLESMatrices* glesMatrices = [CC3OpenGLESEngine engine].matrices;
+	[glesMatrices.projection push];
+	[glesMatrices.projection load: projectionMatrix];
+	[glesMatrices.modelview push];
+	[glesMatrices.modelview load: viewMatrix];
+}
+
+-(void) closeCamera {
+	CC3OpenGLESMatrices* glesMatrices = [CC3OpenGLESEngine engine].matrices;
+	[glesMatrices.modelview pop];
+	[glesMatrices.projection pop];
+}
+
+@end
+
+
 #pragma mark -
 #pragma mark CC3NodePickingVisitor
 
@@ -0,0 +1,228 @@
+/*
+ * CC3OcclusionCulling.h
+ *
+ * cocos3d 2.0.0
+ * Author: Bill Hollings
+ * Copyright (c) 2010-2013 The Brenwill Workshop Ltd. All rights reserved.
+ * http://www.brenwill.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * http://en.wikipedia.org/wiki/MIT_License
+ */
+
+/** @file */	// Doxygen marker
+
+
+#import "CC3Foundation.h"
+#import "CC3Matrix4x4.h"
+
+@class CC3Node, CC3MeshNode, CC3Camera;
+
+
+/** The default width of the depth buffer of a CC3OcclusionBuffer, in pixels. */
+#define kCC3DefaultOcclusionBufferWidth			128
+
+/** The default height of the depth buffer of a CC3OcclusionBuffer, in pixels. */
+#define kCC3DefaultOcclusionBufferHeight		64
+
+/** The default number of frames that a node found to be visible is assumed to remain visible. */
+#define kCC3DefaultOcclusionVisibilityPersistence	4
+
+
+#pragma mark -
+#pragma mark CC3OcclusionBuffer
+
+/**
+ * CC3OcclusionBuffer is a low-resolution depth buffer that is rendered entirely by the CPU.
+ *
+ * The triangles of occluding meshes are rasterized into the buffer, after which the bounding
+ * boxes of other objects can be tested against the buffer to determine whether they are
+ * completely hidden behind the occluders.
+ *
+ * Both operations are conservative. A pixel is only written by an occluder triangle if the
+ * triangle covers the whole pixel, and is written with the farthest depth of the triangle
+ * within that pixel. A bounding box is only reported as occluded if every pixel it covers
+ * holds a depth that is nearer than the nearest corner of the box. Objects may therefore be
+ * reported as visible when they are not, but are never reported as occluded when they are not.
+ *
+ * Depths are stored as floating point values between zero (at the near clipping plane) and one
+ * (at the far clipping plane), in rows from the bottom of the view to the top. Triangles that
+ * cross the near clipping plane are not rasterized, and boxes that cross it are never occluded.
+ *
+ * This class makes no use of the GL engine, and can be used on any thread, and in the absence of
+ * a GL context. An instance should not be accessed by more than one thread at a time.
+ */
+@interface CC3OcclusionBuffer : NSObject {
+	GLfloat* _depths;
+	GLuint _width;
+	GLuint _height;
+	CC3Matrix4x4 _viewProjMatrix;
+	GLuint _rasterizedTriangleCount;
+}
+
+/** The width of this buffer, in pixels. */
+@property(nonatomic, readonly) GLuint width;
+
+/** The height of this buffer, in pixels. */
+@property(nonatomic, readonly) GLuint height;
+
+/** Returns a pointer to the width * height depth values held by this buffer, in rows from the bottom. */
+@property(nonatomic, readonly) GLfloat* depths;
+
+/** The number of triangles rasterized into this buffer since it was last cleared. */
+@property(nonatomic, readonly) GLuint rasterizedTriangleCount;
+
+/** Returns the depth held in the pixel at the specified column and row. */
+-(GLfloat) depthAtX: (GLuint) x andY: (GLuint) y;
+
+/**
+ * Sets every pixel in this buffer to the far depth, and sets the matrix that will be used
+ * to project global locations into this buffer. The matrix is typically the product of the
+ * projection and view matrices of the camera.
+ */
+-(void) clearWithViewProjectionMatrix: (CC3Matrix4x4*) vpMtx;
+
+/** Rasterizes the triangle whose three corners are the specified global locations. */
+-(void) rasterizeTriangle: (const CC3Vector*) globalVertices;
+
+/**
+ * Rasterizes each of the triangle faces of the mesh of the specified node,
+ * transformed to global coordinates by the transformMatrix of the node.
+ *
+ * Mesh faces are retrieved using the faceAt: method of the node. For best performance,
+ * set the shouldCacheFaces property of the occluder node to YES, and use simple meshes
+ * with a small number of large triangles as occluders.
+ */
+-(void) rasterizeMeshNode: (CC3MeshNode*) aNode;
+
+/** Returns whether the specified bounding box, in global coordinates, is completely hidden by this buffer. */
+-(BOOL) isBoxOccluded: (CC3BoundingBox) globalBox;
+
+
+#pragma mark Allocation and initialization
+
+/** Initializes this instance with a depth buffer of the specified dimensions, in pixels. */
+-(id) initWithWidth: (GLuint) width andHeight: (GLuint) height;
+
+/** Allocates and initializes an autoreleased instance with a depth buffer of the specified dimensions. */
++(id) bufferWithWidth: (GLuint) width andHeight: (GLuint) height;
+
+/**
+ * Allocates and initializes an autoreleased instance with a depth buffer with dimensions
+ * of kCC3DefaultOcclusionBufferWidth and kCC3DefaultOcclusionBufferHeight.
+ */
++(id) buffer;
+
+@end
+
+
+#pragma mark -
+#pragma mark CC3OcclusionCuller
+
+/**
+ * CC3OcclusionCuller prevents nodes that are hidden behind designated occluder nodes,
+ * such as walls, buildings or terrain, from being drawn.
+ *
+ * To use occlusion culling, add the occluder nodes to an instance of this class, using the
+ * addOccluder: method, and set that instance into the occlusionCuller property of the CC3Scene.
+ * Good occluders are large, opaque, static meshes with few triangles. Often these are simple,
+ * invisible meshes placed inside the visible geometry of walls or buildings.
+ *
+ * Near the beginning of each frame, the scene invokes the prepareForCamera: method, which
+ * renders the occluders that lie within the camera frustum into a low resolution
+ * CC3OcclusionBuffer. Occluders are rendered whether or not they are visible. As each node is
+ * drawn, the drawing visitor invokes the isNodeOccluded: method, which tests the global
+ * bounding box of the local content of the node against the buffer.
+ *
+ * To avoid flickering as nodes pass in and out of view at the edges of occluders, a node that
+ * has been found to be visible is assumed to remain visible, without being retested, for the
+ * number of frames indicated by the visibilityPersistence property.
+ *
+ * Occlusion culling is applied only when the scene is drawn by traversing the node hierarchy.
+ * When the scene is updated concurrently, and drawn from frame packets, nodes are culled only
+ * against the camera frustum during updating.
+ */
+@interface CC3OcclusionCuller : NSObject {
+	CC3OcclusionBuffer* _occlusionBuffer;
+	CCArray* _occluders;
+	CFMutableDictionaryRef _lastVisibleFrames;
+	GLuint _frameCount;
+	GLuint _visibilityPersistence;
+	GLuint _testedNodeCount;
+	GLuint _occludedNodeCount;
+}
+
+/**
+ * The depth buffer into which occluders are rendered.
+ *
+ * The initial value of this property is a buffer with dimensions of kCC3DefaultOcclusionBufferWidth
+ * and kCC3DefaultOcclusionBufferHeight. Larger buffers provide more accurate culling, at the cost
+ * of more time spent rendering occluders.
+ */
+@property(nonatomic, retain) CC3OcclusionBuffer* occlusionBuffer;
+
+/** The nodes that are rendered into the occlusion buffer each frame. */
+@property(nonatomic, readonly) CCArray* occluders;
+
+/** Adds the specified node as an occluder. Occluders are never culled by this culler. */
+-(void) addOccluder: (CC3MeshNode*) aNode;
+
+/** Removes the specified occluder node. */
+-(void) removeOccluder: (CC3MeshNode*) aNode;
+
+/** Removes all occluder nodes. */
+-(void) removeAllOccluders;
+
+/**
+ * The number of frames that a node that has been found to be visible is assumed to remain visible,
+ * before it is tested against the occlusion buffer again. Setting this value to zero causes every
+ * node to be tested in every frame.
+ *
+ * The initial value of this property is kCC3DefaultOcclusionVisibilityPersistence.
+ */
+@property(nonatomic, assign) GLuint visibilityPersistence;
+
+/** The number of nodes tested against the occlusion buffer during the current frame. */
+@property(nonatomic, readonly) GLuint testedNodeCount;
+
+/** The number of nodes found to be occluded during the current frame. */
+@property(nonatomic, readonly) GLuint occludedNodeCount;
+
+/**
+ * Clears the occlusion buffer, and renders into it each occluder that intersects
+ * the frustum of the specified camera, using the view and projection matrices of the camera.
+ *
+ * This method is invoked automatically by CC3Scene near the beginning of each frame drawing
+ * cycle. Usually, the application never needs to invoke this method directly.
+ */
+-(void) prepareForCamera: (CC3Camera*) aCamera;
+
+/**
+ * Returns whether the local content of the specified node is hidden behind the occluders.
+ *
+ * This method is invoked automatically by CC3NodeDrawingVisitor as each node is drawn.
+ * Usually, the application never needs to invoke this method directly.
+ */
+-(BOOL) isNodeOccluded: (CC3Node*) aNode;
+
+/** Allocates and initializes an autoreleased instance. */
++(id) culler;
+
+@end
@@ -0,0 +1,344 @@
+/*
+ * CC3OcclusionCulling.m
+ *
+ * cocos3d 2.0.0
+ * Author: Bill Hollings
+ * Copyright (c) 2010-2013 The Brenwill Workshop Ltd. All rights reserved.
+ * http://www.brenwill.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * http://en.wikipedia.org/wiki/MIT_License
+ *
+ * See header file CC3OcclusionCulling.h for full API documentation.
+ */
+
+#import "CC3OcclusionCulling.h"
+#import "CC3MeshNode.h"
+#import "CC3Camera.h"
+
+/** Locations with a clip-space W below this value are considered to cross the near clipping plane. */
+#define kCC3OcclusionMinimumW			0.00001f
+
+/** The interval, in frames, at which stale entries are pruned from the visibility history. */
+#define kCC3OcclusionPruneInterval		64
+
+
+#pragma mark -
+#pragma mark CC3OcclusionBuffer
+
+@implementation CC3OcclusionBuffer
+
+@synthesize width=_width, height=_height, depths=_depths;
+@synthesize rasterizedTriangleCount=_rasterizedTriangleCount;
+
+-(void) dealloc {
+	free(_depths);
+	[super dealloc];
+}
+
+-(GLfloat) depthAtX: (GLuint) x andY: (GLuint) y {
+	CC3Assert(x < _width && y < _height, @"%@ pixel (%u, %u) is out of bounds", self, x, y);
+	return _depths[(y * _width) + x];
+}
+
+-(void) clearWithViewProjectionMatrix: (CC3Matrix4x4*) vpMtx {
+	CC3Matrix4x4PopulateFrom4x4(&_viewProjMatrix, vpMtx);
+	GLuint pixCnt = _width * _height;
+	for (GLuint i = 0; i < pixCnt; i++) _depths[i] = 1.0f;
+	_rasterizedTriangleCount = 0;
+}
+
+/**
+ * Projects the specified global location into the pixel coordinates of this buffer, returning
+ * the pixel X & Y coordinates, and the depth between zero and one, in the X, Y & Z components of
+ * the returned vector. Returns NO if the location lies on or behind the near clipping plane.
+ */
+-(BOOL) project: (CC3Vector) aLocation into: (CC3Vector*) pixLoc {
+	CC3Vector4 clipLoc = CC3Matrix4x4TransformCC3Vector4(&_viewProjMatrix, CC3Vector4FromLocation(aLocation));
+	if (clipLoc.w < kCC3OcclusionMinimumW) return NO;
+
+	GLfloat invW = 1.0f / clipLoc.w;
+	pixLoc->x = ((clipLoc.x * invW) * 0.5f + 0.5f) * _width;
+	pixLoc->y = ((clipLoc.y * invW) * 0.5f + 0.5f) * _height;
+	pixLoc->z = (clipLoc.z * invW) * 0.5f + 0.5f;
+	return YES;
+}
+
+/**
+ * Triangles are rasterized conservatively. A pixel is covered only if its center lies far enough
+ * inside each edge that the whole pixel is inside the triangle, and it is written with the depth
+ * of the triangle at the pixel center, pushed back to the farthest depth within the pixel.
+ * Triangles of either winding are rasterized, so occluders are effectively double-sided.
+ */
+-(void) rasterizeTriangle: (const CC3Vector*) globalVertices {
+	CC3Vector p0, p1, p2;
+	if ( !([self project: globalVertices[0] into: &p0] &&
+		   [self project: globalVertices[1] into: &p1] &&
+		   [self project: globalVertices[2] into: &p2]) ) return;
+
+	// Orient the triangle counter-clockwise on screen
+	GLfloat area = (p1.x - p0.x) * (p2.y - p0.y) - (p2.x - p0.x) * (p1.y - p0.y);
+	if (ABS(area) < FLT_EPSILON) return;
+	if (area < 0.0f) {
+		CC3Vector tmp = p1;
+		p1 = p2;
+		p2 = tmp;
+		area = -area;
+	}
+
+	// Pixel bounds of the triangle, clipped to the buffer
+	GLint minX = MAX((GLint)floorf(MIN(MIN(p0.x, p1.x), p2.x)), 0);
+	GLint maxX = MIN((GLint)ceilf(MAX(MAX(p0.x, p1.x), p2.x)), (GLint)_width) - 1;
+	GLint minY = MAX((GLint)floorf(MIN(MIN(p0.y, p1.y), p2.y)), 0);
+	GLint maxY = MIN((GLint)ceilf(MAX(MAX(p0.y, p1.y), p2.y)), (GLint)_height) - 1;
+	if (minX > maxX || minY > maxY) return;
+
+	// Edge functions E(x, y) = A*x + B*y + C, positive inside, for edges 0->1, 1->2 and 2->0.
+	// Each is offset so that it is non-negative only where the entire pixel is inside the edge.
+	GLfloat eA[3], eB[3], eC[3];
+	CC3Vector ev[4] = { p0, p1, p2, p0 };
+	for (GLuint i = 0; i < 3; i++) {
+		eA[i] = ev[i].y - ev[i + 1].y;
+		eB[i] = ev[i + 1].x - ev[i].x;
+		eC[i] = -(eA[i] * ev[i].x + eB[i] * ev[i].y) - 0.5f * (ABS(eA[i]) + ABS(eB[i]));
+	}
+
+	// Depth plane of the triangle, and the farthest offset from the pixel center within a pixel
+	GLfloat dzdx = ((p1.z - p0.z) * (p2.y - p0.y) - (p2.z - p0.z) * (p1.y - p0.y)) / area;
+	GLfloat dzdy = ((p2.z - p0.z) * (p1.x - p0.x) - (p1.z - p0.z) * (p2.x - p0.x)) / area;
+	GLfloat dzPix = 0.5f * (ABS(dzdx) + ABS(dzdy));
+	GLfloat maxZ = MAX(MAX(p0.z, p1.z), p2.z);
+
+	for (GLint y = minY; y <= maxY; y++) {
+		GLfloat cy = y + 0.5f;
+		GLfloat cx = minX + 0.5f;
+		GLfloat e0 = eA[0] * cx + eB[0] * cy + eC[0];
+		GLfloat e1 = eA[1] * cx + eB[1] * cy + eC[1];
+		GLfloat e2 = eA[2] * cx + eB[2] * cy + eC[2];
+		GLfloat z = p0.z + dzdx * (cx - p0.x) + dzdy * (cy - p0.y) + dzPix;
+		GLfloat* row = _depths + (y * _width);
+		for (GLint x = minX; x <= maxX; x++) {
+			if (e0 >= 0.0f && e1 >= 0.0f && e2 >= 0.0f) {
+				GLfloat pixZ = MIN(z, maxZ);
+				if (pixZ < row[x]) row[x] = pixZ;
+			}
+			e0 += eA[0];
+			e1 += eA[1];
+			e2 += eA[2];
+			z += dzdx;
+		}
+	}
+	_rasterizedTriangleCount++;
+}
+
+-(void) rasterizeMeshNode: (CC3MeshNode*) aNode {
+	CC3Matrix* tMtx = aNode.transformMatrix;
+	GLuint faceCnt = aNode.faceCount;
+	for (GLuint faceIdx = 0; faceIdx < faceCnt; faceIdx++) {
+		CC3Face face = [aNode faceAt: faceIdx];
+		for (GLuint i = 0; i < 3; i++) face.vertices[i] = [tMtx transformLocation: face.vertices[i]];
+		[self rasterizeTriangle: face.vertices];
+	}
+	LogTrace(@"%@ rasterized %u faces of %@", self, faceCnt, aNode);
+}
+
+/**
+ * The box is occluded only if all of its corners are in front of the camera, and every pixel
+ * covered by the screen rectangle that surrounds the projected corners holds an occluder depth
+ * that is nearer than the nearest corner. Boxes that lie outside the buffer are left to the frustum.
+ */
+-(BOOL) isBoxOccluded: (CC3BoundingBox) globalBox {
+	if (CC3BoundingBoxIsNull(globalBox)) return NO;
+
+	CC3Vector bbMin = globalBox.minimum;
+	CC3Vector bbMax = globalBox.maximum;
+	GLfloat minX = INFINITY, maxX = -INFINITY, minY = INFINITY, maxY = -INFINITY, minZ = INFINITY;
+	for (GLuint i = 0; i < 8; i++) {
+		CC3Vector corner = cc3v((i & 1) ? bbMax.x : bbMin.x,
+								(i & 2) ? bbMax.y : bbMin.y,
+								(i & 4) ? bbMax.z : bbMin.z);
+		CC3Vector pixLoc;
+		if ( ![self project: corner into: &pixLoc] ) return NO;
+		minX = MIN(minX, pixLoc.x);
+		maxX = MAX(maxX, pixLoc.x);
+		minY = MIN(minY, pixLoc.y);
+		maxY = MAX(maxY, pixLoc.y);
+		minZ = MIN(minZ, pixLoc.z);
+	}
+
+	GLint x0 = MAX((GLint)floorf(minX), 0);
+	GLint x1 = MIN((GLint)ceilf(maxX), (GLint)_width) - 1;
+	GLint y0 = MAX((GLint)floorf(minY), 0);
+	GLint y1 = MIN((GLint)ceilf(maxY), (GLint)_height) - 1;
+	if (x0 > x1 || y0 > y1) return NO;
+
+	for (GLint y = y0; y <= y1; y++) {
+		GLfloat* row = _depths + (y * _width);
+		for (GLint x = x0; x <= x1; x++) if (row[x] >= minZ) return NO;
+	}
+	return YES;
+}
+
+
+#pragma mark Allocation and initialization
+
+-(id) init {
+	return [self initWithWidth: kCC3DefaultOcclusionBufferWidth
+					 andHeight: kCC3DefaultOcclusionBufferHeight];
+}
+
+-(id) initWithWidth: (GLuint) width andHeight: (GLuint) height {
+	CC3Assert(width && height, @"%@ must have a non-zero width and height", [self class]);
+	if ( (self = [super init]) ) {
+		_width = width;
+		_height = height;
+		_depths = malloc(_width * _height * sizeof(GLfloat));
+		_rasterizedTriangleCount = 0;
+		CC3Matrix4x4PopulateIdentity(&_viewProjMatrix);
+		[self clearWithViewProjectionMatrix: &_viewProjMatrix];
+	}
+	return self;
+}
+
++(id) bufferWithWidth: (GLuint) width andHeight: (GLuint) height {
+	return [[[self alloc] initWithWidth: width andHeight: height] autorelease];
+}
+
++(id) buffer { return [[[self alloc] init] autorelease]; }
+
+-(NSString*) description {
+	return [NSString stringWithFormat: @"%@ %u x %u", [self class], _width, _height];
+}
+
+@end
+
+
+#pragma mark -
+#pragma mark CC3OcclusionCuller
+
+@interface CC3OcclusionCuller (TemplateMethods)
+-(void) pruneVisibilityHistory;
+@end
+
+@implementation CC3OcclusionCuller
+
+@synthesize occlusionBuffer=_occlusionBuffer, occluders=_occluders;
+@synthesize visibilityPersistence=_visibilityPersistence;
+@synthesize testedNodeCount=_testedNodeCount, occludedNodeCount=_occludedNodeCount;
+
+-(void) dealloc {
+	[_occlusionBuffer release];
+	[_occluders release];
+	CFRelease(_lastVisibleFrames);
+	[super dealloc];
+}
+
+-(void) addOccluder: (CC3MeshNode*) aNode {
+	if (aNode && ![_occluders containsObject: aNode]) [_occluders addObject: aNode];
+}
+
+-(void) removeOccluder: (CC3MeshNode*) aNode { [_occluders removeObjectIdenticalTo: aNode]; }
+
+-(void) removeAllOccluders { [_occluders removeAllObjects]; }
+
+
+#pragma mark Allocation and initialization
+
+-(id) init {
+	if ( (self = [super init]) ) {
+		_occlusionBuffer = [[CC3OcclusionBuffer buffer] retain];
+		_occluders = [[CCArray array] retain];
+		_lastVisibleFrames = CFDictionaryCreateMutable(kCFAllocatorDefault, 0, NULL, NULL);
+		_frameCount = 0;
+		_visibilityPersistence = kCC3DefaultOcclusionVisibilityPersistence;
+		_testedNodeCount = 0;
+		_occludedNodeCount = 0;
+	}
+	return self;
+}
+
++(id) culler { return [[[self alloc] init] autorelease]; }
+
+-(NSString*) description {
+	return [NSString stringWithFormat: @"%@ with %u occluders in %@",
+			[self class], (GLuint)_occluders.count, _occlusionBuffer];
+}
+
+
+#pragma mark Culling
+
+-(void) prepareForCamera: (CC3Camera*) aCamera {
+	_frameCount++;
+	_testedNodeCount = 0;
+	_occludedNodeCount = 0;
+	if (_frameCount % kCC3OcclusionPruneInterval == 0) [self pruneVisibilityHistory];
+
+	CC3Matrix4x4 projMtx, viewMtx, vpMtx;
+	[aCamera.projectionMatrix populateCC3Matrix4x4: &projMtx];
+	[aCamera.viewMatrix populateCC3Matrix4x4: &viewMtx];
+	CC3Matrix4x4Multiply(&vpMtx, &projMtx, &viewMtx);
+	[_occlusionBuffer clearWithViewProjectionMatrix: &vpMtx];
+
+	CC3Frustum* frustum = aCamera.frustum;
+	for (CC3MeshNode* occluder in _occluders)
+		if ([occluder doesIntersectFrustum: frustum]) [_occlusionBuffer rasterizeMeshNode: occluder];
+
+	LogTrace(@"%@ rasterized %u triangles", self, _occlusionBuffer.rasterizedTriangleCount);
+}
+
+/**
+ * Nodes are tracked by address, without being retained. If a deallocated node is replaced
+ * by another at the same address, the new node may skip testing for a few frames, which
+ * only results in it being drawn when it might have been culled.
+ */
+-(BOOL) isNodeOccluded: (CC3Node*) aNode {
+	if ( ![aNode isKindOfClass: [CC3LocalContentNode class]] ) return NO;
+	if ([_occluders containsObject: aNode]) return NO;
+
+	GLuint lastVisFrame = (GLuint)(uintptr_t)CFDictionaryGetValue(_lastVisibleFrames, aNode);
+	if (lastVisFrame && (_frameCount - lastVisFrame) < _visibilityPersistence) return NO;
+
+	_testedNodeCount++;
+	if ([_occlusionBuffer isBoxOccluded: ((CC3LocalContentNode*)aNode).globalLocalContentBoundingBox]) {
+		_occludedNodeCount++;
+		return YES;
+	}
+	CFDictionarySetValue(_lastVisibleFrames, aNode, (const void*)(uintptr_t)_frameCount);
+	return NO;
+}
+
+/** Removes the nodes whose visibility has expired from the visibility history. */
+-(void) pruneVisibilityHistory {
+	CFIndex entryCnt = CFDictionaryGetCount(_lastVisibleFrames);
+	if (entryCnt == 0) return;
+
+	const void** keys = malloc(entryCnt * sizeof(void*));
+	const void** values = malloc(entryCnt * sizeof(void*));
+	CFDictionaryGetKeysAndValues(_lastVisibleFrames, keys, values);
+	for (CFIndex i = 0; i < entryCnt; i++) {
+		GLuint lastVisFrame = (GLuint)(uintptr_t)values[i];
+		if ((_frameCount - lastVisFrame) >= _visibilityPersistence)
+			CFDictionaryRemoveValue(_lastVisibleFrames, keys[i]);
+	}
+	free(keys);
+	free(values);
+}
+
+@end
@@ -0,0 +1,209 @@
+/*
+ * CC3OpenGLESCommandBuffer.h
+ *
+ * cocos3d 2.0.0
+ * Author: Bill Hollings
+ * Copyright (c) 2010-2013 The Brenwill Workshop Ltd. All rights reserved.
+ * http://www.brenwill.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * http://en.wikipedia.org/wiki/MIT_License
+ */
+
+/** @file */	// Doxygen marker
+
+
+#import "CC3Foundation.h"
+#import "CC3OpenGLESFoundation.h"
+
+
+/** Enumeration of the types of commands that can be recorded in a CC3OpenGLESCommandBuffer. */
+typedef enum {
+	kCC3GLCommandNone = 0,			/**< Unused command slot. */
+	kCC3GLCommandSetState,			/**< A state tracker changed its GL state. */
+	kCC3GLCommandSetUniform,		/**< A GLSL uniform changed its GL value. */
+	kCC3GLCommandDrawArrays,		/**< Vertices were drawn with glDrawArrays. */
+	kCC3GLCommandDrawElements,		/**< Vertex indices were drawn with glDrawElements. */
+} CC3GLCommandType;
+
+/**
+ * A single compact command recorded in a CC3OpenGLESCommandBuffer.
+ *
+ * The meaning of the mode, start and count elements depends on the command type:
+ *   - kCC3GLCommandSetState: none of the elements are used.
+ *   - kCC3GLCommandSetUniform: mode is the GL type of the uniform, start is its location,
+ *     and count is the number of elements in the uniform array.
+ *   - kCC3GLCommandDrawArrays: mode is the draw mode, start is the first vertex drawn,
+ *     and count is the number of vertices drawn.
+ *   - kCC3GLCommandDrawElements: mode is the draw mode, start is the GL type of the
+ *     vertex indices, count is the number of indices drawn, and data is the index pointer.
+ *
+ * The target element is the state tracker or uniform that issued the command.
+ * It is not retained, and is nil for draw commands.
+ */
+typedef struct {
+	GLubyte type;				/**< The command type, from the CC3GLCommandType enumeration. */
+	GLenum mode;				/**< The draw mode, or uniform type. */
+	GLint start;				/**< The first vertex, index type, or uniform location. */
+	GLuint count;				/**< The number of vertices, indices, or uniform elements. */
+	const GLvoid* data;			/**< The vertex index pointer of a draw elements command. */
+	id target;					/**< The tracker or uniform that issued the command. Not retained. */
+} CC3GLCommand;
+
+
+#pragma mark -
+#pragma mark CC3OpenGLESCommandBuffer
+
+/**
+ * CC3OpenGLESCommandBuffer records the GL state changes and draw calls made through
+ * the CC3OpenGLESEngine into a compact, contiguous array of CC3GLCommand structures.
+ *
+ * To start recording, set an instance of this class into the commandBuffer property of
+ * the CC3OpenGLESEngine singleton. Each state change that the state trackers forward
+ * to the GL engine, each GLSL uniform value that is changed, and each draw call,
+ * will then be appended to this buffer.
+ *
+ * Commands accumulate until the clear method is invoked. Typically, the application will
+ * examine or replay the recorded commands once per frame, and then clear this buffer.
+ *
+ * State changes are recorded by reference to the issuing tracker, and the GL value itself
+ * is not captured. A recorded buffer can therefore be validated and analyzed, using a
+ * CC3OpenGLESNullDriver, but cannot be resubmitted to the GL engine.
+ *
+ * Recording is performed on the thread that is drawing, and this class is not thread-safe.
+ */
+@interface CC3OpenGLESCommandBuffer : NSObject {
+	CC3GLCommand* _commands;
+	GLuint _commandCount;
+	GLuint _commandCapacity;
+}
+
+/** Returns a pointer to the recorded commands. */
+@property(nonatomic, readonly) CC3GLCommand* commands;
+
+/** Returns the number of commands that have been recorded since this buffer was last cleared. */
+@property(nonatomic, readonly) GLuint commandCount;
+
+/**
+ * Returns the number of commands that can be held by this buffer before it must grow.
+ *
+ * The buffer grows automatically as commands are recorded, and retains its capacity
+ * when cleared, so that recording in subsequent frames does not allocate memory.
+ */
+@property(nonatomic, readonly) GLuint commandCapacity;
+
+/** Removes all recorded commands, retaining the allocated capacity. */
+-(void) clear;
+
+/** Records that the GL state managed by the specified tracker has been changed. */
+-(void) recordStateChangeFor: (id) tracker;
+
+/**
+ * Records that the value of the specified GLSL uniform, at the specified location, and
+ * of the specified GL type and array size, has been changed in the GL engine.
+ */
+-(void) recordUniformChangeFor: (id) uniform
+					atLocation: (GLint) location
+						ofType: (GLenum) uniformType
+					   andSize: (GLint) size;
+
+/** Records a glDrawArrays call, using the same parameters as that GL function. */
+-(void) recordDrawVerticiesAs: (GLenum) drawMode startingAt: (GLuint) start withLength: (GLuint) len;
+
+/** Records a glDrawElements call, using the same parameters as that GL function. */
+-(void) recordDrawIndicies: (const GLvoid*) indicies
+				  ofLength: (GLuint) len
+				   andType: (GLenum) type
+						as: (GLenum) drawMode;
+
+/** Initializes this instance with the specified initial command capacity. */
+-(id) initWithCapacity: (GLuint) capacity;
+
+/** Allocates and initializes an autoreleased instance with the specified initial command capacity. */
++(id) commandBufferWithCapacity: (GLuint) capacity;
+
+/** Allocates and initializes an autoreleased instance with a default initial command capacity. */
++(id) commandBuffer;
+
+@end
+
+
+#pragma mark -
+#pragma mark CC3OpenGLESNullDriver
+
+/**
+ * CC3OpenGLESNullDriver replays the commands recorded in a CC3OpenGLESCommandBuffer without
+ * submitting them to the GL engine, validating and counting them as it does so.
+ *
+ * Together with setting the shouldSubmitToGL property of the CC3OpenGLESEngine singleton to NO,
+ * this allows the CPU cost of drawing a scene to be measured without involving the GPU.
+ *
+ * The counts accumulate across invocations of the replay: method until the reset method
+ * is invoked, so that a single null driver can tally several frames.
+ */
+@interface CC3OpenGLESNullDriver : NSObject {
+	GLuint _stateChangeCount;
+	GLuint _uniformChangeCount;
+	GLuint _drawCount;
+	GLuint _vertexCount;
+	GLuint _redundantCommandCount;
+	GLuint _invalidCommandCount;
+}
+
+/** The number of state tracker changes replayed. */
+@property(nonatomic, readonly) GLuint stateChangeCount;
+
+/** The number of GLSL uniform changes replayed. */
+@property(nonatomic, readonly) GLuint uniformChangeCount;
+
+/** The number of draw calls replayed. */
+@property(nonatomic, readonly) GLuint drawCount;
+
+/** The number of vertices, or vertex indices, drawn by the replayed draw calls. */
+@property(nonatomic, readonly) GLuint vertexCount;
+
+/**
+ * The number of replayed commands that were redundant.
+ *
+ * A state or uniform change is redundant if the same tracker or uniform is changed again
+ * before the next draw call, making the first change wasted effort. A uniform change to
+ * an inactive uniform location is also counted as redundant.
+ */
+@property(nonatomic, readonly) GLuint redundantCommandCount;
+
+/**
+ * The number of replayed commands that would have failed in the GL engine.
+ *
+ * This includes draw calls with an illegal draw mode or index type, draw calls that draw
+ * no vertices, state changes with no target tracker, and commands of unknown type.
+ * Each invalid command is logged as an error.
+ */
+@property(nonatomic, readonly) GLuint invalidCommandCount;
+
+/** Validates and counts the commands in the specified command buffer, without submitting them to GL. */
+-(void) replay: (CC3OpenGLESCommandBuffer*) cmdBuffer;
+
+/** Resets all the counts to zero. */
+-(void) reset;
+
+/** Allocates and initializes an autoreleased instance. */
++(id) nullDriver;
+
+@end
@@ -0,0 +1,239 @@
+/*
+ * CC3OpenGLESCommandBuffer.m
+ *
+ * cocos3d 2.0.0
+ * Author: Bill Hollings
+ * Copyright (c) 2010-2013 The Brenwill Workshop Ltd. All rights reserved.
+ * http://www.brenwill.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * http://en.wikipedia.org/wiki/MIT_License
+ *
+ * See header file CC3OpenGLESCommandBuffer.h for full API documentation.
+ */
+
+#import "CC3OpenGLESCommandBuffer.h"
+
+#define kCC3GLCommandBufferDefaultCapacity	1024
+
+
+#pragma mark -
+#pragma mark CC3OpenGLESCommandBuffer
+
+@implementation CC3OpenGLESCommandBuffer
+
+@synthesize commands=_commands, commandCount=_commandCount, commandCapacity=_commandCapacity;
+
+-(void) dealloc {
+	free(_commands);
+	[super dealloc];
+}
+
+-(void) clear { _commandCount = 0; }
+
+/** Returns a pointer to the next free command slot, growing the buffer if needed. */
+-(CC3GLCommand*) nextCommand {
+	if (_commandCount == _commandCapacity) {
+		GLuint newCapacity = MAX(_commandCapacity * 2, 16);
+		CC3GLCommand* newCmds = realloc(_commands, newCapacity * sizeof(CC3GLCommand));
+		CC3Assert(newCmds, @"%@ could not grow to hold %u commands", self, newCapacity);
+		_commands = newCmds;
+		_commandCapacity = newCapacity;
+		LogTrace(@"%@ grew to capacity %u", self, _commandCapacity);
+	}
+	CC3GLCommand* cmd = &_commands[_commandCount++];
+	memset(cmd, 0, sizeof(CC3GLCommand));
+	return cmd;
+}
+
+-(void) recordStateChangeFor: (id) tracker {
+	CC3GLCommand* cmd = [self nextCommand];
+	cmd->type = kCC3GLCommandSetState;
+	cmd->target = tracker;
+}
+
+-(void) recordUniformChangeFor: (id) uniform
+					atLocation: (GLint) location
+						ofType: (GLenum) uniformType
+					   andSize: (GLint) size {
+	CC3GLCommand* cmd = [self nextCommand];
+	cmd->type = kCC3GLCommandSetUniform;
+	cmd->mode = uniformType;
+	cmd->start = location;
+	cmd->count = size;
+	cmd->target = uniform;
+}
+
+-(void) recordDrawVerticiesAs: (GLenum) drawMode startingAt: (GLuint) start withLength: (GLuint) len {
+	CC3GLCommand* cmd = [self nextCommand];
+	cmd->type = kCC3GLCommandDrawArrays;
+	cmd->mode = drawMode;
+	cmd->start = start;
+	cmd->count = len;
+}
+
+-(void) recordDrawIndicies: (const GLvoid*) indicies
+				  ofLength: (GLuint) len
+				   andType: (GLenum) type
+						as: (GLenum) drawMode {
+	CC3GLCommand* cmd = [self nextCommand];
+	cmd->type = kCC3GLCommandDrawElements;
+	cmd->mode = drawMode;
+	cmd->start = type;
+	cmd->count = len;
+	cmd->data = indicies;
+}
+
+
+#pragma mark Allocation and initialization
+
+-(id) init { return [self initWithCapacity: kCC3GLCommandBufferDefaultCapacity]; }
+
+-(id) initWithCapacity: (GLuint) capacity {
+	if ( (self = [super init]) ) {
+		_commandCount = 0;
+		_commandCapacity = capacity;
+		_commands = capacity ? malloc(capacity * sizeof(CC3GLCommand)) : NULL;
+	}
+	return self;
+}
+
++(id) commandBufferWithCapacity: (GLuint) capacity {
+	return [[[self alloc] initWithCapacity: capacity] autorelease];
+}
+
++(id) commandBuffer { return [[[self alloc] init] autorelease]; }
+
+-(NSString*) description {
+	return [NSString stringWithFormat: @"%@ with %u commands (capacity %u)",
+			[self class], _commandCount, _commandCapacity];
+}
+
+@end
+
+
+#pragma mark -
+#pragma mark CC3OpenGLESNullDriver
+
+@implementation CC3OpenGLESNullDriver
+
+@synthesize stateChangeCount=_stateChangeCount, uniformChangeCount=_uniformChangeCount;
+@synthesize drawCount=_drawCount, vertexCount=_vertexCount;
+@synthesize redundantCommandCount=_redundantCommandCount, invalidCommandCount=_invalidCommandCount;
+
+-(void) reset {
+	_stateChangeCount = 0;
+	_uniformChangeCount = 0;
+	_drawCount = 0;
+	_vertexCount = 0;
+	_redundantCommandCount = 0;
+	_invalidCommandCount = 0;
+}
+
+/** Returns whether the specified draw mode is one that the GL engine accepts. */
+static BOOL CC3IsValidDrawMode(GLenum drawMode) {
+	switch (drawMode) {
+		case GL_POINTS:
+		case GL_LINES:
+		case GL_LINE_LOOP:
+		case GL_LINE_STRIP:
+		case GL_TRIANGLES:
+		case GL_TRIANGLE_STRIP:
+		case GL_TRIANGLE_FAN:
+			return YES;
+		default:
+			return NO;
+	}
+}
+
+/**
+ * Returns whether the command at the specified index changes the same target as an earlier
+ * command issued since the last draw call, which is at the specified draw index.
+ */
+static BOOL CC3IsOverwritingCommand(CC3GLCommand* cmds, GLuint cmdIdx, GLint lastDrawIdx) {
+	id target = cmds[cmdIdx].target;
+	for (GLint i = (GLint)cmdIdx - 1; i > lastDrawIdx; i--)
+		if (cmds[i].target == target) return YES;
+	return NO;
+}
+
+-(void) replay: (CC3OpenGLESCommandBuffer*) cmdBuffer {
+	CC3GLCommand* cmds = cmdBuffer.commands;
+	GLuint cmdCount = cmdBuffer.commandCount;
+	GLint lastDrawIdx = -1;
+
+	for (GLuint cmdIdx = 0; cmdIdx < cmdCount; cmdIdx++) {
+		CC3GLCommand* cmd = &cmds[cmdIdx];
+		switch (cmd->type) {
+
+			case kCC3GLCommandSetState:
+				_stateChangeCount++;
+				if ( !cmd->target ) {
+					LogError(@"%@ command %u changes state with no tracker", self, cmdIdx);
+					_invalidCommandCount++;
+				} else if (CC3IsOverwritingCommand(cmds, cmdIdx, lastDrawIdx)) {
+					_redundantCommandCount++;
+				}
+				break;
+
+			case kCC3GLCommandSetUniform:
+				_uniformChangeCount++;
+				if ( !cmd->target || !cmd->mode || cmd->count == 0 ) {
+					LogError(@"%@ command %u sets uniform %@ at location %i of type %@ with %u elements",
+							 self, cmdIdx, cmd->target, cmd->start, NSStringFromGLEnum(cmd->mode), cmd->count);
+					_invalidCommandCount++;
+				} else if (cmd->start < 0 || CC3IsOverwritingCommand(cmds, cmdIdx, lastDrawIdx)) {
+					_redundantCommandCount++;
+				}
+				break;
+
+			case kCC3GLCommandDrawArrays:
+			case kCC3GLCommandDrawElements:
+				_drawCount++;
+				_vertexCount += cmd->count;
+				lastDrawIdx = cmdIdx;
+				if ( !CC3IsValidDrawMode(cmd->mode) || cmd->count == 0 ||
+					(cmd->type == kCC3GLCommandDrawElements &&
+					 cmd->start != GL_UNSIGNED_SHORT && cmd->start != GL_UNSIGNED_BYTE) ) {
+					LogError(@"%@ command %u draws %u vertices as %@ with index type %@",
+							 self, cmdIdx, cmd->count, NSStringFromGLEnum(cmd->mode),
+							 (cmd->type == kCC3GLCommandDrawElements) ? NSStringFromGLEnum(cmd->start) : @"none");
+					_invalidCommandCount++;
+				}
+				break;
+
+			default:
+				LogError(@"%@ command %u has unknown type %u", self, cmdIdx, cmd->type);
+				_invalidCommandCount++;
+				break;
+		}
+	}
+	LogTrace(@"%@ replayed %@", self, cmdBuffer);
+}
+
++(id) nullDriver { return [[[self alloc] init] autorelease]; }
+
+-(NSString*) description {
+	return [NSString stringWithFormat: @"%@ state: %u, uniforms: %u, draws: %u, vertices: %u, redundant: %u, invalid: %u",
+			[self class], _stateChangeCount, _uniformChangeCount, _drawCount,
+			_vertexCount, _redundantCommandCount, _invalidCommandCount];
+}
+
+@end
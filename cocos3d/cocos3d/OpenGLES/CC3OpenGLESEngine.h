@@ -40,6 +40,7 @@
 #import "CC3OpenGLESFog.h"
 #import "CC3OpenGLESHints.h"
 #import "CC3OpenGLESShaders.h"
+#import "CC3OpenGLESCommandBuffer.h"
 
 
 /**
@@ -110,6 +111,13 @@
 	CC3OpenGLESHints* _hints;
 	CC3OpenGLESShaders* _shaders;
 	CC3OpenGLESStateTrackerManager* _appExtensions;
+	CC3OpenGLESCommandBuffer* _commandBuffer;
+	CCArray* _trackersWithChangeCounts;
+	NSMutableSet* _unsubmittedChanges;
+	GLuint _stateChangeCount;
+	GLuint _filteredStateChangeCount;
+	GLuint _stateChangesSinceDrawingCall;
+	BOOL _shouldSubmitToGL : 1;
 	BOOL _isClosing;
 	BOOL _trackerToOpenWasAdded;
 }
@@ -184,6 +192,131 @@
  */
 @property(nonatomic, retain) CC3OpenGLESStateTrackerManager* appExtensions;
 
+/**
+ * If set, each GL state change made by the trackers, each GLSL uniform value set in the GL
+ * engine, and each draw call, will be recorded in this command buffer.
+ *
+ * Recording is in addition to submitting the same changes to the GL engine, unless the
+ * shouldSubmitToGL property is set to NO.
+ *
+ * The application is responsible for clearing the command buffer, typically once per frame,
+ * after examining the commands, or replaying them through a CC3OpenGLESNullDriver.
+ *
+ * The value of this property is nil, and no recording takes place, unless the application
+ * sets a command buffer here.
+ */
+@property(nonatomic, retain) CC3OpenGLESCommandBuffer* commandBuffer;
+
+/**
+ * Indicates whether tracked GL state changes, GLSL uniform values, and draw calls should be
+ * submitted to the GL engine.
+ *
+ * Setting this property to NO turns the GL engine into a null driver. The state trackers
+ * continue to track state as if the changes had been made, and the changes continue to be
+ * recorded in the commandBuffer, if it has been set, but the GL functions are not invoked.
+ * Together with a CC3OpenGLESNullDriver, this allows the CPU cost of drawing a scene to be
+ * measured independently of the GPU.
+ *
+ * This property affects only per-frame drawing. GL resources, such as buffers, textures
+ * and shader programs, continue to be created and loaded in the GL engine.
+ *
+ * When this property is set back to YES, each tracker and GLSL uniform whose value was changed
+ * while this property was NO has that value marked as unknown, so that the next value set in
+ * it is submitted to the GL engine, bringing the GL engine back in line with the tracked state.
+ *
+ * The initial value of this property is YES.
+ */
+@property(nonatomic, assign) BOOL shouldSubmitToGL;
+
+
+
+#pragma mark State change statistics
+
+/**
+ * The number of GL state changes made by all trackers since the resetStateChangeCounts
+ * method was last invoked.
+ *
+ * The CC3Scene adds this value to its performanceStatistics, and resets it, on each frame.
+ */
+@property(nonatomic, readonly) GLuint stateChangeCount;
+
+/**
+ * The number of GL state changes that were requested of all trackers, but were not forwarded
+ * to the GL engine because the state was not changing, since the resetStateChangeCounts
+ * method was last invoked.
+ *
+ * The CC3Scene adds this value to its performanceStatistics, and resets it, on each frame.
+ */
+@property(nonatomic, readonly) GLuint filteredStateChangeCount;
+
+/** The number of GL state changes made by all trackers since the last drawing call was made. */
+@property(nonatomic, readonly) GLuint stateChangesSinceDrawingCall;
+
+/** Resets the stateChangeCount and filteredStateChangeCount properties to zero. */
+-(void) resetStateChangeCounts;
+
+/**
+ * Returns the trackers that have made or filtered GL state changes since the
+ * resetTrackerChangeCounts method was last invoked, ordered by decreasing value
+ * of their changeCount property.
+ *
+ * The first trackers in the returned array are those that are churning the most, and whose
+ * state changes are the most likely candidates for reduction by grouping the nodes that are
+ * drawn according to that state.
+ */
+-(NSArray*) trackersOrderedByChangeCount;
+
+/**
+ * Resets the changeCount and filteredChangeCount properties of all of the trackers
+ * that have made or filtered GL state changes.
+ *
+ * Unlike the stateChangeCount and filteredStateChangeCount properties, the counts in the
+ * individual trackers are not reset automatically on each frame. The application should
+ * invoke this method periodically, typically at the same time it resets the performance
+ * statistics of the CC3Scene.
+ */
+-(void) resetTrackerChangeCounts;
+
+/**
+ * Returns a description of the GL state changes made and filtered by each tracker
+ * in the trackersOrderedByChangeCount array.
+ */
+-(NSString*) changeCountDescription;
+
+/**
+ * Invoked automatically by the specified tracker when it is about to set its state in the
+ * GL engine, to count the change, and to record it in the commandBuffer, if it has been set.
+ *
+ * The application should not invoke this method directly.
+ */
+-(void) notifyStateChangedBy: (CC3OpenGLESStateTracker*) tracker;
+
+/**
+ * Invoked automatically by the specified tracker when a change to its state was requested,
+ * but not forwarded to the GL engine, because the state was not changing.
+ *
+ * The application should not invoke this method directly.
+ */
+-(void) notifyStateChangeFilteredBy: (CC3OpenGLESStateTracker*) tracker;
+
+/**
+ * Invoked automatically when the specified tracker or GLSL uniform has changed its tracked
+ * value without submitting it to the GL engine, because the shouldSubmitToGL property is NO.
+ * The specified object must respond to the markValueUnknown method, which is invoked on it
+ * when the shouldSubmitToGL property is set back to YES.
+ *
+ * The application should not invoke this method directly.
+ */
+-(void) notifyUnsubmittedChangeBy: (id) aTrackerOrUniform;
+
+/**
+ * Invoked automatically when a drawing call is made, to reset the
+ * stateChangesSinceDrawingCall property to zero.
+ *
+ * The application should not invoke this method directly.
+ */
+-(void) notifyDrawingCallMade;
+
 /** Returns the CC3OpenGLESEngine engine singleton. */
 +(CC3OpenGLESEngine*) engine;
 
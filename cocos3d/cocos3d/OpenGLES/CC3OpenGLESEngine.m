@@ -56,6 +56,9 @@
 @synthesize hints=_hints;
 @synthesize shaders=_shaders;
 @synthesize appExtensions;
+@synthesize commandBuffer=_commandBuffer;
+@synthesize stateChangeCount=_stateChangeCount, filteredStateChangeCount=_filteredStateChangeCount;
+@synthesize stateChangesSinceDrawingCall=_stateChangesSinceDrawingCall;
 
 -(void) dealloc {
 	[_platform release];
@@ -70,6 +73,9 @@
 	[_hints release];
 	[_shaders release];
 	[_appExtensions release];
+	[_commandBuffer release];
+	[_trackersWithChangeCounts release];
+	[_unsubmittedChanges release];
 	[_trackersToOpen release];
 	[_trackersToClose releaseAsUnretained];		// Clears without releasing each element.
 
@@ -84,6 +90,13 @@
 		_trackersToClose = [[CCArray arrayWithCapacity: 200] retain];
 		_isClosing = NO;
 		_trackerToOpenWasAdded = NO;
+		_commandBuffer = nil;
+		_shouldSubmitToGL = YES;
+		_trackersWithChangeCounts = [[CCArray arrayWithCapacity: 100] retain];
+		_unsubmittedChanges = [NSMutableSet new];		// retained
+		_stateChangeCount = 0;
+		_filteredStateChangeCount = 0;
+		_stateChangesSinceDrawingCall = 0;
 		[self initializeTrackers];
 	}
 	return self;
@@ -108,6 +121,68 @@ static CC3OpenGLESEngine* _engine;
 
 -(void) initializeTrackers {}
 
+-(BOOL) shouldSubmitToGL { return _shouldSubmitToGL; }
+
+-(void) setShouldSubmitToGL: (BOOL) shouldSubmit {
+	_shouldSubmitToGL = shouldSubmit;
+	if (shouldSubmit) {
+		// Values tracked while not submitting were never seen by the GL engine
+		[_unsubmittedChanges makeObjectsPerformSelector: @selector(markValueUnknown)];
+		[_unsubmittedChanges removeAllObjects];
+	}
+}
+
+-(void) notifyUnsubmittedChangeBy: (id) aTrackerOrUniform { [_unsubmittedChanges addObject: aTrackerOrUniform]; }
+
+
+#pragma mark State change statistics
+
+-(void) notifyStateChangedBy: (CC3OpenGLESStateTracker*) tracker {
+	if ( !(tracker.changeCount || tracker.filteredChangeCount) ) [_trackersWithChangeCounts addObject: tracker];
+	_stateChangeCount++;
+	_stateChangesSinceDrawingCall++;
+	[_commandBuffer recordStateChangeFor: tracker];
+	if ( !_shouldSubmitToGL ) [self notifyUnsubmittedChangeBy: tracker];
+}
+
+-(void) notifyStateChangeFilteredBy: (CC3OpenGLESStateTracker*) tracker {
+	if ( !(tracker.changeCount || tracker.filteredChangeCount) ) [_trackersWithChangeCounts addObject: tracker];
+	_filteredStateChangeCount++;
+}
+
+-(void) notifyDrawingCallMade { _stateChangesSinceDrawingCall = 0; }
+
+-(void) resetStateChangeCounts {
+	_stateChangeCount = 0;
+	_filteredStateChangeCount = 0;
+}
+
+-(void) resetTrackerChangeCounts {
+	for (CC3OpenGLESStateTracker* tracker in _trackersWithChangeCounts) [tracker resetChangeCounts];
+	[_trackersWithChangeCounts removeAllObjects];
+}
+
+-(NSArray*) trackersOrderedByChangeCount {
+	NSMutableArray* sorted = [NSMutableArray arrayWithCapacity: _trackersWithChangeCounts.count];
+	for (CC3OpenGLESStateTracker* tracker in _trackersWithChangeCounts) [sorted addObject: tracker];
+	[sorted sortUsingComparator: ^(id t1, id t2) {
+		GLuint cc1 = ((CC3OpenGLESStateTracker*)t1).changeCount;
+		GLuint cc2 = ((CC3OpenGLESStateTracker*)t2).changeCount;
+		if (cc1 > cc2) return NSOrderedAscending;
+		if (cc1 < cc2) return NSOrderedDescending;
+		return NSOrderedSame;
+	}];
+	return sorted;
+}
+
+-(NSString*) changeCountDescription {
+	NSMutableString* desc = [NSMutableString stringWithCapacity: 1000];
+	[desc appendFormat: @"%@ GL state changes:\n\tChanged\tFiltered\tTracker", [self class]];
+	for (CC3OpenGLESStateTracker* tracker in [self trackersOrderedByChangeCount])
+		[desc appendFormat: @"\n\t%u\t%u\t%@", tracker.changeCount, tracker.filteredChangeCount, tracker];
+	return desc;
+}
+
 -(NSString*) description {
 	NSMutableString* desc = [NSMutableString stringWithCapacity: 600];
 	[desc appendFormat: @"%@:", [self class]];
@@ -78,9 +78,11 @@
 	if (shouldSetGL) {
 		[sourceBlend setValueRaw: srcBlend];
 		[destinationBlend setValueRaw: dstBlend];
-		[self setGLValues];
+		if ([self shouldSubmitGLChange]) [self setGLValues];
 		[self notifyGLChanged];
 		self.valueIsKnown = YES;
+	} else {
+		[self notifyGLChangeFiltered];
 	}
 	LogGLErrorTrace(@"while setting GL values for %@", self);
 }
@@ -140,9 +142,11 @@
 	if (shouldSetGL) {
 		[function setValueRaw: func];
 		[reference setValueRaw: refValue];
-		[self setGLValues];
+		if ([self shouldSubmitGLChange]) [self setGLValues];
 		[self notifyGLChanged];
 		self.valueIsKnown = YES;
+	} else {
+		[self notifyGLChangeFiltered];
 	}
 	LogGLErrorTrace(@"while setting GL values for %@", self);
 }
@@ -260,6 +260,9 @@
  * Clears the buffers identified by the specified bitmask, which is a bitwise OR
  * combination of one or more of the following masks: GL_COLOR_BUFFER_BIT,
  * GL_DEPTH_BUFFER_BIT, and GL_STENCIL_BUFFER_BIT
+ *
+ * The buffers are not cleared if the shouldSubmitToGL property of the
+ * CC3OpenGLESEngine is set to NO.
  */
 -(void) clearBuffers: (GLbitfield) mask;
 
@@ -102,9 +102,11 @@
 		[function setValueRaw: func];
 		[reference setValueRaw: refValue];
 		[mask setValueRaw: maskValue];
-		[self setGLValues];
+		if ([self shouldSubmitGLChange]) [self setGLValues];
 		[self notifyGLChanged];
 		self.valueIsKnown = YES;
+	} else {
+		[self notifyGLChangeFiltered];
 	}
 	LogGLErrorTrace(@"while setting GL values for %@", self);
 }
@@ -186,9 +188,11 @@
 		[stencilFail setValueRaw: failOp];
 		[depthFail setValueRaw: zFailOp];
 		[depthPass setValueRaw: zPassOp];
-		[self setGLValues];
+		if ([self shouldSubmitGLChange]) [self setGLValues];
 		[self notifyGLChanged];
 		self.valueIsKnown = YES;
+	} else {
+		[self notifyGLChangeFiltered];
 	}
 	LogGLErrorTrace(@"while setting GL values for %@", self);
 }
@@ -259,9 +263,11 @@
 	if (shouldSetGL) {
 		[factor setValueRaw: factorValue];
 		[units setValueRaw: unitsValue];
-		[self setGLValues];
+		if ([self shouldSubmitGLChange]) [self setGLValues];
 		[self notifyGLChanged];
 		self.valueIsKnown = YES;
+	} else {
+		[self notifyGLChangeFiltered];
 	}
 	LogGLErrorTrace(@"while setting GL values for %@", self);
 }
@@ -362,7 +368,7 @@
 	return desc;
 }
 
--(void) clearBuffers: (GLbitfield) mask { glClear(mask); }
+-(void) clearBuffers: (GLbitfield) mask { if (self.engine.shouldSubmitToGL) glClear(mask); }
 
 -(void) clearColorBuffer { [self clearBuffers: GL_COLOR_BUFFER_BIT]; }
 
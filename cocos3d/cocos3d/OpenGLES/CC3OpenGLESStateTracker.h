@@ -126,6 +126,8 @@ typedef enum {
  */
 @interface CC3OpenGLESStateTracker : NSObject {
 	CC3OpenGLESStateTracker* parent;
+	GLuint changeCount;
+	GLuint filteredChangeCount;
 	BOOL isScheduledForClose : 1;
 }
 
@@ -177,6 +179,63 @@ typedef enum {
  */
 -(void) notifyGLChanged;
 
+/**
+ * Invoked automatically immediately before this tracker sets its value in the GL engine.
+ *
+ * Records the change in the commandBuffer of the CC3OpenGLESEngine, if it has one, and returns
+ * the value of the shouldSubmitToGL property of that engine, indicating whether the GL function
+ * should actually be invoked.
+ *
+ * The application should not invoke this method directly.
+ */
+-(BOOL) shouldSubmitGLChange;
+
+/**
+ * Invoked automatically when a change to the value of this tracker was requested,
+ * but was not forwarded to the GL engine, because the value was not changing.
+ *
+ * Increments the filteredChangeCount property, and notifies the CC3OpenGLESEngine.
+ *
+ * The application should not invoke this method directly.
+ */
+-(void) notifyGLChangeFiltered;
+
+/**
+ * Marks the value of this tracker as unknown, so that the next value set in this tracker
+ * is submitted to the GL engine, even if it is the same as the value currently tracked.
+ *
+ * This method is invoked automatically by the CC3OpenGLESEngine on each tracker whose
+ * value was changed while the shouldSubmitToGL property of the engine was set to NO,
+ * once that property is set back to YES. The application should not invoke this method directly.
+ *
+ * This implementation does nothing. Subclasses that track a GL value will override.
+ */
+-(void) markValueUnknown;
+
+
+#pragma mark State change statistics
+
+/**
+ * The number of times this tracker has set its state in the GL engine,
+ * since the resetChangeCounts method was last invoked.
+ */
+@property(nonatomic, readonly) GLuint changeCount;
+
+/**
+ * The number of times a change to the state of this tracker was requested, but was not
+ * forwarded to the GL engine because the state was not changing, since the resetChangeCounts
+ * method was last invoked.
+ *
+ * Comparing this property to the changeCount property indicates how effective this tracker is
+ * at eliminating redundant GL calls. A tracker with a high changeCount, relative to the number
+ * of drawing calls made, indicates that the drawing order of nodes or materials might be
+ * improved by grouping together the nodes that share this state.
+ */
+@property(nonatomic, readonly) GLuint filteredChangeCount;
+
+/** Resets the changeCount and filteredChangeCount properties to zero. */
+-(void) resetChangeCounts;
+
 @end
 
 
@@ -38,7 +38,7 @@
 
 @implementation CC3OpenGLESStateTracker
 
-@synthesize parent;
+@synthesize parent, changeCount, filteredChangeCount;
 
 -(void) dealloc {
 	parent = nil;			// not retained
@@ -54,6 +54,8 @@
 -(id) initWithParent: (CC3OpenGLESStateTracker*) aTracker {
 	if ( (self = [super init]) ) {
 		parent = aTracker;
+		changeCount = 0;
+		filteredChangeCount = 0;
 		isScheduledForClose = NO;
 	}
 	return self;
@@ -73,6 +75,26 @@
 	if (!isScheduledForClose) isScheduledForClose = YES;
 }
 
+-(BOOL) shouldSubmitGLChange {
+	CC3OpenGLESEngine* glesEngine = self.engine;
+	[glesEngine notifyStateChangedBy: self];
+	changeCount++;
+	return glesEngine.shouldSubmitToGL;
+}
+
+-(void) notifyGLChangeFiltered {
+	LogTrace(@"Reusing GL value for %@", self);
+	[self.engine notifyStateChangeFilteredBy: self];
+	filteredChangeCount++;
+}
+
+-(void) markValueUnknown {}
+
+-(void) resetChangeCounts {
+	changeCount = 0;
+	filteredChangeCount = 0;
+}
+
 -(NSString*) description { return [NSString stringWithFormat: @"%@", [self class]]; }
 
 @end
@@ -197,7 +219,7 @@ andOriginalValueHandling: (CC3GLESStateOriginalValueHandling) origValueHandling
 	[super close];
 	if (self.shouldRestoreOriginalOnClose) {
 		[self restoreOriginalValue];
-		[self setGLValue];
+		if ([self shouldSubmitGLChange]) [self setGLValue];
 		LogGLErrorTrace(@"while setting GL value for %@", self);
 	}
 	valueIsKnown = self.valueIsKnownOnClose;
@@ -220,7 +242,7 @@ andOriginalValueHandling: (CC3GLESStateOriginalValueHandling) origValueHandling
 
 -(void) setGLValueAndNotify {
 	LogTrace(@"Setting GL value for %@", self);
-	[self setGLValue];
+	if ([self shouldSubmitGLChange]) [self setGLValue];
 	LogGLErrorTrace(@"while setting GL value for %@", self);
 	[self notifyGLChanged];
 	valueIsKnown = YES;
@@ -230,6 +252,8 @@ andOriginalValueHandling: (CC3GLESStateOriginalValueHandling) origValueHandling
 
 -(void) setGLValue {}
 
+-(void) markValueUnknown { valueIsKnown = NO; }
+
 -(NSString*) description {
 	return [NSString stringWithFormat: @"%@ %@", [self class], NSStringFromGLEnum(self.name)];
 }
@@ -297,7 +321,7 @@ andOriginalValueHandling: (CC3GLESStateOriginalValueHandling) origValueHandling
 		value = aValue;
 		[self setGLValueAndNotify];
 	} else {
-		LogTrace(@"Reusing GL value for %@", self);
+		[self notifyGLChangeFiltered];
 	}
 }
 
@@ -385,7 +409,7 @@ andOriginalValueHandling: (CC3GLESStateOriginalValueHandling) origValueHandling
 		value = aValue;
 		[self setGLValueAndNotify];
 	} else {
-		LogTrace(@"Reusing GL value for %@", self);
+		[self notifyGLChangeFiltered];
 	}
 }
 
@@ -469,7 +493,7 @@ andOriginalValueHandling: (CC3GLESStateOriginalValueHandling) origValueHandling
 		value = aValue;
 		[self setGLValueAndNotify];
 	} else {
-		LogTrace(@"Reusing GL value for %@", self);
+		[self notifyGLChangeFiltered];
 	}
 }
 
@@ -553,7 +577,7 @@ andOriginalValueHandling: (CC3GLESStateOriginalValueHandling) origValueHandling
 		value = aValue;
 		[self setGLValueAndNotify];
 	} else {
-		LogTrace(@"Reusing GL value for %@", self);
+		[self notifyGLChangeFiltered];
 	}
 }
 
@@ -637,7 +661,7 @@ andOriginalValueHandling: (CC3GLESStateOriginalValueHandling) origValueHandling
 		value = aColor;
 		[self setGLValueAndNotify];
 	} else {
-		LogTrace(@"Reusing GL value for %@", self);
+		[self notifyGLChangeFiltered];
 	}
 }
 
@@ -731,7 +755,7 @@ andOriginalValueHandling: (CC3GLESStateOriginalValueHandling) origValueHandling
 		[self setGLValueAndNotify];
 		fixedValueIsKnown = NO;
 	} else {
-		LogTrace(@"Reusing GL value for %@", self);
+		[self notifyGLChangeFiltered];
 	}
 }
 
@@ -755,13 +779,13 @@ andOriginalValueHandling: (CC3GLESStateOriginalValueHandling) origValueHandling
 
 		fixedValue = aColor;
 		LogTrace(@"Setting fixed GL value for %@", self);
-		[self setGLFixedValue];
+		if ([self shouldSubmitGLChange]) [self setGLFixedValue];
 		LogGLErrorTrace(@"while setting fixed GL value for %@", self);
 		[self notifyGLChanged];
 		fixedValueIsKnown = YES;
 		valueIsKnown = NO;
 	} else {
-		LogTrace(@"Reusing fixed GL value for %@", self);
+		[self notifyGLChangeFiltered];
 	}
 }
 
@@ -845,7 +869,7 @@ andOriginalValueHandling: (CC3GLESStateOriginalValueHandling) origValueHandling
 		[self setGLValueAndNotify];
 		fixedValueIsKnown = NO;
 	} else {
-		LogTrace(@"Reusing GL value for %@", self);
+		[self notifyGLChangeFiltered];
 	}
 }
 
@@ -858,13 +882,13 @@ andOriginalValueHandling: (CC3GLESStateOriginalValueHandling) origValueHandling
 		
 		fixedValue = aColor;
 		LogTrace(@"Setting fixed GL value for %@", self);
-		[self setGLFixedValue];
+		if ([self shouldSubmitGLChange]) [self setGLFixedValue];
 		LogGLErrorTrace(@"while setting fixed GL value for %@", self);
 		[self notifyGLChanged];
 		fixedValueIsKnown = YES;
 		valueIsKnown = NO;
 	} else {
-		LogTrace(@"Reusing fixed GL value for %@", self);
+		[self notifyGLChangeFiltered];
 	}
 }
 
@@ -941,7 +965,7 @@ andOriginalValueHandling: (CC3GLESStateOriginalValueHandling) origValueHandling
 		value = aViewport;
 		[self setGLValueAndNotify];
 	} else {
-		LogTrace(@"Reusing GL value for %@", self);
+		[self notifyGLChangeFiltered];
 	}
 }
 
@@ -975,7 +999,7 @@ andOriginalValueHandling: (CC3GLESStateOriginalValueHandling) origValueHandling
 		value = aValue;
 		[self setGLValueAndNotify];
 	} else {
-		LogTrace(@"Reusing GL value for %@", self);
+		[self notifyGLChangeFiltered];
 	}
 }
 
@@ -1007,7 +1031,7 @@ andOriginalValueHandling: (CC3GLESStateOriginalValueHandling) origValueHandling
 		value = aVector;
 		[self setGLValueAndNotify];
 	} else {
-		LogTrace(@"Reusing GL value for %@", self);
+		[self notifyGLChangeFiltered];
 	}
 }
 
@@ -1039,7 +1063,7 @@ andOriginalValueHandling: (CC3GLESStateOriginalValueHandling) origValueHandling
 		value = aVector;
 		[self setGLValueAndNotify];
 	} else {
-		LogTrace(@"Reusing GL value for %@", self); 
+		[self notifyGLChangeFiltered];
 	}
 }
 
@@ -1105,13 +1129,15 @@ andOriginalValueHandling: (CC3GLESStateOriginalValueHandling) origValueHandling
 
 -(void) setValueIsKnown:(BOOL) aBoolean {}
 
+-(void) markValueUnknown { self.valueIsKnown = NO; }
+
 -(BOOL) valueIsKnownOnClose { return originalValueHandling != kCC3GLESStateOriginalValueIgnore; }
 
 -(void) close {
 	[super close];
 	if (self.shouldRestoreOriginalOnClose) {
 		[self restoreOriginalValues];
-		[self setGLValues];
+		if ([self shouldSubmitGLChange]) [self setGLValues];
 		LogGLErrorTrace(@"while setting GL values for %@", self);
 	}
 	self.valueIsKnown = self.valueIsKnownOnClose;
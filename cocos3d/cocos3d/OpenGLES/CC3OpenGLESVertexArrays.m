@@ -30,6 +30,7 @@
  */
 
 #import "CC3OpenGLESVertexArrays.h"
+#import "CC3OpenGLESEngine.h"
 #import "CC3CC2Extensions.h"
 
 #pragma mark -
@@ -68,7 +69,7 @@
 			  startingAt: (GLintptr) offset
 			   forLength: (GLsizeiptr) length {
 	ccGLBindVAO(0);		// Ensure that a VAO was not left in place by cocos2d
-	glBufferSubData(name, offset, length, buffPtr);
+	glBufferSubData(name, offset, length, ((GLbyte*)buffPtr + offset));
 	LogGLErrorTrace(@"while updating buffer data of length %i at offset %i from %p for",
 					length, offset, buffPtr, self);
 }
@@ -185,10 +186,12 @@
 		[_shouldNormalize setValueRaw: shldNorm];
 
 		LogTrace(@"Setting GL value for %@", self);
-		[self setGLValues];
+		if ([self shouldSubmitGLChange]) [self setGLValues];
 		LogGLErrorTrace(@"while setting GL values for %@", self);
 		[self notifyGLChanged];
 		self.valueIsKnown = YES;
+	} else {
+		[self notifyGLChangeFiltered];
 	}
 	[self enable];
 	self.wasBound = YES;
@@ -296,7 +299,10 @@
 -(void) enable2DVertexPointers {}
 
 -(void) drawVerticiesAs: (GLenum) drawMode startingAt: (GLuint) start withLength: (GLuint) len {
-	glDrawArrays(drawMode, start, len);
+	CC3OpenGLESEngine* glesEngine = self.engine;
+	[glesEngine.commandBuffer recordDrawVerticiesAs: drawMode startingAt: start withLength: len];
+	[glesEngine notifyDrawingCallMade];
+	if (glesEngine.shouldSubmitToGL) glDrawArrays(drawMode, start, len);
 	LogGLErrorTrace(@"%@ drawing %u vertices as %@ starting from %u",
 					self, len, NSStringFromGLEnum(drawMode), start);
 	CC_INCREMENT_GL_DRAWS(1);
@@ -304,7 +310,10 @@
 
 -(void) drawIndicies: (GLvoid*) indicies ofLength: (GLuint) len andType: (GLenum) type as: (GLenum) drawMode {
 	CC3Assert((type == GL_UNSIGNED_SHORT || type == GL_UNSIGNED_BYTE), @"OpenGL ES permits drawing a maximum of 65536 indexed vertices, and supports only GL_UNSIGNED_SHORT or GL_UNSIGNED_BYTE types for vertex indices");
-	glDrawElements(drawMode, len, type, indicies);
+	CC3OpenGLESEngine* glesEngine = self.engine;
+	[glesEngine.commandBuffer recordDrawIndicies: indicies ofLength: len andType: type as: drawMode];
+	[glesEngine notifyDrawingCallMade];
+	if (glesEngine.shouldSubmitToGL) glDrawElements(drawMode, len, type, indicies);
 	LogGLErrorTrace(@"%@ drawing %u vertex indices as %@", self, len, NSStringFromGLEnum(drawMode));
 	CC_INCREMENT_GL_DRAWS(1);
 }
@@ -44,6 +44,9 @@
  * The default value is 8. This can be changed by either setting the value of this compiler
  * build setting, or by setting the originalValue of the maxLights tracker directly before
  * it is opened (or setting both the originalValue and the value properties after opening).
+ *
+ * A scene that uses a CC3LightGrid can contain more lights than the shaders apply to each node.
+ * To allow this, raise this value, up to 256. See the notes of CC3LightGrid for more info.
  */
 #ifndef kCC3MaxGL2Lights
 #	define kCC3MaxGL2Lights					8
@@ -124,6 +124,24 @@
 #pragma mark -
 #pragma mark CC3MeshParticleEmitter
 
+/**
+ * Describes the transformation of the vertices of a single particle, when the vertices of
+ * all particles are transformed together in a batch by a CC3MeshParticleEmitter.
+ *
+ * This structure is used internally by CC3MeshParticleEmitter. The application will generally
+ * not need to use it directly.
+ */
+typedef struct {
+	CC3Matrix4x3 locationMatrix;	/**< The matrix used to transform vertex locations. */
+	CC3Matrix4x3 normalMatrix;		/**< The rotation matrix used to transform vertex normals. */
+	const GLvoid* srcLocations;		/**< The first vertex location in the template mesh. */
+	const GLvoid* srcNormals;		/**< The first vertex normal in the template mesh, or NULL if normals are not transformed. */
+	GLuint srcLocationStride;		/**< The stride of the template vertex locations. */
+	GLuint srcNormalStride;			/**< The stride of the template vertex normals. */
+	GLuint firstVertex;				/**< The index of the first vertex of the particle within the emitter mesh. */
+	GLuint vertexCount;				/**< The number of vertices in the particle. */
+} CC3MeshParticleBatchTransform;
+
 /**
  * CC3MeshParticleEmitter emits particles that conform to the CC3MeshParticleProtocol protocol.
  * 
@@ -185,8 +203,11 @@
  */
 @interface CC3MeshParticleEmitter : CC3CommonVertexArrayParticleEmitter {
 	CC3Mesh* particleTemplateMesh;
+	CC3MeshParticleBatchTransform* batchTransforms;
+	NSUInteger batchTransformCapacity;
 	BOOL isParticleTransformDirty : 1;
 	BOOL shouldNotTransformInvisibleParticles : 1;
+	BOOL shouldBatchParticleTransforms : 1;
 }
 
 /**
@@ -369,6 +390,27 @@
  */
 -(void) markParticleTransformDirty;
 
+/**
+ * Indicates whether the vertices of all particles that need transforming should be transformed
+ * together in a single batch, instead of by invoking the transformVertices method of each particle.
+ *
+ * When this property is set to YES, the transform matrix of each dirty particle is first collected
+ * into an array. The template vertex locations and normals of all of those particles are then
+ * transformed by those matrices in tight loops that write directly into the vertex arrays of
+ * this emitter, without any method invocations per vertex. For large numbers of particles, the
+ * particles are divided into ranges, and each range is transformed on a separate thread. Finally,
+ * the vertices of all transformed particles are marked as dirty in a single range, so they can
+ * be uploaded to the GL engine together.
+ *
+ * Particles that are not instances of CC3MeshParticle, or that override the transformVertices,
+ * translateVertices, or fullyTransformVertices methods, are still transformed individually.
+ * Batching also requires that the vertex locations of the template meshes and of this emitter
+ * each contain three GL_FLOAT components. If they do not, all particles are transformed individually.
+ *
+ * The initial value of this property is NO.
+ */
+@property(nonatomic, assign) BOOL shouldBatchParticleTransforms;
+
 @end
 
 
@@ -59,6 +59,8 @@
 -(void) copyTemplateContentToParticle: (id<CC3MeshParticleProtocol>) aParticle;
 -(BOOL) shouldTransformParticles: (CC3NodeTransformingVisitor*) visitor;
 -(void) transformParticles;
+-(void) transformParticlesInBatch;
+-(BOOL) ensureBatchTransformCapacity: (NSUInteger) aCapacity;
 @end
 
 @interface CC3MeshParticle (TemplateMethods)
@@ -74,6 +76,8 @@
 -(void) applyTranslationTo: (CC3Matrix4x3*) mtx;
 -(void) applyRotationTo: (CC3Matrix4x3*) mtx;
 -(void) applyScalingTo: (CC3Matrix4x3*) mtx;
+-(BOOL) doesInheritMethod: (SEL) aSelector;
+-(BOOL) populateBatchTransform: (CC3MeshParticleBatchTransform*) xfm;
 @end
 
 
@@ -82,10 +86,11 @@
 
 @implementation CC3MeshParticleEmitter
 
-@synthesize isParticleTransformDirty, shouldTransformUnseenParticles;
+@synthesize isParticleTransformDirty, shouldTransformUnseenParticles, shouldBatchParticleTransforms;
 
 -(void) dealloc {
 	[particleTemplateMesh release];
+	free(batchTransforms);
 	[super dealloc];
 }
 
@@ -125,6 +130,9 @@
 		particleTemplateMesh = nil;
 		isParticleTransformDirty = NO;
 		shouldTransformUnseenParticles = YES;
+		shouldBatchParticleTransforms = NO;
+		batchTransforms = NULL;
+		batchTransformCapacity = 0;
 	}
 	return self;
 }
@@ -135,6 +143,7 @@
 	self.particleTemplateMesh = another.particleTemplateMesh;
 	isParticleTransformDirty = another.isParticleTransformDirty;
 	shouldTransformUnseenParticles = another.shouldTransformUnseenParticles;
+	shouldBatchParticleTransforms = another.shouldBatchParticleTransforms;
 }
 
 
@@ -340,11 +349,100 @@
 	NSUInteger partCount = self.particleCount;
 	LogTrace(@"%@ transforming %i particles", self, particleCount);
 
+	if (shouldBatchParticleTransforms) {
+		[self transformParticlesInBatch];
+	} else {
+		for (NSUInteger partIdx = 0; partIdx < partCount; partIdx++) {
+			id<CC3MeshParticleProtocol> mp = [particles objectAtIndex: partIdx];
+			[mp transformVertices];
+		}
+	}
+	isParticleTransformDirty = NO;
+}
+
+/** The number of particles in each range of particles that is transformed on a separate thread. */
+#define kCC3MeshParticleBatchRangeLength	64
+
+/** Transforms the template vertices of each of the specified particles into the emitter vertex arrays. */
+static void CC3MeshParticleTransformBatch(const CC3MeshParticleBatchTransform* xfms, NSUInteger xfmCount,
+										  GLbyte* dstLocs, GLuint dstLocStride,
+										  GLbyte* dstNorms, GLuint dstNormStride) {
+	for (NSUInteger xIdx = 0; xIdx < xfmCount; xIdx++) {
+		const CC3MeshParticleBatchTransform* xfm = &xfms[xIdx];
+		CC3Matrix4x3TransformVectors(&xfm->locationMatrix, 1.0f, xfm->vertexCount,
+									 xfm->srcLocations, xfm->srcLocationStride,
+									 dstLocs + (dstLocStride * xfm->firstVertex), dstLocStride);
+		if (xfm->srcNormals && dstNorms)
+			CC3Matrix4x3TransformVectors(&xfm->normalMatrix, 0.0f, xfm->vertexCount,
+										 xfm->srcNormals, xfm->srcNormalStride,
+										 dstNorms + (dstNormStride * xfm->firstVertex), dstNormStride);
+	}
+}
+
+/**
+ * Transforms all particles together. The transform of each dirty particle is collected into
+ * an array, and the vertices of all of those particles are then transformed in a single pass,
+ * which is divided by particle ranges across threads if there are enough particles. Particles
+ * that cannot be batched are transformed individually. All batched vertices are marked dirty
+ * as a single range, so that a single GL buffer update covers them.
+ */
+-(void) transformParticlesInBatch {
+	NSUInteger partCount = self.particleCount;
+	CC3Mesh* vaMesh = self.mesh;
+	CC3VertexArray* dstLocs = vaMesh.vertexLocations;
+	CC3VertexArray* dstNorms = vaMesh.vertexNormals;
+
+	BOOL canBatch = (dstLocs.vertices && dstLocs.elementType == GL_FLOAT && dstLocs.elementSize == 3 &&
+					 [self ensureBatchTransformCapacity: partCount]);
+
+	NSUInteger xfmCount = 0;
+	GLuint minVtx = UINT_MAX, maxVtx = 0;
 	for (NSUInteger partIdx = 0; partIdx < partCount; partIdx++) {
 		id<CC3MeshParticleProtocol> mp = [particles objectAtIndex: partIdx];
-		[mp transformVertices];
+		if (canBatch && [mp isKindOfClass: [CC3MeshParticle class]]) {
+			CC3MeshParticle* cmp = (CC3MeshParticle*)mp;
+			CC3MeshParticleBatchTransform* xfm = &batchTransforms[xfmCount];
+			if ( cmp.isTransformDirty && [cmp populateBatchTransform: xfm] ) {
+				minVtx = MIN(minVtx, xfm->firstVertex);
+				maxVtx = MAX(maxVtx, xfm->firstVertex + xfm->vertexCount);
+				xfmCount++;
+				[cmp transformVertexColors];
+				continue;
+			}
+		}
+		[mp transformVertices];		// Not batched, or only colors need transforming
 	}
-	isParticleTransformDirty = NO;
+	if (xfmCount == 0) return;
+
+	GLbyte* locVtxs = [dstLocs addressOfElement: 0];
+	GLuint locStride = dstLocs.vertexStride;
+	GLbyte* normVtxs = dstNorms.vertices ? [dstNorms addressOfElement: 0] : NULL;
+	GLuint normStride = dstNorms.vertexStride;
+	CC3MeshParticleBatchTransform* xfms = batchTransforms;
+
+	size_t rangeCount = (xfmCount + kCC3MeshParticleBatchRangeLength - 1) / kCC3MeshParticleBatchRangeLength;
+	if (rangeCount > 1) {
+		dispatch_apply(rangeCount, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t rIdx) {
+			NSUInteger firstXfm = rIdx * kCC3MeshParticleBatchRangeLength;
+			NSUInteger rangeLen = MIN(kCC3MeshParticleBatchRangeLength, xfmCount - firstXfm);
+			CC3MeshParticleTransformBatch(xfms + firstXfm, rangeLen, locVtxs, locStride, normVtxs, normStride);
+		});
+	} else {
+		CC3MeshParticleTransformBatch(xfms, xfmCount, locVtxs, locStride, normVtxs, normStride);
+	}
+
+	[self addDirtyVertexRange: NSMakeRange(minVtx, maxVtx - minVtx)];
+	LogTrace(@"%@ transformed %u of %u particles in a batch of %u ranges", self, xfmCount, partCount, rangeCount);
+}
+
+/** Ensures the array of batch transforms can hold the specified number of particle transforms. */
+-(BOOL) ensureBatchTransformCapacity: (NSUInteger) aCapacity {
+	if (aCapacity <= batchTransformCapacity) return YES;
+	CC3MeshParticleBatchTransform* newXfms = realloc(batchTransforms, aCapacity * sizeof(CC3MeshParticleBatchTransform));
+	if ( !newXfms ) return NO;
+	batchTransforms = newXfms;
+	batchTransformCapacity = aCapacity;
+	return YES;
 }
 
 @end
@@ -696,6 +794,53 @@
 	}
 }
 
+/** Returns whether the specified method of this particle is the one implemented by CC3MeshParticle. */
+-(BOOL) doesInheritMethod: (SEL) aSelector {
+	return [self methodForSelector: aSelector] == [CC3MeshParticle instanceMethodForSelector: aSelector];
+}
+
+/**
+ * Populates the specified batch transform with the transform matrices and template vertex
+ * content of this particle, so that the emitter can transform the vertices of this particle
+ * along with those of other particles, and marks this particle as no longer transform-dirty.
+ *
+ * Returns NO, leaving the transform-dirty state unchanged, if this particle cannot be transformed
+ * in a batch, because it customizes how its vertices are transformed, or because the vertex
+ * content of its template mesh is not in a compatible format.
+ */
+-(BOOL) populateBatchTransform: (CC3MeshParticleBatchTransform*) xfm {
+	if ( !([self doesInheritMethod: @selector(transformVertices)] &&
+		   [self doesInheritMethod: @selector(translateVertices)] &&
+		   [self doesInheritMethod: @selector(fullyTransformVertices)]) ) return NO;
+
+	CC3VertexArray* srcLocs = templateMesh.vertexLocations;
+	if ( !(srcLocs.vertices && srcLocs.elementType == GL_FLOAT && srcLocs.elementSize >= 3) ) return NO;
+
+	xfm->srcNormals = NULL;
+	xfm->srcNormalStride = 0;
+	if (self.doesUseTranslationOnly) {
+		CC3Matrix4x3PopulateFromTranslation(&xfm->locationMatrix, location);
+	} else {
+		[self applyLocalTransformsTo: &xfm->locationMatrix];
+		if (self.hasVertexNormals) {
+			// Rotate normals using only the rotational transform to avoid scaling the normal.
+			CC3VertexArray* srcNorms = templateMesh.vertexNormals;
+			if ( !srcNorms.vertices ) return NO;
+			CC3Matrix4x3PopulateIdentity(&xfm->normalMatrix);
+			[self applyRotationTo: &xfm->normalMatrix];
+			xfm->srcNormals = [srcNorms addressOfElement: 0];
+			xfm->srcNormalStride = srcNorms.vertexStride;
+		}
+	}
+	xfm->srcLocations = [srcLocs addressOfElement: 0];
+	xfm->srcLocationStride = srcLocs.vertexStride;
+	xfm->firstVertex = firstVertexOffset;
+	xfm->vertexCount = self.vertexCount;
+
+	_isTransformDirty = NO;
+	return YES;
+}
+
 /** Apply the location, rotation and scaling transforms to the specified matrix data. */
 -(void) applyLocalTransformsTo: (CC3Matrix4x3*) mtx {
 	[self prepareForTransform: mtx];
@@ -464,6 +464,237 @@ static const CC3VertexContent kCC3PointParticleContentSize DEPRECATED_ATTRIBUTE
 @end
 
 
+#pragma mark -
+#pragma mark CC3BulkPointParticleEmitter
+
+/**
+ * Enumerates the per-particle content streams held by a CC3BulkPointParticleEmitter.
+ *
+ * Each stream is a contiguous array of GLfloats, containing one value per living particle.
+ */
+typedef enum {
+	kCC3BulkParticleStreamLocationX = 0,	/**< X-component of particle location. */
+	kCC3BulkParticleStreamLocationY,		/**< Y-component of particle location. */
+	kCC3BulkParticleStreamLocationZ,		/**< Z-component of particle location. */
+	kCC3BulkParticleStreamVelocityX,		/**< X-component of particle velocity. */
+	kCC3BulkParticleStreamVelocityY,		/**< Y-component of particle velocity. */
+	kCC3BulkParticleStreamVelocityZ,		/**< Z-component of particle velocity. */
+	kCC3BulkParticleStreamColorR,			/**< Red component of particle color. */
+	kCC3BulkParticleStreamColorG,			/**< Green component of particle color. */
+	kCC3BulkParticleStreamColorB,			/**< Blue component of particle color. */
+	kCC3BulkParticleStreamColorA,			/**< Alpha component of particle color. */
+	kCC3BulkParticleStreamColorVelocityR,	/**< Rate of change of red component per second. */
+	kCC3BulkParticleStreamColorVelocityG,	/**< Rate of change of green component per second. */
+	kCC3BulkParticleStreamColorVelocityB,	/**< Rate of change of blue component per second. */
+	kCC3BulkParticleStreamColorVelocityA,	/**< Rate of change of alpha component per second. */
+	kCC3BulkParticleStreamSize,				/**< Particle size. */
+	kCC3BulkParticleStreamSizeVelocity,		/**< Rate of change of size per second. */
+	kCC3BulkParticleStreamTimeToLive,		/**< Remaining life of the particle, in seconds. */
+	kCC3BulkParticleStreamCount,			/**< The number of streams. Not a valid stream. */
+} CC3BulkParticleStream;
+
+/**
+ * CC3BulkPointParticleEmitter is a point particle emitter that can manage very large numbers
+ * of simple particles by holding their state in bulk, instead of as individual particle objects.
+ *
+ * When the particleClass property is nil, which is the initial state, this emitter does not
+ * create particle objects. Instead, the location, velocity, color, size and remaining life of
+ * each particle are held in separate contiguous arrays of floats (one per CC3BulkParticleStream),
+ * and each update is performed as a small number of tight loops across each of those arrays.
+ * These loops contain no branches and no method invocations, and are therefore vectorized by the
+ * compiler for the SIMD unit of the device. The results are written directly into the vertex
+ * location, normal, color and point size arrays of the underlying mesh, and the vertices that
+ * changed are uploaded to the GL engine as a single range.
+ *
+ * Each particle moves at its velocity, which is changed by the particleAcceleration property.
+ * The color and size of each particle change linearly over its lifetime, from the values that
+ * were established when the particle was emitted. A particle expires when its time-to-live
+ * reaches zero, and the last living particle is moved into its place.
+ *
+ * The initial content of each emitted particle is established by the initializeBulkParticlesFrom:
+ * count: method. The default implementation of that method uses the ranges defined by the
+ * properties of this class. Subclasses may override that method, and use the bulkParticleStream:
+ * method to write directly into the content streams.
+ *
+ * If you need particles with behaviour that is more complex than can be described by these
+ * streams, set the particleClass property to a class that conforms to CC3PointParticleProtocol.
+ * In that case, this emitter reverts to the standard behaviour of CC3PointParticleEmitter,
+ * and each particle is an object that is updated individually. This object-based path is
+ * considerably slower, and should be reserved for small numbers of particles. Because the
+ * object-based path is selected by the particleClass property, you should set that property
+ * only while the emitter contains no particles.
+ *
+ * When using bulk particles, the particleAt: method and related methods will not return
+ * particles, since no particle objects exist. For the same reason, the emitParticle method
+ * emits a bulk particle, but always returns nil. Use the emitParticles: method instead.
+ */
+@interface CC3BulkPointParticleEmitter : CC3PointParticleEmitter {
+	GLfloat* bulkStreams[kCC3BulkParticleStreamCount];
+	GLuint bulkParticleCapacity;
+	CC3Vector particleAcceleration;
+	CC3Vector minParticleVelocity;
+	CC3Vector maxParticleVelocity;
+	ccColor4F minParticleStartingColor;
+	ccColor4F maxParticleStartingColor;
+	ccColor4F minParticleEndingColor;
+	ccColor4F maxParticleEndingColor;
+	GLfloat minParticleStartingSize;
+	GLfloat maxParticleStartingSize;
+	GLfloat minParticleEndingSize;
+	GLfloat maxParticleEndingSize;
+	ccTime minParticleLifeSpan;
+	ccTime maxParticleLifeSpan;
+}
+
+/**
+ * Indicates whether this emitter is managing its particles in bulk, instead of as individual
+ * particle objects.
+ *
+ * This property returns YES if the particleClass property is nil, and NO otherwise.
+ */
+@property(nonatomic, readonly) BOOL isUsingBulkParticles;
+
+/**
+ * The acceleration applied to the velocity of each bulk particle, in the local coordinate
+ * system of the emitter. This can be used to apply a constant force such as gravity.
+ *
+ * The initial value of this property is kCC3VectorZero.
+ */
+@property(nonatomic, assign) CC3Vector particleAcceleration;
+
+/**
+ * The minimum velocity of each emitted bulk particle. Each component of the velocity of
+ * an emitted particle is chosen randomly between the corresponding components of this
+ * property and the maxParticleVelocity property.
+ *
+ * The initial value of this property is kCC3VectorZero.
+ */
+@property(nonatomic, assign) CC3Vector minParticleVelocity;
+
+/**
+ * The maximum velocity of each emitted bulk particle. Each component of the velocity of
+ * an emitted particle is chosen randomly between the corresponding components of the
+ * minParticleVelocity property and this property.
+ *
+ * The initial value of this property is kCC3VectorZero.
+ */
+@property(nonatomic, assign) CC3Vector maxParticleVelocity;
+
+/**
+ * The minimum color of each emitted bulk particle. Each component of the starting color of an
+ * emitted particle is chosen randomly between the corresponding components of this property and
+ * the maxParticleStartingColor property.
+ *
+ * The initial value of this property is kCCC4FWhite.
+ */
+@property(nonatomic, assign) ccColor4F minParticleStartingColor;
+
+/**
+ * The maximum color of each emitted bulk particle. Each component of the starting color of an
+ * emitted particle is chosen randomly between the corresponding components of the
+ * minParticleStartingColor property and this property.
+ *
+ * The initial value of this property is kCCC4FWhite.
+ */
+@property(nonatomic, assign) ccColor4F maxParticleStartingColor;
+
+/**
+ * The minimum color of each bulk particle at the end of its life. Each component of the ending
+ * color of an emitted particle is chosen randomly between the corresponding components of this
+ * property and the maxParticleEndingColor property.
+ *
+ * The initial value of this property is kCCC4FWhite.
+ */
+@property(nonatomic, assign) ccColor4F minParticleEndingColor;
+
+/**
+ * The maximum color of each bulk particle at the end of its life. Each component of the ending
+ * color of an emitted particle is chosen randomly between the corresponding components of the
+ * minParticleEndingColor property and this property.
+ *
+ * The initial value of this property is kCCC4FWhite.
+ */
+@property(nonatomic, assign) ccColor4F maxParticleEndingColor;
+
+/**
+ * The minimum size of each emitted bulk particle. The starting size of each emitted particle is
+ * chosen randomly between the value of this property and the maxParticleStartingSize property.
+ *
+ * The individual size of each particle is only used if the vertexContentTypes property of this
+ * emitter includes kCC3VertexContentPointSize.
+ *
+ * The initial value of this property is kCC3DefaultParticleSize.
+ */
+@property(nonatomic, assign) GLfloat minParticleStartingSize;
+
+/**
+ * The maximum size of each emitted bulk particle. The starting size of each emitted particle is
+ * chosen randomly between the value of the minParticleStartingSize property and this property.
+ *
+ * The initial value of this property is kCC3DefaultParticleSize.
+ */
+@property(nonatomic, assign) GLfloat maxParticleStartingSize;
+
+/**
+ * The minimum size of each bulk particle at the end of its life. The ending size of each emitted
+ * particle is chosen randomly between the value of this property and the maxParticleEndingSize property.
+ *
+ * The initial value of this property is kCC3DefaultParticleSize.
+ */
+@property(nonatomic, assign) GLfloat minParticleEndingSize;
+
+/**
+ * The maximum size of each bulk particle at the end of its life. The ending size of each emitted
+ * particle is chosen randomly between the value of the minParticleEndingSize property and this property.
+ *
+ * The initial value of this property is kCC3DefaultParticleSize.
+ */
+@property(nonatomic, assign) GLfloat maxParticleEndingSize;
+
+/**
+ * The minimum lifespan of each emitted bulk particle, in seconds. The lifespan of each emitted
+ * particle is chosen randomly between the value of this property and the maxParticleLifeSpan property.
+ *
+ * The initial value of this property is one second.
+ */
+@property(nonatomic, assign) ccTime minParticleLifeSpan;
+
+/**
+ * The maximum lifespan of each emitted bulk particle, in seconds. The lifespan of each emitted
+ * particle is chosen randomly between the value of the minParticleLifeSpan property and this property.
+ *
+ * The initial value of this property is one second.
+ */
+@property(nonatomic, assign) ccTime maxParticleLifeSpan;
+
+/**
+ * Returns a pointer to the array of floats holding the specified content of all bulk particles.
+ * The value for the particle at index i is found at element i of the returned array.
+ *
+ * The returned pointer remains valid only until more particles are emitted, since emitting
+ * particles may cause the streams to be reallocated. Returns NULL if no bulk particles have
+ * yet been allocated.
+ *
+ * This method is intended primarily for use by subclasses that override the
+ * initializeBulkParticlesFrom:count: method.
+ */
+-(GLfloat*) bulkParticleStream: (CC3BulkParticleStream) stream;
+
+/**
+ * Template method that establishes the initial content of the specified number of newly
+ * emitted bulk particles, starting at the specified index within the content streams.
+ *
+ * The default implementation locates each particle at the origin of the emitter, and chooses
+ * its velocity, color, size and lifespan randomly from the ranges defined by the properties
+ * of this class. Subclasses may override to establish different initial content, by writing
+ * directly into the arrays returned by the bulkParticleStream: method. A particle whose
+ * time-to-live is not positive will be expired during the next update.
+ */
+-(void) initializeBulkParticlesFrom: (GLuint) firstIndex count: (GLuint) count;
+
+@end
+
+
 #pragma mark -
 #pragma mark Deprecated CC3PointParticleMesh
 
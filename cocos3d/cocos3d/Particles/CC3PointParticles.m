@@ -599,6 +599,462 @@ static GLfloat deviceScaleFactor = 0.0f;
 @end
 
 
+#pragma mark -
+#pragma mark CC3BulkPointParticleEmitter
+
+/**
+ * Bulk particle kernels. Each operates on contiguous float streams, and contains no branches
+ * inside the loop, so that the compiler can vectorize it for the SIMD unit of the device.
+ */
+
+/** Adds the specified delta to each of the count values in the stream. */
+static void CC3BulkParticleOffset(GLfloat* restrict stream, GLfloat delta, GLuint count) {
+	for (GLuint i = 0; i < count; i++) stream[i] += delta;
+}
+
+/** Adds the product of each velocity and the specified time interval to each value. */
+static void CC3BulkParticleIntegrate(GLfloat* restrict values, const GLfloat* restrict velocities,
+									 GLfloat dt, GLuint count) {
+	for (GLuint i = 0; i < count; i++) values[i] += velocities[i] * dt;
+}
+
+/**
+ * Adds the product of each velocity and the specified time interval to each value,
+ * clamping each result to the specified range.
+ */
+static void CC3BulkParticleIntegrateClamped(GLfloat* restrict values, const GLfloat* restrict velocities,
+											GLfloat dt, GLfloat minVal, GLfloat maxVal, GLuint count) {
+	for (GLuint i = 0; i < count; i++) values[i] = fminf(fmaxf(values[i] + velocities[i] * dt, minVal), maxVal);
+}
+
+/** Writes the three streams to the x, y & z components of the vector elements of a vertex array. */
+static void CC3BulkParticleWriteVectors(GLbyte* restrict vertices, GLuint stride,
+										const GLfloat* restrict xs, const GLfloat* restrict ys,
+										const GLfloat* restrict zs, GLuint count) {
+	for (GLuint i = 0; i < count; i++) {
+		GLfloat* v = (GLfloat*)(vertices + (stride * i));
+		v[0] = xs[i];
+		v[1] = ys[i];
+		v[2] = zs[i];
+	}
+}
+
+/** Writes unit normals that point from each particle location towards the specified local location. */
+static void CC3BulkParticleWriteNormals(GLbyte* restrict vertices, GLuint stride,
+										const GLfloat* restrict xs, const GLfloat* restrict ys,
+										const GLfloat* restrict zs, CC3Vector target, GLuint count) {
+	for (GLuint i = 0; i < count; i++) {
+		GLfloat dx = target.x - xs[i];
+		GLfloat dy = target.y - ys[i];
+		GLfloat dz = target.z - zs[i];
+		GLfloat invLen = 1.0f / sqrtf(fmaxf((dx * dx) + (dy * dy) + (dz * dz), FLT_MIN));
+		GLfloat* v = (GLfloat*)(vertices + (stride * i));
+		v[0] = dx * invLen;
+		v[1] = dy * invLen;
+		v[2] = dz * invLen;
+	}
+}
+
+/** Writes the four color streams to float vertex color elements. */
+static void CC3BulkParticleWriteColor4Fs(GLbyte* restrict vertices, GLuint stride,
+										 const GLfloat* restrict rs, const GLfloat* restrict gs,
+										 const GLfloat* restrict bs, const GLfloat* restrict as,
+										 GLuint count) {
+	for (GLuint i = 0; i < count; i++) {
+		GLfloat* v = (GLfloat*)(vertices + (stride * i));
+		v[0] = rs[i];
+		v[1] = gs[i];
+		v[2] = bs[i];
+		v[3] = as[i];
+	}
+}
+
+/** Writes the four color streams, whose values lie between zero and one, to byte vertex color elements. */
+static void CC3BulkParticleWriteColor4Bs(GLbyte* restrict vertices, GLuint stride,
+										 const GLfloat* restrict rs, const GLfloat* restrict gs,
+										 const GLfloat* restrict bs, const GLfloat* restrict as,
+										 GLuint count) {
+	for (GLuint i = 0; i < count; i++) {
+		GLubyte* v = (GLubyte*)(vertices + (stride * i));
+		v[0] = (GLubyte)((rs[i] * 255.0f) + 0.5f);
+		v[1] = (GLubyte)((gs[i] * 255.0f) + 0.5f);
+		v[2] = (GLubyte)((bs[i] * 255.0f) + 0.5f);
+		v[3] = (GLubyte)((as[i] * 255.0f) + 0.5f);
+	}
+}
+
+/** Writes the scaled size stream to float vertex point size elements. */
+static void CC3BulkParticleWriteSizes(GLbyte* restrict vertices, GLuint stride,
+									  const GLfloat* restrict sizes, GLfloat scale, GLuint count) {
+	for (GLuint i = 0; i < count; i++) *(GLfloat*)(vertices + (stride * i)) = sizes[i] * scale;
+}
+
+@interface CC3ParticleEmitter (BulkTemplateMethods)
+-(void) checkEmission: (ccTime) dt;
+@end
+
+@interface CC3CommonVertexArrayParticleEmitter (BulkTemplateMethods)
+-(void) updateParticleMeshWithVisitor: (CC3NodeUpdatingVisitor*) visitor;
+-(void) addDirtyVertexRange: (NSRange) aRange;
+@end
+
+@interface CC3BulkPointParticleEmitter (TemplateMethods)
+-(GLuint) emitBulkParticles: (NSUInteger) count;
+-(BOOL) ensureBulkParticleCapacity: (GLuint) aCapacity;
+-(void) updateBulkParticles: (ccTime) dt;
+-(void) expireBulkParticles;
+-(void) writeBulkParticlesToMesh;
+@end
+
+@implementation CC3BulkPointParticleEmitter
+
+@synthesize particleAcceleration, minParticleVelocity, maxParticleVelocity;
+@synthesize minParticleStartingColor, maxParticleStartingColor;
+@synthesize minParticleEndingColor, maxParticleEndingColor;
+@synthesize minParticleStartingSize, maxParticleStartingSize;
+@synthesize minParticleEndingSize, maxParticleEndingSize;
+@synthesize minParticleLifeSpan, maxParticleLifeSpan;
+
+-(void) dealloc {
+	free(bulkStreams[0]);		// All streams share a single allocation
+	[super dealloc];
+}
+
+-(BOOL) isUsingBulkParticles { return (particleClass == nil); }
+
+-(GLfloat*) bulkParticleStream: (CC3BulkParticleStream) stream { return bulkStreams[stream]; }
+
+
+#pragma mark Allocation and initialization
+
+-(id) initWithTag: (GLuint) aTag withName: (NSString*) aName {
+	if ( (self = [super initWithTag: aTag withName: aName]) ) {
+		for (GLuint s = 0; s < kCC3BulkParticleStreamCount; s++) bulkStreams[s] = NULL;
+		bulkParticleCapacity = 0;
+		particleAcceleration = kCC3VectorZero;
+		minParticleVelocity = kCC3VectorZero;
+		maxParticleVelocity = kCC3VectorZero;
+		minParticleStartingColor = kCCC4FWhite;
+		maxParticleStartingColor = kCCC4FWhite;
+		minParticleEndingColor = kCCC4FWhite;
+		maxParticleEndingColor = kCCC4FWhite;
+		minParticleStartingSize = kCC3DefaultParticleSize;
+		maxParticleStartingSize = kCC3DefaultParticleSize;
+		minParticleEndingSize = kCC3DefaultParticleSize;
+		maxParticleEndingSize = kCC3DefaultParticleSize;
+		minParticleLifeSpan = 1.0f;
+		maxParticleLifeSpan = 1.0f;
+	}
+	return self;
+}
+
+/** Bulk particles are not copied. */
+-(void) populateFrom: (CC3BulkPointParticleEmitter*) another {
+	[super populateFrom: another];
+
+	particleAcceleration = another.particleAcceleration;
+	minParticleVelocity = another.minParticleVelocity;
+	maxParticleVelocity = another.maxParticleVelocity;
+	minParticleStartingColor = another.minParticleStartingColor;
+	maxParticleStartingColor = another.maxParticleStartingColor;
+	minParticleEndingColor = another.minParticleEndingColor;
+	maxParticleEndingColor = another.maxParticleEndingColor;
+	minParticleStartingSize = another.minParticleStartingSize;
+	maxParticleStartingSize = another.maxParticleStartingSize;
+	minParticleEndingSize = another.minParticleEndingSize;
+	maxParticleEndingSize = another.maxParticleEndingSize;
+	minParticleLifeSpan = another.minParticleLifeSpan;
+	maxParticleLifeSpan = another.maxParticleLifeSpan;
+}
+
+
+#pragma mark Emitting particles
+
+-(NSUInteger) emitParticles: (NSUInteger) count {
+	return self.isUsingBulkParticles ? [self emitBulkParticles: count] : [super emitParticles: count];
+}
+
+-(id<CC3ParticleProtocol>) emitParticle {
+	if ( !self.isUsingBulkParticles ) return [super emitParticle];
+	[self emitBulkParticles: 1];
+	return nil;
+}
+
+/**
+ * Overridden to emit all bulk particles that are due in a single batch,
+ * instead of emitting them one at a time.
+ */
+-(void) checkEmission: (ccTime) dt {
+	if ( !self.isUsingBulkParticles ) {
+		[super checkEmission: dt];
+		return;
+	}
+	if ( !isEmitting ) return;
+
+	timeSinceEmission += dt;
+	NSUInteger room = maximumParticleCapacity - particleCount;
+	NSUInteger dueCount = (emissionInterval > 0.0f) ? (NSUInteger)(timeSinceEmission / emissionInterval) : room;
+	GLuint emitCount = [self emitBulkParticles: MIN(dueCount, room)];
+	timeSinceEmission -= emitCount * emissionInterval;
+}
+
+/**
+ * Emits up to the specified number of bulk particles, ensuring there is capacity for them,
+ * and initializing their content. Returns the number of particles actually emitted.
+ */
+-(GLuint) emitBulkParticles: (NSUInteger) count {
+	count = MIN(count, maximumParticleCapacity - particleCount);
+	if (count == 0) return 0;
+
+	GLuint firstIdx = particleCount;
+	if ( ![self ensureBulkParticleCapacity: (GLuint)(firstIdx + count)] ) count = bulkParticleCapacity - firstIdx;
+	if (count == 0) return 0;
+
+	[self initializeBulkParticlesFrom: firstIdx count: count];
+	particleCount += count;
+	self.vertexCount = particleCount;
+	LogTrace(@"%@ emitted %u bulk particles", self, count);
+	return count;
+}
+
+/**
+ * Ensures that the content streams and the vertex arrays of the mesh have room for the specified
+ * number of particles, expanding both by a large chunk if needed. All streams share a single
+ * allocation, so expanding them involves one allocation and one copy per stream.
+ */
+-(BOOL) ensureBulkParticleCapacity: (GLuint) aCapacity {
+	if (aCapacity <= bulkParticleCapacity) return YES;
+	if (particleCapacityExpansionIncrement == 0) return NO;		// Oops...can't expand
+
+	CC3Mesh* vaMesh = self.mesh;
+	CC3Assert(vaMesh, @"%@ must have its vertexContentTypes property set before emitting particles.", self);
+
+	GLuint newCap = MAX(aCapacity, bulkParticleCapacity + particleCapacityExpansionIncrement);
+	newCap = MIN(newCap, maximumParticleCapacity);
+
+	GLfloat* newBlock = calloc(newCap * kCC3BulkParticleStreamCount, sizeof(GLfloat));
+	if ( !newBlock ) return NO;
+	GLfloat* oldBlock = bulkStreams[0];
+	for (GLuint s = 0; s < kCC3BulkParticleStreamCount; s++) {
+		GLfloat* newStream = newBlock + (s * newCap);
+		if (oldBlock) memcpy(newStream, bulkStreams[s], particleCount * sizeof(GLfloat));
+		bulkStreams[s] = newStream;
+	}
+	free(oldBlock);
+	bulkParticleCapacity = newCap;
+
+	// Expand the vertex arrays to match. This does not change the value of the vertexCount property.
+	GLuint meshVtxCount = vaMesh.vertexCount;
+	if (vaMesh.allocatedVertexCapacity < newCap) {
+		vaMesh.allocatedVertexCapacity = newCap;
+		vaMesh.vertexCount = meshVtxCount;
+		if (vaMesh.allocatedVertexCapacity != newCap) {		// Expansion failed
+			bulkParticleCapacity = MIN(bulkParticleCapacity, vaMesh.allocatedVertexCapacity);
+			return NO;
+		}
+		wasVertexCapacityChanged = YES;
+	}
+	LogTrace(@"%@ changed bulk particle capacity to %u", self, bulkParticleCapacity);
+	return YES;
+}
+
+-(void) initializeBulkParticlesFrom: (GLuint) firstIndex count: (GLuint) count {
+	GLfloat* locX = bulkStreams[kCC3BulkParticleStreamLocationX];
+	GLfloat* locY = bulkStreams[kCC3BulkParticleStreamLocationY];
+	GLfloat* locZ = bulkStreams[kCC3BulkParticleStreamLocationZ];
+	GLfloat* velX = bulkStreams[kCC3BulkParticleStreamVelocityX];
+	GLfloat* velY = bulkStreams[kCC3BulkParticleStreamVelocityY];
+	GLfloat* velZ = bulkStreams[kCC3BulkParticleStreamVelocityZ];
+	GLfloat* colR = bulkStreams[kCC3BulkParticleStreamColorR];
+	GLfloat* colG = bulkStreams[kCC3BulkParticleStreamColorG];
+	GLfloat* colB = bulkStreams[kCC3BulkParticleStreamColorB];
+	GLfloat* colA = bulkStreams[kCC3BulkParticleStreamColorA];
+	GLfloat* colVelR = bulkStreams[kCC3BulkParticleStreamColorVelocityR];
+	GLfloat* colVelG = bulkStreams[kCC3BulkParticleStreamColorVelocityG];
+	GLfloat* colVelB = bulkStreams[kCC3BulkParticleStreamColorVelocityB];
+	GLfloat* colVelA = bulkStreams[kCC3BulkParticleStreamColorVelocityA];
+	GLfloat* sizes = bulkStreams[kCC3BulkParticleStreamSize];
+	GLfloat* sizeVels = bulkStreams[kCC3BulkParticleStreamSizeVelocity];
+	GLfloat* ttls = bulkStreams[kCC3BulkParticleStreamTimeToLive];
+
+	GLuint endIdx = firstIndex + count;
+	for (GLuint i = firstIndex; i < endIdx; i++) {
+		ccTime lifeSpan = CC3RandomFloatBetween(minParticleLifeSpan, maxParticleLifeSpan);
+		GLfloat invLife = (lifeSpan > 0.0f) ? (1.0f / lifeSpan) : 0.0f;
+		ttls[i] = lifeSpan;
+
+		locX[i] = locY[i] = locZ[i] = 0.0f;
+		velX[i] = CC3RandomFloatBetween(minParticleVelocity.x, maxParticleVelocity.x);
+		velY[i] = CC3RandomFloatBetween(minParticleVelocity.y, maxParticleVelocity.y);
+		velZ[i] = CC3RandomFloatBetween(minParticleVelocity.z, maxParticleVelocity.z);
+
+		ccColor4F startColor = RandomCCC4FBetween(minParticleStartingColor, maxParticleStartingColor);
+		ccColor4F endColor = RandomCCC4FBetween(minParticleEndingColor, maxParticleEndingColor);
+		colR[i] = startColor.r;
+		colG[i] = startColor.g;
+		colB[i] = startColor.b;
+		colA[i] = startColor.a;
+		colVelR[i] = (endColor.r - startColor.r) * invLife;
+		colVelG[i] = (endColor.g - startColor.g) * invLife;
+		colVelB[i] = (endColor.b - startColor.b) * invLife;
+		colVelA[i] = (endColor.a - startColor.a) * invLife;
+
+		GLfloat startSize = CC3RandomFloatBetween(minParticleStartingSize, maxParticleStartingSize);
+		GLfloat endSize = CC3RandomFloatBetween(minParticleEndingSize, maxParticleEndingSize);
+		sizes[i] = startSize;
+		sizeVels[i] = (endSize - startSize) * invLife;
+	}
+}
+
+
+#pragma mark Updating
+
+/** Overridden to update bulk particles as a batch, or to update particle objects individually. */
+-(void) updateParticlesBeforeTransform: (CC3NodeUpdatingVisitor*) visitor {
+	if (self.isUsingBulkParticles)
+		[self updateBulkParticles: visitor.deltaTime];
+	else
+		[super updateParticlesBeforeTransform: visitor];
+}
+
+/**
+ * Integrates the content streams of all bulk particles over the specified time interval,
+ * and then expires the particles whose time-to-live has run out. Colors and sizes are only
+ * integrated if the mesh will use them.
+ */
+-(void) updateBulkParticles: (ccTime) dt {
+	GLuint pCnt = particleCount;
+	if (pCnt == 0) return;
+
+	CC3Mesh* vaMesh = self.mesh;
+
+	if ( !CC3VectorIsZero(particleAcceleration) ) {
+		CC3BulkParticleOffset(bulkStreams[kCC3BulkParticleStreamVelocityX], particleAcceleration.x * dt, pCnt);
+		CC3BulkParticleOffset(bulkStreams[kCC3BulkParticleStreamVelocityY], particleAcceleration.y * dt, pCnt);
+		CC3BulkParticleOffset(bulkStreams[kCC3BulkParticleStreamVelocityZ], particleAcceleration.z * dt, pCnt);
+	}
+	CC3BulkParticleIntegrate(bulkStreams[kCC3BulkParticleStreamLocationX],
+							 bulkStreams[kCC3BulkParticleStreamVelocityX], dt, pCnt);
+	CC3BulkParticleIntegrate(bulkStreams[kCC3BulkParticleStreamLocationY],
+							 bulkStreams[kCC3BulkParticleStreamVelocityY], dt, pCnt);
+	CC3BulkParticleIntegrate(bulkStreams[kCC3BulkParticleStreamLocationZ],
+							 bulkStreams[kCC3BulkParticleStreamVelocityZ], dt, pCnt);
+
+	if (vaMesh.hasVertexColors) {
+		for (GLuint c = 0; c < 4; c++)
+			CC3BulkParticleIntegrateClamped(bulkStreams[kCC3BulkParticleStreamColorR + c],
+											bulkStreams[kCC3BulkParticleStreamColorVelocityR + c],
+											dt, 0.0f, 1.0f, pCnt);
+	}
+	if (vaMesh.hasVertexPointSizes)
+		CC3BulkParticleIntegrateClamped(bulkStreams[kCC3BulkParticleStreamSize],
+										bulkStreams[kCC3BulkParticleStreamSizeVelocity],
+										dt, 0.0f, kCC3MaxGLfloat, pCnt);
+
+	CC3BulkParticleOffset(bulkStreams[kCC3BulkParticleStreamTimeToLive], -dt, pCnt);
+	[self expireBulkParticles];
+}
+
+/**
+ * Removes each bulk particle whose time-to-live has run out, by moving the content of the
+ * last living particle into its place, in each stream.
+ */
+-(void) expireBulkParticles {
+	GLfloat* ttls = bulkStreams[kCC3BulkParticleStreamTimeToLive];
+	GLuint pIdx = 0;
+	while (pIdx < particleCount) {
+		if (ttls[pIdx] > 0.0f) {
+			pIdx++;			// Move on to next particle
+		} else {
+			// Move the last particle here and don't increment iterator.
+			GLuint lastIdx = particleCount - 1;
+			for (GLuint s = 0; s < kCC3BulkParticleStreamCount; s++) bulkStreams[s][pIdx] = bulkStreams[s][lastIdx];
+			particleCount--;
+		}
+	}
+	self.vertexCount = particleCount;
+}
+
+/** Overridden to write the bulk particle content into the mesh before the GL buffers are updated. */
+-(void) updateParticleMeshWithVisitor: (CC3NodeUpdatingVisitor*) visitor {
+	if (self.isUsingBulkParticles && particleCount > 0) [self writeBulkParticlesToMesh];
+	[super updateParticleMeshWithVisitor: visitor];
+}
+
+/**
+ * Writes the location, normal, color and size streams of all bulk particles directly into
+ * the corresponding vertex arrays of the mesh, and marks all living particle vertices as dirty,
+ * so that they are uploaded to the GL buffer as a single range.
+ */
+-(void) writeBulkParticlesToMesh {
+	CC3Mesh* vaMesh = self.mesh;
+	GLuint pCnt = particleCount;
+	const GLfloat* locX = bulkStreams[kCC3BulkParticleStreamLocationX];
+	const GLfloat* locY = bulkStreams[kCC3BulkParticleStreamLocationY];
+	const GLfloat* locZ = bulkStreams[kCC3BulkParticleStreamLocationZ];
+
+	CC3VertexArray* va = vaMesh.vertexLocations;
+	CC3BulkParticleWriteVectors([va addressOfElement: 0], va.vertexStride, locX, locY, locZ, pCnt);
+
+	// Point the normals at the camera, which has been registered by the first update if needed.
+	if (self.hasIlluminatedNormals && !CC3VectorIsNull(globalCameraLocation)) {
+		CC3Vector camDir = CC3VectorDifference(globalCameraLocation, self.globalLocation);
+		camDir = [self.transformMatrixInverted transformDirection: camDir];
+		va = vaMesh.vertexNormals;
+		CC3BulkParticleWriteNormals([va addressOfElement: 0], va.vertexStride, locX, locY, locZ, camDir, pCnt);
+	}
+
+	va = vaMesh.vertexColors;
+	if (va) {
+		if (va.elementType == GL_FLOAT)
+			CC3BulkParticleWriteColor4Fs([va addressOfElement: 0], va.vertexStride,
+										 bulkStreams[kCC3BulkParticleStreamColorR],
+										 bulkStreams[kCC3BulkParticleStreamColorG],
+										 bulkStreams[kCC3BulkParticleStreamColorB],
+										 bulkStreams[kCC3BulkParticleStreamColorA], pCnt);
+		else
+			CC3BulkParticleWriteColor4Bs([va addressOfElement: 0], va.vertexStride,
+										 bulkStreams[kCC3BulkParticleStreamColorR],
+										 bulkStreams[kCC3BulkParticleStreamColorG],
+										 bulkStreams[kCC3BulkParticleStreamColorB],
+										 bulkStreams[kCC3BulkParticleStreamColorA], pCnt);
+	}
+
+	va = vaMesh.vertexPointSizes;
+	if (va) CC3BulkParticleWriteSizes([va addressOfElement: 0], va.vertexStride,
+									  bulkStreams[kCC3BulkParticleStreamSize],
+									  [self normalizeParticleSizeToDevice: 1.0f], pCnt);
+
+	[self addDirtyVertexRange: NSMakeRange(0, pCnt)];
+}
+
+
+#pragma mark Accessing particles
+
+-(id<CC3ParticleProtocol>) particleAt: (NSUInteger) aParticleIndex {
+	return self.isUsingBulkParticles ? nil : [super particleAt: aParticleIndex];
+}
+
+-(id<CC3ParticleProtocol>) particleWithVertexAt: (GLuint) vtxIndex {
+	return self.isUsingBulkParticles ? nil : [super particleWithVertexAt: vtxIndex];
+}
+
+-(id<CC3ParticleProtocol>) particleWithVertexIndexAt: (GLuint) index {
+	return self.isUsingBulkParticles ? nil : [super particleWithVertexIndexAt: index];
+}
+
+-(void) removeAllParticles {
+	if (self.isUsingBulkParticles) {
+		particleCount = 0;
+		self.vertexCount = 0;
+	} else {
+		[super removeAllParticles];
+	}
+}
+
+@end
+
+
 #pragma mark -
 #pragma mark Deprecated CC3PointParticleMesh
 
@@ -81,6 +81,24 @@
 /** Allocates and initializes an autoreleased instance on the specified NSData object. */
 +(id) readerOnData: (NSData*) data;
 
+/**
+ * Initializes this instance on the contents of the file at the specified absolute file path.
+ *
+ * Where possible, the file is memory-mapped, instead of being loaded into memory up front,
+ * so that only the parts of the file that are actually read are paged into memory.
+ *
+ * Returns nil if the file could not be opened.
+ */
+-(id) initOnContentsOfFile: (NSString*) aFilePath;
+
+/**
+ * Allocates and initializes an autoreleased instance on the contents of the file at the
+ * specified absolute file path, or returns nil if the file could not be opened.
+ *
+ * Where possible, the file is memory-mapped, instead of being loaded into memory up front.
+ */
++(id) readerOnContentsOfFile: (NSString*) aFilePath;
+
 
 #pragma mark Reading stream content
 
@@ -111,4 +129,46 @@
 /** Reads and returns an unsigned short from the current position in the stream, and advances the stream pointer. */
 -(unsigned short) readUnsignedShort;
 
+
+#pragma mark Reading arrays of stream content
+
+/*
+ * The following methods each read an array of elements from the current position in the stream
+ * into the specified array, and advance the stream pointer past those elements.
+ *
+ * Each element array is copied from the stream in a single block, and then, if the stream content
+ * is not in the byte order of the platform, byte-swapped in a single pass across the array. This is
+ * considerably faster than reading each element individually.
+ *
+ * If there are not enough bytes remaining in the stream to read the entire array, nothing is read,
+ * each element of the specified array is set to zero, and the wasReadBeyondEOF property is set to YES.
+ */
+
+/** Reads the specified number of floats into the specified array, and advances the stream pointer. */
+-(void) read: (NSUInteger) count floats: (float*) floats;
+
+/** Reads the specified number of integers into the specified array, and advances the stream pointer. */
+-(void) read: (NSUInteger) count integers: (int*) ints;
+
+/** Reads the specified number of shorts into the specified array, and advances the stream pointer. */
+-(void) read: (NSUInteger) count shorts: (short*) shorts;
+
+/**
+ * Reads the specified number of vectors into the specified array, and advances the stream pointer.
+ * Each vector is read as three consecutive floats, in X, Y, Z order.
+ */
+-(void) read: (NSUInteger) count vectors: (CC3Vector*) vectors;
+
+/**
+ * Reads the specified number of quaternions into the specified array, and advances the stream pointer.
+ * Each quaternion is read as four consecutive floats, in X, Y, Z, W order.
+ */
+-(void) read: (NSUInteger) count quaternions: (CC3Quaternion*) quaternions;
+
+/** Reads and returns a vector from the current position in the stream, and advances the stream pointer. */
+-(CC3Vector) readVector;
+
+/** Reads and returns a quaternion from the current position in the stream, and advances the stream pointer. */
+-(CC3Quaternion) readQuaternion;
+
 @end
@@ -32,6 +32,17 @@
 #import "CC3DataStreams.h"
 
 
+/** Swaps the byte order of each of the specified 32-bit values, in place, in a single tight loop. */
+static void CC3SwapBytes32(uint32_t* restrict values, NSUInteger count) {
+	for (NSUInteger i = 0; i < count; i++) values[i] = OSSwapInt32(values[i]);
+}
+
+/** Swaps the byte order of each of the specified 16-bit values, in place, in a single tight loop. */
+static void CC3SwapBytes16(uint16_t* restrict values, NSUInteger count) {
+	for (NSUInteger i = 0; i < count; i++) values[i] = OSSwapInt16(values[i]);
+}
+
+
 @implementation CC3DataReader
 
 @synthesize data=_data, isBigEndian=_isBigEndian, wasReadBeyondEOF=_wasReadBeyondEOF;
@@ -61,6 +72,21 @@
 
 +(id) readerOnData: (NSData*) data { return [[[self alloc] initOnData: data] autorelease]; }
 
+-(id) initOnContentsOfFile: (NSString*) aFilePath {
+	NSError* err = nil;
+	NSData* data = [NSData dataWithContentsOfFile: aFilePath options: NSDataReadingMappedIfSafe error: &err];
+	if ( !data ) {
+		LogError(@"Could not open %@: %@", aFilePath.lastPathComponent, err);
+		[self release];
+		return nil;
+	}
+	return [self initOnData: data];
+}
+
++(id) readerOnContentsOfFile: (NSString*) aFilePath {
+	return [[[self alloc] initOnContentsOfFile: aFilePath] autorelease];
+}
+
 -(NSUInteger) position { return _readRange.location; }
 
 -(NSUInteger) bytesRemaining { return _data.length - _readRange.location; }
@@ -128,6 +154,61 @@
 	return _isBigEndian ? NSSwapBigShortToHost(value) : NSSwapLittleShortToHost(value);
 }
 
+
+
+#pragma mark Reading arrays of stream content
+
+/** Returns whether the byte order of the stream content differs from that of the platform. */
+-(BOOL) needsByteSwap { return _isBigEndian != (NSHostByteOrder() == NS_BigEndian); }
+
+/**
+ * Reads the specified number of 32-bit values into the specified array, swapping the
+ * byte order of all of the values in a single pass if needed.
+ */
+-(void) read: (NSUInteger) count values32: (uint32_t*) values {
+	NSUInteger byteCount = count * sizeof(uint32_t);
+	[self read: byteCount bytes: (char*)values];
+	if (_wasReadBeyondEOF) {
+		memset(values, 0, byteCount);
+		return;
+	}
+	if (self.needsByteSwap) CC3SwapBytes32(values, count);
+}
+
+-(void) read: (NSUInteger) count floats: (float*) floats { [self read: count values32: (uint32_t*)floats]; }
+
+-(void) read: (NSUInteger) count integers: (int*) ints { [self read: count values32: (uint32_t*)ints]; }
+
+-(void) read: (NSUInteger) count shorts: (short*) shorts {
+	NSUInteger byteCount = count * sizeof(short);
+	[self read: byteCount bytes: (char*)shorts];
+	if (_wasReadBeyondEOF) {
+		memset(shorts, 0, byteCount);
+		return;
+	}
+	if (self.needsByteSwap) CC3SwapBytes16((uint16_t*)shorts, count);
+}
+
+-(void) read: (NSUInteger) count vectors: (CC3Vector*) vectors {
+	[self read: (count * 3) floats: (float*)vectors];
+}
+
+-(void) read: (NSUInteger) count quaternions: (CC3Quaternion*) quaternions {
+	[self read: (count * 4) floats: (float*)quaternions];
+}
+
+-(CC3Vector) readVector {
+	CC3Vector value;
+	[self read: 1 vectors: &value];
+	return value;
+}
+
+-(CC3Quaternion) readQuaternion {
+	CC3Quaternion value;
+	[self read: 1 quaternions: &value];
+	return value;
+}
+
 //-(float) readFloat {
 //	float value = 0.0f;
 //	[self read: sizeof(value) bytes: (char*)&value];
@@ -32,6 +32,13 @@
 
 #import "CC3Identifiable.h"
 
+/**
+ * A block that is invoked on the main thread when a resource requested using the
+ * resourceFromFileInBackground:withCompletion: method of CC3Resource has been loaded.
+ * The resource argument is nil if the resource could not be loaded.
+ */
+typedef void (^CC3ResourceCompletionBlock)(id resource);
+
 
 /**
  * CC3Resource is an abstract wrapper class around content loaded from a file containing
@@ -58,13 +65,30 @@
  * You do not need to set the directory property if these additional resources are in the same
  * directory as the file loaded by this resource.
  *
+ * Resources can also be loaded without blocking the main thread, by using the
+ * resourceFromFileInBackground:withCompletion: method. The file is read and parsed on a
+ * background thread, and the resource is then completed, placed in the cache, and handed to
+ * the completion block, on the main thread. Multiple requests for the same file that are made
+ * while that file is loading are combined into a single load.
+ *
+ * The memory consumed by the resources in the cache can be limited by setting the
+ * resourceCacheMemoryBudget property. When the cache exceeds that budget, the least recently
+ * used resources that are not in use are removed from the cache. A resource is in use while any
+ * object that depends on it has bracketed that dependency with the beginUse and endUse methods.
+ *
  * Subclasses must override the primitive template method processFile:. All other loading and
  * initialization methods defined by this class are implemented using this primitive method,
  * and subclasses do not need to override any of these other loading and initialization methods.
+ * Subclasses may also override the preprocessFile: template method to move the part of their
+ * loading that does not involve the GL engine onto the background thread during background loading.
  */
 @interface CC3Resource : CC3Identifiable {
 	NSString* _directory;
+	NSUInteger _memorySize;
+	NSUInteger _lastAccessSequence;
+	NSUInteger _useCount;
 	BOOL _wasLoaded : 1;
+	BOOL _wasPreprocessed : 1;
 	BOOL _isBigEndian : 1;
 }
 
@@ -100,6 +124,43 @@
  */
 @property(nonatomic, assign) BOOL isBigEndian;
 
+/**
+ * An estimate of the number of bytes of memory consumed by the content of this resource, used
+ * to enforce the resourceCacheMemoryBudget class-side property.
+ *
+ * When this resource is loaded, this property is set to the size of the file from which it is
+ * loaded. The application can set this property to a more accurate estimate, and subclasses may
+ * override this property to calculate the size of their content.
+ */
+@property(nonatomic, assign) NSUInteger memorySize;
+
+/**
+ * Indicates whether this resource is currently in use, as indicated by an invocation of the
+ * beginUse method that has not yet been balanced by an invocation of the endUse method.
+ *
+ * A resource that is in use is not removed from the cache by the enforceResourceCacheMemoryBudget
+ * method, regardless of how long ago it was last accessed.
+ */
+@property(nonatomic, readonly) BOOL isInUse;
+
+/**
+ * Marks this resource as being in use, preventing it from being removed from the resource
+ * cache when the cache is trimmed to its resourceCacheMemoryBudget.
+ *
+ * Each invocation of this method must be balanced by a subsequent invocation of the endUse
+ * method. CC3ResourceNode invokes these methods automatically for the resource it holds. An
+ * application that holds a resource directly, outside of a resource node, and wants that
+ * resource to remain in the cache, should invoke these methods itself.
+ */
+-(void) beginUse;
+
+/**
+ * Balances a prior invocation of the beginUse method. Once each invocation of beginUse
+ * has been balanced, this resource is no longer in use, and may be removed from the
+ * resource cache when the cache is trimmed to its resourceCacheMemoryBudget.
+ */
+-(void) endUse;
+
 /**
  * Loads the resources from the file at the specified file path and returns whether the loading
  * was successful.
@@ -146,6 +207,30 @@
  */
 -(BOOL) processFile: (NSString*) anAbsoluteFilePath;
 
+/**
+ * Template method that performs the part of processing the file at the specified file path,
+ * which must be an absolute file path, that can safely be run on a background thread, and
+ * returns whether that processing was successful.
+ *
+ * When a resource is loaded using the resourceFromFileInBackground:withCompletion: method, this
+ * method is invoked on a background thread, and, if it is successful, the processFile: method is
+ * then invoked on the main thread to complete the loading. When a resource is loaded using the
+ * loadFromFile: method, this method is not invoked.
+ *
+ * Subclasses that override this method will typically read and parse the file here, and should
+ * have their processFile: method check the wasPreprocessed property to avoid reading the file
+ * again. This method must not use the GL engine, or access any resource or texture caches.
+ *
+ * This implementation does nothing, and returns YES, leaving all processing to the processFile: method.
+ */
+-(BOOL) preprocessFile: (NSString*) anAbsoluteFilePath;
+
+/**
+ * Indicates whether the preprocessFile: method has been successfully run on this resource, and
+ * therefore the processFile: method only needs to complete the loading of this resource.
+ */
+@property(nonatomic, readonly) BOOL wasPreprocessed;
+
 /**
  * Saves the content of this resource to the file at the specified file path and returns whether
  * the saving was successful.
@@ -229,12 +314,39 @@
  */
 +(id) resourceFromFile: (NSString*) aFilePath;
 
+/**
+ * Retrieves a resource instance loaded from the specified file, loading it on a background thread
+ * if needed, and invokes the specified completion block on the main thread with that resource,
+ * or with nil if the resource could not be loaded.
+ *
+ * If the resource is already in the cache, it is passed to the completion block. Otherwise, a new
+ * instance of this class is created and initialized with the init method, the preprocessFile:
+ * method is invoked on a background thread, and then the processFile: method is invoked on the
+ * main thread, where the resource is placed in the cache before being passed to the completion block.
+ *
+ * If this method is invoked for a file that is already being loaded by this method, the completion
+ * block is invoked when that load completes, and the file is not loaded again. If a resource with the
+ * same name is placed in the cache by other means while the file is loading, such as by the
+ * resourceFromFile: method, the resource in the cache is passed to the completion block instead.
+ *
+ * Files are loaded in the background one at a time, in the order requested. The completion block
+ * is always invoked after this method returns. This method may be invoked from any thread. The
+ * completion block may be nil.
+ *
+ * The specified file path may be either an absolute path, or a path relative to the
+ * application resource directory. If the file is located directly in the application
+ * resources directory, the specified file path can simply be the name of the file.
+ */
++(void) resourceFromFileInBackground: (NSString*) aFilePath withCompletion: (CC3ResourceCompletionBlock) completion;
+
 
 #pragma mark Resource cache
 
 /** 
  * Returns the cached resource with the specified name,
  * or nil if a resource with that name has not been cached.
+ *
+ * Retrieving a resource marks it as the most recently used resource in the cache.
  */
 +(CC3Resource*) getResourceNamed: (NSString*) rezName;
 
@@ -242,6 +354,11 @@
  * Adds the specified resource to the resource cache. Resources are indexed in the cache using
  * the name property of the resource. If a resource already exists in the cache with the same
  * name, it is replaced by the specified resource.
+ *
+ * Adding a resource marks it as the most recently used resource in the cache, and removes
+ * any resources needed to bring the cache within the resourceCacheMemoryBudget.
+ *
+ * The resource cache should only be accessed from the main thread.
  */
 +(void) addResource: (CC3Resource*) resource;
 
@@ -254,6 +371,38 @@
 /** Removes this resource instance from the cache. */
 -(void) remove;
 
+/**
+ * The maximum number of bytes of memory that the resources in the cache should consume, as
+ * measured by the memorySize property of each resource.
+ *
+ * Whenever a resource is added to the cache, or this property is changed, if the total memorySize
+ * of the resources in the cache exceeds this budget, resources are removed from the cache, least
+ * recently used first, until the cache is within this budget. A resource whose isInUse property
+ * is YES is not removed from the cache, even if the cache remains over budget as a result.
+ *
+ * The initial value of this property is zero, indicating that the cache has no memory budget.
+ */
++(NSUInteger) resourceCacheMemoryBudget;
+
+/**
+ * The maximum number of bytes of memory that the resources in the cache should consume.
+ *
+ * See the notes for the resourceCacheMemoryBudget property for more info.
+ */
++(void) setResourceCacheMemoryBudget: (NSUInteger) budget;
+
+/** Returns the total memorySize of all resources in the cache. */
++(NSUInteger) resourceCacheMemorySize;
+
+/**
+ * Removes resources from the cache, least recently used first, until the cache is within
+ * the resourceCacheMemoryBudget. Resources whose isInUse property is YES are not removed.
+ *
+ * This method is invoked automatically whenever a resource is added to the cache. The application
+ * can also invoke this method after resources are no longer in use, for example after removing a level.
+ */
++(void) enforceResourceCacheMemoryBudget;
+
 
 #pragma mark Deprecated functionality
 
@@ -36,6 +36,7 @@
 @implementation CC3Resource
 
 @synthesize directory=_directory, isBigEndian=_isBigEndian, wasLoaded=_wasLoaded;
+@synthesize wasPreprocessed=_wasPreprocessed, memorySize=_memorySize;
 
 -(void) dealloc {
 	[_directory release];
@@ -48,14 +49,7 @@
 		return _wasLoaded;
 	}
 	
-	// Ensure the path is absolute, converting it if needed.
-	NSString* absFilePath = CC3EnsureAbsoluteFilePath(aFilePath);
-	
-	LogRez(@"--------------------------------------------------");
-	LogRez(@"Loading resources from file '%@'", absFilePath);
-	
-	if (!_name) self.name = absFilePath.lastPathComponent;
-	if (!_directory) self.directory = [absFilePath stringByDeletingLastPathComponent];
+	NSString* absFilePath = [self prepareToLoadFromFile: aFilePath];
 	
 	MarkRezActivityStart();
 	
@@ -71,8 +65,29 @@
 	return _wasLoaded;
 }
 
+/**
+ * Logs the start of loading the file at the specified path, sets the name, directory and
+ * memorySize properties from that file, and returns the absolute path to that file.
+ */
+-(NSString*) prepareToLoadFromFile: (NSString*) aFilePath {
+	
+	// Ensure the path is absolute, converting it if needed.
+	NSString* absFilePath = CC3EnsureAbsoluteFilePath(aFilePath);
+	
+	LogRez(@"--------------------------------------------------");
+	LogRez(@"Loading resources from file '%@'", absFilePath);
+	
+	if (!_name) self.name = absFilePath.lastPathComponent;
+	if (!_directory) self.directory = [absFilePath stringByDeletingLastPathComponent];
+	if (!_memorySize) _memorySize = (NSUInteger)[[NSFileManager.defaultManager attributesOfItemAtPath: absFilePath
+																							error: NULL] fileSize];
+	return absFilePath;
+}
+
 -(BOOL) processFile: (NSString*) anAbsoluteFilePath { return NO; }
 
+-(BOOL) preprocessFile: (NSString*) anAbsoluteFilePath { return YES; }
+
 -(BOOL) saveToFile: (NSString*) aFilePath {
 	CC3Assert(NO, @"%@ does not support saving the resource content back to a file.", self);
 	return NO;
@@ -84,8 +99,12 @@
 -(id) init {
 	if ( (self = [super init]) ) {
 		_directory = nil;
+		_memorySize = 0;
+		_lastAccessSequence = 0;
+		_useCount = 0;
 		_isBigEndian = NO;
 		_wasLoaded = NO;
+		_wasPreprocessed = NO;
 	}
 	return self;
 }
@@ -114,18 +133,125 @@
 
 -(NSString*) description { return [NSString stringWithFormat: @"%@ from file %@", self.class, self.name]; }
 
+-(BOOL) isInUse { return _useCount > 0; }
+
+-(void) beginUse { _useCount++; }
+
+-(void) endUse {
+	CC3Assert(_useCount > 0, @"%@ endUse invoked without a matching beginUse.", self);
+	if (_useCount > 0) _useCount--;
+}
+
+
+#pragma mark Background loading
+
+static dispatch_queue_t _resourceLoadingQueue = NULL;
+static NSMutableDictionary* _pendingCompletionsByFilePath = nil;
+
++(void) resourceFromFileInBackground: (NSString*) aFilePath withCompletion: (CC3ResourceCompletionBlock) completion {
+
+	// All cache and request bookkeeping is performed on the main thread
+	if ( ![NSThread isMainThread] ) {
+		dispatch_async(dispatch_get_main_queue(), ^{
+			[self resourceFromFileInBackground: aFilePath withCompletion: completion];
+		});
+		return;
+	}
+
+	CC3ResourceCompletionBlock onComplete = [[completion copy] autorelease];
+
+	id rez = [self getResourceNamed: aFilePath.lastPathComponent];
+	if (rez) {
+		if (onComplete) dispatch_async(dispatch_get_main_queue(), ^{ onComplete(rez); });
+		return;
+	}
+
+	// If this file is already being loaded, wait for that load to complete
+	NSString* absFilePath = CC3EnsureAbsoluteFilePath(aFilePath);
+	if ( !_pendingCompletionsByFilePath ) _pendingCompletionsByFilePath = [NSMutableDictionary new];	// retained
+	NSMutableArray* pendingCompletions = [_pendingCompletionsByFilePath objectForKey: absFilePath];
+	if (pendingCompletions) {
+		LogRez(@"Resource file '%@' is already being loaded in the background", absFilePath);
+		if (onComplete) [pendingCompletions addObject: onComplete];
+		return;
+	}
+	pendingCompletions = [NSMutableArray array];
+	if (onComplete) [pendingCompletions addObject: onComplete];
+	[_pendingCompletionsByFilePath setObject: pendingCompletions forKey: absFilePath];
+
+	// Resource files are loaded one at a time, because the file readers of some subclasses
+	// share global state. The resource is released on the main thread once it is complete.
+	if ( !_resourceLoadingQueue ) _resourceLoadingQueue = dispatch_queue_create("org.cocos3d.resource.load", NULL);
+	CC3Resource* newRez = [[self alloc] init];
+	dispatch_async(_resourceLoadingQueue, ^{
+		@autoreleasepool {
+			[newRez preprocessFromFile: absFilePath];
+		}
+		dispatch_async(dispatch_get_main_queue(), ^{
+			[self completeLoadingResource: newRez fromFile: absFilePath];
+			[newRez release];
+		});
+	});
+}
+
+/**
+ * Invoked on a background thread to prepare this resource for loading from the file at the
+ * specified absolute file path, and to invoke the preprocessFile: method.
+ */
+-(void) preprocessFromFile: (NSString*) absFilePath {
+	[self prepareToLoadFromFile: absFilePath];
+	MarkRezActivityStart();
+	_wasPreprocessed = [self preprocessFile: absFilePath];
+	LogRez(@"Preprocessed resources from file '%@' in the background in %.4f seconds",
+		   absFilePath, GetRezActivityDuration());
+}
+
+/**
+ * Invoked on the main thread once the specified resource has been preprocessed on a background
+ * thread. Completes the loading of the resource, adds it to the cache, and invokes the completion
+ * blocks that are waiting for it.
+ */
++(void) completeLoadingResource: (CC3Resource*) rez fromFile: (NSString*) absFilePath {
+	NSArray* pendingCompletions = [[[_pendingCompletionsByFilePath objectForKey: absFilePath] retain] autorelease];
+	[_pendingCompletionsByFilePath removeObjectForKey: absFilePath];
+
+	// A resource with the same name may have been added to the cache while this one was loading
+	CC3Resource* cachedRez = [self getResourceNamed: rez.name];
+	if ( !cachedRez && rez.wasPreprocessed ) {
+		MarkRezActivityStart();
+		rez->_wasLoaded = [rez processFile: absFilePath];
+		if (rez.wasLoaded) {
+			LogRez(@"Loaded resources from file '%@' in %.4f seconds on the main thread",
+				   absFilePath, GetRezActivityDuration());
+			[self addResource: rez];
+			cachedRez = rez;
+		}
+	}
+	if ( !cachedRez ) LogError(@"Could not load resource file '%@'", absFilePath);
+
+	for (CC3ResourceCompletionBlock onComplete in pendingCompletions) onComplete(cachedRez);
+}
+
 
 #pragma mark Resource cache
 
 static NSMutableDictionary* _resourcesByName = nil;
+static NSUInteger _resourceCacheMemoryBudget = 0;
+static NSUInteger _lastResourceAccessSequence = 0;
 
-+(CC3Resource*) getResourceNamed: (NSString*) rezName { return [_resourcesByName objectForKey: rezName]; }
++(CC3Resource*) getResourceNamed: (NSString*) rezName {
+	CC3Resource* rez = [_resourcesByName objectForKey: rezName];
+	if (rez) rez->_lastAccessSequence = ++_lastResourceAccessSequence;
+	return rez;
+}
 
 +(void) addResource: (CC3Resource*) resource {
 	if ( !resource ) return;
 	CC3Assert(resource.name, @"%@ cannot be added to the resource cache because its name property is nil.", resource);
 	if ( !_resourcesByName ) _resourcesByName = [NSMutableDictionary new];		// retained
+	resource->_lastAccessSequence = ++_lastResourceAccessSequence;
 	[_resourcesByName setObject: resource forKey: resource.name];
+	[self enforceResourceCacheMemoryBudget];
 }
 
 +(void) removeResource: (CC3Resource*) resource {
@@ -141,6 +267,44 @@ static NSMutableDictionary* _resourcesByName = nil;
 
 -(void) remove { [[self class] removeResource: self]; }
 
++(NSUInteger) resourceCacheMemoryBudget { return _resourceCacheMemoryBudget; }
+
++(void) setResourceCacheMemoryBudget: (NSUInteger) budget {
+	_resourceCacheMemoryBudget = budget;
+	[self enforceResourceCacheMemoryBudget];
+}
+
++(NSUInteger) resourceCacheMemorySize {
+	NSUInteger cacheSize = 0;
+	for (CC3Resource* rez in _resourcesByName.objectEnumerator) cacheSize += rez.memorySize;
+	return cacheSize;
+}
+
++(void) enforceResourceCacheMemoryBudget {
+	if ( !_resourceCacheMemoryBudget ) return;
+
+	NSUInteger cacheSize = self.resourceCacheMemorySize;
+	while (cacheSize > _resourceCacheMemoryBudget) {
+
+		// Find the least recently used resource that is not in use.
+		CC3Resource* lruRez = nil;
+		for (CC3Resource* rez in _resourcesByName.objectEnumerator) {
+			if (rez.isInUse) continue;
+			if ( !lruRez || rez->_lastAccessSequence < lruRez->_lastAccessSequence ) lruRez = rez;
+		}
+		if ( !lruRez ) {
+			LogRez(@"Resource cache holds %lu bytes, exceeding its budget of %lu bytes, but all resources are in use",
+				   (unsigned long)cacheSize, (unsigned long)_resourceCacheMemoryBudget);
+			return;
+		}
+
+		LogRez(@"Removing %@ holding %lu bytes from the resource cache to meet its budget of %lu bytes",
+			   lruRez, (unsigned long)lruRez.memorySize, (unsigned long)_resourceCacheMemoryBudget);
+		cacheSize -= lruRez.memorySize;
+		[_resourcesByName removeObjectForKey: lruRez.name];
+	}
+}
+
 
 #pragma mark Tag allocation
 
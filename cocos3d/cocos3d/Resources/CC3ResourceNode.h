@@ -95,6 +95,10 @@
  *
  * If the resource has not already been loaded when it is set here, it may
  * be loaded using the loadFromFile: methods of this resource node instance.
+ *
+ * While it is held by this node, the resource is marked as in use, using its beginUse
+ * and endUse methods, so that it is not removed from the resource cache when the cache
+ * is trimmed to its resourceCacheMemoryBudget.
  * 
  * For subclasses of CC3ResourceNode that override the resourceClass property,
  * if this resource property is not explicitly set, it is lazily created, as an
@@ -37,6 +37,7 @@
 @synthesize resource=_resource;
 
 -(void) dealloc {
+	[_resource endUse];
 	[_resource release];
 	[super dealloc];
 }
@@ -61,8 +62,10 @@
 -(void) setResource: (CC3NodesResource*) aResource {
 	if (aResource == _resource) return;
 	[self removeAllChildren];
+	[_resource endUse];
 	[_resource release];
 	_resource = [aResource retain];
+	[_resource beginUse];
 	if (!_name) { self.name = self.resource.name; }
 	[self addResourceNodes];
 }
@@ -99,8 +102,10 @@
 -(void) populateFrom: (CC3ResourceNode*) another {
 	[super populateFrom: another];
 	
+	[_resource endUse];
 	[_resource release];
 	_resource = [another.resource retain];		// retained
+	[_resource beginUse];
 }
 
 
@@ -45,7 +45,7 @@ static const ccTime kCC3DefaultMaximumUpdateInterval = (1.0 / 15.0);
 /** Default color for the ambient scene light. */
 static const ccColor4F kCC3DefaultLightColorAmbientScene = { 0.2, 0.2, 0.2, 1.0 };
 
-@class CC3Layer, CC3TouchedNodePicker, CC3ViewportManager;
+@class CC3Layer, CC3TouchedNodePicker, CC3ViewportManager, CC3LightGrid, CC3OcclusionCuller;
 
 
 #pragma mark -
@@ -245,11 +245,21 @@ static const ccColor4F kCC3DefaultLightColorAmbientScene = { 0.2, 0.2, 0.2, 1.0
 	CC3NodeTransformingVisitor* transformVisitor;
 	CC3NodeSequencerVisitor* drawingSequenceVisitor;
 	CC3Fog* fog;
+	CC3LightGrid* _lightGrid;
+	CC3OcclusionCuller* _occlusionCuller;
 	ccColor4F ambientLight;
 	ccTime minUpdateInterval;
 	ccTime maxUpdateInterval;
 	ccTime _deltaFrameTime;
+	ccTime _deferredUpdateTime;
+	CC3FramePacket* _framePackets[2];
+	CC3FramePacket* _drawingFramePacket;
+	dispatch_queue_t _updateQueue;
+	volatile int32_t _frontFramePacketIndex;
+	volatile int32_t _isUpdateInFlight;
 	BOOL _shouldClearDepthBuffer : 1;
+	BOOL _shouldUpdateShadowsConcurrently : 1;
+	BOOL _shouldUpdateSceneConcurrently : 1;
 }
 
 /**
@@ -355,6 +365,78 @@ static const ccColor4F kCC3DefaultLightColorAmbientScene = { 0.2, 0.2, 0.2, 1.0
 /** Returns whether any of the lights in the scene are casting shadows. */
 @property(nonatomic, readonly) BOOL doesContainShadows;
 
+/**
+ * Indicates whether the shadow volumes cast by all of the lights in this scene should
+ * be built concurrently on background threads during each update.
+ *
+ * When this property is set to YES, the shadows of all lights are updated together using
+ * the CC3ShadowVolumeMeshNode updateShadowsConcurrently: method, which spreads the
+ * construction of the shadow volume meshes across the available processor cores. When
+ * this property is set to NO, each shadow is updated in turn on the updating thread.
+ *
+ * Setting this property to YES is most effective when the scene contains many shadow-casting
+ * nodes, or several lights casting shadows. See the notes of that method for more information.
+ *
+ * The initial value of this property is NO.
+ */
+@property(nonatomic, assign) BOOL shouldUpdateShadowsConcurrently;
+
+/**
+ * Indicates whether this scene should be updated on a background thread, concurrently
+ * with the drawing of the previous update on the rendering thread.
+ *
+ * When this property is set to YES, each invocation of the updateScene: method hands the
+ * update off to a background serial queue, and returns immediately. Once the nodes have been
+ * updated, the state needed to draw them (the global transform matrices and bone palettes of
+ * the nodes that are visible and inside the camera frustum, and the view and projection
+ * matrices of the camera) is captured into one of two CC3FramePackets. The drawScene
+ * method draws the most recently completed frame packet, while the next update runs. Drawing
+ * therefore lags the update by one frame.
+ *
+ * Only one update runs at a time. If the previous update has not finished when the updateScene:
+ * method is next invoked, the update interval is carried forward and added to the next update
+ * that is started, so that no simulation time is lost.
+ *
+ * Because the update runs on a background thread, any update activity must be safe to perform
+ * away from the rendering thread. In particular:
+ *   - no GL calls may be made during the update. This excludes scenes containing shadow volumes,
+ *     and particle emitters or other meshes whose vertex content is updated into GL buffers
+ *     during the update.
+ *   - lights, fog, billboards, and materials are not captured in the frame packet, and are read
+ *     directly from the nodes while drawing. Changes to these that are made during the update
+ *     may appear one frame early, or partially.
+ *   - touch events are dispatched on the main thread, between updates.
+ *   - CCActions, which are run by the CCActionManager, and any methods scheduled with the
+ *     CCScheduler, continue to run on the main thread, and may change the nodes of this scene
+ *     while the background update is reading them. Nodes that are moved by CCActions or by
+ *     scheduled methods may therefore be drawn with a transform that mixes the old and new
+ *     values. If this is a concern, restrict such changes to the update methods of the nodes
+ *     (updateBeforeTransform: and updateAfterTransform:), which run within the update itself.
+ *   - statistics are collected into the performanceStatistics from both threads; node update
+ *     and transform counts are collected during the background update, while drawing counts
+ *     and frame times are collected on the rendering thread. The CC3PerformanceStatistics
+ *     counters are not synchronized, so statistics read or reset while an update is running
+ *     may be slightly inaccurate. This does not affect the behaviour of the scene.
+ *
+ * The updateScene method, which forces an immediate update, waits for any update in progress,
+ * and then updates this scene synchronously, capturing a new frame packet.
+ *
+ * Setting this property to NO waits for any update in progress to finish.
+ *
+ * The initial value of this property is NO.
+ */
+@property(nonatomic, assign) BOOL shouldUpdateSceneConcurrently;
+
+/**
+ * When the shouldUpdateSceneConcurrently property is set to YES, returns the frame packet that
+ * was captured at the end of the most recently completed update, and which will be drawn by
+ * the next invocation of the drawScene method.
+ *
+ * Returns nil if the shouldUpdateSceneConcurrently property is set to NO,
+ * or if no update has yet completed.
+ */
+@property(nonatomic, readonly) CC3FramePacket* framePacket;
+
 /**
  * Updates the relative intensities of each light by invoking the
  * updateRelativeIntensityFrom: method on each light.
@@ -382,6 +464,10 @@ static const ccColor4F kCC3DefaultLightColorAmbientScene = { 0.2, 0.2, 0.2, 1.0
  * reset method, to ensure that the counters do not overflow. Depending on the
  * complexity and capabilities of your application, you should reset the performance
  * statistics at least every few seconds.
+ *
+ * If the shouldUpdateSceneConcurrently property is set to YES, this statistics collector
+ * is written to from both the background update thread and the rendering thread, without
+ * synchronization. See the notes of that property for more information.
  */
 @property(nonatomic, retain) CC3PerformanceStatistics* performanceStatistics;
 
@@ -394,6 +480,35 @@ static const ccColor4F kCC3DefaultLightColorAmbientScene = { 0.2, 0.2, 0.2, 1.0
  */
 @property(nonatomic, retain) CC3Fog* fog;
 
+/**
+ * If set, selects the lights that illuminate each node from the lights in this scene.
+ *
+ * When this property is nil, each lit node is drawn with all of the lights in this scene,
+ * and the number of lights in the scene is limited by the platform. When this property is
+ * set, the light grid is populated with the visible lights near the beginning of each frame,
+ * and each lit node is drawn with only the few lights that most strongly illuminate it.
+ * See the notes for the CC3LightGrid class for more information.
+ *
+ * Under OpenGL ES 2, the light grid allows the scene to contain many more lights than can
+ * be used by the shaders, by raising the maxLights value of the platform. Under OpenGL ES 1,
+ * the number of lights in the scene remains limited by the platform.
+ *
+ * The initial value is nil, indicating that all lights illuminate all nodes.
+ */
+@property(nonatomic, retain) CC3LightGrid* lightGrid;
+
+/**
+ * If set, prevents nodes that are hidden behind designated occluder nodes from being drawn.
+ *
+ * When this property is set, the occluders held by the culler are rendered into a low resolution
+ * software depth buffer near the beginning of each frame, and each node is tested against that
+ * buffer, after being tested against the camera frustum, before it is drawn. See the notes for
+ * the CC3OcclusionCuller class for more information.
+ *
+ * The initial value is nil, indicating that nodes are culled only against the camera frustum.
+ */
+@property(nonatomic, retain) CC3OcclusionCuller* occlusionCuller;
+
 
 #pragma mark Allocation and initialization
 
@@ -36,12 +36,14 @@
 #import "CC3Light.h"
 #import "CC3Billboard.h"
 #import "CC3ShadowVolumes.h"
+#import "CC3OcclusionCulling.h"
 #import "CC3AffineMatrix.h"
 #import "CC3OpenGLESEngine.h"
 #import "CC3CC2Extensions.h"
 #import "CC3IOSExtensions.h"
 #import "CGPointExtension.h"
 #import "ccMacros.h"
+#import <libkern/OSAtomic.h>
 
 
 #pragma mark -
@@ -58,7 +60,12 @@
 -(void) updateFog: (ccTime) dt;
 -(void) updateShadows: (ccTime) dt;
 -(void) updateBillboards: (ccTime) dt;
+-(void) processUpdate: (ccTime) dt;
+-(void) dispatchConcurrentUpdate: (ccTime) dt;
+-(void) waitForConcurrentUpdate;
+-(void) captureFramePacket;
 -(void) collectFrameInterval;
+-(void) collectGLStateChanges;
 -(void) openViewport;
 -(void) closeViewport;
 -(void) open3DCamera;
@@ -81,7 +88,10 @@
 @synthesize touchedNodePicker, drawingSequencer, drawingSequenceVisitor;
 @synthesize drawVisitor, shadowVisitor, updateVisitor, transformVisitor;
 @synthesize viewportManager, performanceStatistics, fog, lights;
+@synthesize lightGrid=_lightGrid, occlusionCuller=_occlusionCuller;
 @synthesize shouldClearDepthBuffer=_shouldClearDepthBuffer;
+@synthesize shouldUpdateShadowsConcurrently=_shouldUpdateShadowsConcurrently;
+@synthesize shouldUpdateSceneConcurrently=_shouldUpdateSceneConcurrently;
 
 /**
  * Descendant nodes will be removed by superclass. Their removal may invoke
@@ -100,12 +110,20 @@
 	self.transformVisitor = nil;			// Use setter to release and make nil
 	self.drawingSequenceVisitor = nil;		// Use setter to release and make nil
 	self.fog = nil;							// Use setter to stop any actions
+	[_lightGrid release];
+	_lightGrid = nil;
+	[_occlusionCuller release];
+	_occlusionCuller = nil;
 	[targettingNodes release];
 	targettingNodes = nil;
 	[lights release];
 	lights = nil;
 	[billboards release];
 	billboards = nil;
+	[_framePackets[0] release];
+	[_framePackets[1] release];
+	_drawingFramePacket = nil;				// Not retained
+	if (_updateQueue) dispatch_release(_updateQueue);
 	
     [super dealloc];
 }
@@ -171,6 +189,15 @@
 		lights = [[CCArray array] retain];
 		billboards = [[CCArray array] retain];
 		_shouldClearDepthBuffer = YES;
+		_shouldUpdateShadowsConcurrently = NO;
+		_shouldUpdateSceneConcurrently = NO;
+		_framePackets[0] = nil;
+		_framePackets[1] = nil;
+		_drawingFramePacket = nil;
+		_updateQueue = NULL;
+		_frontFramePacketIndex = -1;
+		_isUpdateInFlight = 0;
+		_deferredUpdateTime = 0;
 		self.touchedNodePicker = [CC3TouchedNodePicker pickerOnScene: self];
 		self.drawingSequencer = [CC3BTreeNodeSequencer sequencerLocalContentOpaqueFirst];
 		self.viewportManager = [CC3ViewportManager viewportManagerOnScene: self];
@@ -180,6 +207,8 @@
 		self.transformVisitor = [[self transformVisitorClass] visitor];
 		self.drawingSequenceVisitor = [CC3NodeSequencerVisitor visitorWithScene: self];
 		fog = nil;
+		_lightGrid = nil;
+		_occlusionCuller = nil;
 		activeCamera = nil;
 		ambientLight = kCC3DefaultLightColorAmbientScene;
 		minUpdateInterval = kCC3DefaultMinimumUpdateInterval;
@@ -220,11 +249,19 @@
 
 	[fog release];
 	fog = [another.fog copy];											// retained
+
+	CC3LightGrid* anotherGrid = another.lightGrid;
+	self.lightGrid = anotherGrid ? [[anotherGrid class] lightGrid] : nil;	// retained
+	_lightGrid.cellSize = anotherGrid.cellSize;
+	_lightGrid.influenceThreshold = anotherGrid.influenceThreshold;
+	_lightGrid.maximumLightsPerNode = anotherGrid.maximumLightsPerNode;
 	
 	ambientLight = another.ambientLight;
 	minUpdateInterval = another.minUpdateInterval;
 	maxUpdateInterval = another.maxUpdateInterval;
 	_shouldClearDepthBuffer = another.shouldClearDepthBuffer;
+	_shouldUpdateShadowsConcurrently = another.shouldUpdateShadowsConcurrently;
+	self.shouldUpdateSceneConcurrently = another.shouldUpdateSceneConcurrently;
 }
 
 
@@ -250,13 +287,25 @@
 -(void) pause { self.isRunning = NO; }
 
 /**
- * If needed, clamps the specified interval value, then invokes a sequence of template methods.
+ * If needed, clamps the specified interval value, then invokes a sequence of template methods,
+ * either immediately, or on the background update queue if the scene is updated concurrently.
  * Does nothing if this instance is not running.
  */
 -(void) updateScene: (ccTime) dt {
 	[performanceStatistics addUpdateTime: dt];
 	if( !self.isRunning) return;
 
+	if (_shouldUpdateSceneConcurrently) {
+		[self dispatchConcurrentUpdate: dt];
+	} else {
+		[touchedNodePicker dispatchPickedNode];
+		[self processUpdate: dt];
+	}
+}
+
+/** Template method that clamps the specified interval and updates the contents of the scene. */
+-(void) processUpdate: (ccTime) dt {
+
 	// Clamp the specified interval to a range defined by the minimum and maximum
 	// update intervals. If the maximum update interval limit is zero or negative,
 	// its value is ignored, and the dt value is not limited to a maximum value.
@@ -266,8 +315,6 @@
 	LogTrace(@"******* %@ starting update: %.2f ms (clamped from %.2f ms)",
 			 self, _deltaFrameTime * 1000.0, dt * 1000.0);
 	
-	[touchedNodePicker dispatchPickedNode];
-	
 	updateVisitor.deltaTime = _deltaFrameTime;
 	[updateVisitor visit: self];
 	
@@ -284,10 +331,84 @@
 -(void) updateScene {
 	BOOL wasRunning = isRunning;
 	isRunning = YES;
-	[self updateScene: minUpdateInterval];
+	if (_shouldUpdateSceneConcurrently) {
+		[self waitForConcurrentUpdate];
+		[performanceStatistics addUpdateTime: minUpdateInterval];
+		[touchedNodePicker dispatchPickedNode];
+		[self processUpdate: minUpdateInterval];
+		[self captureFramePacket];
+	} else {
+		[self updateScene: minUpdateInterval];
+	}
 	isRunning = wasRunning;
 }
 
+
+#pragma mark Concurrent updating
+
+-(void) setShouldUpdateSceneConcurrently: (BOOL) shouldUpdateConcurrently {
+	if (shouldUpdateConcurrently == _shouldUpdateSceneConcurrently) return;
+
+	if (shouldUpdateConcurrently) {
+		if ( !_updateQueue ) _updateQueue = dispatch_queue_create("org.cocos3d.scene.update", NULL);
+		if ( !_framePackets[0] ) _framePackets[0] = [CC3FramePacket new];
+		if ( !_framePackets[1] ) _framePackets[1] = [CC3FramePacket new];
+	} else {
+		[self waitForConcurrentUpdate];
+	}
+	_frontFramePacketIndex = -1;		// Don't draw stale state when switching modes
+	_deferredUpdateTime = 0;
+	_shouldUpdateSceneConcurrently = shouldUpdateConcurrently;
+}
+
+-(CC3FramePacket*) framePacket {
+	if ( !_shouldUpdateSceneConcurrently ) return nil;
+	OSMemoryBarrier();
+	int32_t frontIdx = _frontFramePacketIndex;
+	return (frontIdx >= 0) ? _framePackets[frontIdx] : nil;
+}
+
+/**
+ * Starts an update of this scene on the background update queue, unless the previous update
+ * is still running, in which case the interval is carried forward to the next update.
+ *
+ * Picked nodes are dispatched here, on the main thread, before the update starts. This scene
+ * is retained while the update runs, and is released on the main thread once it is done.
+ */
+-(void) dispatchConcurrentUpdate: (ccTime) dt {
+	_deferredUpdateTime += dt;
+	if ( !OSAtomicCompareAndSwap32Barrier(0, 1, &_isUpdateInFlight) ) return;
+
+	ccTime updateTime = _deferredUpdateTime;
+	_deferredUpdateTime = 0;
+
+	[touchedNodePicker dispatchPickedNode];
+
+	__block CC3Scene* scene = [self retain];
+	dispatch_async(_updateQueue, ^{
+		[scene processUpdate: updateTime];
+		[scene captureFramePacket];
+		OSAtomicCompareAndSwap32Barrier(1, 0, &scene->_isUpdateInFlight);
+		dispatch_async(dispatch_get_main_queue(), ^{ [scene release]; });
+	});
+}
+
+/** Blocks until any update running on the background update queue has finished. */
+-(void) waitForConcurrentUpdate {
+	if (_updateQueue) dispatch_sync(_updateQueue, ^{});
+}
+
+/**
+ * Captures the drawing state of this scene into the frame packet that is not currently
+ * being drawn, and then publishes it as the frame packet to be drawn on the next frame.
+ */
+-(void) captureFramePacket {
+	int32_t backIdx = (_frontFramePacketIndex == 0) ? 1 : 0;
+	[_framePackets[backIdx] captureScene: self];
+	OSMemoryBarrier();
+	_frontFramePacketIndex = backIdx;
+}
+
 /** 
  * Template method to update the direction pointed to by any targetting nodes in this scene.
  * Iterates through all the targetting nodes in this scene, updating their target tracking.
@@ -310,10 +431,19 @@
 	[fog update: dt];
 }
 
-/** Template method to update shadows cast by the lights. */
+/**
+ * Template method to update shadows cast by the lights. If shadows are to be updated
+ * concurrently, the shadows of all lights are gathered and updated together.
+ */
 -(void) updateShadows: (ccTime) dt {
-	for (CC3Light* lgt in lights) {
-		[lgt updateShadows];
+	if (_shouldUpdateShadowsConcurrently) {
+		CCArray* allShadows = [CCArray array];
+		for (CC3Light* lgt in lights) if (lgt.hasShadows) [allShadows addObjectsFromArray: lgt.shadows];
+		[CC3ShadowVolumeMeshNode updateShadowsConcurrently: allShadows];
+	} else {
+		for (CC3Light* lgt in lights) {
+			[lgt updateShadows];
+		}
 	}
 }
 
@@ -349,6 +479,10 @@
 
 	[self collectFrameInterval];	// Collect the frame interval in the performance statistics.
 	
+	// If updating concurrently, draw the frame packet captured by the last completed update.
+	// It is held for the whole frame, because another may be published while drawing.
+	_drawingFramePacket = self.framePacket;		// Not retained
+
 	if (self.visible) {
 		[self open3D];
 		[self openViewport];
@@ -356,6 +490,7 @@
 		[touchedNodePicker pickTouchedNode];
 		[self illuminate];
 		[self drawFog];
+		[_occlusionCuller prepareForCamera: activeCamera];
 		[self visitForDrawingWithVisitor: drawVisitor];
 		[self drawShadows];
 		[self close3DCamera];
@@ -365,6 +500,10 @@
 		[self draw2DBillboards];	// Back to 2D now
 	}
 	
+	[self collectGLStateChanges];	// Collect the GL state changes in the performance statistics.
+
+	_drawingFramePacket = nil;		// Not retained
+	
 	// Check and clear any GL error that occurred during 3D code
 	LogGLErrorState(@"after drawing %@", self);
 	LogTrace(@"******* %@ exiting drawing visit", self);
@@ -379,6 +518,19 @@
 		[performanceStatistics addFrameTime: [[CCDirector sharedDirector] frameInterval]];
 }
 
+/**
+ * Add the GL state changes made and filtered by the GL engine during this frame
+ * to the performance statistics, and reset the engine counts for the next frame.
+ */
+-(void) collectGLStateChanges {
+	CC3OpenGLESEngine* glesEngine = [CC3OpenGLESEngine engine];
+	if (performanceStatistics) {
+		[performanceStatistics addGLStateChangesMade: glesEngine.stateChangeCount];
+		[performanceStatistics addGLStateChangesFiltered: glesEngine.filteredStateChangeCount];
+	}
+	[glesEngine resetStateChangeCounts];
+}
+
 -(void) open3D {
 	LogTrace(@"%@ opening the 3D scene", self);
 
@@ -494,11 +646,24 @@
 /** Template method that closes the 3D viewport. This is the compliment of the openViewport method. */
 -(void) closeViewport { [viewportManager close]; }
 
-/** Template method that opens the 3D camera. */
--(void) open3DCamera { [activeCamera open]; }
+/**
+ * Template method that opens the 3D camera. If a frame packet is being drawn,
+ * the camera matrices captured in the frame packet are used instead.
+ */
+-(void) open3DCamera {
+	if (_drawingFramePacket)
+		[_drawingFramePacket openCamera];
+	else
+		[activeCamera open];
+}
 
 /** Template method that closes the 3D camera. This is the compliment of the open3DCamera method. */
--(void) close3DCamera { [activeCamera close]; }
+-(void) close3DCamera {
+	if (_drawingFramePacket)
+		[_drawingFramePacket closeCamera];
+	else
+		[activeCamera close];
+}
 
 /**
  * Template method that turns on lighting of the 3D scene. Turns on global ambient lighting,
@@ -517,6 +682,9 @@
 
 	// Turn on any individual lights
 	for (CC3Light* lgt in lights) [lgt turnOn];
+
+	// Bin the lights so each node can be drawn with only the lights that influence it
+	[_lightGrid binLights: lights];
 }
 
 -(BOOL) isIlluminated {
@@ -578,13 +746,19 @@
 	[viewportManager closeClipping];
 }
 
-/** Visits this scene for drawing (or picking) using the specified visitor. */
+/**
+ * Visits this scene for drawing (or picking) using the specified visitor.
+ * If a frame packet is being drawn, the visitor draws the nodes in the frame packet.
+ */
 -(void) visitForDrawingWithVisitor: (CC3NodeDrawingVisitor*) visitor {
 	visitor.deltaTime = _deltaFrameTime;
 	visitor.shouldClearDepthBuffer = self.shouldClearDepthBuffer;
 	visitor.drawingSequencer = drawingSequencer;
 	visitor.shouldVisitChildren = YES;
-	[visitor visit: self];
+	if (_drawingFramePacket)
+		[visitor visitFramePacket: _drawingFramePacket forScene: self];
+	else
+		[visitor visit: self];
 }
 
 -(id) drawVisitorClass { return [CC3NodeDrawingVisitor class]; }
@@ -703,6 +877,14 @@
 		
 		// If the node is a shadow, check if we need to remove the shadow visitor
 		if (removedNode.isShadowVolume) [self checkNeedShadowVisitor];
+
+		// If the node is drawn by an instancing node or a static batch node, remove it
+		// from that node, so that it is no longer drawn as part of the batch.
+		if (removedNode.isMeshNode) {
+			CC3MeshNode* removedMeshNode = (CC3MeshNode*)removedNode;
+			[removedMeshNode.instancingNode removeInstance: removedMeshNode];
+			[removedMeshNode.staticBatchNode removeSourceNode: removedMeshNode];
+		}
 	}
 }
 
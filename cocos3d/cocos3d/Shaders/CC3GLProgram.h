@@ -52,11 +52,14 @@
 	CCArray* _uniformsSceneScope;
 	CCArray* _uniformsNodeScope;
 	CCArray* _uniformsDrawScope;
+	CCArray* _uniformsLightScope;
 	CCArray* _attributes;
 	GLint _maxUniformNameLength;
 	GLint _maxAttributeNameLength;
 	GLuint _programID;
+	GLuint _lightSelectionVersion;
 	BOOL _isSceneScopeDirty : 1;
+	BOOL _isLightScopePopulated : 1;
 }
 
 /** Returns the GL program ID. */
@@ -128,7 +131,14 @@
  */
 -(void) populateSceneScopeUniformsWithVisitor: (CC3NodeDrawingVisitor*) visitor;
 
-/** Populates all uniform variables that have node scope. */
+/**
+ * Populates all uniform variables that have node scope.
+ *
+ * If the visitor is selecting the lights that illuminate each node, and the lights selected for
+ * the current node differ from those that were last populated into this program, as indicated by
+ * the lightSelectionVersion property of the visitor, the uniform variables that describe the
+ * lights are also populated. Otherwise, those variables are populated with the scene scope.
+ */
 -(void) populateNodeScopeUniformsWithVisitor: (CC3NodeDrawingVisitor*) visitor;
 
 /** Populates all uniform variables that have draw scope. */
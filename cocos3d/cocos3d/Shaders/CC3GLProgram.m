@@ -56,6 +56,7 @@
 	[_uniformsSceneScope release];
 	[_uniformsNodeScope release];
 	[_uniformsDrawScope release];
+	[_uniformsLightScope release];
 	[_attributes release];
 	[super dealloc];
 }
@@ -67,6 +68,7 @@
 	for (CC3GLSLUniform* var in _uniformsSceneScope) if ( [var.name isEqualToString: varName] ) return var;
 	for (CC3GLSLUniform* var in _uniformsNodeScope) if ( [var.name isEqualToString: varName] ) return var;
 	for (CC3GLSLUniform* var in _uniformsDrawScope) if ( [var.name isEqualToString: varName] ) return var;
+	for (CC3GLSLUniform* var in _uniformsLightScope) if ( [var.name isEqualToString: varName] ) return var;
 	return nil;
 }
 
@@ -74,6 +76,7 @@
 	for (CC3GLSLUniform* var in _uniformsSceneScope) if (var.location == uniformLocation) return var;
 	for (CC3GLSLUniform* var in _uniformsNodeScope) if (var.location == uniformLocation) return var;
 	for (CC3GLSLUniform* var in _uniformsDrawScope) if (var.location == uniformLocation) return var;
+	for (CC3GLSLUniform* var in _uniformsLightScope) if (var.location == uniformLocation) return var;
 	return nil;
 }
 
@@ -88,6 +91,8 @@
 		if (var.semantic == semantic && var.semanticIndex == semanticIndex) return var;
 	for (CC3GLSLUniform* var in _uniformsDrawScope)
 		if (var.semantic == semantic && var.semanticIndex == semanticIndex) return var;
+	for (CC3GLSLUniform* var in _uniformsLightScope)
+		if (var.semantic == semantic && var.semanticIndex == semanticIndex) return var;
 	return nil;
 }
 
@@ -210,6 +215,7 @@
 	[_uniformsSceneScope removeAllObjects];
 	[_uniformsNodeScope removeAllObjects];
 	[_uniformsDrawScope removeAllObjects];
+	[_uniformsLightScope removeAllObjects];
 	
 	GLint varCnt;
 	glGetProgramiv(_programID, GL_ACTIVE_UNIFORMS, &varCnt);
@@ -234,6 +240,9 @@
 		case kCC3GLSLVariableScopeDraw:
 			[_uniformsDrawScope addObject: var];
 			return;
+		case kCC3GLSLVariableScopeLight:
+			[_uniformsLightScope addObject: var];
+			return;
 		default:
 			[_uniformsNodeScope addObject: var];
 			return;
@@ -326,11 +335,28 @@ typedef void ( GLLogFunction (GLuint program, GLsizei bufsize, GLsizei* length,
 		LogTrace(@"%@ populating scene scope", self);
 		[self populateUniforms: _uniformsSceneScope withVisitor: visitor];
 		_isSceneScopeDirty = NO;
+		_isLightScopePopulated = NO;	// Force lights to be populated
+	}
+}
+
+/**
+ * Populates the light uniforms if the lights to be used differ from those last populated.
+ * When the visitor is not selecting lights per node, the scene lights are identified
+ * by a light selection version of zero, and are populated once per scene.
+ */
+-(void) populateLightScopeUniformsWithVisitor: (CC3NodeDrawingVisitor*) visitor {
+	GLuint ltVer = visitor.isSelectingLights ? visitor.lightSelectionVersion : 0;
+	if ( !_isLightScopePopulated || ltVer != _lightSelectionVersion ) {
+		LogTrace(@"%@ populating light scope", self);
+		[self populateUniforms: _uniformsLightScope withVisitor: visitor];
+		_lightSelectionVersion = ltVer;
+		_isLightScopePopulated = YES;
 	}
 }
 
 -(void) populateNodeScopeUniformsWithVisitor: (CC3NodeDrawingVisitor*) visitor {
 	[self populateSceneScopeUniformsWithVisitor: visitor];
+	[self populateLightScopeUniformsWithVisitor: visitor];
 	LogTrace(@"%@ populating node scope", self);
 	[self populateUniforms: _uniformsNodeScope withVisitor: visitor];
 }
@@ -340,12 +366,30 @@ typedef void ( GLLogFunction (GLuint program, GLsizei bufsize, GLsizei* length,
 	[self populateUniforms: _uniformsDrawScope withVisitor: visitor];
 }
 
+/**
+ * Populates the specified uniforms, and updates the GL engine with any values that have changed.
+ *
+ * Overrides in the program context of the current material take precedence. Otherwise, uniforms
+ * whose values are derived only from the environmental matrices of the visitor are skipped if
+ * those matrices have not changed since the uniform was last populated. All other uniforms are
+ * populated by the semantic delegate.
+ */
 -(void) populateUniforms: (CCArray*) uniforms withVisitor: (CC3NodeDrawingVisitor*) visitor {
 	CC3GLProgramContext* progCtx = visitor.currentMaterial.shaderContext;
+	GLuint modelVersion = visitor.modelMatrixVersion;
+	GLuint viewVersion = visitor.viewMatrixVersion;
+	GLuint projVersion = visitor.projMatrixVersion;
 	for (CC3GLSLUniform* var in uniforms)
-		if ([progCtx populateUniform: var withVisitor: visitor] ||
-			[_semanticDelegate populateUniform: var withVisitor: visitor]) {
+		if ([progCtx populateUniform: var withVisitor: visitor]) {
+			[var updateGLValue];
+			[var markMatrixVersionsUnknown];
+		} else if ([var isCurrentForModelMatrixVersion: modelVersion
+									 viewMatrixVersion: viewVersion
+									 projMatrixVersion: projVersion]) {
+			continue;
+		} else if ([_semanticDelegate populateUniform: var withVisitor: visitor]) {
 			[var updateGLValue];
+			[var setModelMatrixVersion: modelVersion viewMatrixVersion: viewVersion projMatrixVersion: projVersion];
 		} else {
 			CC3Assert(NO, @"%@ could not resolve the value of uniform %@ with semantic %@."
 					  " If this is a valid uniform, you should create a uniform override in the"
@@ -379,10 +423,13 @@ andFragmentShaderBytes: (const GLchar*) fshBytes {
 		_uniformsSceneScope = [CCArray new];	// retained
 		_uniformsNodeScope = [CCArray new];		// retained
 		_uniformsDrawScope = [CCArray new];		// retained
+		_uniformsLightScope = [CCArray new];	// retained
 		_attributes = [CCArray new];			// retained
 		_maxUniformNameLength = 0;
 		_maxAttributeNameLength = 0;
 		_isSceneScopeDirty = NO;
+		_lightSelectionVersion = 0;
+		_isLightScopePopulated = NO;
 		_semanticDelegate = [semanticDelegate retain];
 		[self compileAndLinkVertexShaderBytes: vshBytes andFragmentShaderBytes: fshBytes];
 	}
@@ -426,11 +473,12 @@ andFragmentShaderFile: (NSString*) fshFilename {
 -(NSString*) fullDescription {
 	NSMutableString* desc = [NSMutableString stringWithCapacity: 500];
 	[desc appendFormat: @"%@ declaring %i attributes and %i uniforms:",
-	 self.description, _attributes.count, (_uniformsSceneScope.count + _uniformsNodeScope.count + _uniformsDrawScope.count)];
+	 self.description, _attributes.count, (_uniformsSceneScope.count + _uniformsNodeScope.count + _uniformsDrawScope.count + _uniformsLightScope.count)];
 	for (CC3GLSLVariable* var in _attributes) [desc appendFormat: @"\n\t %@", var.fullDescription];
 	for (CC3GLSLVariable* var in _uniformsSceneScope) [desc appendFormat: @"\n\t %@", var.fullDescription];
 	for (CC3GLSLVariable* var in _uniformsNodeScope) [desc appendFormat: @"\n\t %@", var.fullDescription];
 	for (CC3GLSLVariable* var in _uniformsDrawScope) [desc appendFormat: @"\n\t %@", var.fullDescription];
+	for (CC3GLSLVariable* var in _uniformsLightScope) [desc appendFormat: @"\n\t %@", var.fullDescription];
 	return desc;
 }
 
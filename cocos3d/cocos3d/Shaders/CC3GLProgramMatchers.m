@@ -57,6 +57,10 @@
 	GLuint texCnt = mat.textureCount;
 	BOOL shouldAlphaTest = !mat.shouldDrawLowAlpha;
 	
+	// Billboards oriented to face the camera by the vertex shader
+	if (aMeshNode.isDrawingShaderAlignedBillboards)
+		return [self billboardCloudProgram: shouldAlphaTest withTexture: (texCnt > 0)];
+	
 	// Material without texture
 	if (texCnt == 0) return [self noTextureProgram: shouldAlphaTest];
 	
@@ -121,6 +125,15 @@
 											   : @"CC3PointSprites.fsh")];
 }
 
+-(CC3GLProgram*) billboardCloudProgram: (BOOL) shouldAlphaTest withTexture: (BOOL) hasTexture {
+	NSString* fshFilename;
+	if (hasTexture)
+		fshFilename = shouldAlphaTest ? @"CC3SingleTextureWithAlphaTest.fsh" : @"CC3SingleTexture.fsh";
+	else
+		fshFilename = shouldAlphaTest ? @"CC3NoTextureWithAlphaTest.fsh" : @"CC3NoTexture.fsh";
+	return [self programFromVertexShaderFile: @"CC3BillboardCloud.vsh" andFragmentShaderFile: fshFilename];
+}
+
 -(CC3GLProgram*) bumpMapObjectSpaceProgram: (BOOL) shouldAlphaTest {
 	return [self programFromVertexShaderFile: @"CC3BumpMapObjectSpace.vsh"
 					   andFragmentShaderFile: (shouldAlphaTest
@@ -259,6 +259,23 @@ NSString* NSStringFromCC3Semantic(CC3Semantic semantic) {
 			
 			return kCC3GLSLVariableScopeDraw;
 
+		case kCC3SemanticLightIsEnabled:
+		case kCC3SemanticLightPositionGlobal:
+		case kCC3SemanticLightPositionEyeSpace:
+		case kCC3SemanticLightInvertedPositionGlobal:
+		case kCC3SemanticLightInvertedPositionEyeSpace:
+		case kCC3SemanticLightColorAmbient:
+		case kCC3SemanticLightColorDiffuse:
+		case kCC3SemanticLightColorSpecular:
+		case kCC3SemanticLightAttenuation:
+		case kCC3SemanticLightSpotDirectionGlobal:
+		case kCC3SemanticLightSpotDirectionEyeSpace:
+		case kCC3SemanticLightSpotExponent:
+		case kCC3SemanticLightSpotCutoffAngle:
+		case kCC3SemanticLightSpotCutoffAngleCosine:
+
+			return kCC3GLSLVariableScopeLight;
+
 		case kCC3SemanticViewMatrix:
 		case kCC3SemanticViewMatrixInv:
 		case kCC3SemanticViewMatrixInvTran:
@@ -276,21 +293,6 @@ NSString* NSStringFromCC3Semantic(CC3Semantic semantic) {
 		case kCC3SemanticIsUsingLighting:
 		case kCC3SemanticSceneLightColorAmbient:
 
-		case kCC3SemanticLightIsEnabled:
-		case kCC3SemanticLightPositionGlobal:
-		case kCC3SemanticLightPositionEyeSpace:
-		case kCC3SemanticLightInvertedPositionGlobal:
-		case kCC3SemanticLightInvertedPositionEyeSpace:
-		case kCC3SemanticLightColorAmbient:
-		case kCC3SemanticLightColorDiffuse:
-		case kCC3SemanticLightColorSpecular:
-		case kCC3SemanticLightAttenuation:
-		case kCC3SemanticLightSpotDirectionGlobal:
-		case kCC3SemanticLightSpotDirectionEyeSpace:
-		case kCC3SemanticLightSpotExponent:
-		case kCC3SemanticLightSpotCutoffAngle:
-		case kCC3SemanticLightSpotCutoffAngleCosine:
-
 		case kCC3SemanticFogIsEnabled:
 		case kCC3SemanticFogColor:
 		case kCC3SemanticFogAttenuationMode:
@@ -311,6 +313,56 @@ NSString* NSStringFromCC3Semantic(CC3Semantic semantic) {
 	}
 }
 
+/**
+ * Returns the environmental matrices from which the value of a uniform with the specified
+ * semantic is derived exclusively, or zero if the value is derived from any other content.
+ *
+ * Uniforms whose value depends only on these matrices are not repopulated if none of the
+ * matrices has changed since the uniform was last populated.
+ *
+ * Subclasses that override the populateUniform:withVisitor: method to derive the value of any
+ * of these semantics from other content should override this method to return zero for those
+ * semantics.
+ */
+-(CC3GLSLMatrixDependencies) matrixDependenciesForSemantic: (GLenum) semantic {
+	switch (semantic) {
+		case kCC3SemanticModelMatrix:
+		case kCC3SemanticModelMatrixInv:
+		case kCC3SemanticModelMatrixInvTran:
+			return kCC3GLSLMatrixDependencyModel;
+
+		case kCC3SemanticViewMatrix:
+		case kCC3SemanticViewMatrixInv:
+		case kCC3SemanticViewMatrixInvTran:
+			return kCC3GLSLMatrixDependencyView;
+
+		case kCC3SemanticProjMatrix:
+		case kCC3SemanticProjMatrixInv:
+		case kCC3SemanticProjMatrixInvTran:
+			return kCC3GLSLMatrixDependencyProj;
+
+		case kCC3SemanticModelViewMatrix:
+		case kCC3SemanticModelViewMatrixInv:
+		case kCC3SemanticModelViewMatrixInvTran:
+			return kCC3GLSLMatrixDependencyModel | kCC3GLSLMatrixDependencyView;
+
+		case kCC3SemanticViewProjMatrix:
+		case kCC3SemanticViewProjMatrixInv:
+		case kCC3SemanticViewProjMatrixInvTran:
+			return kCC3GLSLMatrixDependencyView | kCC3GLSLMatrixDependencyProj;
+
+		case kCC3SemanticModelViewProjMatrix:
+		case kCC3SemanticModelViewProjMatrixInv:
+		case kCC3SemanticModelViewProjMatrixInvTran:
+			return (kCC3GLSLMatrixDependencyModel |
+					kCC3GLSLMatrixDependencyView |
+					kCC3GLSLMatrixDependencyProj);
+
+		default:
+			return 0;
+	}
+}
+
 /**
  * For semantics that may have more than one target, such as components of lights, or textures,
  * the iteration loops in this method are designed to deal with two situations:
@@ -502,8 +554,7 @@ NSString* NSStringFromCC3Semantic(CC3Semantic semantic) {
 			CC3Assert(boneCnt <= uniformSize, @"%@ in %@ supports %i bones, which is not enough for %@.",
 					  uniform, uniform.program, uniformSize, skin);
 			for (GLuint boneIdx = 0; boneIdx < boneCnt; boneIdx++) {
-				CC3Matrix* boneMtx = [skin getDrawTransformMatrixForBoneAt: boneIdx];
-				[boneMtx populateCC3Matrix4x3: &m4x3];
+				[skin populateDrawTransformMatrix: &m4x3 forBoneAt: boneIdx withVisitor: visitor];
 				CC3Matrix4x3Multiply(&mRslt4x3, pm4x3, &m4x3);
 				[uniform setMatrix4x3: &mRslt4x3 at: boneIdx];
 			}
@@ -515,8 +566,7 @@ NSString* NSStringFromCC3Semantic(CC3Semantic semantic) {
 			CC3Assert(boneCnt <= uniformSize, @"%@ in %@ supports %i bones, which is not enough for %@.",
 					  uniform, uniform.program, uniformSize, skin);
 			for (GLuint boneIdx = 0; boneIdx < boneCnt; boneIdx++) {
-				CC3Matrix* boneMtx = [skin getDrawTransformMatrixForBoneAt: boneIdx];
-				[boneMtx populateCC3Matrix4x3: &m4x3];
+				[skin populateDrawTransformMatrix: &m4x3 forBoneAt: boneIdx withVisitor: visitor];
 				CC3Matrix4x3Multiply(&mRslt4x3, pm4x3, &m4x3);
 				// Now take inverse-transpose
 				CC3Matrix3x3PopulateFrom4x3(&m3x3, &mRslt4x3);
@@ -531,8 +581,7 @@ NSString* NSStringFromCC3Semantic(CC3Semantic semantic) {
 			CC3Assert(boneCnt <= uniformSize, @"%@ in %@ supports %i bones, which is not enough for %@.",
 					  uniform, uniform.program, uniformSize, skin);
 			for (GLuint boneIdx = 0; boneIdx < boneCnt; boneIdx++) {
-				CC3Matrix* boneMtx = [skin getDrawTransformMatrixForBoneAt: boneIdx];
-				[boneMtx populateCC3Matrix4x3: &m4x3];
+				[skin populateDrawTransformMatrix: &m4x3 forBoneAt: boneIdx withVisitor: visitor];
 				CC3Matrix4x3Multiply(&mRslt4x3, pm4x3, &m4x3);
 				[uniform setMatrix4x3: &mRslt4x3 at: boneIdx];
 				[visitor.camera.viewMatrix populateCC3Matrix4x3: &m4x3];
@@ -546,8 +595,7 @@ NSString* NSStringFromCC3Semantic(CC3Semantic semantic) {
 			CC3Assert(boneCnt <= uniformSize, @"%@ in %@ supports %i bones, which is not enough for %@.",
 					  uniform, uniform.program, uniformSize, skin);
 			for (GLuint boneIdx = 0; boneIdx < boneCnt; boneIdx++) {
-				CC3Matrix* boneMtx = [skin getDrawTransformMatrixForBoneAt: boneIdx];
-				[boneMtx populateCC3Matrix4x3: &m4x3];
+				[skin populateDrawTransformMatrix: &m4x3 forBoneAt: boneIdx withVisitor: visitor];
 				CC3Matrix4x3Multiply(&mRslt4x3, pm4x3, &m4x3);
 				// Now take inverse-transpose
 				CC3Matrix3x3PopulateFrom4x3(&m3x3, &mRslt4x3);
@@ -561,8 +609,7 @@ NSString* NSStringFromCC3Semantic(CC3Semantic semantic) {
 			CC3Assert(boneCnt <= uniformSize, @"%@ in %@ supports %i bones, which is not enough for %@.",
 					  uniform, uniform.program, uniformSize, skin);
 			for (GLuint boneIdx = 0; boneIdx < boneCnt; boneIdx++) {
-				CC3Matrix* boneMtx = [skin getDrawTransformMatrixForBoneAt: boneIdx];
-				[boneMtx populateCC3Matrix4x3: &m4x3];
+				[skin populateDrawTransformMatrix: &m4x3 forBoneAt: boneIdx withVisitor: visitor];
 				[uniform setMatrix4x3: &m4x3 at: boneIdx];
 			}
 			return YES;
@@ -572,8 +619,8 @@ NSString* NSStringFromCC3Semantic(CC3Semantic semantic) {
 			CC3Assert(boneCnt <= uniformSize, @"%@ in %@ supports %i bones, which is not enough for %@.",
 					  uniform, uniform.program, uniformSize, skin);
 			for (GLuint boneIdx = 0; boneIdx < boneCnt; boneIdx++) {
-				CC3Matrix* boneMtx = [skin getDrawTransformMatrixForBoneAt: boneIdx];
-				[boneMtx populateCC3Matrix3x3: &m3x3];
+				[skin populateDrawTransformMatrix: &m4x3 forBoneAt: boneIdx withVisitor: visitor];
+				CC3Matrix3x3PopulateFrom4x3(&m3x3, &m4x3);
 				// Now take inverse-transpose
 				CC3Matrix3x3InvertAdjointTranspose(&m3x3);
 				[uniform setMatrix3x3: &m3x3 at: boneIdx];
@@ -1036,6 +1083,7 @@ NSString* NSStringFromCC3Semantic(CC3Semantic semantic) {
 		variable.semantic = varConfig.semantic;
 		variable.semanticIndex = varConfig.semanticIndex;
 		variable.scope = [self variableScopeForSemantic: varConfig.semantic];
+		variable.matrixDependencies = [self matrixDependenciesForSemantic: varConfig.semantic];
 		return YES;
 	}
 	return NO;
@@ -46,17 +46,35 @@
  * Most GLSL variables need to be populated anew as each node is drawn. But some variables, such
  * as lighting or camera content only needs to be populated once each time the scene is drawn,
  * and some other variables, such as bone matrices, need to be populated on each draw call.
+ *
+ * Variables that describe the lights are populated once each time the scene is drawn, unless
+ * the scene selects the lights that illuminate each node individually, in which case they are
+ * populated whenever the lights selected for the node being drawn differ from those populated.
  */
 typedef enum {
 	kCC3GLSLVariableScopeUnknown = 0,	/**< The scope of the variable is unknown. */
 	kCC3GLSLVariableScopeScene,			/**< The scope of the variable is the entire scene. */
 	kCC3GLSLVariableScopeNode,			/**< The scope of the variable is the current node. */
 	kCC3GLSLVariableScopeDraw,			/**< The scope of the variable is the current draw call. */
+	kCC3GLSLVariableScopeLight,			/**< The scope of the variable is the set of lights illuminating the current node. */
 } CC3GLSLVariableScope;
 
 /** Returns a string representation of the specified GLSL variable scope. */
 NSString* NSStringFromCC3GLSLVariableScope(CC3GLSLVariableScope scope);
 
+/**
+ * Bit flags indicating the environmental matrices from which the value of a GLSL variable
+ * is derived, and from which the value is derived exclusively.
+ */
+typedef enum {
+	kCC3GLSLMatrixDependencyModel = 1 << 0,		/**< The value is derived from the model matrix. */
+	kCC3GLSLMatrixDependencyView = 1 << 1,		/**< The value is derived from the view matrix. */
+	kCC3GLSLMatrixDependencyProj = 1 << 2,		/**< The value is derived from the projection matrix. */
+} CC3GLSLMatrixDependencyBits;
+
+/** A combination of CC3GLSLMatrixDependencyBits flags. */
+typedef GLubyte CC3GLSLMatrixDependencies;
+
 
 #pragma mark -
 #pragma mark CC3GLSLVariable
@@ -78,6 +96,7 @@ NSString* NSStringFromCC3GLSLVariableScope(CC3GLSLVariableScope scope);
 	CC3GLSLVariableScope _scope : 4;
 	GLint _size : 8;
 	GLuint _semanticIndex : 8;
+	CC3GLSLMatrixDependencies _matrixDependencies;
 }
 
 /** The GL program object containing this variable. */
@@ -165,6 +184,20 @@ NSString* NSStringFromCC3GLSLVariableScope(CC3GLSLVariableScope scope);
  */
 @property(nonatomic, assign) CC3GLSLVariableScope scope;
 
+/**
+ * Indicates the environmental matrices from which the value of this variable is derived,
+ * if the value is derived exclusively from one or more of the model, view and projection
+ * matrices of the drawing visitor.
+ *
+ * When this property is not zero, and none of the indicated matrices has changed since the
+ * variable was last populated, the variable does not need to be populated again. This avoids
+ * recalculating values, such as inverse-transpose matrices, that have not changed.
+ *
+ * The initial value of this property is zero, indicating that the variable must always be
+ * populated when its scope requires it.
+ */
+@property(nonatomic, assign) CC3GLSLMatrixDependencies matrixDependencies;
+
 
 #pragma mark Allocation and initialization
 
@@ -252,6 +285,9 @@ NSString* NSStringFromCC3GLSLVariableScope(CC3GLSLVariableScope scope);
 @interface CC3GLSLUniform : CC3GLSLVariable {
 	size_t _varLen;
 	GLvoid* _varValue;
+	GLuint _modelMatrixVersion;
+	GLuint _viewMatrixVersion;
+	GLuint _projMatrixVersion;
 }
 
 /**
@@ -728,6 +764,41 @@ NSString* NSStringFromCC3GLSLVariableScope(CC3GLSLVariableScope scope);
  */
 -(BOOL) updateGLValue;
 
+
+#pragma mark Matrix versions
+
+/**
+ * Returns whether the value of this uniform is current for the specified versions of the model,
+ * view, and projection matrices, as tracked by the versions properties of a CC3NodeDrawingVisitor.
+ *
+ * Returns YES only if the matrixDependencies property is not zero, and each of the matrices
+ * indicated by that property has the same version as when this uniform was last populated.
+ * Versions of zero are considered unknown, and always result in this method returning NO.
+ */
+-(BOOL) isCurrentForModelMatrixVersion: (GLuint) modelVersion
+					 viewMatrixVersion: (GLuint) viewVersion
+					 projMatrixVersion: (GLuint) projVersion;
+
+/**
+ * Records the versions of the model, view, and projection matrices from which the value
+ * of this uniform was most recently populated.
+ *
+ * This method is invoked automatically during uniform population.
+ * The application normally never needs to invoke this method.
+ */
+-(void) setModelMatrixVersion: (GLuint) modelVersion
+			viewMatrixVersion: (GLuint) viewVersion
+			projMatrixVersion: (GLuint) projVersion;
+
+/**
+ * Marks the value of this uniform as not having been populated from known versions of the
+ * environmental matrices, so that it will be populated again the next time it is required.
+ *
+ * This method is invoked automatically when the value of this uniform is set from an override.
+ * The application normally never needs to invoke this method.
+ */
+-(void) markMatrixVersionsUnknown;
+
 @end
 
 
@@ -749,7 +820,18 @@ NSString* NSStringFromCC3GLSLVariableScope(CC3GLSLVariableScope scope);
  */
 @interface CC3OpenGLESStateTrackerGLSLUniform : CC3GLSLUniform {
 	GLvoid* _glVarValue;
+	BOOL _glValueIsKnown : 1;
 }
 
+/**
+ * Marks the value of this uniform in the GL engine as unknown, so that the next value
+ * set in this uniform is submitted to the GL engine, even if it has not changed.
+ *
+ * This method is invoked automatically by the CC3OpenGLESEngine on each uniform whose
+ * value was changed while the shouldSubmitToGL property of the engine was set to NO,
+ * once that property is set back to YES. The application should not invoke this method directly.
+ */
+-(void) markValueUnknown;
+
 @end
 
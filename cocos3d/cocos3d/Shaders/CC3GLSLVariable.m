@@ -32,6 +32,7 @@
 #import "CC3GLSLVariable.h"
 #import "CC3GLProgram.h"
 #import "CC3OpenGLESVertexArrays.h"
+#import "CC3OpenGLESEngine.h"
 
 
 NSString* NSStringFromCC3GLSLVariableScope(CC3GLSLVariableScope scope) {
@@ -40,6 +41,7 @@ NSString* NSStringFromCC3GLSLVariableScope(CC3GLSLVariableScope scope) {
 		case kCC3GLSLVariableScopeScene: return @"kCC3GLSLVariableScopeScene";
 		case kCC3GLSLVariableScopeNode: return @"kCC3GLSLVariableScopeNode";
 		case kCC3GLSLVariableScopeDraw: return @"kCC3GLSLVariableScopeDraw";
+		case kCC3GLSLVariableScopeLight: return @"kCC3GLSLVariableScopeLight";
 			
 		default: return [NSString stringWithFormat: @"Unknown variable scope (%u)", scope];
 	}
@@ -53,6 +55,7 @@ NSString* NSStringFromCC3GLSLVariableScope(CC3GLSLVariableScope scope) {
 
 @synthesize program=_program, index=_index, location=_location, name=_name;
 @synthesize type=_type, size=_size, semantic=_semantic, semanticIndex=_semanticIndex, scope=_scope;
+@synthesize matrixDependencies=_matrixDependencies;
 
 -(void) dealloc {
 	_program = nil;			// not retained
@@ -69,6 +72,7 @@ NSString* NSStringFromCC3GLSLVariableScope(CC3GLSLVariableScope scope) {
 		_semantic = kCC3SemanticNone;
 		_semanticIndex = 0;
 		_scope = kCC3GLSLVariableScopeUnknown;
+		_matrixDependencies = 0;
 		_program = program;			// not retained
 		[self populateFromProgram];
 	}
@@ -100,6 +104,7 @@ NSString* NSStringFromCC3GLSLVariableScope(CC3GLSLVariableScope scope) {
 	_semantic = another.semantic;
 	_semanticIndex = another.semanticIndex;
 	_scope = another.scope;
+	_matrixDependencies = another.matrixDependencies;
 }
 
 -(void) populateFromProgram {}
@@ -164,6 +169,9 @@ NSString* NSStringFromCC3GLSLVariableScope(CC3GLSLVariableScope scope) {
 	// Initialized before populateFromProgram is invoked in parent initializer.
 	_varLen = 0;
 	_varValue = NULL;
+	_modelMatrixVersion = 0;
+	_viewMatrixVersion = 0;
+	_projMatrixVersion = 0;
 	return [super initInProgram: program atIndex: index];
 }
 
@@ -456,6 +464,32 @@ NSString* NSStringFromCC3GLSLVariableScope(CC3GLSLVariableScope scope) {
 
 -(BOOL) updateGLValue { return NO; }
 
+
+#pragma mark Matrix versions
+
+-(BOOL) isCurrentForModelMatrixVersion: (GLuint) modelVersion
+					 viewMatrixVersion: (GLuint) viewVersion
+					 projMatrixVersion: (GLuint) projVersion {
+	if ( !_matrixDependencies ) return NO;
+	if ((_matrixDependencies & kCC3GLSLMatrixDependencyModel) &&
+		(modelVersion == 0 || modelVersion != _modelMatrixVersion)) return NO;
+	if ((_matrixDependencies & kCC3GLSLMatrixDependencyView) &&
+		(viewVersion == 0 || viewVersion != _viewMatrixVersion)) return NO;
+	if ((_matrixDependencies & kCC3GLSLMatrixDependencyProj) &&
+		(projVersion == 0 || projVersion != _projMatrixVersion)) return NO;
+	return YES;
+}
+
+-(void) setModelMatrixVersion: (GLuint) modelVersion
+			viewMatrixVersion: (GLuint) viewVersion
+			projMatrixVersion: (GLuint) projVersion {
+	_modelMatrixVersion = modelVersion;
+	_viewMatrixVersion = viewVersion;
+	_projMatrixVersion = projVersion;
+}
+
+-(void) markMatrixVersionsUnknown { [self setModelMatrixVersion: 0 viewMatrixVersion: 0 projMatrixVersion: 0]; }
+
 @end
 
 
@@ -501,6 +535,7 @@ NSString* NSStringFromCC3GLSLVariableScope(CC3GLSLVariableScope scope) {
 	[super populateFrom: another];
 	free(_glVarValue);
 	_glVarValue = calloc(_varLen, 1);
+	_glValueIsKnown = NO;
 }
 
 
@@ -521,6 +556,7 @@ NSString* NSStringFromCC3GLSLVariableScope(CC3GLSLVariableScope scope) {
 	_varValue = calloc(_varLen, 1);
 	free(_glVarValue);
 	_glVarValue = calloc(_varLen, 1);
+	_glValueIsKnown = NO;
 	
 	_location = glGetUniformLocation(_program.programID, cName);
 	LogGLErrorTrace(@"while retrieving location of active uniform named %s at index %i in %@", cName, _index, self);
@@ -533,14 +569,22 @@ NSString* NSStringFromCC3GLSLVariableScope(CC3GLSLVariableScope scope) {
 
 /** Overridden to update the GL state engine if the value was changed. */
 -(BOOL) updateGLValue {
-	if (memcmp(_glVarValue, _varValue, _varLen) != 0) {
+	if ( !_glValueIsKnown || memcmp(_glVarValue, _varValue, _varLen) != 0 ) {
 		memcpy(_glVarValue, _varValue, _varLen);
-		[self setGLValue];
+		_glValueIsKnown = YES;
+		CC3OpenGLESEngine* glesEngine = [CC3OpenGLESEngine engine];
+		[glesEngine.commandBuffer recordUniformChangeFor: self atLocation: _location ofType: _type andSize: _size];
+		if (glesEngine.shouldSubmitToGL)
+			[self setGLValue];
+		else
+			[glesEngine notifyUnsubmittedChangeBy: self];
 		return YES;
 	}
 	return NO;
 }
 
+-(void) markValueUnknown { _glValueIsKnown = NO; }
+
 -(void) setGLValue {
 	switch (_type) {
 			
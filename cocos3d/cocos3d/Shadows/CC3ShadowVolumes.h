@@ -37,6 +37,18 @@
 /** The suggested default shadow volume vertex offset factor. */
 static const GLfloat kCC3DefaultShadowVolumeVertexOffsetFactor = 0.001;
 
+/**
+ * An edge of the mesh of a shadow-casting node, identifying the faces on each side of the edge.
+ *
+ * Each edge in the mesh is represented once, by the face with the lower face index. The
+ * neighbour element holds kCC3FaceNoNeighbour if there is no face on the other side of the edge.
+ */
+typedef struct {
+	GLuint face;			/**< The index of the face on one side of the edge. */
+	GLuint neighbour;		/**< The index of the face on the other side of the edge. */
+	GLuint edgeIndex;		/**< The index of the edge (0, 1 or 2) within the face. */
+} CC3ShadowCasterEdge;
+
 
 #pragma mark -
 #pragma mark CC3ShadowVolumeMeshNode
@@ -80,6 +92,22 @@ static const GLfloat kCC3DefaultShadowVolumeVertexOffsetFactor = 0.001;
 	BOOL shouldShadowBackFaces : 1;
 	BOOL useDepthFailAlgorithm : 1;
 	BOOL shouldAddEndCapsOnlyWhenNeeded : 1;
+	CC3ShadowCasterEdge* casterEdges;
+	GLuint casterEdgeCount;
+	GLuint casterFaceCount;
+	CC3Vector4* casterFaceVertices;
+	CC3Plane* casterFacePlanes;
+	GLubyte* casterFaceLitFlags;
+	GLuint* terminatorEdges;
+	GLuint terminatorEdgeCount;
+	GLuint shadowVertexCount;
+	CC3Vector4 localLightPosition;
+	CC3Vector4 shadowVertexNudge;
+	NSTimeInterval shadowUpdateDuration;
+	BOOL areCasterFacesDirty : 1;
+	BOOL isTerminatorDirty : 1;
+	BOOL isShadowBuildPending : 1;
+	BOOL wasShadowMeshExpanded : 1;
 }
 
 /**
@@ -104,6 +132,61 @@ static const GLfloat kCC3DefaultShadowVolumeVertexOffsetFactor = 0.001;
  */
 -(void) drawToStencilWithVisitor: (CC3NodeDrawingVisitor*) visitor;
 
+/**
+ * Marks the cached copy of the faces of the shadow-casting node as dirty, so that they
+ * will be retrieved from the shadow-casting node the next time this shadow is rebuilt.
+ *
+ * To avoid retrieving the faces of the shadow caster every time the light or shadow caster
+ * moves, this shadow volume caches the local face vertices and face planes of a shadow-casting
+ * node whose mesh is not deformed by vertex skinning. If the application changes the vertex
+ * locations of the mesh of such a shadow-casting node, it should invoke this method to ensure
+ * that this shadow volume is rebuilt from the new vertex locations.
+ *
+ * The faces of shadow-casting nodes that contain soft-body content, such as skinned mesh
+ * nodes, are always retrieved each time the shadow is rebuilt.
+ */
+-(void) markShadowCasterFacesDirty;
+
+/**
+ * Indicates the time, in seconds, spent rebuilding this shadow volume during the most
+ * recent invocation of the updateShadow method.
+ *
+ * The value of this property will be zero if this shadow volume was not rebuilt during the
+ * most recent update, either because neither the light nor the shadow-casting node moved,
+ * or because the shadowLagCount property has not yet counted down to zero.
+ *
+ * The shadowUpdateDuration property of the CC3Node ShadowVolumes category can be used to
+ * total this property across all of the shadow volumes of a shadow-casting node.
+ */
+@property(nonatomic, readonly) NSTimeInterval shadowUpdateDuration;
+
+
+#pragma mark Concurrent updating
+
+/**
+ * Updates the shape and location of each shadow in the specified collection of objects
+ * that support the CC3ShadowProtocol, by constructing the meshes of any shadow volumes
+ * concurrently on background threads.
+ *
+ * Updating each CC3ShadowVolumeMeshNode is divided into three phases. The first phase
+ * determines which shadow volumes need to be rebuilt, retrieves the faces of the
+ * shadow-casting nodes, and extracts the terminator edges of each shadow caster. This
+ * phase is performed on the current thread, because it interacts with the scene. The
+ * second phase, in which the vertices of each shadow volume mesh are generated from
+ * the extracted terminator edges, depends only on data held by each shadow volume, and
+ * is dispatched concurrently across the available processor cores. The third phase,
+ * which updates the GL buffers of each shadow volume mesh, is performed on the current
+ * thread once all of the shadow volume meshes have been built.
+ *
+ * Any object in the specified collection that is not a CC3ShadowVolumeMeshNode is
+ * updated by invoking its updateShadow method on the current thread.
+ *
+ * This method is invoked automatically by the CC3Scene when the value of the
+ * shouldUpdateShadowsConcurrently property of the scene is set to YES. Usually,
+ * the application never needs to invoke this method directly.
+ */
++(void) updateShadowsConcurrently: (CCArray*) shadows;
+
 @end
 
 
@@ -638,6 +721,17 @@ static const GLfloat kCC3DefaultShadowVolumeVertexOffsetFactor = 0.001;
  */
 @property(nonatomic, assign) BOOL shouldShadowBackFaces;
 
+/**
+ * Returns the total time, in seconds, spent rebuilding the shadow volumes of this node
+ * and its descendants during the most recent update.
+ *
+ * This is the sum of the shadowUpdateDuration property of all descendant shadow volume
+ * nodes. When invoked on a shadow-casting mesh node, this property indicates the time spent
+ * rebuilding the shadows of that shadow caster, for all lights. When invoked on the CC3Scene,
+ * this property indicates the time spent rebuilding all shadow volumes in the scene.
+ */
+@property(nonatomic, readonly) NSTimeInterval shadowUpdateDuration;
+
 @end
 
 
@@ -56,40 +56,32 @@
 @interface CC3ShadowVolumeMeshNode (TemplateMethods)
 -(void) createShadowMesh;
 -(void) checkShadowMaterial;
--(void) populateShadowMesh;
+-(BOOL) prepareShadowUpdate;
+-(BOOL) prepareShadowMesh;
+-(void) buildShadowMesh;
+-(void) finishShadowUpdate;
+-(void) populateShadowCasterFaces;
+-(void) populateShadowCasterEdges;
+-(void) populateTerminatorEdges;
+-(void) deallocateShadowCasterCaches;
 -(void) updateStencilAlgorithm;
 -(CC3Vector4) shadowVolumeVertexOffsetForLightAt: (CC3Vector4) localLightPos;
--(BOOL) addShadowVolumeCapFor: (BOOL) isFaceLit
-						 face: (CC3Vector4*) vertices
-				   forLightAt: (CC3Vector4) lightPosition
-			  startingAtIndex: (GLuint*) shdwVtxIdx;
--(BOOL) addTerminatorLineFrom: (CC3Vector4) edgeStartLoc
-						   to: (CC3Vector4) edgeEndLoc
-			  startingAtIndex: (GLuint*) shdwVtxIdx;
--(BOOL) addShadowVolumeSideFrom: (CC3Vector4) edgeStartLoc
-							 to: (CC3Vector4) edgeEndLoc
-		  forDirectionalLightAt: (CC3Vector4) lightPosition
-				startingAtIndex: (GLuint*) shdwVtxIdx;
--(BOOL) addShadowVolumeSideFrom: (CC3Vector4) edgeStartLoc
-							 to: (CC3Vector4) edgeEndLoc
-						withCap: (BOOL) doesRequireCapping
-		   forLocationalLightAt: (CC3Vector4) lightPosition
-				startingAtIndex: (GLuint*) shdwVtxIdx;
--(CC3Vector4) expand: (CC3Vector4) edgeLoc awayFromLocationalLightAt: (CC3Vector4) lightLoc;
 -(void) drawToStencilIncrementing: (BOOL) isIncrementing
 					  withVisitor: (CC3NodeDrawingVisitor*) visitor;
 @property(nonatomic, readonly) CC3MeshNode* shadowCaster;
 @property(nonatomic, readonly) BOOL isReadyToUpdate;
+@property(nonatomic, readonly) BOOL doesRequireCapping;
 @end
 
 
 @implementation CC3ShadowVolumeMeshNode
 
-@synthesize light, shouldDrawTerminator;
+@synthesize light, shouldDrawTerminator, shadowUpdateDuration;
 
 -(void) dealloc {
 	[light removeShadow: self];		// Will also set light to nil
 	LogTrace(@"Removed %@ from %@ leaving %i shadows", self, light, light.shadows.count);
+	[self deallocateShadowCasterCaches];
 	[super dealloc];
 }
 
@@ -136,6 +128,7 @@
 -(BOOL) shouldShadowFrontFaces { return shouldShadowFrontFaces; }
 
 -(void) setShouldShadowFrontFaces: (BOOL) shouldShadow {
+	if (shouldShadow != shouldShadowFrontFaces) isTerminatorDirty = YES;
 	shouldShadowFrontFaces = shouldShadow;
 	super.shouldShadowFrontFaces = shouldShadow;
 }
@@ -143,6 +136,7 @@
 -(BOOL) shouldShadowBackFaces { return shouldShadowBackFaces; }
 
 -(void) setShouldShadowBackFaces: (BOOL) shouldShadow {
+	if (shouldShadow != shouldShadowBackFaces) isTerminatorDirty = YES;
 	shouldShadowBackFaces = shouldShadow;
 	super.shouldShadowBackFaces = shouldShadow;
 }
@@ -210,6 +204,22 @@
 		shadowVolumeVertexOffsetFactor = 0;
 		shadowExpansionLimitFactor = 100;
 		self.pureColor = kCCC4FYellow;		// For terminator lines
+		casterEdges = NULL;
+		casterEdgeCount = 0;
+		casterFaceCount = 0;
+		casterFaceVertices = NULL;
+		casterFacePlanes = NULL;
+		casterFaceLitFlags = NULL;
+		terminatorEdges = NULL;
+		terminatorEdgeCount = 0;
+		shadowVertexCount = 0;
+		localLightPosition = kCC3Vector4Zero;
+		shadowVertexNudge = kCC3Vector4Zero;
+		shadowUpdateDuration = 0.0;
+		areCasterFacesDirty = YES;
+		isTerminatorDirty = YES;
+		isShadowBuildPending = NO;
+		wasShadowMeshExpanded = NO;
 	}
 	return self;
 }
@@ -234,6 +244,10 @@
 	shadowLagCount = another.shadowLagCount;
 	shadowVolumeVertexOffsetFactor = another.shadowVolumeVertexOffsetFactor;
 	shadowExpansionLimitFactor = another.shadowExpansionLimitFactor;
+	
+	// The caches of the faces and edges of the shadow caster are not copied,
+	// since the copy will be attached to a different shadow caster.
+	[self deallocateShadowCasterCaches];
 }
 
 /**
@@ -258,6 +272,7 @@
 }
 
 -(void) createShadowMesh {
+	[self deallocateShadowCasterCaches];
 	GLuint vertexCount = self.shadowCaster.vertexCount;
 	
 	// Create vertexLocation array.
@@ -307,361 +322,388 @@
 	return CC3Vector4FromDirection(offset);
 }
 
+-(BOOL) doesRequireCapping { return useDepthFailAlgorithm || !shouldAddEndCapsOnlyWhenNeeded; }
+
+-(void) markShadowCasterFacesDirty {
+	areCasterFacesDirty = YES;
+	isShadowDirty = YES;
+}
+
+
+#pragma mark Shadow caster faces and edges
+
+/** Releases the cached faces and edges of the shadow caster. They will be rebuilt when next needed. */
+-(void) deallocateShadowCasterCaches {
+	free(casterEdges);
+	casterEdges = NULL;
+	casterEdgeCount = 0;
+	
+	free(casterFaceVertices);
+	casterFaceVertices = NULL;
+	free(casterFacePlanes);
+	casterFacePlanes = NULL;
+	free(casterFaceLitFlags);
+	casterFaceLitFlags = NULL;
+	casterFaceCount = 0;
+	
+	free(terminatorEdges);
+	terminatorEdges = NULL;
+	terminatorEdgeCount = 0;
+	
+	areCasterFacesDirty = YES;
+	isTerminatorDirty = YES;
+}
+
 /**
- * Populates the shadow volume mesh by iterating through all the faces in the mesh of
- * the shadow casting node, looking for all pairs of neighbouring faces where one face
- * is in illuminated (facing towards the light) and the other is dark (facing away from
- * the light). The set of edges between these pairs forms the terminator of the mesh,
- * where the mesh on one side of the terminator is illuminated and the other is dark.
+ * Retrieves the vertices and planes of the faces of the shadow caster, in the local coordinate
+ * system of the shadow caster, and caches them in flat arrays that can be traversed quickly.
  *
- * The shadow volume is then constructed by extruding each edge line segment in the
- * terminator out to infinity in the direction away from the light source, forming a
- * tube of infinite length.
+ * If the number of faces in the shadow caster has changed, the caches are reallocated,
+ * and the edges of the shadow caster are rebuilt from the face neighbour information.
  *
- * Uses the 4D homogeneous location of the light in the global coordinate system.
- * When using the light location this method transforms this location to the local
- * coordinates system of the shadow caster.
+ * The local faces of a rigid shadow caster do not change when the shadow caster or light moves,
+ * and are only retrieved once. The faces of a shadow caster with soft-body content, such as a
+ * skinned mesh, are deformed by the bones, and are retrieved each time the shadow is rebuilt.
  */
--(void) populateShadowMesh {
-	
+-(void) populateShadowCasterFaces {
 	CC3MeshNode* scNode = self.shadowCaster;
 	GLuint faceCnt = scNode.faceCount;
-	GLuint shdwVtxIdx = 0;
-	BOOL wasMeshExpanded = NO;
-	BOOL doesRequireCapping = useDepthFailAlgorithm || !shouldAddEndCapsOnlyWhenNeeded;
 	
-	// Transform the 4D position of the light into the local coordinates of the shadow caster.
-	CC3Vector4 lightPosition = light.globalHomogeneousPosition;
-	CC3Vector4 localLightPosition = [scNode.transformMatrixInverted
-									 transformHomogeneousVector: lightPosition];
-	
-	// Determine whether we want to nudge the shadow volume vertices away from the shadow caster
-	BOOL isNudgingVertices = (shadowVolumeVertexOffsetFactor != 0.0f);
-	CC3Vector4 svVtxNudge = isNudgingVertices
-								? [self shadowVolumeVertexOffsetForLightAt: localLightPosition]
-								: kCC3Vector4Zero;
-	
-	//	if (doesRequireCapping) LogDebug(@"Populating %@ with end caps", self);
+	if (faceCnt != casterFaceCount || !casterFaceVertices) {
+		[self deallocateShadowCasterCaches];
+		casterFaceCount = faceCnt;
+		casterFaceVertices = malloc(faceCnt * 3 * sizeof(CC3Vector4));
+		casterFacePlanes = malloc(faceCnt * sizeof(CC3Plane));
+		casterFaceLitFlags = calloc(faceCnt, sizeof(GLubyte));
+		[self populateShadowCasterEdges];
+	}
 	
-	//	if ( [scNode.name isEqualToString: @"GeoSphere01"] ) {
-	//		LogDebug(@"Populating %@ with %i faces for light at %@ and %@ end caps",
-	//					  self, faceCnt, NSStringFromCC3Vector4(lightPosition),
-	//					  (doesRequireCapping ? @"including" : @"excluding"));
-	//	}
+	if ( !(areCasterFacesDirty || scNode.hasSoftBodyContent) ) return;
 	
-	LogTrace(@"Populating %@ with %i faces for light at %@ and %@ end caps",
-				  self, faceCnt, NSStringFromCC3Vector4(lightPosition),
-				  (doesRequireCapping ? @"including" : @"excluding"));
+	for (GLuint faceIdx = 0; faceIdx < faceCnt; faceIdx++) {
+		CC3Face face = [scNode deformedFaceAt: faceIdx];
+		CC3Vector4* faceVertices = &casterFaceVertices[faceIdx * 3];
+		faceVertices[0] = CC3Vector4FromLocation(face.vertices[0]);
+		faceVertices[1] = CC3Vector4FromLocation(face.vertices[1]);
+		faceVertices[2] = CC3Vector4FromLocation(face.vertices[2]);
+		casterFacePlanes[faceIdx] = CC3FacePlane(face);
+	}
+	areCasterFacesDirty = NO;
+	LogTrace(@"%@ retrieved %u faces from %@", self, faceCnt, scNode);
+}
+
+/**
+ * Builds the list of edges of the shadow caster from the face neighbour information of the
+ * shadow caster mesh. Each edge shared by two faces is included only once, by the face with
+ * the lower index. Edges with no neighbouring face are also included.
+ */
+-(void) populateShadowCasterEdges {
+	CC3MeshNode* scNode = self.shadowCaster;
+	GLuint faceCnt = casterFaceCount;
 	
-	LogTrace(@"%@ global light location: %@ shadow local light: %@ %@ inverted: %@",
-				  self, NSStringFromCC3Vector4(lightPosition),
-				  NSStringFromCC3Vector4(localLightPosition),
-				  scNode.transformMatrix,
-				  scNode.transformMatrixInverted);
+	free(casterEdges);
+	casterEdges = malloc(faceCnt * 3 * sizeof(CC3ShadowCasterEdge));
+	casterEdgeCount = 0;
 	
-	// Iterate through all the faces in the mesh of the shadow caster.
 	for (GLuint faceIdx = 0; faceIdx < faceCnt; faceIdx++) {
-		
-		// Retrieve the current face, convert it to 4D homogeneous locations
-		CC3Face face = [scNode deformedFaceAt: faceIdx];
-		CC3Vector4 vertices4d[3];
-		vertices4d[0] = CC3Vector4FromLocation(face.vertices[0]);
-		vertices4d[1] = CC3Vector4FromLocation(face.vertices[1]);
-		vertices4d[2] = CC3Vector4FromLocation(face.vertices[2]);
-		
-		// If needed, nudge the shadow volume face away from the
-		// shadow caster face in the direction away from the light
-		if (isNudgingVertices) {
-			vertices4d[0] = CC3Vector4Add(vertices4d[0], svVtxNudge);
-			vertices4d[1] = CC3Vector4Add(vertices4d[1], svVtxNudge);
-			vertices4d[2] = CC3Vector4Add(vertices4d[2], svVtxNudge);
-		}
-		
-		// Determine whether the face is illuminated.
-		BOOL isFaceLit = CC3Vector4IsInFrontOfPlane(localLightPosition, [scNode deformedFacePlaneAt: faceIdx]);
-		
-		LogTrace(@"Face %i of %@ is %@. Indices: %@, Vertices: %@, plane: %@, neighbours: %@",
-					  faceIdx, scNode, (isFaceLit ? @"illuminated" : @"dark"),
-					  NSStringFromCC3FaceIndices([scNode faceIndicesAt: faceIdx]),
-					  NSStringFromCC3Face([scNode deformedFaceAt: faceIdx]),
-					  NSStringFromCC3Plane([scNode deformedFacePlaneAt: faceIdx]),
-					  NSStringFromCC3FaceNeighbours([scNode faceNeighboursAt: faceIdx]));
-		
-		// If we're drawing end-caps, and this face is part of an end-cap, draw it.
-		// It's part of an end-cap if it's a dark face and shadowing is based on front
-		// faces (typical), or it's a lit face and shadowing is (also) based on back faces
-		// (as with some open meshes).
-		if (doesRequireCapping && (isFaceLit ? shouldShadowBackFaces : shouldShadowFrontFaces) && !shouldDrawTerminator) {
-			LogTrace(@"%@ adding end cap for face %i", self, faceIdx);
-			wasMeshExpanded |= [self addShadowVolumeCapFor: isFaceLit
-													  face: vertices4d
-												forLightAt: localLightPosition
-										   startingAtIndex: &shdwVtxIdx];
-		}
-		
-		// Now check the neighbouring face on the other side of each edge of this face.
 		CC3FaceNeighbours neighbours = [scNode faceNeighboursAt: faceIdx];
-		for (int edgeIdx = 0; edgeIdx < 3; edgeIdx++) {
-			
-			// Get the index of the face on the other side of this edge
+		for (GLuint edgeIdx = 0; edgeIdx < 3; edgeIdx++) {
 			GLuint neighbourFaceIdx = neighbours.edges[edgeIdx];
-			
-			// Check if this edge is part of the terminator. It is if either:
-			//   - There is no neighbouring face on this edge, and either the face is lit
-			//     and front faces are being shadowed, or the face is dark and back faces
-			//     are being shadowed.
-			//   - The neighbour has the opposite illumination than the current face
-			//     (ie- lit/dark or dark/lit) AND we haven't encountered this edge before
-			//     during this iteration, (ie- don't double count). The double-count test
-			//     is accomplished by only accepting the neighbouring face if it has a
-			//     larger index than the current face.
-			BOOL isTerminatorEdge = NO;
-			if (neighbourFaceIdx == kCC3FaceNoNeighbour) {
-				isTerminatorEdge = isFaceLit ? shouldShadowFrontFaces : shouldShadowBackFaces;
-			} else if (neighbourFaceIdx > faceIdx) {		// Don't double count edges
-				BOOL isNeighbourFaceLit = CC3Vector4IsInFrontOfPlane(localLightPosition, [scNode deformedFacePlaneAt: neighbourFaceIdx]);
-				isTerminatorEdge = (isNeighbourFaceLit != isFaceLit);
-			}
-			
-			if (isTerminatorEdge) {
-				
-				// We've found a terminator edge!
-				LogTrace(@"\tNeighbouring face %u is %@. We have a terminator edge.",
-							  neighbourFaceIdx, ((neighbourFaceIdx == kCC3FaceNoNeighbour)
-												 ? @"missing" 
-												 : (isFaceLit ? @"dark" : @"illuminated")));
-				
-				// Get the end points of the terminator edge that we will be extruding.
-				// To have the normals of the shadow volume mesh point outwards, we want the
-				// winding of the extruded face to be the same as the dark face. So, choose
-				// the start and end of the edge based on which face of this pair is illuminated.
-				CC3Vector4 edgeStartLoc, edgeEndLoc;
-				if (isFaceLit) {
-					edgeStartLoc = vertices4d[edgeIdx];
-					edgeEndLoc = vertices4d[(edgeIdx < 2) ? (edgeIdx + 1) : 0];
-				} else {
-					edgeStartLoc = vertices4d[(edgeIdx < 2) ? (edgeIdx + 1) : 0];
-					edgeEndLoc = vertices4d[edgeIdx];
-				}
-				
-				if (self.shouldDrawTerminator && self.visible) {
-					// Draw the terminator line instead of a shadow
-					wasMeshExpanded |= [self addTerminatorLineFrom: edgeStartLoc
-																to: edgeEndLoc
-												   startingAtIndex: &shdwVtxIdx];
-				} else if (CC3Vector4IsDirectional(localLightPosition)) {
-					// Draw the shadow from a directional light
-					wasMeshExpanded |= [self addShadowVolumeSideFrom: edgeStartLoc
-																  to: edgeEndLoc
-											   forDirectionalLightAt: localLightPosition
-													 startingAtIndex: &shdwVtxIdx];
-				} else {
-					// Draw the shadow from a locational light, possibly closing off the far end
-					wasMeshExpanded |= [self addShadowVolumeSideFrom: edgeStartLoc
-																  to: edgeEndLoc
-															 withCap: doesRequireCapping
-												forLocationalLightAt: localLightPosition
-													 startingAtIndex: &shdwVtxIdx];
-				}
-			} else {
-				LogTrace(@"\tNeighbouring face %u is %@. Not a terminator edge.",
-							  neighbourFaceIdx, (isFaceLit ? @"illuminated" : @"dark"));
+			if (neighbourFaceIdx == kCC3FaceNoNeighbour || neighbourFaceIdx > faceIdx) {
+				CC3ShadowCasterEdge* edge = &casterEdges[casterEdgeCount++];
+				edge->face = faceIdx;
+				edge->neighbour = neighbourFaceIdx;
+				edge->edgeIndex = edgeIdx;
 			}
 		}
 	}
 	
-	// Update the vertex count of the shadow volume mesh, based on how many sides we've added.
-	mesh.vertexCount = shdwVtxIdx;
-	LogTrace(@"%@ setting vertex count to %u", self, shdwVtxIdx);
-	
-	// If the mesh is using GL VBO's, update them. If the mesh was expanded,
-	// recreate the VBO's, otherwise update them.
-	if (mesh.isUsingGLBuffers) {
-		if (wasMeshExpanded) {
-			[mesh deleteGLBuffers];
-			[mesh createGLBuffers];
+	free(terminatorEdges);
+	terminatorEdges = malloc(MAX(casterEdgeCount, 1) * sizeof(GLuint));
+	terminatorEdgeCount = 0;
+	isTerminatorDirty = YES;
+	LogTrace(@"%@ extracted %u edges from %u faces of %@", self, casterEdgeCount, faceCnt, scNode);
+}
+
+/**
+ * Classifies each face in the specified array of face planes as illuminated or dark, by testing
+ * which side of the face plane the specified homogeneous light position lies on, and records the
+ * result in the corresponding element of the litFlags array.
+ *
+ * Returns, through the litCount argument, the number of faces that are illuminated. The return
+ * value of this function indicates whether the illumination of any face has changed from the
+ * value that was previously held in the litFlags array.
+ *
+ * The loop body is deliberately kept free of function calls and branches, so that the compiler
+ * can vectorize it.
+ */
+static BOOL CC3ShadowClassifyFaces(const CC3Plane* planes, GLuint faceCount,
+								   CC3Vector4 lightPos, GLubyte* litFlags, GLuint* litCount) {
+	GLfloat lx = lightPos.x, ly = lightPos.y, lz = lightPos.z, lw = lightPos.w;
+	GLuint changeCount = 0;
+	GLuint lit = 0;
+	for (GLuint faceIdx = 0; faceIdx < faceCount; faceIdx++) {
+		const CC3Plane* p = &planes[faceIdx];
+		GLubyte isLit = ((p->a * lx) + (p->b * ly) + (p->c * lz) + (p->d * lw)) > 0.0f;
+		changeCount += (isLit ^ litFlags[faceIdx]);
+		litFlags[faceIdx] = isLit;
+		lit += isLit;
+	}
+	*litCount = lit;
+	return (changeCount > 0);
+}
+
+/**
+ * Extracts the terminator of the shadow caster from the list of shadow caster edges, using the
+ * current illumination of each face. An edge is part of the terminator if either:
+ *   - There is no neighbouring face on this edge, and either the face is lit and front faces
+ *     are being shadowed, or the face is dark and back faces are being shadowed.
+ *   - The neighbouring face has the opposite illumination than the face (ie- lit/dark or dark/lit).
+ */
+-(void) populateTerminatorEdges {
+	terminatorEdgeCount = 0;
+	for (GLuint edgeIdx = 0; edgeIdx < casterEdgeCount; edgeIdx++) {
+		CC3ShadowCasterEdge* edge = &casterEdges[edgeIdx];
+		BOOL isFaceLit = casterFaceLitFlags[edge->face];
+		BOOL isTerminatorEdge;
+		if (edge->neighbour == kCC3FaceNoNeighbour) {
+			isTerminatorEdge = isFaceLit ? shouldShadowFrontFaces : shouldShadowBackFaces;
 		} else {
-			[mesh updateVertexLocationsGLBuffer];
+			isTerminatorEdge = (casterFaceLitFlags[edge->neighbour] != isFaceLit);
 		}
+		if (isTerminatorEdge) terminatorEdges[terminatorEdgeCount++] = edgeIdx;
 	}
-	LogTrace(@"Finshed populating %@", self);
+	isTerminatorDirty = NO;
+	LogTrace(@"%@ extracted %u terminator edges", self, terminatorEdgeCount);
 }
 
+
+#pragma mark Building the shadow volume mesh
+
 /**
- * Adds a side to the shadow volume, by extruding the specified terminator edge of
- * the specified shadow caster mesh to infinity. The light source is directional
- * at the specified position. The shadow volume vertices are added starting at the
- * specified vertex index.
- * 
- * For a directional light, the shadow volume sides are parallel and can therefore
- * be described as meeting at a single point at infinity. We therefore only need to
- * add a single triangle, whose far point is in the opposite direction of the light.
+ * Prepares to populate the shadow volume mesh, by retrieving the faces of the shadow caster,
+ * determining which faces are illuminated by the light, and extracting the terminator of the
+ * mesh, where the mesh on one side of the terminator is illuminated and the other is dark.
+ *
+ * The terminator is only re-extracted if the illumination of at least one face has changed,
+ * so that small movements of the light or shadow caster only need to re-extrude the existing
+ * terminator edges.
+ *
+ * Uses the 4D homogeneous location of the light in the global coordinate system, transformed
+ * to the local coordinates system of the shadow caster.
+ *
+ * Also ensures that the shadow volume mesh has enough capacity to hold all the vertices that
+ * will be generated when the mesh is built, so that the buildShadowMesh method does not need
+ * to interact with the mesh object, and can safely be run on a background thread.
+ *
+ * This method is invoked on the thread that is updating the scene. Returns whether the shadow
+ * volume mesh should be built, which is always the case once this method has been invoked.
  */
--(BOOL) addShadowVolumeSideFrom: (CC3Vector4) edgeStartLoc
-							 to: (CC3Vector4) edgeEndLoc
-		  forDirectionalLightAt: (CC3Vector4) lightPosition
-				startingAtIndex: (GLuint*) shdwVtxIdx {
+-(BOOL) prepareShadowMesh {
+	CC3MeshNode* scNode = self.shadowCaster;
 	
-	// Get the location of the single point at infinity from the light direction.
-	CC3Vector4 farLoc = CC3Vector4HomogeneousNegate(lightPosition);
+	[self populateShadowCasterFaces];
 	
-	// Ensure the mesh has enough capacity for another triangle.
-	BOOL wasMeshExpanded = [self.mesh ensureVertexCapacity: (*shdwVtxIdx + 3)];
+	// Transform the 4D position of the light into the local coordinates of the shadow caster.
+	CC3Vector4 lightPosition = light.globalHomogeneousPosition;
+	localLightPosition = [scNode.transformMatrixInverted transformHomogeneousVector: lightPosition];
 	
-	// Add a single triangle from the edge to a single point at infinity,
-	// with the same winding as the dark face.
-	[mesh setVertexHomogeneousLocation: edgeStartLoc at: (*shdwVtxIdx)++];
-	[mesh setVertexHomogeneousLocation: farLoc at: (*shdwVtxIdx)++];
-	[mesh setVertexHomogeneousLocation: edgeEndLoc at: (*shdwVtxIdx)++];
+	// Determine whether we want to nudge the shadow volume vertices away from the shadow caster
+	shadowVertexNudge = (shadowVolumeVertexOffsetFactor != 0.0f)
+							? [self shadowVolumeVertexOffsetForLightAt: localLightPosition]
+							: kCC3Vector4Zero;
 	
-	LogTrace(@"%@ drawing shadow volume side face for directional light", self);
+	// Determine which faces are illuminated, and if any have changed, re-extract the terminator.
+	GLuint litCnt;
+	BOOL wasLightingChanged = CC3ShadowClassifyFaces(casterFacePlanes, casterFaceCount,
+													 localLightPosition, casterFaceLitFlags, &litCnt);
+	if (wasLightingChanged || isTerminatorDirty) [self populateTerminatorEdges];
 	
-	return wasMeshExpanded;
-}
-
-/**
- * Adds a side to the shadow volume, by extruding the specified terminator edge of
- * the specified shadow caster mesh to infinity. The light source is positional at
- * the specified position. The shadow volume vertices are added starting at the
- * specified vertex index.
- * 
- * For a locational light, the shadow volume sides are not parallel and expand as
- * they extend away from the shadow casting object. If the shadow volume does not
- * need to be capped off at the far end, the shadow expands to infinity.
- *
- * However, if the shadow volume needs to be capped off at the far end, the shadow
- * is allowed to expand behind the shadow-caster to a distance equivalent to the
- * distance from the light to the shadow-caster, multiplied by the value of the
- * shadowExpansionLimitFactor property. At that point, the shadow volume will
- * extend out to infinity at that same size.
- * 
- * For the shadow volume segment that expands in size, each side is a trapezoid
- * formed by projecting a vector from the light, through each terminator edge
- * vertex, out to either infinity of the distance determined by the value of the
- * shadowExpansionLimitFactor property. Then, from that distance to infinity,
- * the shadow volume side behaves as if it originated from a directional light,
- * and is constructed from a single triangle, extending out to infinity in the
- * opposite direction of the light.
- */
--(BOOL) addShadowVolumeSideFrom: (CC3Vector4) edgeStartLoc
-							 to: (CC3Vector4) edgeEndLoc
-						withCap: (BOOL) doesRequireCapping
-		   forLocationalLightAt: (CC3Vector4) lightPosition
-				startingAtIndex: (GLuint*) shdwVtxIdx {
-
-	CC3Vector4 farStartLoc, farEndLoc;
-
-	if (doesRequireCapping) {
-		// We need to cap this shadow volume at infinity, so allow the shadow volume
-		// to expand only for a distance equivalent to the distance from the light to
-		// the vertex, mulitiplied by the shadowExpansionLimitFactor property.
-		farStartLoc = [self expand: edgeStartLoc awayFromLocationalLightAt: lightPosition];
-		farEndLoc = [self expand: edgeEndLoc awayFromLocationalLightAt: lightPosition];
+	// Determine how many vertices will be generated, and ensure the mesh can hold them.
+	GLuint vtxCnt;
+	if (shouldDrawTerminator && self.visible) {
+		vtxCnt = terminatorEdgeCount * 2;
 	} else {
-		// We don't need to cap this shadow volume, so allow the shadow volume to expand
-		// to infinity in a direction away from the light, through the edge points.
-		// The W component of the result of each subtraction will be zero, indicating
-		// a point at infinity.
-		farStartLoc = CC3Vector4Difference(edgeStartLoc, lightPosition);
-		farEndLoc = CC3Vector4Difference(edgeEndLoc, lightPosition);
+		GLuint capFaceCnt = 0;
+		if (self.doesRequireCapping) {
+			if (shouldShadowBackFaces) capFaceCnt += litCnt;
+			if (shouldShadowFrontFaces) capFaceCnt += (casterFaceCount - litCnt);
+		}
+		GLuint vtxPerSide = CC3Vector4IsDirectional(localLightPosition) ? 3 : (self.doesRequireCapping ? 9 : 6);
+		vtxCnt = (capFaceCnt * 3) + (terminatorEdgeCount * vtxPerSide);
 	}
-	
-	// Ensure the mesh has enough capacity for another two triangles.
-	BOOL wasMeshExpanded = [self.mesh ensureVertexCapacity: (*shdwVtxIdx + 6)];
-	
-	// The shadow volume faces have the same winding as the dark face.
-	// First triangular face:
-	[mesh setVertexHomogeneousLocation: edgeStartLoc at: (*shdwVtxIdx)++];
-	[mesh setVertexHomogeneousLocation: farStartLoc at: (*shdwVtxIdx)++];
-	[mesh setVertexHomogeneousLocation: farEndLoc at: (*shdwVtxIdx)++];
-	
-	// Second triangular face:
-	[mesh setVertexHomogeneousLocation: edgeStartLoc at: (*shdwVtxIdx)++];
-	[mesh setVertexHomogeneousLocation: farEndLoc at: (*shdwVtxIdx)++];
-	[mesh setVertexHomogeneousLocation: edgeEndLoc at: (*shdwVtxIdx)++];
-
-	if (doesRequireCapping) {
-		// To cap, extend from the limited expansion points out to infinity in
-		// a direction away from the light, as if the light was directional.
-		// These segments will be parallel to each other, and the shadow will
-		// expand no further.
-		wasMeshExpanded |= [self addShadowVolumeSideFrom: farStartLoc
-													  to: farEndLoc
-								   forDirectionalLightAt: lightPosition
-										 startingAtIndex: shdwVtxIdx];
+	wasShadowMeshExpanded = [mesh ensureVertexCapacity: vtxCnt];
+	if (mesh.allocatedVertexCapacity < vtxCnt) {
+		mesh.allocatedVertexCapacity = vtxCnt;
+		wasShadowMeshExpanded = YES;
 	}
 	
-	LogTrace(@"%@ drawing shadow volume side face for positional light", self);
+	LogTrace(@"%@ prepared %u terminator edges from %u faces (%u lit) for light at %@ and %@ end caps",
+			 self, terminatorEdgeCount, casterFaceCount, litCnt,
+			 NSStringFromCC3Vector4(localLightPosition),
+			 (self.doesRequireCapping ? @"including" : @"excluding"));
 	
-	return wasMeshExpanded;
+	return YES;
 }
 
-/** 
+/** Adds the specified vertex to the specified vertex buffer, and advances the buffer pointer. */
+#define CC3AddShadowVertex(vtxPtr, vtx)		(*(vtxPtr)++ = (vtx))
+
+/**
  * Expands the location of an terminator edge vertex in the direction away from the locational
  * light at the specified location. The vertex is moved away from the light along the vector
  * from the light to the vertex, a distance equal to the distance between the light and the
- * vertex, multiplied by the value of the shadowExpansionLimitFactor property.
+ * vertex, multiplied by the specified expansion limit factor.
  */
--(CC3Vector4) expand: (CC3Vector4) edgeLoc awayFromLocationalLightAt: (CC3Vector4) lightLoc {
+static inline CC3Vector4 CC3ShadowExpandAwayFromLight(CC3Vector4 edgeLoc, CC3Vector4 lightLoc, GLfloat limitFactor) {
 	CC3Vector4 extDir = CC3Vector4Difference(edgeLoc, lightLoc);
-	CC3Vector4 extrusion = CC3Vector4ScaleUniform(extDir, shadowExpansionLimitFactor);
-	return CC3Vector4Add(edgeLoc, extrusion);
+	return CC3Vector4Add(edgeLoc, CC3Vector4ScaleUniform(extDir, limitFactor));
 }
 
 /**
- * Adds a face to the cap at the near end of the shadow volume.
+ * Populates the shadow volume mesh from the terminator edges extracted by the prepareShadowMesh
+ * method. The shadow volume is constructed by extruding each edge line segment in the terminator
+ * out to infinity in the direction away from the light source, forming a tube of infinite length.
+ * If end caps are required, the faces of the shadow caster that form the near end cap are also
+ * added to the mesh.
+ *
+ * The vertices are written directly into the vertex content of the mesh. This method does not
+ * interact with any object other than this shadow volume, and can therefore be run on a
+ * background thread, concurrently with other shadow volumes.
+ *
+ * For a directional light, the shadow volume sides are parallel and can therefore be described
+ * as meeting at a single point at infinity. Each side is a single triangle, whose far point is
+ * in the opposite direction of the light.
+ *
+ * For a locational light, the shadow volume sides are not parallel and expand as they extend
+ * away from the shadow casting object. If the shadow volume does not need to be capped off at
+ * the far end, the shadow expands to infinity. However, if the shadow volume needs to be capped
+ * off at the far end, the shadow is allowed to expand behind the shadow-caster to a distance
+ * equivalent to the distance from the light to the shadow-caster, multiplied by the value of
+ * the shadowExpansionLimitFactor property. From that distance to infinity, the shadow volume
+ * side behaves as if it originated from a directional light.
  *
- * The winding order of the end-cap faces is determined from the winding order of
- * the model face, taking into consideration whether the face is lit or not.
+ * All shadow volume faces have the same winding as the dark face, so that the normals of the
+ * shadow volume mesh point outwards.
  */
--(BOOL) addShadowVolumeCapFor: (BOOL) isFaceLit
-						 face: (CC3Vector4*) vertices
-				   forLightAt: (CC3Vector4) lightPosition
-			  startingAtIndex: (GLuint*) shdwVtxIdx {
+-(void) buildShadowMesh {
+	NSTimeInterval startTime = [NSDate timeIntervalSinceReferenceDate];
 	
-	// Ensure the mesh has enough capacity for another triangle.
-	BOOL wasMeshExpanded = [self.mesh ensureVertexCapacity: (*shdwVtxIdx + 3)];
+	CC3Vector4* vtxStart = (CC3Vector4*)mesh.vertexLocations.vertices;
+	CC3Vector4* vtx = vtxStart;
+	CC3Vector4 lightPos = localLightPosition;
+	CC3Vector4 nudge = shadowVertexNudge;
+	BOOL isDirectionalLight = CC3Vector4IsDirectional(lightPos);
+	BOOL isCapping = self.doesRequireCapping;
+	BOOL isDrawingTerminator = shouldDrawTerminator && visible;
+	CC3Vector4 dirFarLoc = CC3Vector4HomogeneousNegate(lightPos);
 	
-	// Add a single triangle face to the cap at the near end, built from the vertices
-	// of the shadow caster face at the specified index. If the face is lit, use the
-	// same winding order. If the face is dark, use the opposite winding.
-	if (isFaceLit) {
-		[mesh setVertexHomogeneousLocation: vertices[0] at: (*shdwVtxIdx)++];
-		[mesh setVertexHomogeneousLocation: vertices[1] at: (*shdwVtxIdx)++];
-		[mesh setVertexHomogeneousLocation: vertices[2] at: (*shdwVtxIdx)++];
-	} else {
-		[mesh setVertexHomogeneousLocation: vertices[0] at: (*shdwVtxIdx)++];
-		[mesh setVertexHomogeneousLocation: vertices[2] at: (*shdwVtxIdx)++];
-		[mesh setVertexHomogeneousLocation: vertices[1] at: (*shdwVtxIdx)++];
+	// If we're drawing end-caps, add the faces that are part of the near end-cap. A face is part
+	// of an end-cap if it's a dark face and shadowing is based on front faces (typical), or it's
+	// a lit face and shadowing is (also) based on back faces (as with some open meshes).
+	// If the face is lit, use the same winding order. If the face is dark, use the opposite winding.
+	if (isCapping && !shouldDrawTerminator) {
+		for (GLuint faceIdx = 0; faceIdx < casterFaceCount; faceIdx++) {
+			BOOL isFaceLit = casterFaceLitFlags[faceIdx];
+			if (isFaceLit ? shouldShadowBackFaces : shouldShadowFrontFaces) {
+				CC3Vector4* faceVertices = &casterFaceVertices[faceIdx * 3];
+				CC3AddShadowVertex(vtx, CC3Vector4Add(faceVertices[0], nudge));
+				CC3AddShadowVertex(vtx, CC3Vector4Add(faceVertices[isFaceLit ? 1 : 2], nudge));
+				CC3AddShadowVertex(vtx, CC3Vector4Add(faceVertices[isFaceLit ? 2 : 1], nudge));
+			}
+		}
+	}
+	
+	// Extrude each terminator edge
+	for (GLuint termIdx = 0; termIdx < terminatorEdgeCount; termIdx++) {
+		CC3ShadowCasterEdge* edge = &casterEdges[terminatorEdges[termIdx]];
+		CC3Vector4* faceVertices = &casterFaceVertices[edge->face * 3];
+		GLuint edgeIdx = edge->edgeIndex;
+		GLuint nextIdx = (edgeIdx < 2) ? (edgeIdx + 1) : 0;
+		
+		// Choose the start and end of the edge based on which face of this pair is illuminated,
+		// so that the winding of the extruded face is the same as the dark face.
+		CC3Vector4 edgeStartLoc, edgeEndLoc;
+		if (casterFaceLitFlags[edge->face]) {
+			edgeStartLoc = CC3Vector4Add(faceVertices[edgeIdx], nudge);
+			edgeEndLoc = CC3Vector4Add(faceVertices[nextIdx], nudge);
+		} else {
+			edgeStartLoc = CC3Vector4Add(faceVertices[nextIdx], nudge);
+			edgeEndLoc = CC3Vector4Add(faceVertices[edgeIdx], nudge);
+		}
+		
+		if (isDrawingTerminator) {
+			// Draw the terminator line instead of a shadow
+			CC3AddShadowVertex(vtx, edgeStartLoc);
+			CC3AddShadowVertex(vtx, edgeEndLoc);
+		} else if (isDirectionalLight) {
+			// Single triangle from the edge to a single point at infinity
+			CC3AddShadowVertex(vtx, edgeStartLoc);
+			CC3AddShadowVertex(vtx, dirFarLoc);
+			CC3AddShadowVertex(vtx, edgeEndLoc);
+		} else {
+			CC3Vector4 farStartLoc, farEndLoc;
+			if (isCapping) {
+				// Allow the shadow volume to expand only for a limited distance
+				farStartLoc = CC3ShadowExpandAwayFromLight(edgeStartLoc, lightPos, shadowExpansionLimitFactor);
+				farEndLoc = CC3ShadowExpandAwayFromLight(edgeEndLoc, lightPos, shadowExpansionLimitFactor);
+			} else {
+				// Expand to infinity through the edge points. The W component of the
+				// result of each subtraction will be zero, indicating a point at infinity.
+				farStartLoc = CC3Vector4Difference(edgeStartLoc, lightPos);
+				farEndLoc = CC3Vector4Difference(edgeEndLoc, lightPos);
+			}
+			
+			// Two triangles forming the expanding trapezoid side
+			CC3AddShadowVertex(vtx, edgeStartLoc);
+			CC3AddShadowVertex(vtx, farStartLoc);
+			CC3AddShadowVertex(vtx, farEndLoc);
+			
+			CC3AddShadowVertex(vtx, edgeStartLoc);
+			CC3AddShadowVertex(vtx, farEndLoc);
+			CC3AddShadowVertex(vtx, edgeEndLoc);
+			
+			// To cap, extend from the limited expansion points out to infinity in a direction
+			// away from the light, as if the light was directional. These segments will be
+			// parallel to each other, and the shadow will expand no further.
+			if (isCapping) {
+				CC3AddShadowVertex(vtx, farStartLoc);
+				CC3AddShadowVertex(vtx, dirFarLoc);
+				CC3AddShadowVertex(vtx, farEndLoc);
+			}
+		}
 	}
-
-	LogTrace(@"%@ drawing shadow volume near %@end cap face (%@, %@, %@)",
-				  self, (CC3Vector4IsLocational(lightPosition) ? @"and far " : @""),
-				  NSStringFromCC3Vector4(vertices[0]),
-				  NSStringFromCC3Vector4(vertices[1]),
-				  NSStringFromCC3Vector4(vertices[2]));
 	
-	return wasMeshExpanded;
+	shadowVertexCount = (GLuint)(vtx - vtxStart);
+	shadowUpdateDuration += ([NSDate timeIntervalSinceReferenceDate] - startTime);
 }
 
 /**
- * When drawing the terminator line of the mesh, just add the two line
- * endpoints, and don't make use of infinitely extruded endpoints.
+ * Completes the update of the shadow volume mesh by setting the vertex count of the mesh to
+ * the number of vertices generated by the buildShadowMesh method, and updating the GL buffers.
+ * If the mesh was expanded, the GL buffers are recreated, otherwise they are updated.
+ *
+ * This method is invoked on the thread that is updating the scene.
  */
--(BOOL) addTerminatorLineFrom: (CC3Vector4) edgeStartLoc
-						   to: (CC3Vector4) edgeEndLoc
-			  startingAtIndex: (GLuint*) shdwVtxIdx {
-	
-	// Ensure the mesh has enough capacity for another line
-	BOOL wasMeshExpanded = [self.mesh ensureVertexCapacity: (*shdwVtxIdx + 2)];
+-(void) finishShadowUpdate {
+	NSTimeInterval startTime = [NSDate timeIntervalSinceReferenceDate];
 	
-	// Add just the two end points of the terminator edge
-	[mesh setVertexHomogeneousLocation: edgeStartLoc at: (*shdwVtxIdx)++];
-	[mesh setVertexHomogeneousLocation: edgeEndLoc at: (*shdwVtxIdx)++];
+	mesh.vertexCount = shadowVertexCount;
+	LogTrace(@"%@ setting vertex count to %u", self, shadowVertexCount);
 	
-	LogTrace(@"%@ drawing terminator line", self);
+	if (mesh.isUsingGLBuffers) {
+		if (wasShadowMeshExpanded) {
+			[mesh deleteGLBuffers];
+			[mesh createGLBuffers];
+		} else {
+			[mesh updateVertexLocationsGLBuffer];
+		}
+	}
+	wasShadowMeshExpanded = NO;
+	isShadowBuildPending = NO;
 	
-	return wasMeshExpanded;
+	shadowUpdateDuration += ([NSDate timeIntervalSinceReferenceDate] - startTime);
+	LogTrace(@"Finshed populating %@ in %.3f ms", self, shadowUpdateDuration * 1000.0);
 }
 
 
@@ -689,26 +731,70 @@
 
 /**
  * If the shadow is ready to be updated, check if the shadow is both
- * visible and dirty, and re-populate the shadow mesh if needed.
+ * visible and dirty, and prepare to re-populate the shadow mesh if needed.
+ * Returns whether the shadow mesh needs to be built.
  *
  * To keep the shadow lag count synchronized across all shadow-casting nodes,
  * the shadow lag count will be reset to the value of the shadow lag factor
  * if the shadow is ready to be updated, even if it is not actually updated
  * due to it being invisible, or not dirty.
  */
--(void) updateShadow {
+-(BOOL) prepareShadowUpdate {
 	LogTrace(@"Testing to update %@ with shadow lag count %i", self, shadowLagCount);
+	NSTimeInterval startTime = [NSDate timeIntervalSinceReferenceDate];
+	shadowUpdateDuration = 0.0;
+	isShadowBuildPending = NO;
 	if (self.isReadyToUpdate) {
 		if (self.isShadowVisible) {
 			[self updateStencilAlgorithm];
 			if (isShadowDirty) {
 				LogTrace(@"Updating %@", self);
-				[self populateShadowMesh];
+				isShadowBuildPending = [self prepareShadowMesh];
 				isShadowDirty = NO;
 			}
 		}
 		shadowLagCount = shadowLagFactor;
 	}
+	if (isShadowBuildPending) shadowUpdateDuration = ([NSDate timeIntervalSinceReferenceDate] - startTime);
+	return isShadowBuildPending;
+}
+
+-(void) updateShadow {
+	if ( [self prepareShadowUpdate] ) {
+		[self buildShadowMesh];
+		[self finishShadowUpdate];
+	}
+}
+
++(void) updateShadowsConcurrently: (CCArray*) shadows {
+	NSUInteger shdwCnt = shadows.count;
+	if ( !shdwCnt ) return;
+	
+	// Prepare each shadow volume on this thread, collecting those that need to be built.
+	CC3ShadowVolumeMeshNode** pendingSVs = malloc(shdwCnt * sizeof(CC3ShadowVolumeMeshNode*));
+	NSUInteger pendingCnt = 0;
+	for (id<CC3ShadowProtocol> shdw in shadows) {
+		if ( [shdw isKindOfClass: [CC3ShadowVolumeMeshNode class]] ) {
+			CC3ShadowVolumeMeshNode* sv = (CC3ShadowVolumeMeshNode*)shdw;
+			if ( [sv prepareShadowUpdate] ) pendingSVs[pendingCnt++] = sv;
+		} else {
+			[shdw updateShadow];
+		}
+	}
+	
+	// Build the meshes concurrently. Each build only touches its own shadow volume.
+	if (pendingCnt > 1) {
+		dispatch_apply(pendingCnt, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0),
+					   ^(size_t svIdx) { [pendingSVs[svIdx] buildShadowMesh]; });
+	} else if (pendingCnt == 1) {
+		[pendingSVs[0] buildShadowMesh];
+	}
+	
+	// Update the GL buffers on this thread.
+	for (NSUInteger svIdx = 0; svIdx < pendingCnt; svIdx++) [pendingSVs[svIdx] finishShadowUpdate];
+	
+	LogTrace(@"Updated %u of %u shadows concurrently", pendingCnt, shdwCnt);
+	free(pendingSVs);
 }
 
 /**
@@ -980,6 +1066,12 @@
 	for (CC3Node* child in children) child.shouldShadowBackFaces = shouldShadow;
 }
 
+-(NSTimeInterval) shadowUpdateDuration {
+	NSTimeInterval totalDuration = 0.0;
+	for (CC3Node* child in children) totalDuration += child.shadowUpdateDuration;
+	return totalDuration;
+}
+
 -(GLfloat) shadowOffsetFactor {
 	for (CC3Node* child in children) {
 		GLfloat sf = child.shadowOffsetFactor;
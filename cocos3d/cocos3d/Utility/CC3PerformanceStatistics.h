@@ -57,6 +57,9 @@
 	GLuint nodesDrawn;
 	GLuint drawingCallsMade;
 	GLuint facesPresented;
+	GLuint facesSavedByLevelOfDetail;
+	GLuint glStateChangesMade;
+	GLuint glStateChangesFiltered;
 }
 
 
@@ -169,6 +172,51 @@
  */
 -(void) addSingleCallFacesPresented: (GLuint) faceCount;
 
+/**
+ * The total number of triangle faces that were not presented to the GL engine, since the
+ * reset method was last invoked, because a CC3LODMeshNode drew one of its lower levels of
+ * detail, instead of its full-detail mesh.
+ */
+@property(nonatomic, readonly) GLuint facesSavedByLevelOfDetail;
+
+/** Adds the specified number of faces to the facesSavedByLevelOfDetail property. */
+-(void) addFacesSavedByLevelOfDetail: (GLuint) faceCount;
+
+/**
+ * The total number of GL state changes that were made by the CC3OpenGLESEngine state
+ * trackers since the reset method was last invoked.
+ *
+ * This value is collected from the stateChangeCount property of the CC3OpenGLESEngine
+ * at the end of each frame.
+ */
+@property(nonatomic, readonly) GLuint glStateChangesMade;
+
+/** Adds the specified number of GL state changes to the glStateChangesMade property. */
+-(void) addGLStateChangesMade: (GLuint) changeCount;
+
+/**
+ * The total number of GL state changes that were requested of the CC3OpenGLESEngine state
+ * trackers, but were not forwarded to the GL engine because the state was not changing,
+ * since the reset method was last invoked.
+ *
+ * This value is collected from the filteredStateChangeCount property of the
+ * CC3OpenGLESEngine at the end of each frame.
+ */
+@property(nonatomic, readonly) GLuint glStateChangesFiltered;
+
+/** Adds the specified number of GL state changes to the glStateChangesFiltered property. */
+-(void) addGLStateChangesFiltered: (GLuint) changeCount;
+
+/**
+ * Invoked immediately before each drawing call, with the number of GL state changes
+ * that were made since the previous drawing call.
+ *
+ * This implementation does nothing, since the total number of state changes is collected
+ * at the end of each frame. The CC3PerformanceStatisticsHistogram subclass uses this value
+ * to populate a histogram of the number of state changes made per drawing call.
+ */
+-(void) addGLStateChangesForDrawingCall: (GLuint) changeCount;
+
 
 #pragma mark Average update statistics
 
@@ -236,6 +284,30 @@
  */
 @property(nonatomic, readonly) GLfloat averageFacesPresentedPerFrame;
 
+/**
+ * The average number of triangle faces saved by level-of-detail selection per frame,
+ * calculated by dividing the facesSavedByLevelOfDetail property by the framesHandled property.
+ */
+@property(nonatomic, readonly) GLfloat averageFacesSavedByLevelOfDetailPerFrame;
+
+/**
+ * The average number of GL state changes made per drawing frame, calculated by
+ * dividing the glStateChangesMade property by the framesHandled property.
+ */
+@property(nonatomic, readonly) GLfloat averageGLStateChangesMadePerFrame;
+
+/**
+ * The average number of GL state changes filtered per drawing frame, calculated by
+ * dividing the glStateChangesFiltered property by the framesHandled property.
+ */
+@property(nonatomic, readonly) GLfloat averageGLStateChangesFilteredPerFrame;
+
+/**
+ * The average number of GL state changes made per drawing call, calculated by
+ * dividing the glStateChangesMade property by the drawingCallsMade property.
+ */
+@property(nonatomic, readonly) GLfloat averageGLStateChangesMadePerDrawingCall;
+
 
 #pragma mark Allocation and initialization
 
@@ -264,6 +336,7 @@
 
 // Number of buckets in each of the histograms
 #define kCC3RateHistogramSize 80
+#define kCC3StateChangesHistogramSize 32
 
 /**
  * Collects statistics about the updating and drawing performance of the 3D scene,
@@ -283,6 +356,7 @@
 @interface CC3PerformanceStatisticsHistogram : CC3PerformanceStatistics {
 	GLint updateRateHistogram[kCC3RateHistogramSize];
 	GLint frameRateHistogram[kCC3RateHistogramSize];
+	GLint glStateChangesPerDrawingCallHistogram[kCC3StateChangesHistogramSize];
 }
 
 /**
@@ -303,5 +377,18 @@
  */
 @property(nonatomic, readonly) GLint* frameRateHistogram;
 
+/**
+ * Returns a histogram of the number of GL state changes made before each drawing call.
+ * Each drawing call that was preceded by more than (kCC3StateChangesHistogramSize - 1)
+ * state changes is counted in the last bucket.
+ *
+ * A distribution concentrated in the low buckets indicates that nodes are being drawn in an
+ * order that shares GL state effectively. Use the trackersOrderedByChangeCount method of the
+ * CC3OpenGLESEngine to determine which state is changing most often.
+ *
+ * This histogram is cleared when the reset method is invoked.
+ */
+@property(nonatomic, readonly) GLint* glStateChangesPerDrawingCallHistogram;
+
 @end
 
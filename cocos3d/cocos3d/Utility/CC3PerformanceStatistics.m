@@ -39,7 +39,8 @@
 
 @synthesize updatesHandled, accumulatedUpdateTime, nodesUpdated, nodesTransformed;
 @synthesize framesHandled, accumulatedFrameTime, nodesVisitedForDrawing;
-@synthesize nodesDrawn, drawingCallsMade, facesPresented;
+@synthesize nodesDrawn, drawingCallsMade, facesPresented, facesSavedByLevelOfDetail;
+@synthesize glStateChangesMade, glStateChangesFiltered;
 
 -(void) dealloc {
 	[super dealloc];
@@ -106,6 +107,20 @@
 	facesPresented += faceCount;
 }
 
+-(void) addFacesSavedByLevelOfDetail: (GLuint) faceCount {
+	facesSavedByLevelOfDetail += faceCount;
+}
+
+-(void) addGLStateChangesMade: (GLuint) changeCount {
+	glStateChangesMade += changeCount;
+}
+
+-(void) addGLStateChangesFiltered: (GLuint) changeCount {
+	glStateChangesFiltered += changeCount;
+}
+
+-(void) addGLStateChangesForDrawingCall: (GLuint) changeCount {}
+
 
 #pragma mark Averaged update statistics
 
@@ -144,6 +159,22 @@
 	return framesHandled ? ((GLfloat)facesPresented / (GLfloat)framesHandled) : 0.0;
 }
 
+-(GLfloat) averageFacesSavedByLevelOfDetailPerFrame {
+	return framesHandled ? ((GLfloat)facesSavedByLevelOfDetail / (GLfloat)framesHandled) : 0.0;
+}
+
+-(GLfloat) averageGLStateChangesMadePerFrame {
+	return framesHandled ? ((GLfloat)glStateChangesMade / (GLfloat)framesHandled) : 0.0;
+}
+
+-(GLfloat) averageGLStateChangesFilteredPerFrame {
+	return framesHandled ? ((GLfloat)glStateChangesFiltered / (GLfloat)framesHandled) : 0.0;
+}
+
+-(GLfloat) averageGLStateChangesMadePerDrawingCall {
+	return drawingCallsMade ? ((GLfloat)glStateChangesMade / (GLfloat)drawingCallsMade) : 0.0;
+}
+
 
 #pragma mark Allocation and initialization
 
@@ -170,6 +201,9 @@
 	nodesDrawn = 0;
 	drawingCallsMade = 0;
 	facesPresented = 0;
+	facesSavedByLevelOfDetail = 0;
+	glStateChangesMade = 0;
+	glStateChangesFiltered = 0;
 }
 
 // Template method that populates this instance from the specified other instance.
@@ -186,6 +220,9 @@
 	nodesDrawn = another.nodesDrawn;
 	drawingCallsMade = another.drawingCallsMade;
 	facesPresented = another.facesPresented;
+	facesSavedByLevelOfDetail = another.facesSavedByLevelOfDetail;
+	glStateChangesMade = another.glStateChangesMade;
+	glStateChangesFiltered = another.glStateChangesFiltered;
 }
 
 -(id) copyWithZone: (NSZone*) zone {
@@ -199,9 +236,10 @@
 }
 
 -(NSString*) fullDescription {
-	return [NSString stringWithFormat: @"%@ nodes drawn: %.0f, GL calls: %.0f, faces: %.0f",
+	return [NSString stringWithFormat: @"%@ nodes drawn: %.0f, GL calls: %.0f, faces: %.0f, GL state changes: %.0f (filtered %.0f)",
 			self.description, self.averageNodesDrawnPerFrame,
-			self.averageDrawingCallsMadePerFrame, self.averageFacesPresentedPerFrame];
+			self.averageDrawingCallsMadePerFrame, self.averageFacesPresentedPerFrame,
+			self.averageGLStateChangesMadePerFrame, self.averageGLStateChangesFilteredPerFrame];
 }
 
 @end
@@ -220,6 +258,10 @@
 	return frameRateHistogram;
 }
 
+-(GLint*) glStateChangesPerDrawingCallHistogram {
+	return glStateChangesPerDrawingCallHistogram;
+}
+
 -(GLint) getIndexOfInterval: (ccTime) deltaTime {
 	return CLAMP((GLint)(1.0 / deltaTime), 0, kCC3RateHistogramSize - 1);
 }
@@ -240,6 +282,11 @@
 	frameRateHistogram[[self getIndexOfInterval: deltaTime]]++;
 }
 
+-(void) addGLStateChangesForDrawingCall: (GLuint) changeCount {
+	[super addGLStateChangesForDrawingCall: changeCount];
+	glStateChangesPerDrawingCallHistogram[MIN(changeCount, kCC3StateChangesHistogramSize - 1)]++;
+}
+
 
 #pragma mark Allocation and initialization
 
@@ -247,12 +294,16 @@
 	[super reset];
 	memset(frameRateHistogram, 0, kCC3RateHistogramSize * sizeof(frameRateHistogram[0]));
 	memset(updateRateHistogram, 0, kCC3RateHistogramSize * sizeof(updateRateHistogram[0]));
+	memset(glStateChangesPerDrawingCallHistogram, 0,
+		   kCC3StateChangesHistogramSize * sizeof(glStateChangesPerDrawingCallHistogram[0]));
 }
 
 -(void) populateFrom: (CC3PerformanceStatisticsHistogram*) another {
 	[super populateFrom: another];
 	memcpy(frameRateHistogram, another.frameRateHistogram, kCC3RateHistogramSize * sizeof(frameRateHistogram[0]));
 	memcpy(updateRateHistogram, another.updateRateHistogram, kCC3RateHistogramSize * sizeof(updateRateHistogram[0]));
+	memcpy(glStateChangesPerDrawingCallHistogram, another.glStateChangesPerDrawingCallHistogram,
+		   kCC3StateChangesHistogramSize * sizeof(glStateChangesPerDrawingCallHistogram[0]));
 }
 
 -(NSString*) fullDescription {
@@ -266,6 +317,14 @@
 			[desc appendFormat: @"\n\t%u\t%u\t%u", i, fpsCount, upsCount];
 		}
 	}
+	[desc appendFormat: @"\n\tGL state changes per draw\tDraws"];
+	for (int i = 0; i < kCC3StateChangesHistogramSize; i++) {
+		GLint drawCount = glStateChangesPerDrawingCallHistogram[i];
+		if (drawCount) {
+			[desc appendFormat: @"\n\t%u%@\t%u", i,
+			 (i == kCC3StateChangesHistogramSize - 1) ? @"+" : @"", drawCount];
+		}
+	}
 	return desc;
 }
 